@@ -0,0 +1,163 @@
+// BackgroundWriter.cpp - Writer thread, wakeups and latency accounting
+
+#include "BackgroundWriter.h"
+
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+#include "SettingsStore.h"
+
+namespace {
+
+int64_t NanosecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Replaces the snapshot for the same path in pending (or extends it, for an
+// append), or adds it. Returns true if it was merged into an older snapshot.
+bool MergeSnapshot(std::vector<PersistSnapshot>* pending,
+                   PersistSnapshot&& snapshot) {
+  for (PersistSnapshot& existing : *pending) {
+    if (existing.path == snapshot.path) {
+      if (snapshot.append) {
+        existing.contents += snapshot.contents;
+      } else {
+        existing = std::move(snapshot);
+      }
+      return true;
+    }
+  }
+  pending->push_back(std::move(snapshot));
+  return false;
+}
+
+}  // namespace
+
+void LatencyHistogram::Record(int64_t nanoseconds) {
+  int bucket = 0;
+  for (uint64_t value = nanoseconds > 0 ? nanoseconds : 0; value; value >>= 1) {
+    bucket++;
+  }
+  if (bucket >= kBucketCount) bucket = kBucketCount - 1;
+  buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::Count() const {
+  uint64_t total = 0;
+  for (const auto& bucket : buckets) {
+    total += bucket.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+int64_t LatencyHistogram::PercentileNs(double fraction) const {
+  const uint64_t total = Count();
+  if (total == 0) return 0;
+
+  uint64_t target = static_cast<uint64_t>(std::ceil(fraction * total));
+  if (target == 0) target = 1;
+  uint64_t seen = 0;
+  for (int i = 0; i < kBucketCount; i++) {
+    seen += buckets[i].load(std::memory_order_relaxed);
+    if (seen >= target) return i == 0 ? 0 : int64_t{1} << i;
+  }
+  return int64_t{1} << (kBucketCount - 1);
+}
+
+void BackgroundWriter::Start(Sink writeSink) {
+  if (IsRunning()) return;
+  sink = writeSink ? std::move(writeSink) : Sink([](const PersistSnapshot& s) {
+    return s.append ? AppendToFile(s.path, s.contents)
+                    : WriteFileAtomically(s.path, s.contents);
+  });
+  stopping.store(false);
+  thread = std::thread(&BackgroundWriter::Run, this);
+}
+
+void BackgroundWriter::Enqueue(PersistSnapshot snapshot) {
+  const auto start = std::chrono::steady_clock::now();
+  if (!IsRunning()) Start();
+  enqueued.fetch_add(1, std::memory_order_relaxed);
+
+  // Anything already stashed must go first so the newest snapshot wins.
+  if (!DeliverStash() || !queue.TryPush(std::move(snapshot))) {
+    stashed.fetch_add(1, std::memory_order_relaxed);
+    if (MergeSnapshot(&stash, std::move(snapshot))) {
+      coalesced.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  Wake();
+
+  enqueueLatency.Record(NanosecondsSince(start));
+}
+
+void BackgroundWriter::Shutdown() {
+  if (!IsRunning()) return;
+
+  while (!DeliverStash()) {
+    Wake();
+    std::this_thread::yield();
+  }
+
+  stopping.store(true);
+  { std::lock_guard<std::mutex> lock(wakeMutex); }
+  wakeup.notify_one();
+  thread.join();
+}
+
+bool BackgroundWriter::DeliverStash() {
+  size_t delivered = 0;
+  while (delivered < stash.size() &&
+         queue.TryPush(std::move(stash[delivered]))) {
+    delivered++;
+  }
+  stash.erase(stash.begin(), stash.begin() + delivered);
+  return stash.empty();
+}
+
+void BackgroundWriter::Wake() {
+  // Pairs with the fence in Run(): either the writer sees the new item before
+  // it sleeps, or we see it sleeping and notify it.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!sleeping.load()) return;
+  { std::lock_guard<std::mutex> lock(wakeMutex); }
+  wakeup.notify_one();
+}
+
+void BackgroundWriter::Run() {
+  std::vector<PersistSnapshot> batch;
+  PersistSnapshot snapshot;
+
+  for (;;) {
+    batch.clear();
+    while (queue.TryPop(&snapshot)) {
+      if (MergeSnapshot(&batch, std::move(snapshot))) {
+        coalesced.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    for (const PersistSnapshot& pending : batch) {
+      const auto start = std::chrono::steady_clock::now();
+      const bool ok = sink(pending);
+      writeLatency.Record(NanosecondsSince(start));
+      written.fetch_add(1, std::memory_order_relaxed);
+      if (!ok) failed.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!batch.empty()) continue;  // More may have arrived while writing
+
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    sleeping.store(true);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    wakeup.wait(lock, [this] { return !queue.Empty() || stopping.load(); });
+    sleeping.store(false);
+    if (queue.Empty() && stopping.load()) break;
+  }
+}
+
+BackgroundWriter& GetBackgroundWriter() {
+  static BackgroundWriter writer;
+  return writer;
+}
@@ -0,0 +1,102 @@
+// BackgroundWriter.h - Writer thread that keeps disk I/O off the UI thread
+
+#ifndef BACKGROUNDWRITER_H
+#define BACKGROUNDWRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SpscQueue.h"
+
+// Power-of-two buckets of durations in nanoseconds. Safe to record from one
+// thread while another reads it.
+struct LatencyHistogram {
+  static constexpr int kBucketCount = 40;  // Up to ~9 minutes
+
+  std::atomic<uint64_t> buckets[kBucketCount] = {};
+
+  // Bucket i counts durations in [2^(i-1), 2^i) ns; bucket 0 counts 0 ns.
+  void Record(int64_t nanoseconds);
+  uint64_t Count() const;
+
+  // Upper bound of the bucket holding the given fraction (0-1) of samples,
+  // in nanoseconds, or 0 if nothing was recorded.
+  int64_t PercentileNs(double fraction) const;
+};
+
+// Complete contents a file should end up with, or (if append is set) bytes to
+// add to its end. Snapshots for the same path replace each other: only the
+// newest one pending is written. Appends are never dropped; they are
+// concatenated onto whatever is pending for the path.
+struct PersistSnapshot {
+  std::filesystem::path path;
+  std::string contents;
+  bool append = false;
+};
+
+// Writes snapshots on its own thread. Enqueue() is called from a single
+// producer thread (the UI thread) and only hands the snapshot over through a
+// lock-free queue; the condition variable is used purely to wake the writer
+// when it sleeps. Shutdown() writes everything still pending before joining.
+struct BackgroundWriter {
+  using Sink = std::function<bool(const PersistSnapshot&)>;
+
+  static constexpr size_t kQueueCapacity = 64;
+
+  BackgroundWriter() = default;
+  ~BackgroundWriter() { Shutdown(); }
+
+  BackgroundWriter(const BackgroundWriter&) = delete;
+  BackgroundWriter& operator=(const BackgroundWriter&) = delete;
+
+  // Starts the writer thread. sink performs the write (WriteFileAtomically
+  // or AppendToFile by default) and runs on the writer thread only.
+  void Start(Sink sink = Sink());
+
+  // Producer only. Never blocks: if the queue is full the snapshot is kept
+  // aside and handed over by the next Enqueue() or by Shutdown(). Starts the
+  // thread on first use.
+  void Enqueue(PersistSnapshot snapshot);
+
+  // Producer only. Delivers every pending snapshot, waits until all of them
+  // are written and stops the thread. Safe to call more than once.
+  void Shutdown();
+
+  bool IsRunning() const { return thread.joinable(); }
+
+  // Instrumentation
+  LatencyHistogram enqueueLatency;  // Producer-side cost of Enqueue()
+  LatencyHistogram writeLatency;    // Writer-side cost of each write
+  std::atomic<uint64_t> enqueued{0};
+  std::atomic<uint64_t> written{0};    // Snapshots passed to the sink
+  std::atomic<uint64_t> coalesced{0};  // Snapshots superseded before writing
+  std::atomic<uint64_t> failed{0};     // Sink reported failure
+  std::atomic<uint64_t> stashed{0};    // Enqueues that found the queue full
+
+ private:
+  void Run();
+  bool DeliverStash();
+  void Wake();
+
+  SpscQueue<PersistSnapshot, kQueueCapacity> queue;
+  std::vector<PersistSnapshot> stash;  // Producer-owned overflow
+
+  Sink sink;
+  std::thread thread;
+  std::mutex wakeMutex;
+  std::condition_variable wakeup;
+  std::atomic<bool> sleeping{false};
+  std::atomic<bool> stopping{false};
+};
+
+// The process-wide writer used for settings and session files.
+BackgroundWriter& GetBackgroundWriter();
+
+#endif  // BACKGROUNDWRITER_H
@@ -0,0 +1,319 @@
+// BarRenderer.cpp - Software rasterizer for the owner-drawn timer bar
+
+#include "BarRenderer.h"
+
+#include <algorithm>
+
+namespace {
+
+// Colors match the child-control bar (0x00RRGGBB)
+constexpr uint32_t kBackColor = 0x2D2D30;
+constexpr uint32_t kTextColor = 0xF0F0F0;
+constexpr uint32_t kProgressBackColor = 0xDCDCDC;
+constexpr uint32_t kQuestionBarColor = 0x00B400;
+constexpr uint32_t kBlockBarColor = 0x0078D7;
+constexpr uint32_t kButtonFaceColor = 0x3E444E;
+constexpr uint32_t kButtonPressedColor = 0x2A2E35;
+constexpr uint32_t kButtonBorderColor = 0x5A606A;
+constexpr uint32_t kButtonTextColor = 0xF0F3F8;
+constexpr uint32_t kButtonDisabledTextColor = 0x80848C;
+
+constexpr wchar_t kGearChar = 0x2699;
+constexpr int kFirstAsciiChar = 0x20;
+constexpr int kLastAsciiChar = 0x7E;
+
+// Built-in 5x7 font: one byte per row, bit 4 is the leftmost pixel.
+struct BuiltinGlyph {
+  wchar_t ch;
+  uint8_t rows[7];
+};
+
+constexpr BuiltinGlyph kBuiltinGlyphs[] = {
+    {L'-', {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}},
+    {L'/', {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}},
+    {L'0', {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}},
+    {L'1', {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}},
+    {L'2', {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}},
+    {L'3', {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}},
+    {L'4', {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}},
+    {L'5', {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}},
+    {L'6', {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}},
+    {L'7', {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}},
+    {L'8', {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}},
+    {L'9', {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}},
+    {L':', {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}},
+    {L'B', {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}},
+    {L'P', {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}},
+    {L'Q', {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}},
+    {L'R', {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}},
+    {L'S', {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}},
+    {L'X', {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}},
+    {L'a', {0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F}},
+    {L'c', {0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E}},
+    {L'e', {0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E}},
+    {L'k', {0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12}},
+    {L'l', {0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}},
+    {L'm', {0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11}},
+    {L'o', {0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E}},
+    {L'p', {0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10}},
+    {L'r', {0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10}},
+    {L's', {0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E}},
+    {L't', {0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06}},
+    {L'u', {0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D}},
+    {kGearChar, {0x04, 0x15, 0x0E, 0x1B, 0x0E, 0x15, 0x04}},
+};
+
+// Drawn for characters the built-in font lacks: a hollow box.
+constexpr uint8_t kMissingGlyphRows[7] = {0x1F, 0x11, 0x11, 0x11,
+                                          0x11, 0x11, 0x1F};
+
+const uint8_t* FindBuiltinRows(wchar_t ch) {
+  if (ch == L' ') return nullptr;
+  for (const BuiltinGlyph& glyph : kBuiltinGlyphs) {
+    if (glyph.ch == ch) return glyph.rows;
+  }
+  return kMissingGlyphRows;
+}
+
+uint32_t Blend(uint32_t back, uint32_t fore, unsigned alpha) {
+  uint32_t result = 0;
+  for (int shift = 0; shift <= 16; shift += 8) {
+    const unsigned b = (back >> shift) & 0xFF;
+    const unsigned f = (fore >> shift) & 0xFF;
+    const unsigned c = (b * (255 - alpha) + f * alpha + 127) / 255;
+    result |= c << shift;
+  }
+  return result;
+}
+
+BarRect Intersect(const BarRect& a, const BarRect& b) {
+  BarRect r = {std::max(a.left, b.left), std::max(a.top, b.top),
+               std::min(a.right, b.right), std::min(a.bottom, b.bottom)};
+  if (r.right < r.left) r.right = r.left;
+  if (r.bottom < r.top) r.bottom = r.top;
+  return r;
+}
+
+BarRect Inset(const BarRect& rect, int amount) {
+  BarRect r = {rect.left + amount, rect.top + amount, rect.right - amount,
+               rect.bottom - amount};
+  return r;
+}
+
+}  // namespace
+
+void PixelSurface::FillRect(const BarRect& rect, uint32_t color) {
+  const BarRect bounds = {0, 0, width, height};
+  const BarRect r = Intersect(rect, bounds);
+  for (int y = r.top; y < r.bottom; y++) {
+    uint32_t* row = pixels + static_cast<size_t>(y) * width;
+    std::fill(row + r.left, row + r.right, color);
+  }
+}
+
+const GlyphAtlas::Entry* GlyphAtlas::Find(wchar_t ch) const {
+  const auto it = std::lower_bound(
+      entries.begin(), entries.end(), ch,
+      [](const Entry& entry, wchar_t value) { return entry.ch < value; });
+  if (it == entries.end() || it->ch != ch) return nullptr;
+  return &*it;
+}
+
+int GlyphAtlas::MeasureText(const wchar_t* text) const {
+  int width = 0;
+  for (; *text; text++) {
+    const Entry* entry = Find(*text);
+    if (entry) width += entry->advance;
+  }
+  return width;
+}
+
+int GlyphAtlasCharCount() { return kLastAsciiChar - kFirstAsciiChar + 2; }
+
+wchar_t GlyphAtlasChar(int index) {
+  if (index == GlyphAtlasCharCount() - 1) return kGearChar;
+  return static_cast<wchar_t>(kFirstAsciiChar + index);
+}
+
+void BuildBuiltinGlyphAtlas(int dpi, GlyphAtlas* atlas) {
+  // Scale the 7-pixel cap height to roughly that of a 14px UI font.
+  const int fontHeight = ScaleForDpi(BASE_FONT_SIZE, dpi);
+  const int scale = std::max(1, (fontHeight * 5 + 35) / 70);
+  const int advance = 6 * scale;
+  const int count = GlyphAtlasCharCount();
+
+  atlas->dpi = dpi;
+  atlas->height = 9 * scale;
+  atlas->width = advance * count;
+  atlas->coverage.assign(static_cast<size_t>(atlas->width) * atlas->height, 0);
+  atlas->entries.clear();
+  atlas->entries.reserve(count);
+
+  for (int i = 0; i < count; i++) {
+    const wchar_t ch = GlyphAtlasChar(i);
+    const int x0 = i * advance;
+    atlas->entries.push_back({ch, x0, advance});
+
+    const uint8_t* rows = FindBuiltinRows(ch);
+    if (!rows) continue;
+    for (int row = 0; row < 7; row++) {
+      for (int col = 0; col < 5; col++) {
+        if ((rows[row] & (0x10 >> col)) == 0) continue;
+        for (int sy = 0; sy < scale; sy++) {
+          uint8_t* line = atlas->coverage.data() +
+                          static_cast<size_t>((row + 1) * scale + sy) *
+                              atlas->width;
+          std::fill(line + x0 + col * scale, line + x0 + (col + 1) * scale,
+                    static_cast<uint8_t>(255));
+        }
+      }
+    }
+  }
+}
+
+void BarRenderer::DrawText(const BarRect& rect, const wchar_t* text,
+                           uint32_t color, bool center) {
+  if (!atlas || atlas->height == 0) return;
+
+  const BarRect bounds = {0, 0, surface.width, surface.height};
+  const BarRect clip = Intersect(rect, bounds);
+  if (clip.Width() <= 0 || clip.Height() <= 0) return;
+  const uint32_t back = surface.pixels[static_cast<size_t>(clip.top) *
+                                           surface.width + clip.left];
+
+  int x = rect.left;
+  if (center) x += (rect.Width() - atlas->MeasureText(text)) / 2;
+  const int y = rect.top + (rect.Height() - atlas->height) / 2;
+
+  for (; *text; text++) {
+    const GlyphAtlas::Entry* entry = atlas->Find(*text);
+    if (!entry) continue;
+
+    for (int gy = 0; gy < atlas->height; gy++) {
+      const int py = y + gy;
+      if (py < clip.top || py >= clip.bottom) continue;
+      const uint8_t* src = atlas->coverage.data() +
+                           static_cast<size_t>(gy) * atlas->width + entry->x;
+      uint32_t* dst = surface.pixels + static_cast<size_t>(py) * surface.width;
+      for (int gx = 0; gx < entry->advance; gx++) {
+        const int px = x + gx;
+        if (px < clip.left || px >= clip.right || src[gx] == 0) continue;
+        dst[px] = Blend(back, color, src[gx]);
+      }
+    }
+    x += entry->advance;
+  }
+}
+
+void BarRenderer::PaintElement(int element, const TimerViewModel& view) {
+  const BarRect& rect = layout.rects[element];
+  elementsPainted++;
+  pixelsPainted += static_cast<uint64_t>(rect.Width()) * rect.Height();
+
+  switch (element) {
+    case kElementQuestionLabel:
+    case kElementBlockLabel: {
+      surface.FillRect(rect, kBackColor);
+      DrawText(rect,
+               element == kElementQuestionLabel ? view.questionLabel
+                                                : view.blockLabel,
+               kTextColor, false);
+      break;
+    }
+
+    case kElementQuestionTime:
+    case kElementBlockTime: {
+      surface.FillRect(rect, kBackColor);
+      DrawText(rect,
+               element == kElementQuestionTime ? view.questionTime
+                                               : view.blockTime,
+               kTextColor, true);
+      break;
+    }
+
+    case kElementQuestionProgress:
+    case kElementBlockProgress: {
+      const bool question = element == kElementQuestionProgress;
+      int filled = question ? view.questionProgress : view.blockProgress;
+      filled = std::min(rect.Width(), std::max(0, filled));
+      BarRect fill = rect;
+      fill.right = rect.left + filled;
+      surface.FillRect(rect, kProgressBackColor);
+      surface.FillRect(fill, question ? kQuestionBarColor : kBlockBarColor);
+      break;
+    }
+
+    case kElementSettingsButton:
+    case kElementCloseButton:
+    case kElementStartStopButton:
+    case kElementPauseButton: {
+      const wchar_t gear[] = {kGearChar, 0};
+      const wchar_t* text = gear;
+      uint32_t textColor = kButtonTextColor;
+      if (element == kElementCloseButton) {
+        text = L"X";
+      } else if (element == kElementStartStopButton) {
+        text = view.startStopText;
+      } else if (element == kElementPauseButton) {
+        text = view.pauseText;
+        if (!view.pauseEnabled) textColor = kButtonDisabledTextColor;
+      }
+
+      const bool pressed = element == pressedElement;
+      surface.FillRect(rect, kButtonBorderColor);
+      surface.FillRect(Inset(rect, 1),
+                       pressed ? kButtonPressedColor : kButtonFaceColor);
+      DrawText(Inset(rect, 1), text, textColor, true);
+      break;
+    }
+  }
+}
+
+void BarRenderer::RenderAll(const TimerViewModel& view) {
+  const BarRect whole = {0, 0, surface.width, surface.height};
+  surface.FillRect(whole, kBackColor);
+  pixelsPainted += static_cast<uint64_t>(whole.Width()) * whole.Height();
+  for (int element = 0; element < kTimerElementCount; element++) {
+    PaintElement(element, view);
+  }
+  dirty[0] = whole;
+  dirtyCount = 1;
+}
+
+int BarRenderer::Render(const TimerViewModel& view, unsigned changedFields) {
+  static const struct {
+    unsigned fields;
+    int element;
+  } kFieldElements[] = {
+      {kViewQuestionLabel, kElementQuestionLabel},
+      {kViewQuestionTime, kElementQuestionTime},
+      {kViewQuestionProgress, kElementQuestionProgress},
+      {kViewBlockLabel, kElementBlockLabel},
+      {kViewBlockTime, kElementBlockTime},
+      {kViewBlockProgress, kElementBlockProgress},
+      {kViewStartStopText, kElementStartStopButton},
+      {kViewPauseText | kViewPauseEnabled, kElementPauseButton},
+  };
+
+  dirtyCount = 0;
+  for (const auto& mapping : kFieldElements) {
+    if ((changedFields & mapping.fields) == 0) continue;
+    PaintElement(mapping.element, view);
+    dirty[dirtyCount++] = layout.rects[mapping.element];
+  }
+  return dirtyCount;
+}
+
+int BarRenderer::SetPressed(int element, const TimerViewModel& view) {
+  dirtyCount = 0;
+  if (element == pressedElement) return 0;
+
+  const int previous = pressedElement;
+  pressedElement = element;
+  for (int changed : {previous, element}) {
+    if (changed < 0) continue;
+    PaintElement(changed, view);
+    dirty[dirtyCount++] = layout.rects[changed];
+  }
+  return dirtyCount;
+}
@@ -0,0 +1,112 @@
+// BarRenderer.h - Platform-neutral software renderer for the timer bar
+
+#ifndef BARRENDERER_H
+#define BARRENDERER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "TimerLayout.h"
+#include "TimerViewModel.h"
+
+// 32-bit 0x00RRGGBB pixels, top-down rows. Either owns its pixels or renders
+// straight into external memory such as a Win32 DIB section.
+struct PixelSurface {
+  uint32_t* pixels = nullptr;
+  int width = 0;
+  int height = 0;
+  std::vector<uint32_t> storage;
+
+  void Allocate(int w, int h) {
+    storage.assign(static_cast<size_t>(w) * h, 0);
+    pixels = storage.data();
+    width = w;
+    height = h;
+  }
+
+  void Attach(uint32_t* external, int w, int h) {
+    storage.clear();
+    pixels = external;
+    width = w;
+    height = h;
+  }
+
+  void FillRect(const BarRect& rect, uint32_t color);
+};
+
+// Pre-rasterized coverage masks for the characters the bar can show, built
+// once per DPI. All glyphs share one row of height pixels.
+struct GlyphAtlas {
+  struct Entry {
+    wchar_t ch;
+    int x;        // Left edge in the atlas
+    int advance;  // Width in pixels
+  };
+
+  int dpi = 0;
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> coverage;  // width * height, 0-255
+  std::vector<Entry> entries;     // Sorted by ch
+
+  const Entry* Find(wchar_t ch) const;
+  int MeasureText(const wchar_t* text) const;
+};
+
+// Characters every atlas provides: printable ASCII plus the settings gear.
+int GlyphAtlasCharCount();
+wchar_t GlyphAtlasChar(int index);
+
+// Fills atlas from a built-in 5x7 pixel font scaled to dpi. Deterministic on
+// every platform, so renders can be compared pixel for pixel.
+void BuildBuiltinGlyphAtlas(int dpi, GlyphAtlas* atlas);
+
+// Keeps one atlas per DPI so moving between monitors never re-rasterizes.
+struct GlyphAtlasCache {
+  std::vector<std::unique_ptr<GlyphAtlas>> atlases;
+
+  // Returns the atlas for dpi, calling build(dpi, atlas) to create it once.
+  template <typename Builder>
+  const GlyphAtlas& Get(int dpi, Builder build) {
+    for (const auto& atlas : atlases) {
+      if (atlas->dpi == dpi) return *atlas;
+    }
+    atlases.push_back(std::make_unique<GlyphAtlas>());
+    build(dpi, atlases.back().get());
+    atlases.back()->dpi = dpi;
+    return *atlases.back();
+  }
+};
+
+// Paints the whole timer bar into one back buffer and reports the rectangles
+// that changed, so the window only has to blit those.
+struct BarRenderer {
+  PixelSurface surface;  // Sized to layout.windowWidth x windowHeight
+  TimerLayout layout = {};
+  const GlyphAtlas* atlas = nullptr;
+  int pressedElement = -1;
+
+  BarRect dirty[kTimerElementCount];
+  int dirtyCount = 0;
+
+  uint64_t elementsPainted = 0;  // Instrumentation
+  uint64_t pixelsPainted = 0;
+
+  // Paints every element; the whole surface becomes one dirty rectangle.
+  void RenderAll(const TimerViewModel& view);
+
+  // Repaints only the elements affected by changedFields (a TimerViewField
+  // mask). Returns the number of dirty rectangles.
+  int Render(const TimerViewModel& view, unsigned changedFields);
+
+  // Shows element as pressed (-1 for none) and repaints affected buttons.
+  int SetPressed(int element, const TimerViewModel& view);
+
+ private:
+  void PaintElement(int element, const TimerViewModel& view);
+  void DrawText(const BarRect& rect, const wchar_t* text, uint32_t color,
+                bool center);
+};
+
+#endif  // BARRENDERER_H
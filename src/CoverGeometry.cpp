@@ -0,0 +1,172 @@
+// CoverGeometry.cpp - Cover square clamping, resizing and hit-testing
+
+#include "CoverGeometry.h"
+
+namespace {
+
+bool ResizingLeft(DragMode mode) {
+  return mode == DragMode::Left || mode == DragMode::TopLeft ||
+         mode == DragMode::BottomLeft;
+}
+
+bool ResizingRight(DragMode mode) {
+  return mode == DragMode::Right || mode == DragMode::TopRight ||
+         mode == DragMode::BottomRight;
+}
+
+bool ResizingTop(DragMode mode) {
+  return mode == DragMode::Top || mode == DragMode::TopLeft ||
+         mode == DragMode::TopRight;
+}
+
+bool ResizingBottom(DragMode mode) {
+  return mode == DragMode::Bottom || mode == DragMode::BottomLeft ||
+         mode == DragMode::BottomRight;
+}
+
+}  // namespace
+
+CoverLimits ComputeCoverLimits(const CoverRect& virtualScreen, int margin,
+                               int minSize) {
+  CoverLimits limits = {};
+  limits.bounds.left = virtualScreen.left + margin;
+  limits.bounds.top = virtualScreen.top + margin;
+  limits.bounds.right = virtualScreen.right - margin;
+  limits.bounds.bottom = virtualScreen.bottom - margin;
+
+  if (limits.bounds.right <= limits.bounds.left) {
+    limits.bounds.right = limits.bounds.left + 1;
+  }
+  if (limits.bounds.bottom <= limits.bounds.top) {
+    limits.bounds.bottom = limits.bounds.top + 1;
+  }
+
+  limits.minWidth = minSize;
+  limits.minHeight = minSize;
+
+  const int maxWidth = limits.bounds.Width();
+  const int maxHeight = limits.bounds.Height();
+  if (limits.minWidth > maxWidth) limits.minWidth = maxWidth;
+  if (limits.minHeight > maxHeight) limits.minHeight = maxHeight;
+
+  return limits;
+}
+
+void ClampRectToBounds(CoverRect* rect, const CoverRect& bounds) {
+  const int width = rect->Width();
+  const int height = rect->Height();
+  const int boundsWidth = bounds.Width();
+  const int boundsHeight = bounds.Height();
+
+  if (width >= boundsWidth) {
+    rect->left = bounds.left;
+    rect->right = bounds.right;
+  } else {
+    if (rect->left < bounds.left) {
+      rect->left = bounds.left;
+      rect->right = rect->left + width;
+    }
+    if (rect->right > bounds.right) {
+      rect->right = bounds.right;
+      rect->left = rect->right - width;
+    }
+  }
+
+  if (height >= boundsHeight) {
+    rect->top = bounds.top;
+    rect->bottom = bounds.bottom;
+  } else {
+    if (rect->top < bounds.top) {
+      rect->top = bounds.top;
+      rect->bottom = rect->top + height;
+    }
+    if (rect->bottom > bounds.bottom) {
+      rect->bottom = bounds.bottom;
+      rect->top = rect->bottom - height;
+    }
+  }
+}
+
+void EnforceRectConstraints(const CoverLimits& limits, CoverRect* rect) {
+  if (rect->Width() < limits.minWidth) rect->right = rect->left + limits.minWidth;
+  if (rect->Height() < limits.minHeight) {
+    rect->bottom = rect->top + limits.minHeight;
+  }
+
+  const int maxWidth = limits.bounds.Width();
+  const int maxHeight = limits.bounds.Height();
+  if (rect->Width() > maxWidth) rect->right = rect->left + maxWidth;
+  if (rect->Height() > maxHeight) rect->bottom = rect->top + maxHeight;
+
+  ClampRectToBounds(rect, limits.bounds);
+}
+
+void EnforceResizeConstraints(const CoverLimits& limits, CoverRect* rect,
+                              DragMode mode) {
+  if (ResizingLeft(mode)) {
+    if (rect->left < limits.bounds.left) rect->left = limits.bounds.left;
+    if (rect->Width() < limits.minWidth) {
+      rect->left = rect->right - limits.minWidth;
+    }
+  } else if (ResizingRight(mode)) {
+    if (rect->right > limits.bounds.right) rect->right = limits.bounds.right;
+    if (rect->Width() < limits.minWidth) {
+      rect->right = rect->left + limits.minWidth;
+    }
+  }
+
+  if (ResizingTop(mode)) {
+    if (rect->top < limits.bounds.top) rect->top = limits.bounds.top;
+    if (rect->Height() < limits.minHeight) {
+      rect->top = rect->bottom - limits.minHeight;
+    }
+  } else if (ResizingBottom(mode)) {
+    if (rect->bottom > limits.bounds.bottom) {
+      rect->bottom = limits.bounds.bottom;
+    }
+    if (rect->Height() < limits.minHeight) {
+      rect->bottom = rect->top + limits.minHeight;
+    }
+  }
+
+  EnforceRectConstraints(limits, rect);
+}
+
+DragMode HitTestDragMode(const CoverRect& client, int grip, int x, int y) {
+  const bool left = x <= client.left + grip;
+  const bool right = x >= client.right - grip;
+  const bool top = y <= client.top + grip;
+  const bool bottom = y >= client.bottom - grip;
+
+  if (top && left) return DragMode::TopLeft;
+  if (top && right) return DragMode::TopRight;
+  if (bottom && left) return DragMode::BottomLeft;
+  if (bottom && right) return DragMode::BottomRight;
+  if (left) return DragMode::Left;
+  if (right) return DragMode::Right;
+  if (top) return DragMode::Top;
+  if (bottom) return DragMode::Bottom;
+  return DragMode::Move;
+}
+
+CoverRect ApplyDrag(const CoverLimits& limits, DragMode mode,
+                    const CoverRect& startRect, int dx, int dy) {
+  CoverRect next = startRect;
+
+  if (mode == DragMode::None) return next;
+  if (mode == DragMode::Move) {
+    next.left += dx;
+    next.right += dx;
+    next.top += dy;
+    next.bottom += dy;
+    ClampRectToBounds(&next, limits.bounds);
+    return next;
+  }
+
+  if (ResizingLeft(mode)) next.left += dx;
+  if (ResizingRight(mode)) next.right += dx;
+  if (ResizingTop(mode)) next.top += dy;
+  if (ResizingBottom(mode)) next.bottom += dy;
+  EnforceResizeConstraints(limits, &next, mode);
+  return next;
+}
@@ -0,0 +1,63 @@
+// CoverGeometry.h - Platform-neutral move/resize math for the cover square
+
+#ifndef COVERGEOMETRY_H
+#define COVERGEOMETRY_H
+
+// Screen rectangle (right/bottom exclusive), layout-compatible with the
+// Win32 RECT.
+struct CoverRect {
+  int left;
+  int top;
+  int right;
+  int bottom;
+
+  int Width() const { return right - left; }
+  int Height() const { return bottom - top; }
+};
+
+enum class DragMode {
+  None,
+  Move,
+  Left,
+  Right,
+  Top,
+  Bottom,
+  TopLeft,
+  TopRight,
+  BottomLeft,
+  BottomRight
+};
+
+// Where the cover may go and how small it may get, in physical pixels.
+struct CoverLimits {
+  CoverRect bounds;
+  int minWidth;
+  int minHeight;
+};
+
+// Limits for a cover on a virtual desktop spanning virtualScreen, kept margin
+// pixels inside its edges and at least minSize pixels on each side (shrunk to
+// fit if the desktop is smaller).
+CoverLimits ComputeCoverLimits(const CoverRect& virtualScreen, int margin,
+                               int minSize);
+
+// Slides rect inside bounds without resizing it, unless it is larger.
+void ClampRectToBounds(CoverRect* rect, const CoverRect& bounds);
+
+// Applies the minimum and maximum size, then clamps into the bounds.
+void EnforceRectConstraints(const CoverLimits& limits, CoverRect* rect);
+
+// Like EnforceRectConstraints, but keeps the edges opposite the ones being
+// dragged in mode fixed.
+void EnforceResizeConstraints(const CoverLimits& limits, CoverRect* rect,
+                              DragMode mode);
+
+// Drag mode for a press at client point (x, y) of a client rectangle, with
+// resize grips grip pixels wide along every edge.
+DragMode HitTestDragMode(const CoverRect& client, int grip, int x, int y);
+
+// Rectangle after dragging startRect by (dx, dy) in mode, within limits.
+CoverRect ApplyDrag(const CoverLimits& limits, DragMode mode,
+                    const CoverRect& startRect, int dx, int dy);
+
+#endif  // COVERGEOMETRY_H
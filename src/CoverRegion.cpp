@@ -0,0 +1,173 @@
+// CoverRegion.cpp - Sweep-line rectangle union and grid hit-testing
+
+#include "CoverRegion.h"
+
+#include <algorithm>
+
+namespace {
+
+bool IsEmpty(const CoverRect& rect) {
+  return rect.right <= rect.left || rect.bottom <= rect.top;
+}
+
+}  // namespace
+
+CoverRect GetCoverBounds(const std::vector<CoverRect>& rects) {
+  CoverRect bounds = {0, 0, 0, 0};
+  bool first = true;
+  for (const CoverRect& rect : rects) {
+    if (IsEmpty(rect)) continue;
+    if (first) {
+      bounds = rect;
+      first = false;
+      continue;
+    }
+    bounds.left = std::min(bounds.left, rect.left);
+    bounds.top = std::min(bounds.top, rect.top);
+    bounds.right = std::max(bounds.right, rect.right);
+    bounds.bottom = std::max(bounds.bottom, rect.bottom);
+  }
+  return bounds;
+}
+
+std::vector<CoverRect> ComputeRectUnion(const std::vector<CoverRect>& rects) {
+  std::vector<int> edges;
+  std::vector<int> byTop;
+  edges.reserve(rects.size() * 2);
+  byTop.reserve(rects.size());
+  for (int i = 0; i < static_cast<int>(rects.size()); i++) {
+    if (IsEmpty(rects[i])) continue;
+    edges.push_back(rects[i].top);
+    edges.push_back(rects[i].bottom);
+    byTop.push_back(i);
+  }
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+  std::sort(byTop.begin(), byTop.end(), [&rects](int a, int b) {
+    return rects[a].top < rects[b].top;
+  });
+
+  std::vector<CoverRect> result;
+  std::vector<int> active;
+  std::vector<CoverRect> spans;  // Current band; only left/right are used
+  size_t nextRect = 0;
+  size_t bandStart = 0;  // First rect of the previous band in result
+  bool bandOpen = false;  // Previous band ends where the current one begins
+
+  for (size_t e = 0; e + 1 < edges.size(); e++) {
+    const int top = edges[e];
+    const int bottom = edges[e + 1];
+
+    // Sweep: drop rects that ended, add rects that start at this edge. The
+    // active list stays sorted by left edge, so each band is one linear merge.
+    active.erase(std::remove_if(active.begin(), active.end(),
+                                [&rects, top](int i) {
+                                  return rects[i].bottom <= top;
+                                }),
+                 active.end());
+    while (nextRect < byTop.size() && rects[byTop[nextRect]].top <= top) {
+      const int added = byTop[nextRect++];
+      active.insert(std::upper_bound(active.begin(), active.end(), added,
+                                     [&rects](int a, int b) {
+                                       return rects[a].left < rects[b].left;
+                                     }),
+                    added);
+    }
+
+    spans.clear();
+    for (int i : active) {
+      if (!spans.empty() && rects[i].left <= spans.back().right) {
+        spans.back().right = std::max(spans.back().right, rects[i].right);
+      } else {
+        spans.push_back(rects[i]);
+      }
+    }
+
+    if (spans.empty()) {
+      bandOpen = false;
+      continue;
+    }
+
+    // Extend the previous band downwards if its spans are identical.
+    bool sameAsPrevious = bandOpen && result.size() - bandStart == spans.size();
+    for (size_t i = 0; sameAsPrevious && i < spans.size(); i++) {
+      sameAsPrevious = result[bandStart + i].left == spans[i].left &&
+                       result[bandStart + i].right == spans[i].right;
+    }
+    if (sameAsPrevious) {
+      for (size_t i = bandStart; i < result.size(); i++) {
+        result[i].bottom = bottom;
+      }
+    } else {
+      bandStart = result.size();
+      for (const CoverRect& span : spans) {
+        result.push_back({span.left, top, span.right, bottom});
+      }
+    }
+    bandOpen = true;
+  }
+
+  return result;
+}
+
+void CoverGridIndex::Build(const std::vector<CoverRect>& rects,
+                           int requestedCellSize) {
+  bounds = GetCoverBounds(rects);
+  cellSize = requestedCellSize > 0 ? requestedCellSize : 1;
+  const int longest = std::max(bounds.Width(), bounds.Height());
+  if (longest / cellSize >= kMaxCellsPerAxis) {
+    cellSize = longest / kMaxCellsPerAxis + 1;
+  }
+  columns = std::max(1, (bounds.Width() + cellSize - 1) / cellSize);
+  rows = std::max(1, (bounds.Height() + cellSize - 1) / cellSize);
+
+  // Two passes (count, then fill) keep every cell's entries contiguous.
+  const int cellCount = columns * rows;
+  cellStart.assign(cellCount + 1, 0);
+  for (int pass = 0; pass < 2; pass++) {
+    std::vector<int> fill;
+    if (pass == 1) {
+      for (int c = 0; c < cellCount; c++) cellStart[c + 1] += cellStart[c];
+      entries.assign(cellStart[cellCount], 0);
+      fill.assign(cellStart.begin(), cellStart.end() - 1);
+    }
+    for (int i = 0; i < static_cast<int>(rects.size()); i++) {
+      const CoverRect& rect = rects[i];
+      if (IsEmpty(rect)) continue;
+      const int col0 = (rect.left - bounds.left) / cellSize;
+      const int col1 = (rect.right - 1 - bounds.left) / cellSize;
+      const int row0 = (rect.top - bounds.top) / cellSize;
+      const int row1 = (rect.bottom - 1 - bounds.top) / cellSize;
+      for (int row = row0; row <= row1; row++) {
+        for (int col = col0; col <= col1; col++) {
+          const int cell = row * columns + col;
+          if (pass == 0) {
+            cellStart[cell + 1]++;
+          } else {
+            entries[fill[cell]++] = i;
+          }
+        }
+      }
+    }
+  }
+}
+
+int CoverGridIndex::HitTest(const std::vector<CoverRect>& rects, int x,
+                            int y) const {
+  if (x < bounds.left || x >= bounds.right || y < bounds.top ||
+      y >= bounds.bottom || cellStart.empty()) {
+    return -1;
+  }
+  const int col = (x - bounds.left) / cellSize;
+  const int row = (y - bounds.top) / cellSize;
+  const int cell = row * columns + col;
+
+  // Entries are in ascending index order, so scan from the topmost down.
+  for (int e = cellStart[cell + 1] - 1; e >= cellStart[cell]; e--) {
+    const CoverRect& rect = rects[entries[e]];
+    if (x >= rect.left && x < rect.right && y >= rect.top && y < rect.bottom) {
+      return entries[e];
+    }
+  }
+  return -1;
+}
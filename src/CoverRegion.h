@@ -0,0 +1,44 @@
+// CoverRegion.h - Union and hit-testing of several cover rectangles
+
+#ifndef COVERREGION_H
+#define COVERREGION_H
+
+#include <vector>
+
+#include "CoverGeometry.h"
+
+// Smallest rectangle containing every rect; empty (all zero) if there are
+// none.
+CoverRect GetCoverBounds(const std::vector<CoverRect>& rects);
+
+// Union of rects as disjoint rectangles in y-x banded order: sorted by top,
+// then by left, each horizontal band split into maximal spans, and
+// vertically adjacent bands with identical spans merged. This is the layout
+// ExtCreateRegion() expects, so the result can be handed to it directly.
+// Computed with a sweep over the distinct top/bottom edges; empty rects are
+// ignored.
+std::vector<CoverRect> ComputeRectUnion(const std::vector<CoverRect>& rects);
+
+// Uniform grid over the bounds of a set of rects, used to find the rect under
+// a point without testing all of them. Each cell lists the rects overlapping
+// it in ascending index order. Rebuild whenever the rects change.
+struct CoverGridIndex {
+  static constexpr int kMaxCellsPerAxis = 64;
+
+  CoverRect bounds = {0, 0, 0, 0};
+  int cellSize = 1;
+  int columns = 0;
+  int rows = 0;
+  std::vector<int> cellStart;  // columns * rows + 1 offsets into entries
+  std::vector<int> entries;    // Rect indices, grouped by cell
+
+  // Indexes rects using square cells of about cellSize pixels, grown as
+  // needed to keep at most kMaxCellsPerAxis cells along each axis.
+  void Build(const std::vector<CoverRect>& rects, int cellSize);
+
+  // Index of the topmost (last) rect containing (x, y), or -1. rects must be
+  // the vector the index was built from.
+  int HitTest(const std::vector<CoverRect>& rects, int x, int y) const;
+};
+
+#endif  // COVERREGION_H
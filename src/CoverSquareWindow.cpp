@@ -2,44 +2,81 @@
 
 #include <windowsx.h>
 
+#include <chrono>
 #include <string>
+#include <vector>
+
+#include "BackgroundWriter.h"
+#include "CoverGeometry.h"
+#include "CoverRegion.h"
+#include "FramePacer.h"
+#include "SettingsStore.h"
 
 namespace {
 
 constexpr wchar_t kCoverSquareClassName[] = L"WolfTimerCoverSquareClass";
-constexpr wchar_t kSettingsSection[] = L"CoverSquare";
-constexpr wchar_t kSettingsKeyX[] = L"x";
-constexpr wchar_t kSettingsKeyY[] = L"y";
-constexpr wchar_t kSettingsKeyWidth[] = L"width";
-constexpr wchar_t kSettingsKeyHeight[] = L"height";
-constexpr wchar_t kSettingsKeyLegacySize[] = L"size";
+constexpr char kSettingsSection[] = "CoverSquare";
+constexpr char kSettingsKeyX[] = "x";
+constexpr char kSettingsKeyY[] = "y";
+constexpr char kSettingsKeyWidth[] = "width";
+constexpr char kSettingsKeyHeight[] = "height";
+constexpr char kSettingsKeyLegacySize[] = "size";
+constexpr char kSettingsKeyCount[] = "count";
+constexpr char kSettingsKeyRefreshRate[] = "refreshRate";  // 0 = detect
+constexpr wchar_t kSettingsFileName[] = L"cover_square.ini";
 constexpr wchar_t kFallbackSettingsFile[] = L".\\session_timer_cover_square.ini";
+constexpr UINT_PTR kSettingsFlushTimer = 1;
+constexpr UINT kSettingsFlushDelayMs = 500;  // Coalesces bursts of saves
+constexpr UINT_PTR kDragFrameTimer = 2;
 
 constexpr int kBaseInitialSize = 260;     // @96 DPI
 constexpr int kBaseMinSize = 120;         // @96 DPI
 constexpr int kBaseResizeGrip = 12;       // @96 DPI
 constexpr int kBaseScreenMargin = 8;      // @96 DPI
+constexpr int kBaseIndexCellSize = 128;   // @96 DPI
+constexpr int kMaxCovers = 256;
 constexpr UINT_PTR kCoverMenuSettings = 1;
 constexpr UINT_PTR kCoverMenuClose = 2;
-
-enum class DragMode {
-  None,
-  Move,
-  Left,
-  Right,
-  Top,
-  Bottom,
-  TopLeft,
-  TopRight,
-  BottomLeft,
-  BottomRight
+constexpr UINT_PTR kCoverMenuAdd = 3;
+constexpr UINT_PTR kCoverMenuRemove = 4;
+
+// Cursors shown over each DragMode, indexed by the enum value.
+constexpr int kDragModeCount = static_cast<int>(DragMode::BottomRight) + 1;
+
+// Everything the drag path needs that depends on DPI or the display layout.
+// Snapshotted at creation and on DPI/display changes, so clicks, mouse moves
+// and hovers never query the system.
+struct CoverMetrics {
+  CoverLimits limits = {};
+  int initialSize = 0;
+  int grip = 0;
+  int indexCellSize = 0;
+  int refreshRate = 0;  // Hz of the monitor showing the window
+  HCURSOR cursors[kDragModeCount] = {};
 };
 
+// One overlay window shows every cover: it spans their bounding box and its
+// window region is their union, so the desktop shows through the gaps.
 struct CoverSquareData {
+  std::vector<CoverRect> covers;        // Screen coordinates, bottom first
+  std::vector<CoverRect> regionRects;   // Window region last applied
+  CoverRect windowRect = {0, 0, 0, 0};  // Window bounds last applied
+  CoverGridIndex index;                 // Built over covers
+
   bool dragging = false;
   DragMode dragMode = DragMode::None;
+  int dragCover = -1;
   POINT dragStartCursor = {0, 0};  // Screen coordinates
-  RECT dragStartRect = {0, 0, 0, 0};
+  CoverRect dragStartRect = {0, 0, 0, 0};
+  CoverRect dragTargetRect = {0, 0, 0, 0};  // Newest unapplied drag result
+  FramePacer dragPacer;
+  bool dragTimerArmed = false;
+
+  // Instrumentation
+  uint64_t drags = 0;         // Drags ended
+  uint64_t paints = 0;        // WM_PAINT calls
+  uint64_t pixelsFilled = 0;  // Total area of the painted rectangles
+  CoverMetrics metrics;
   HWND hController = nullptr;
 };
 
@@ -49,37 +86,30 @@ struct CoverSquareCreateParams {
 
 int ScaleForDpi(int value, UINT dpi) { return MulDiv(value, dpi, 96); }
 
-std::wstring GetSettingsFilePath() {
-  wchar_t appDataPath[MAX_PATH] = {};
-  const DWORD pathLen =
-      GetEnvironmentVariableW(L"APPDATA", appDataPath, _countof(appDataPath));
-  if (pathLen == 0 || pathLen >= _countof(appDataPath)) {
-    return kFallbackSettingsFile;
+// The cover square's settings, loaded from disk on first use only.
+SettingsStore& GetCoverSettings() {
+  static SettingsStore store;
+  static bool loaded = false;
+  if (!loaded) {
+    const std::filesystem::path& dir = GetSettingsDirectory();
+    store.Load(dir.empty() ? std::filesystem::path(kFallbackSettingsFile)
+                           : dir / kSettingsFileName);
+    loaded = true;
   }
-
-  std::wstring settingsDir = std::wstring(appDataPath) + L"\\WolfTimer";
-  CreateDirectoryW(settingsDir.c_str(), nullptr);
-  return settingsDir + L"\\cover_square.ini";
+  return store;
 }
 
-bool ReadIntSetting(const std::wstring& settingsFile, const wchar_t* key,
-                    int* value) {
-  wchar_t text[32] = {};
-  GetPrivateProfileStringW(kSettingsSection, key, L"", text, _countof(text),
-                           settingsFile.c_str());
-  if (text[0] == L'\0') {
-    return false;
-  }
-
-  *value = _wtoi(text);
-  return true;
+// Hands pending settings to the writer thread now instead of when the
+// coalescing timer fires. The window procedure never waits on the disk.
+void FlushSettings(HWND hWnd) {
+  KillTimer(hWnd, kSettingsFlushTimer);
+  GetCoverSettings().FlushTo(&GetBackgroundWriter());
 }
 
-void WriteIntSetting(const std::wstring& settingsFile, const wchar_t* key,
-                     int value) {
-  wchar_t text[32] = {};
-  swprintf_s(text, L"%d", value);
-  WritePrivateProfileStringW(kSettingsSection, key, text, settingsFile.c_str());
+int64_t NowMicroseconds() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
 }
 
 UINT GetWindowDpi(HWND hWnd) {
@@ -93,196 +123,85 @@ UINT GetWindowDpi(HWND hWnd) {
   return dpi == 0 ? 96 : dpi;
 }
 
-RECT GetVirtualDesktopBounds(HWND hWnd) {
-  const UINT dpi = GetWindowDpi(hWnd);
-  const int margin = ScaleForDpi(kBaseScreenMargin, dpi);
-
-  RECT bounds = {};
-  bounds.left = GetSystemMetrics(SM_XVIRTUALSCREEN) + margin;
-  bounds.top = GetSystemMetrics(SM_YVIRTUALSCREEN) + margin;
-  bounds.right =
-      GetSystemMetrics(SM_XVIRTUALSCREEN) + GetSystemMetrics(SM_CXVIRTUALSCREEN) - margin;
-  bounds.bottom =
-      GetSystemMetrics(SM_YVIRTUALSCREEN) + GetSystemMetrics(SM_CYVIRTUALSCREEN) - margin;
-
-  if (bounds.right <= bounds.left) bounds.right = bounds.left + 1;
-  if (bounds.bottom <= bounds.top) bounds.bottom = bounds.top + 1;
-  return bounds;
+CoverLimits GetDesktopLimits(UINT dpi) {
+  CoverRect screen = {};
+  screen.left = GetSystemMetrics(SM_XVIRTUALSCREEN);
+  screen.top = GetSystemMetrics(SM_YVIRTUALSCREEN);
+  screen.right = screen.left + GetSystemMetrics(SM_CXVIRTUALSCREEN);
+  screen.bottom = screen.top + GetSystemMetrics(SM_CYVIRTUALSCREEN);
+  return ComputeCoverLimits(screen, ScaleForDpi(kBaseScreenMargin, dpi),
+                            ScaleForDpi(kBaseMinSize, dpi));
 }
 
-struct WindowLimits {
-  RECT bounds;
-  int minWidth;
-  int minHeight;
-};
-
-WindowLimits GetWindowLimits(HWND hWnd) {
-  WindowLimits limits = {};
-  limits.bounds = GetVirtualDesktopBounds(hWnd);
-
-  const UINT dpi = GetWindowDpi(hWnd);
-  limits.minWidth = ScaleForDpi(kBaseMinSize, dpi);
-  limits.minHeight = ScaleForDpi(kBaseMinSize, dpi);
-
-  const int maxWidth = limits.bounds.right - limits.bounds.left;
-  const int maxHeight = limits.bounds.bottom - limits.bounds.top;
-
-  if (limits.minWidth > maxWidth) limits.minWidth = maxWidth;
-  if (limits.minHeight > maxHeight) limits.minHeight = maxHeight;
-
-  return limits;
+CoverLimits GetWindowLimits(HWND hWnd) {
+  return GetDesktopLimits(GetWindowDpi(hWnd));
 }
 
-void ClampRectToBounds(RECT* rect, const RECT& bounds) {
-  const int width = rect->right - rect->left;
-  const int height = rect->bottom - rect->top;
-  const int boundsWidth = bounds.right - bounds.left;
-  const int boundsHeight = bounds.bottom - bounds.top;
-
-  if (width >= boundsWidth) {
-    rect->left = bounds.left;
-    rect->right = bounds.right;
-  } else {
-    if (rect->left < bounds.left) {
-      rect->left = bounds.left;
-      rect->right = rect->left + width;
-    }
-    if (rect->right > bounds.right) {
-      rect->right = bounds.right;
-      rect->left = rect->right - width;
-    }
-  }
-
-  if (height >= boundsHeight) {
-    rect->top = bounds.top;
-    rect->bottom = bounds.bottom;
-  } else {
-    if (rect->top < bounds.top) {
-      rect->top = bounds.top;
-      rect->bottom = rect->top + height;
-    }
-    if (rect->bottom > bounds.bottom) {
-      rect->bottom = bounds.bottom;
-      rect->top = rect->bottom - height;
-    }
-  }
-}
-
-bool ResizingLeft(DragMode mode) {
-  return mode == DragMode::Left || mode == DragMode::TopLeft ||
-         mode == DragMode::BottomLeft;
-}
-
-bool ResizingRight(DragMode mode) {
-  return mode == DragMode::Right || mode == DragMode::TopRight ||
-         mode == DragMode::BottomRight;
-}
-
-bool ResizingTop(DragMode mode) {
-  return mode == DragMode::Top || mode == DragMode::TopLeft ||
-         mode == DragMode::TopRight;
+// A cover of the initial size centered on (x, y), kept within the limits.
+CoverRect GetCenteredRect(const CoverMetrics& metrics, int x, int y) {
+  const int size = metrics.initialSize;
+  CoverRect rect = {x - size / 2, y - size / 2, 0, 0};
+  rect.right = rect.left + size;
+  rect.bottom = rect.top + size;
+  EnforceRectConstraints(metrics.limits, &rect);
+  return rect;
 }
 
-bool ResizingBottom(DragMode mode) {
-  return mode == DragMode::Bottom || mode == DragMode::BottomLeft ||
-         mode == DragMode::BottomRight;
+CoverRect GetDefaultRect(const CoverMetrics& metrics) {
+  const CoverRect& bounds = metrics.limits.bounds;
+  return GetCenteredRect(metrics, bounds.left + bounds.Width() / 2,
+                         bounds.top + bounds.Height() / 2);
 }
 
-void EnforceRectConstraints(const WindowLimits& limits, RECT* rect) {
-  int width = rect->right - rect->left;
-  int height = rect->bottom - rect->top;
-
-  if (width < limits.minWidth) rect->right = rect->left + limits.minWidth;
-  if (height < limits.minHeight) rect->bottom = rect->top + limits.minHeight;
-
-  width = rect->right - rect->left;
-  height = rect->bottom - rect->top;
-
-  const int maxWidth = limits.bounds.right - limits.bounds.left;
-  const int maxHeight = limits.bounds.bottom - limits.bounds.top;
-  if (width > maxWidth) rect->right = rect->left + maxWidth;
-  if (height > maxHeight) rect->bottom = rect->top + maxHeight;
-
-  ClampRectToBounds(rect, limits.bounds);
+// The first cover keeps the original key names so existing settings files
+// load unchanged; cover i > 0 appends i ("x1", "width1", ...).
+std::string GetCoverKey(const char* key, size_t cover) {
+  return cover == 0 ? std::string(key) : key + std::to_string(cover);
 }
 
-void EnforceResizeConstraints(HWND hWnd, RECT* rect, DragMode mode) {
-  const WindowLimits limits = GetWindowLimits(hWnd);
-
-  if (ResizingLeft(mode)) {
-    if (rect->left < limits.bounds.left) rect->left = limits.bounds.left;
-    if (rect->right - rect->left < limits.minWidth) {
-      rect->left = rect->right - limits.minWidth;
-    }
-  } else if (ResizingRight(mode)) {
-    if (rect->right > limits.bounds.right) rect->right = limits.bounds.right;
-    if (rect->right - rect->left < limits.minWidth) {
-      rect->right = rect->left + limits.minWidth;
-    }
+void SavePlacement(HWND hWnd, const CoverSquareData& data) {
+  SettingsStore& settings = GetCoverSettings();
+  settings.SetInt(kSettingsSection, kSettingsKeyCount,
+                  static_cast<int>(data.covers.size()));
+  for (size_t i = 0; i < data.covers.size(); i++) {
+    const CoverRect& rect = data.covers[i];
+    settings.SetInt(kSettingsSection, GetCoverKey(kSettingsKeyX, i).c_str(),
+                    rect.left);
+    settings.SetInt(kSettingsSection, GetCoverKey(kSettingsKeyY, i).c_str(),
+                    rect.top);
+    settings.SetInt(kSettingsSection,
+                    GetCoverKey(kSettingsKeyWidth, i).c_str(), rect.Width());
+    settings.SetInt(kSettingsSection,
+                    GetCoverKey(kSettingsKeyHeight, i).c_str(), rect.Height());
   }
 
-  if (ResizingTop(mode)) {
-    if (rect->top < limits.bounds.top) rect->top = limits.bounds.top;
-    if (rect->bottom - rect->top < limits.minHeight) {
-      rect->top = rect->bottom - limits.minHeight;
-    }
-  } else if (ResizingBottom(mode)) {
-    if (rect->bottom > limits.bounds.bottom) rect->bottom = limits.bounds.bottom;
-    if (rect->bottom - rect->top < limits.minHeight) {
-      rect->bottom = rect->top + limits.minHeight;
-    }
+  // (Re)starting the timer folds every save of a burst into one write.
+  if (settings.dirty) {
+    SetTimer(hWnd, kSettingsFlushTimer, kSettingsFlushDelayMs, nullptr);
   }
-
-  EnforceRectConstraints(limits, rect);
-}
-
-RECT GetDefaultRect(HWND hWnd) {
-  const UINT dpi = GetWindowDpi(hWnd);
-  const int defaultSize = ScaleForDpi(kBaseInitialSize, dpi);
-  const WindowLimits limits = GetWindowLimits(hWnd);
-  const RECT bounds = limits.bounds;
-
-  RECT rect = {};
-  rect.left = bounds.left + ((bounds.right - bounds.left) - defaultSize) / 2;
-  rect.top = bounds.top + ((bounds.bottom - bounds.top) - defaultSize) / 2;
-  rect.right = rect.left + defaultSize;
-  rect.bottom = rect.top + defaultSize;
-
-  EnforceRectConstraints(limits, &rect);
-  return rect;
 }
 
-void SavePlacement(HWND hWnd) {
-  RECT rect = {};
-  if (!GetWindowRect(hWnd, &rect)) {
-    return;
-  }
-
-  const int width = rect.right - rect.left;
-  const int height = rect.bottom - rect.top;
-  const std::wstring settingsFile = GetSettingsFilePath();
-  WriteIntSetting(settingsFile, kSettingsKeyX, rect.left);
-  WriteIntSetting(settingsFile, kSettingsKeyY, rect.top);
-  WriteIntSetting(settingsFile, kSettingsKeyWidth, width);
-  WriteIntSetting(settingsFile, kSettingsKeyHeight, height);
-}
-
-void RestorePlacement(HWND hWnd) {
-  RECT rect = GetDefaultRect(hWnd);
-  const std::wstring settingsFile = GetSettingsFilePath();
-
+// Reads cover i from the settings, falling back to rect for missing values.
+CoverRect LoadCoverRect(const SettingsStore& settings, size_t cover,
+                        CoverRect rect) {
   int savedX = 0;
   int savedY = 0;
   int savedWidth = 0;
   int savedHeight = 0;
   int savedLegacySize = 0;
-  const bool hasX = ReadIntSetting(settingsFile, kSettingsKeyX, &savedX);
-  const bool hasY = ReadIntSetting(settingsFile, kSettingsKeyY, &savedY);
-  const bool hasWidth = ReadIntSetting(settingsFile, kSettingsKeyWidth, &savedWidth);
-  const bool hasHeight =
-      ReadIntSetting(settingsFile, kSettingsKeyHeight, &savedHeight);
+  const bool hasX = settings.GetInt(
+      kSettingsSection, GetCoverKey(kSettingsKeyX, cover).c_str(), &savedX);
+  const bool hasY = settings.GetInt(
+      kSettingsSection, GetCoverKey(kSettingsKeyY, cover).c_str(), &savedY);
+  const bool hasWidth = settings.GetInt(
+      kSettingsSection, GetCoverKey(kSettingsKeyWidth, cover).c_str(),
+      &savedWidth);
+  const bool hasHeight = settings.GetInt(
+      kSettingsSection, GetCoverKey(kSettingsKeyHeight, cover).c_str(),
+      &savedHeight);
   const bool hasLegacySize =
-      ReadIntSetting(settingsFile, kSettingsKeyLegacySize, &savedLegacySize);
+      cover == 0 && settings.GetInt(kSettingsSection, kSettingsKeyLegacySize,
+                                    &savedLegacySize);
 
   if (hasX) {
     rect.left = savedX;
@@ -308,36 +227,123 @@ void RestorePlacement(HWND hWnd) {
 
   rect.right = rect.left + width;
   rect.bottom = rect.top + height;
-  EnforceRectConstraints(GetWindowLimits(hWnd), &rect);
+  return rect;
+}
 
-  SetWindowPos(hWnd, HWND_TOPMOST, rect.left, rect.top,
-               rect.right - rect.left, rect.bottom - rect.top, SWP_NOACTIVATE);
+// GDI region made of rects (y-x banded, within width x height).
+HRGN CreateRegionFromRects(const std::vector<CoverRect>& region, int width,
+                           int height) {
+  std::vector<BYTE> buffer(sizeof(RGNDATAHEADER) +
+                           region.size() * sizeof(RECT));
+  RGNDATA* rgnData = reinterpret_cast<RGNDATA*>(buffer.data());
+  rgnData->rdh.dwSize = sizeof(RGNDATAHEADER);
+  rgnData->rdh.iType = RDH_RECTANGLES;
+  rgnData->rdh.nCount = static_cast<DWORD>(region.size());
+  rgnData->rdh.nRgnSize = static_cast<DWORD>(region.size() * sizeof(RECT));
+  rgnData->rdh.rcBound = {0, 0, width, height};
+  RECT* rects = reinterpret_cast<RECT*>(rgnData->Buffer);
+  for (size_t i = 0; i < region.size(); i++) {
+    rects[i] = {region[i].left, region[i].top, region[i].right,
+                region[i].bottom};
+  }
+  return ExtCreateRegion(nullptr, static_cast<DWORD>(buffer.size()), rgnData);
 }
 
-DragMode HitTestDragMode(HWND hWnd, int x, int y) {
-  RECT rc = {};
-  GetClientRect(hWnd, &rc);
+// Sets the window region to the union of the covers (in window coordinates)
+// and the window bounds to their bounding box, skipping whichever did not
+// change, and rebuilds the hit-test index.
+//
+// Nothing is repainted wholesale: the class has no CS_HREDRAW/CS_VREDRAW, so
+// a resize keeps the existing client pixels (anchored top-left) and the
+// system only invalidates area outside the old client rect. Because every
+// visible pixel is the same black, the only other area that needs painting
+// is the part of the new region the old region did not cover.
+void ApplyCovers(HWND hWnd, CoverSquareData* data) {
+  const CoverRect bounds = GetCoverBounds(data->covers);
+  std::vector<CoverRect> region = ComputeRectUnion(data->covers);
+  for (CoverRect& rect : region) {
+    rect.left -= bounds.left;
+    rect.right -= bounds.left;
+    rect.top -= bounds.top;
+    rect.bottom -= bounds.top;
+  }
 
-  const UINT dpi = GetWindowDpi(hWnd);
-  const int grip = ScaleForDpi(kBaseResizeGrip, dpi);
-
-  const bool left = x <= rc.left + grip;
-  const bool right = x >= rc.right - grip;
-  const bool top = y <= rc.top + grip;
-  const bool bottom = y >= rc.bottom - grip;
-
-  if (top && left) return DragMode::TopLeft;
-  if (top && right) return DragMode::TopRight;
-  if (bottom && left) return DragMode::BottomLeft;
-  if (bottom && right) return DragMode::BottomRight;
-  if (left) return DragMode::Left;
-  if (right) return DragMode::Right;
-  if (top) return DragMode::Top;
-  if (bottom) return DragMode::Bottom;
-  return DragMode::Move;
+  const bool moved = bounds.left != data->windowRect.left ||
+                     bounds.top != data->windowRect.top ||
+                     bounds.right != data->windowRect.right ||
+                     bounds.bottom != data->windowRect.bottom;
+  bool reshaped = region.size() != data->regionRects.size();
+  for (size_t i = 0; !reshaped && i < region.size(); i++) {
+    const CoverRect& a = region[i];
+    const CoverRect& b = data->regionRects[i];
+    reshaped = a.left != b.left || a.top != b.top || a.right != b.right ||
+               a.bottom != b.bottom;
+  }
+
+  HRGN hExposed = nullptr;
+  if (reshaped) {
+    HRGN hRgn = CreateRegionFromRects(region, bounds.Width(), bounds.Height());
+    if (hRgn) {
+      hExposed = CreateRectRgn(0, 0, 0, 0);
+      HRGN hOld = CreateRegionFromRects(data->regionRects,
+                                        data->windowRect.Width(),
+                                        data->windowRect.Height());
+      if (hExposed &&
+          CombineRgn(hExposed, hRgn, hOld, hOld ? RGN_DIFF : RGN_COPY) ==
+              ERROR) {
+        DeleteObject(hExposed);
+        hExposed = nullptr;
+      }
+      if (hOld) DeleteObject(hOld);
+
+      // The system owns the region once SetWindowRgn succeeds.
+      if (!SetWindowRgn(hWnd, hRgn, FALSE)) DeleteObject(hRgn);
+    }
+    data->regionRects = std::move(region);
+  }
+
+  if (moved) {
+    SetWindowPos(hWnd, HWND_TOPMOST, bounds.left, bounds.top, bounds.Width(),
+                 bounds.Height(), SWP_NOACTIVATE);
+    data->windowRect = bounds;
+  }
+
+  if (hExposed) {
+    InvalidateRgn(hWnd, hExposed, FALSE);
+    DeleteObject(hExposed);
+  }
+
+  data->index.Build(data->covers, data->metrics.indexCellSize);
+}
+
+void RestorePlacement(HWND hWnd, CoverSquareData* data) {
+  const SettingsStore& settings = GetCoverSettings();
+  const CoverRect defaultRect = GetDefaultRect(data->metrics);
+
+  int count = 1;
+  settings.GetInt(kSettingsSection, kSettingsKeyCount, &count);
+  if (count < 1) count = 1;
+  if (count > kMaxCovers) count = kMaxCovers;
+
+  data->covers.clear();
+  for (size_t i = 0; i < static_cast<size_t>(count); i++) {
+    CoverRect rect = LoadCoverRect(settings, i, defaultRect);
+    EnforceRectConstraints(data->metrics.limits, &rect);
+    data->covers.push_back(rect);
+  }
+  ApplyCovers(hWnd, data);
 }
 
-HCURSOR CursorForMode(DragMode mode) {
+// Clamps every cover into the current limits, e.g. after a display change.
+void ReclampCovers(HWND hWnd, CoverSquareData* data) {
+  for (CoverRect& rect : data->covers) {
+    EnforceRectConstraints(data->metrics.limits, &rect);
+  }
+  ApplyCovers(hWnd, data);
+  SavePlacement(hWnd, *data);
+}
+
+HCURSOR LoadCursorForMode(DragMode mode) {
   switch (mode) {
     case DragMode::TopLeft:
     case DragMode::BottomRight:
@@ -359,17 +365,132 @@ HCURSOR CursorForMode(DragMode mode) {
   return LoadCursor(nullptr, IDC_ARROW);
 }
 
+// Refresh rate of the monitor showing the window, overridable through the
+// settings file. Returns 0 if unknown.
+int GetWindowRefreshRate(HWND hWnd) {
+  int configured = 0;
+  if (GetCoverSettings().GetInt(kSettingsSection, kSettingsKeyRefreshRate,
+                                &configured) &&
+      configured > 0) {
+    return configured;
+  }
+
+  MONITORINFOEX monitor = {};
+  monitor.cbSize = sizeof(monitor);
+  if (!GetMonitorInfo(MonitorFromWindow(hWnd, MONITOR_DEFAULTTONEAREST),
+                      &monitor)) {
+    return 0;
+  }
+  DEVMODE mode = {};
+  mode.dmSize = sizeof(mode);
+  if (!EnumDisplaySettings(monitor.szDevice, ENUM_CURRENT_SETTINGS, &mode)) {
+    return 0;
+  }
+  return static_cast<int>(mode.dmDisplayFrequency);
+}
+
+// Re-reads DPI, desktop bounds, refresh rate and cursors into metrics.
+void RefreshCoverMetrics(HWND hWnd, CoverMetrics* metrics) {
+  const UINT dpi = GetWindowDpi(hWnd);
+  metrics->limits = GetDesktopLimits(dpi);
+  metrics->initialSize = ScaleForDpi(kBaseInitialSize, dpi);
+  metrics->grip = ScaleForDpi(kBaseResizeGrip, dpi);
+  metrics->indexCellSize = ScaleForDpi(kBaseIndexCellSize, dpi);
+  metrics->refreshRate = GetWindowRefreshRate(hWnd);
+  for (int mode = 0; mode < kDragModeCount; mode++) {
+    metrics->cursors[mode] = LoadCursorForMode(static_cast<DragMode>(mode));
+  }
+}
+
+// Limits from the last metrics snapshot, or fresh ones before data exists.
+CoverLimits GetCachedLimits(HWND hWnd, const CoverSquareData* data) {
+  return data ? data->metrics.limits : GetWindowLimits(hWnd);
+}
+
+// Cover under screen point pt, or -1, and the drag mode there.
+int HitTestCovers(const CoverSquareData& data, POINT pt, DragMode* mode) {
+  const int cover = data.index.HitTest(data.covers, pt.x, pt.y);
+  *mode = cover < 0 ? DragMode::None
+                    : HitTestDragMode(data.covers[cover], data.metrics.grip,
+                                      pt.x, pt.y);
+  return cover;
+}
+
+void AddCover(HWND hWnd, CoverSquareData* data, POINT center) {
+  if (data->covers.size() >= static_cast<size_t>(kMaxCovers)) return;
+  data->covers.push_back(GetCenteredRect(data->metrics, center.x, center.y));
+  ApplyCovers(hWnd, data);
+  SavePlacement(hWnd, *data);
+}
+
+void RemoveCover(HWND hWnd, CoverSquareData* data, int cover) {
+  if (cover < 0 || data->covers.size() <= 1) return;
+  data->covers.erase(data->covers.begin() + cover);
+  ApplyCovers(hWnd, data);
+  SavePlacement(hWnd, *data);
+}
+
+// Moves the dragged cover to the newest drag result, if one is pending.
+void ApplyPendingDrag(HWND hWnd, CoverSquareData* data) {
+  if (data->dragTimerArmed) {
+    KillTimer(hWnd, kDragFrameTimer);
+    data->dragTimerArmed = false;
+  }
+  if (!data->dragPacer.pending) return;
+
+  if (data->dragCover >= 0 &&
+      data->dragCover < static_cast<int>(data->covers.size())) {
+    data->covers[data->dragCover] = data->dragTargetRect;
+    ApplyCovers(hWnd, data);
+  }
+  data->dragPacer.OnApplied(NowMicroseconds());
+}
+
+// Applies pending drag input now if a frame has passed since the last move,
+// otherwise arms a one-shot timer for the start of the next frame.
+void PaceDrag(HWND hWnd, CoverSquareData* data) {
+  const int64_t delayUs =
+      data->dragPacer.DelayUntilNextFrameUs(NowMicroseconds());
+  if (delayUs < 0) return;
+  if (delayUs == 0) {
+    ApplyPendingDrag(hWnd, data);
+    return;
+  }
+  const UINT delayMs = static_cast<UINT>((delayUs + 999) / 1000);
+  SetTimer(hWnd, kDragFrameTimer, delayMs, nullptr);
+  data->dragTimerArmed = true;
+}
+
+// Ends the drag in progress, if any, and lands the newest position. Returns
+// false if there was no drag.
+bool EndDrag(HWND hWnd, CoverSquareData* data) {
+  if (!data->dragging) return false;
+  ApplyPendingDrag(hWnd, data);
+  data->dragging = false;
+  data->dragMode = DragMode::None;
+  data->dragCover = -1;
+  data->drags++;
+  return true;
+}
+
 CoverSquareData* GetCoverData(HWND hWnd) {
   return reinterpret_cast<CoverSquareData*>(GetWindowLongPtr(hWnd, GWLP_USERDATA));
 }
 
-void PaintSolidBlack(HWND hWnd) {
+// Fills only the invalid part of the window; see ApplyCovers().
+void PaintSolidBlack(HWND hWnd, CoverSquareData* data) {
   PAINTSTRUCT ps = {};
   HDC hdc = BeginPaint(hWnd, &ps);
-  RECT rc = {};
-  GetClientRect(hWnd, &rc);
-  FillRect(hdc, &rc, static_cast<HBRUSH>(GetStockObject(BLACK_BRUSH)));
+  FillRect(hdc, &ps.rcPaint,
+           static_cast<HBRUSH>(GetStockObject(BLACK_BRUSH)));
   EndPaint(hWnd, &ps);
+
+  if (data) {
+    data->paints++;
+    data->pixelsFilled +=
+        static_cast<uint64_t>(ps.rcPaint.right - ps.rcPaint.left) *
+        static_cast<uint64_t>(ps.rcPaint.bottom - ps.rcPaint.top);
+  }
 }
 
 void ShowCoverContextMenu(HWND hWnd, CoverSquareData* data, POINT ptScreen) {
@@ -380,6 +501,14 @@ void ShowCoverContextMenu(HWND hWnd, CoverSquareData* data, POINT ptScreen) {
   HMENU menu = CreatePopupMenu();
   if (!menu) return;
 
+  const int cover = data->index.HitTest(data->covers, ptScreen.x, ptScreen.y);
+  const bool canAdd = data->covers.size() < static_cast<size_t>(kMaxCovers);
+  const bool canRemove = cover >= 0 && data->covers.size() > 1;
+  AppendMenu(menu, canAdd ? MF_STRING : MF_STRING | MF_GRAYED, kCoverMenuAdd,
+             L"Add cover");
+  AppendMenu(menu, canRemove ? MF_STRING : MF_STRING | MF_GRAYED,
+             kCoverMenuRemove, L"Remove cover");
+  AppendMenu(menu, MF_SEPARATOR, 0, nullptr);
   AppendMenu(menu, MF_STRING, kCoverMenuSettings, L"Settings...");
   AppendMenu(menu, MF_SEPARATOR, 0, nullptr);
   AppendMenu(menu, MF_STRING, kCoverMenuClose, L"Close");
@@ -389,7 +518,11 @@ void ShowCoverContextMenu(HWND hWnd, CoverSquareData* data, POINT ptScreen) {
                                  ptScreen.y, 0, hWnd, nullptr);
   DestroyMenu(menu);
 
-  if (selected == kCoverMenuSettings) {
+  if (selected == kCoverMenuAdd) {
+    AddCover(hWnd, data, ptScreen);
+  } else if (selected == kCoverMenuRemove) {
+    RemoveCover(hWnd, data, cover);
+  } else if (selected == kCoverMenuSettings) {
     PostMessage(data->hController, WM_COVER_SQUARE_OPEN_SETTINGS, 0, 0);
   } else if (selected == kCoverMenuClose) {
     PostMessage(data->hController, WM_COVER_SQUARE_CLOSE_APP, 0, 0);
@@ -410,17 +543,19 @@ LRESULT CALLBACK CoverSquareWindowProc(HWND hWnd, UINT message, WPARAM wParam,
         createdData->hController = params->hController;
       }
       SetWindowLongPtr(hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(createdData));
-      RestorePlacement(hWnd);
+      RefreshCoverMetrics(hWnd, &createdData->metrics);
+      createdData->dragPacer.SetRefreshRate(createdData->metrics.refreshRate);
+      RestorePlacement(hWnd, createdData);
       return 0;
     }
 
     case WM_SETCURSOR: {
-      if (LOWORD(lParam) == HTCLIENT) {
+      if (LOWORD(lParam) == HTCLIENT && data) {
         POINT pt = {};
         GetCursorPos(&pt);
-        ScreenToClient(hWnd, &pt);
-        const DragMode hoverMode = HitTestDragMode(hWnd, pt.x, pt.y);
-        SetCursor(CursorForMode(hoverMode));
+        DragMode hoverMode = DragMode::None;
+        HitTestCovers(*data, pt, &hoverMode);
+        SetCursor(data->metrics.cursors[static_cast<int>(hoverMode)]);
         return TRUE;
       }
       break;
@@ -429,10 +564,15 @@ LRESULT CALLBACK CoverSquareWindowProc(HWND hWnd, UINT message, WPARAM wParam,
     case WM_LBUTTONDOWN: {
       if (!data) break;
 
+      POINT pt = {GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam)};
+      ClientToScreen(hWnd, &pt);
+      const int cover = HitTestCovers(*data, pt, &data->dragMode);
+      if (cover < 0) return 0;
+
       data->dragging = true;
-      data->dragMode = HitTestDragMode(hWnd, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
-      GetCursorPos(&data->dragStartCursor);
-      GetWindowRect(hWnd, &data->dragStartRect);
+      data->dragCover = cover;
+      data->dragStartCursor = pt;
+      data->dragStartRect = data->covers[cover];
       SetCapture(hWnd);
       return 0;
     }
@@ -446,136 +586,88 @@ LRESULT CALLBACK CoverSquareWindowProc(HWND hWnd, UINT message, WPARAM wParam,
       const int dx = currentCursor.x - data->dragStartCursor.x;
       const int dy = currentCursor.y - data->dragStartCursor.y;
 
-      RECT nextRect = data->dragStartRect;
-
-      switch (data->dragMode) {
-        case DragMode::Move:
-          OffsetRect(&nextRect, dx, dy);
-          ClampRectToBounds(&nextRect, GetWindowLimits(hWnd).bounds);
-          break;
-        case DragMode::Left:
-          nextRect.left += dx;
-          EnforceResizeConstraints(hWnd, &nextRect, DragMode::Left);
-          break;
-        case DragMode::Right:
-          nextRect.right += dx;
-          EnforceResizeConstraints(hWnd, &nextRect, DragMode::Right);
-          break;
-        case DragMode::Top:
-          nextRect.top += dy;
-          EnforceResizeConstraints(hWnd, &nextRect, DragMode::Top);
-          break;
-        case DragMode::Bottom:
-          nextRect.bottom += dy;
-          EnforceResizeConstraints(hWnd, &nextRect, DragMode::Bottom);
-          break;
-        case DragMode::TopLeft:
-          nextRect.left += dx;
-          nextRect.top += dy;
-          EnforceResizeConstraints(hWnd, &nextRect, DragMode::TopLeft);
-          break;
-        case DragMode::TopRight:
-          nextRect.right += dx;
-          nextRect.top += dy;
-          EnforceResizeConstraints(hWnd, &nextRect, DragMode::TopRight);
-          break;
-        case DragMode::BottomLeft:
-          nextRect.left += dx;
-          nextRect.bottom += dy;
-          EnforceResizeConstraints(hWnd, &nextRect, DragMode::BottomLeft);
-          break;
-        case DragMode::BottomRight:
-          nextRect.right += dx;
-          nextRect.bottom += dy;
-          EnforceResizeConstraints(hWnd, &nextRect, DragMode::BottomRight);
-          break;
-        case DragMode::None:
-          break;
+      // Only the newest target matters; the pacer decides when to show it.
+      data->dragTargetRect = ApplyDrag(data->metrics.limits, data->dragMode,
+                                       data->dragStartRect, dx, dy);
+      if (data->dragPacer.OnInput(NowMicroseconds())) {
+        ApplyPendingDrag(hWnd, data);
+      } else if (!data->dragTimerArmed) {
+        PaceDrag(hWnd, data);
       }
-
-      SetWindowPos(hWnd, HWND_TOPMOST, nextRect.left, nextRect.top,
-                   nextRect.right - nextRect.left, nextRect.bottom - nextRect.top,
-                   SWP_NOACTIVATE);
       return 0;
     }
 
     case WM_LBUTTONUP:
-      if (data && data->dragging) {
-        data->dragging = false;
-        data->dragMode = DragMode::None;
+      // Ends the drag before ReleaseCapture() so WM_CAPTURECHANGED finds
+      // nothing left to end.
+      if (data && EndDrag(hWnd, data)) {
         ReleaseCapture();
-        SavePlacement(hWnd);
+        SavePlacement(hWnd, *data);
       }
       return 0;
 
     case WM_CAPTURECHANGED:
-      if (data) {
-        data->dragging = false;
-        data->dragMode = DragMode::None;
-      }
+      // Capture taken away mid-drag (Alt+Tab, another window): the cover
+      // stays where the drag left it, so save it as a button-up would.
+      if (data && EndDrag(hWnd, data)) SavePlacement(hWnd, *data);
       return 0;
 
     case WM_GETMINMAXINFO: {
       MINMAXINFO* mmi = reinterpret_cast<MINMAXINFO*>(lParam);
       if (mmi) {
-        const WindowLimits limits = GetWindowLimits(hWnd);
+        const CoverLimits limits = GetCachedLimits(hWnd, data);
         mmi->ptMinTrackSize.x = limits.minWidth;
         mmi->ptMinTrackSize.y = limits.minHeight;
       }
       return 0;
     }
 
-    case WM_WINDOWPOSCHANGING: {
-      WINDOWPOS* wp = reinterpret_cast<WINDOWPOS*>(lParam);
-      if (!wp) break;
-
-      if ((wp->flags & SWP_NOMOVE) == 0 || (wp->flags & SWP_NOSIZE) == 0) {
-        RECT pending = {wp->x, wp->y, wp->x + wp->cx, wp->y + wp->cy};
-        EnforceRectConstraints(GetWindowLimits(hWnd), &pending);
-        wp->x = pending.left;
-        wp->y = pending.top;
-        wp->cx = pending.right - pending.left;
-        wp->cy = pending.bottom - pending.top;
+    case WM_DPICHANGED:
+      // The covers keep their own screen rectangles, so the suggested window
+      // rect (the bounding box scaled as one) does not apply.
+      if (data) {
+        RefreshCoverMetrics(hWnd, &data->metrics);
+        data->dragPacer.SetRefreshRate(data->metrics.refreshRate);
+        ReclampCovers(hWnd, data);
       }
       return 0;
-    }
 
-    case WM_DPICHANGED: {
-      RECT* suggestedRect = reinterpret_cast<RECT*>(lParam);
-      if (suggestedRect) {
-        RECT nextRect = *suggestedRect;
-        EnforceRectConstraints(GetWindowLimits(hWnd), &nextRect);
-        SetWindowPos(hWnd, HWND_TOPMOST, nextRect.left, nextRect.top,
-                     nextRect.right - nextRect.left, nextRect.bottom - nextRect.top,
-                     SWP_NOACTIVATE);
-        SavePlacement(hWnd);
+    case WM_DISPLAYCHANGE:
+      if (data) {
+        RefreshCoverMetrics(hWnd, &data->metrics);
+        data->dragPacer.SetRefreshRate(data->metrics.refreshRate);
+        ReclampCovers(hWnd, data);
       }
       return 0;
-    }
 
-    case WM_DISPLAYCHANGE: {
-      RECT rect = {};
-      GetWindowRect(hWnd, &rect);
-      EnforceRectConstraints(GetWindowLimits(hWnd), &rect);
-      SetWindowPos(hWnd, HWND_TOPMOST, rect.left, rect.top, rect.right - rect.left,
-                   rect.bottom - rect.top, SWP_NOACTIVATE);
-      SavePlacement(hWnd);
-      return 0;
-    }
+    case WM_TIMER:
+      if (wParam == kSettingsFlushTimer) {
+        FlushSettings(hWnd);
+        return 0;
+      }
+      if (wParam == kDragFrameTimer) {
+        if (data) {
+          KillTimer(hWnd, kDragFrameTimer);
+          data->dragTimerArmed = false;
+          PaceDrag(hWnd, data);
+        } else {
+          KillTimer(hWnd, kDragFrameTimer);
+        }
+        return 0;
+      }
+      break;
 
     case WM_PAINT:
-      PaintSolidBlack(hWnd);
+      PaintSolidBlack(hWnd, data);
       return 0;
 
     case WM_CONTEXTMENU: {
       if (!data) return 0;
 
       POINT pt = {GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam)};
-      if (pt.x == -1 && pt.y == -1) {
-        RECT rc = {};
-        GetWindowRect(hWnd, &rc);
-        pt.x = rc.left + 20;
-        pt.y = rc.top + 20;
+      if (pt.x == -1 && pt.y == -1 && !data->covers.empty()) {
+        pt.x = data->covers.front().left + 20;
+        pt.y = data->covers.front().top + 20;
       }
       ShowCoverContextMenu(hWnd, data, pt);
       return 0;
@@ -589,7 +681,9 @@ LRESULT CALLBACK CoverSquareWindowProc(HWND hWnd, UINT message, WPARAM wParam,
 
     case WM_DESTROY:
       if (data) {
-        SavePlacement(hWnd);
+        KillTimer(hWnd, kDragFrameTimer);
+        SavePlacement(hWnd, *data);
+        FlushSettings(hWnd);
         delete data;
         SetWindowLongPtr(hWnd, GWLP_USERDATA, 0);
       }
@@ -604,7 +698,7 @@ LRESULT CALLBACK CoverSquareWindowProc(HWND hWnd, UINT message, WPARAM wParam,
 bool RegisterCoverSquareWindowClass(HINSTANCE hInstance) {
   WNDCLASSEX wc = {};
   wc.cbSize = sizeof(WNDCLASSEX);
-  wc.style = CS_HREDRAW | CS_VREDRAW | CS_DBLCLKS;
+  wc.style = CS_DBLCLKS;  // No CS_HREDRAW/CS_VREDRAW; see ApplyCovers()
   wc.lpfnWndProc = CoverSquareWindowProc;
   wc.cbClsExtra = 0;
   wc.cbWndExtra = 0;
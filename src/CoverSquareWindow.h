@@ -10,7 +10,8 @@
 // Register the black cover square window class.
 bool RegisterCoverSquareWindowClass(HINSTANCE hInstance);
 
-// Create the always-on-top black cover square.
+// Create the always-on-top overlay showing the black cover rectangles (one
+// by default; more can be added from its right-click menu).
 // hController receives right-click menu actions from the cover square.
 HWND CreateCoverSquareWindow(HINSTANCE hInstance, HWND hController);
 
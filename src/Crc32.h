@@ -0,0 +1,37 @@
+// Crc32.h - CRC-32 checksum for on-disk records
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Byte-at-a-time lookup table for the reflected IEEE 802.3 polynomial
+// (0xEDB88320), built at compile time.
+struct Crc32Table {
+  uint32_t entries[256];
+
+  constexpr Crc32Table() : entries() {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t crc = i;
+      for (int bit = 0; bit < 8; bit++) {
+        crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+      }
+      entries[i] = crc;
+    }
+  }
+};
+
+inline constexpr Crc32Table kCrc32Table;
+
+// CRC-32 of size bytes at data, as used by zip and PNG.
+inline uint32_t ComputeCrc32(const void* data, size_t size) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < size; i++) {
+    crc = kCrc32Table.entries[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFFu;
+}
+
+#endif  // CRC32_H
@@ -0,0 +1,75 @@
+// FramePacer.h - Coalesces bursts of input into at most one update per frame
+
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <cstdint>
+
+// Mice can report moves far faster than the display refreshes, and every
+// window move costs a full compositor round trip. The pacer lets the caller
+// keep only the newest input and apply it at most once per frame interval:
+// immediately if a frame has passed since the last update (leading edge),
+// otherwise from a one-shot wakeup after DelayUntilNextFrameUs() (trailing
+// edge), so the final position always lands.
+//
+// The pacer holds no payload and reads no clock; callers pass the time in
+// microseconds, which lets a simulated clock drive it deterministically.
+struct FramePacer {
+  static constexpr int kDefaultRefreshRate = 60;
+
+  int64_t frameIntervalUs = 1000000 / kDefaultRefreshRate;
+  bool pending = false;         // Input received but not yet applied
+  int64_t pendingSinceUs = 0;   // Arrival of the oldest unapplied input
+  int64_t lastApplyUs = 0;
+  bool appliedOnce = false;
+
+  // Instrumentation
+  uint64_t received = 0;     // Inputs reported through OnInput()
+  uint64_t applied = 0;      // Updates actually performed
+  int64_t totalLagUs = 0;    // Summed oldest-input-to-update latency
+  int64_t maxLagUs = 0;
+
+  // Sets the frame interval from a refresh rate in Hz. Rates of 0 or 1 mean
+  // "hardware default" in DEVMODE and fall back to kDefaultRefreshRate.
+  void SetRefreshRate(int hz) {
+    if (hz <= 1) hz = kDefaultRefreshRate;
+    frameIntervalUs = 1000000 / hz;
+  }
+
+  // Records an input. Returns true if the caller should apply it now.
+  bool OnInput(int64_t nowUs) {
+    received++;
+    if (!pending) {
+      pending = true;
+      pendingSinceUs = nowUs;
+    }
+    return DelayUntilNextFrameUs(nowUs) == 0;
+  }
+
+  // Microseconds until pending input may be applied, or -1 if none is.
+  int64_t DelayUntilNextFrameUs(int64_t nowUs) const {
+    if (!pending) return -1;
+    if (!appliedOnce) return 0;
+    const int64_t delay = lastApplyUs + frameIntervalUs - nowUs;
+    return delay > 0 ? delay : 0;
+  }
+
+  // Records that the caller applied the newest input at nowUs.
+  void OnApplied(int64_t nowUs) {
+    if (!pending) return;
+    const int64_t lag = nowUs - pendingSinceUs;
+    applied++;
+    totalLagUs += lag;
+    if (lag > maxLagUs) maxLagUs = lag;
+    pending = false;
+    lastApplyUs = nowUs;
+    appliedOnce = true;
+  }
+
+  uint64_t Coalesced() const { return received - applied; }
+  int64_t AverageLagUs() const {
+    return applied ? totalLagUs / static_cast<int64_t>(applied) : 0;
+  }
+};
+
+#endif  // FRAMEPACER_H
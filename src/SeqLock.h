@@ -0,0 +1,74 @@
+// SeqLock.h - Lock-free single-writer publication of a small value
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Publishes a trivially copyable value from one writer to any number of
+// readers without locks. The writer never waits for readers; a reader that
+// overlaps a write notices the sequence number change and retries, so it
+// never sees a torn value. The payload is stored as relaxed atomic words
+// bracketed by fences (the Boehm formulation), which keeps the protocol free
+// of data races under the C++ memory model.
+//
+// Writes must not overlap each other: use one writer thread, or serialize
+// writers with a mutex.
+template <typename T>
+struct SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SeqLock values are copied bytewise");
+
+  static constexpr size_t kWords =
+      (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  void Write(const T& value) {
+    uint64_t words[kWords] = {};
+    std::memcpy(words, &value, sizeof(T));
+
+    const uint32_t before = sequence.load(std::memory_order_relaxed);
+    sequence.store(before + 1, std::memory_order_relaxed);  // Odd: writing
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; i++) {
+      data[i].store(words[i], std::memory_order_relaxed);
+    }
+    sequence.store(before + 2, std::memory_order_release);
+  }
+
+  // Copies the value into *out, or returns false (leaving *out untouched) if
+  // a write was in progress or completed during the copy.
+  bool TryRead(T* out) const {
+    const uint32_t before = sequence.load(std::memory_order_acquire);
+    if (before & 1) return false;
+
+    uint64_t words[kWords];
+    for (size_t i = 0; i < kWords; i++) {
+      words[i] = data[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence.load(std::memory_order_relaxed) != before) return false;
+
+    std::memcpy(out, words, sizeof(T));
+    return true;
+  }
+
+  // Retries until a consistent copy is read and returns how many attempts
+  // were rejected as torn.
+  uint32_t Read(T* out) const {
+    uint32_t rejected = 0;
+    while (!TryRead(out)) rejected++;
+    return rejected;
+  }
+
+  // Bumped by 2 per write (odd while one is in progress): compare to tell
+  // whether anything was published since a previous read.
+  uint32_t Version() const { return sequence.load(std::memory_order_acquire); }
+
+  alignas(64) std::atomic<uint32_t> sequence{0};
+  std::atomic<uint64_t> data[kWords]{};
+};
+
+#endif  // SEQLOCK_H
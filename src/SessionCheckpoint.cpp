@@ -0,0 +1,213 @@
+// SessionCheckpoint.cpp - Checkpoint encoding, capture and restore
+
+#include "SessionCheckpoint.h"
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+
+#include "BackgroundWriter.h"
+#include "Crc32.h"
+#include "SettingsStore.h"
+
+namespace {
+
+constexpr char kMagic[4] = {'W', 'T', 'C', 'K'};
+constexpr uint16_t kVersion = 1;
+constexpr int kSlotCount = 2;
+
+// Byte offsets within the encoded record
+constexpr size_t kOffsetVersion = 4;
+constexpr size_t kOffsetSize = 6;
+constexpr size_t kOffsetSequence = 8;
+constexpr size_t kOffsetFlags = 12;
+constexpr size_t kOffsetTimePerBlock = 16;
+constexpr size_t kOffsetNumBlocks = 20;
+constexpr size_t kOffsetNumQuestions = 24;
+constexpr size_t kOffsetTransparency = 28;
+constexpr size_t kOffsetWallOrigin = 32;
+constexpr size_t kOffsetHeld = 40;
+constexpr size_t kOffsetSavedAt = 48;
+constexpr size_t kOffsetChecksum = 60;
+static_assert(kOffsetChecksum + 4 == SessionCheckpoint::kEncodedSize,
+              "The checksum ends the record");
+
+constexpr uint8_t kFlagActive = 1;
+constexpr uint8_t kFlagPaused = 2;
+constexpr uint8_t kFlagStopped = 4;
+
+void StoreLE(unsigned char* out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    out[i] = static_cast<unsigned char>(value >> (8 * i));
+  }
+}
+
+uint64_t LoadLE(const unsigned char* in, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; i++) {
+    value |= static_cast<uint64_t>(in[i]) << (8 * i);
+  }
+  return value;
+}
+
+bool ReadSlot(const std::filesystem::path& dir, int slot,
+              SessionCheckpoint* checkpoint) {
+  std::ifstream in(GetSessionCheckpointPath(dir, slot), std::ios::binary);
+  if (!in) return false;
+  std::string bytes((std::istreambuf_iterator<char>(in)),
+                    std::istreambuf_iterator<char>());
+  return DecodeSessionCheckpoint(bytes, checkpoint);
+}
+
+}  // namespace
+
+TimerConfig SessionCheckpoint::ToConfig(const TimerConfig& base) const {
+  TimerConfig config = base;
+  config.timePerBlock = timePerBlock;
+  config.numBlocks = numBlocks;
+  config.numQuestions = numQuestions;
+  config.transparency = transparency;
+  config.ComputeDerivedValues();
+  return config;
+}
+
+bool SessionCheckpoint::IsResumableAt(int64_t wallNowMs) const {
+  if (!active || timePerBlock <= 0 || numBlocks <= 0) return false;
+  const int64_t totalMs =
+      static_cast<int64_t>(timePerBlock) * 60 * numBlocks * 1000;
+  return ElapsedMillisecondsAt(wallNowMs) < totalMs;
+}
+
+int64_t GetWallClockMilliseconds() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+SessionCheckpoint CaptureSessionCheckpoint(const TimerState& state,
+                                           int64_t wallNowMs,
+                                           uint32_t sequence, bool active) {
+  SessionCheckpoint checkpoint;
+  checkpoint.sequence = sequence;
+  checkpoint.active = active;
+  checkpoint.paused = state.paused;
+  checkpoint.stopped = state.stopped;
+  checkpoint.timePerBlock = state.config.timePerBlock;
+  checkpoint.numBlocks = state.config.numBlocks;
+  checkpoint.numQuestions = state.config.numQuestions;
+  checkpoint.transparency = state.config.transparency;
+
+  // Re-anchor the steady-clock elapsed time to the wall clock.
+  const int64_t elapsedMs = state.GetElapsedMilliseconds();
+  checkpoint.wallOriginMs = wallNowMs - elapsedMs;
+  checkpoint.heldMs = elapsedMs;
+  checkpoint.savedAtMs = wallNowMs;
+  return checkpoint;
+}
+
+void RestoreSessionCheckpoint(const SessionCheckpoint& checkpoint,
+                              int64_t wallNowMs, TimerState* state) {
+  if (checkpoint.stopped) state->Stop();
+  if (checkpoint.paused) state->SetPaused(true);
+  state->SeekTo(checkpoint.ElapsedMillisecondsAt(wallNowMs));
+}
+
+std::string EncodeSessionCheckpoint(const SessionCheckpoint& checkpoint) {
+  unsigned char record[SessionCheckpoint::kEncodedSize] = {};
+  for (int i = 0; i < 4; i++) record[i] = static_cast<unsigned char>(kMagic[i]);
+  StoreLE(record + kOffsetVersion, kVersion, 2);
+  StoreLE(record + kOffsetSize, SessionCheckpoint::kEncodedSize, 2);
+  StoreLE(record + kOffsetSequence, checkpoint.sequence, 4);
+  record[kOffsetFlags] =
+      static_cast<unsigned char>((checkpoint.active ? kFlagActive : 0) |
+                                 (checkpoint.paused ? kFlagPaused : 0) |
+                                 (checkpoint.stopped ? kFlagStopped : 0));
+  StoreLE(record + kOffsetTimePerBlock,
+          static_cast<uint32_t>(checkpoint.timePerBlock), 4);
+  StoreLE(record + kOffsetNumBlocks,
+          static_cast<uint32_t>(checkpoint.numBlocks), 4);
+  StoreLE(record + kOffsetNumQuestions,
+          static_cast<uint32_t>(checkpoint.numQuestions), 4);
+  StoreLE(record + kOffsetTransparency,
+          static_cast<uint32_t>(checkpoint.transparency), 4);
+  StoreLE(record + kOffsetWallOrigin,
+          static_cast<uint64_t>(checkpoint.wallOriginMs), 8);
+  StoreLE(record + kOffsetHeld, static_cast<uint64_t>(checkpoint.heldMs), 8);
+  StoreLE(record + kOffsetSavedAt,
+          static_cast<uint64_t>(checkpoint.savedAtMs), 8);
+  StoreLE(record + kOffsetChecksum, ComputeCrc32(record, kOffsetChecksum), 4);
+  return std::string(reinterpret_cast<const char*>(record), sizeof(record));
+}
+
+bool DecodeSessionCheckpoint(const std::string& bytes,
+                             SessionCheckpoint* checkpoint) {
+  if (bytes.size() != SessionCheckpoint::kEncodedSize) return false;
+  const unsigned char* record =
+      reinterpret_cast<const unsigned char*>(bytes.data());
+  for (int i = 0; i < 4; i++) {
+    if (record[i] != static_cast<unsigned char>(kMagic[i])) return false;
+  }
+  if (LoadLE(record + kOffsetVersion, 2) != kVersion ||
+      LoadLE(record + kOffsetSize, 2) != SessionCheckpoint::kEncodedSize ||
+      LoadLE(record + kOffsetChecksum, 4) !=
+          ComputeCrc32(record, kOffsetChecksum)) {
+    return false;
+  }
+
+  const uint8_t flags = record[kOffsetFlags];
+  checkpoint->sequence =
+      static_cast<uint32_t>(LoadLE(record + kOffsetSequence, 4));
+  checkpoint->active = (flags & kFlagActive) != 0;
+  checkpoint->paused = (flags & kFlagPaused) != 0;
+  checkpoint->stopped = (flags & kFlagStopped) != 0;
+  checkpoint->timePerBlock = static_cast<int32_t>(
+      static_cast<uint32_t>(LoadLE(record + kOffsetTimePerBlock, 4)));
+  checkpoint->numBlocks = static_cast<int32_t>(
+      static_cast<uint32_t>(LoadLE(record + kOffsetNumBlocks, 4)));
+  checkpoint->numQuestions = static_cast<int32_t>(
+      static_cast<uint32_t>(LoadLE(record + kOffsetNumQuestions, 4)));
+  checkpoint->transparency = static_cast<int32_t>(
+      static_cast<uint32_t>(LoadLE(record + kOffsetTransparency, 4)));
+  checkpoint->wallOriginMs =
+      static_cast<int64_t>(LoadLE(record + kOffsetWallOrigin, 8));
+  checkpoint->heldMs = static_cast<int64_t>(LoadLE(record + kOffsetHeld, 8));
+  checkpoint->savedAtMs =
+      static_cast<int64_t>(LoadLE(record + kOffsetSavedAt, 8));
+  return true;
+}
+
+std::filesystem::path GetSessionCheckpointPath(int slot) {
+  return GetSessionCheckpointPath(GetSettingsDirectory(), slot);
+}
+
+std::filesystem::path GetSessionCheckpointPath(const std::filesystem::path& dir,
+                                               int slot) {
+  const char* name = slot == 0 ? "session.0.ckpt" : "session.1.ckpt";
+  return dir.empty() ? std::filesystem::path(name) : dir / name;
+}
+
+bool LoadSessionCheckpoint(SessionCheckpoint* checkpoint) {
+  return LoadSessionCheckpoint(GetSettingsDirectory(), checkpoint);
+}
+
+bool LoadSessionCheckpoint(const std::filesystem::path& dir,
+                           SessionCheckpoint* checkpoint) {
+  bool found = false;
+  for (int slot = 0; slot < kSlotCount; slot++) {
+    SessionCheckpoint candidate;
+    if (!ReadSlot(dir, slot, &candidate)) continue;
+    // Sequences wrap; compare by signed distance.
+    if (!found || static_cast<int32_t>(candidate.sequence -
+                                       checkpoint->sequence) > 0) {
+      *checkpoint = candidate;
+      found = true;
+    }
+  }
+  return found;
+}
+
+void SaveSessionCheckpoint(const SessionCheckpoint& checkpoint,
+                           BackgroundWriter* writer) {
+  writer->Enqueue({GetSessionCheckpointPath(checkpoint.sequence % kSlotCount),
+                   EncodeSessionCheckpoint(checkpoint)});
+}
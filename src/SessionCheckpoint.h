@@ -0,0 +1,92 @@
+// SessionCheckpoint.h - Crash-safe record of a running session
+
+#ifndef SESSIONCHECKPOINT_H
+#define SESSIONCHECKPOINT_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "TimerState.h"
+
+struct BackgroundWriter;
+
+// Everything needed to put a session back where it was after a crash, kill or
+// reboot: the timing settings and where elapsed time stands. Elapsed time is
+// anchored to the wall clock (Unix milliseconds), since the steady clock
+// restarts with the machine and exam time keeps running while it is down.
+// Pause intervals are folded into the anchor, exactly as TimerState folds
+// them into originMs.
+struct SessionCheckpoint {
+  static constexpr size_t kEncodedSize = 64;
+
+  uint32_t sequence = 0;  // Grows with every save; the newest valid one wins
+  bool active = false;    // A session is in progress (false after a clean exit)
+  bool paused = false;
+  bool stopped = false;
+
+  int32_t timePerBlock = 0;  // TimerConfig timing settings
+  int32_t numBlocks = 0;
+  int32_t numQuestions = 0;
+  int32_t transparency = 100;
+
+  int64_t wallOriginMs = 0;  // Wall clock at elapsed == 0 (while running)
+  int64_t heldMs = 0;        // Elapsed milliseconds (while paused/stopped)
+  int64_t savedAtMs = 0;     // Wall clock when the checkpoint was taken
+
+  // Config to initialize the resumed TimerState with; non-timing settings
+  // missing from the record (ownerDraw) are taken from base.
+  TimerConfig ToConfig(const TimerConfig& base) const;
+
+  // Elapsed session time at wall clock wallNowMs.
+  int64_t ElapsedMillisecondsAt(int64_t wallNowMs) const {
+    const int64_t elapsed =
+        paused || stopped ? heldMs : wallNowMs - wallOriginMs;
+    return elapsed > 0 ? elapsed : 0;
+  }
+
+  // True if this records a session that was still in progress and has time
+  // left at wallNowMs.
+  bool IsResumableAt(int64_t wallNowMs) const;
+};
+
+// Current wall-clock time in Unix milliseconds.
+int64_t GetWallClockMilliseconds();
+
+// Snapshot of state as of wall clock wallNowMs.
+SessionCheckpoint CaptureSessionCheckpoint(const TimerState& state,
+                                           int64_t wallNowMs,
+                                           uint32_t sequence, bool active);
+
+// Puts state (already initialized with checkpoint.ToConfig()) at the recorded
+// position for wall clock wallNowMs, with the recorded pause/stop state. One
+// SeekTo(): no ticks are replayed however long the gap was.
+void RestoreSessionCheckpoint(const SessionCheckpoint& checkpoint,
+                              int64_t wallNowMs, TimerState* state);
+
+// Fixed 64-byte little-endian layout ending in a CRC-32 of everything before
+// it. Decoding fails on a wrong size, magic, version or checksum, so a torn
+// or truncated write is never mistaken for a checkpoint.
+std::string EncodeSessionCheckpoint(const SessionCheckpoint& checkpoint);
+bool DecodeSessionCheckpoint(const std::string& bytes,
+                             SessionCheckpoint* checkpoint);
+
+// Checkpoints alternate between two files, each replaced atomically, so even
+// if the newest one is lost or damaged (e.g. by power loss before the data
+// reached the disk) the previous one survives. The slots live in the
+// settings directory unless another dir is given.
+std::filesystem::path GetSessionCheckpointPath(int slot);
+std::filesystem::path GetSessionCheckpointPath(const std::filesystem::path& dir,
+                                               int slot);
+
+// Reads both slots and returns the valid checkpoint with the highest
+// sequence. Returns false if neither slot holds one.
+bool LoadSessionCheckpoint(SessionCheckpoint* checkpoint);
+bool LoadSessionCheckpoint(const std::filesystem::path& dir,
+                           SessionCheckpoint* checkpoint);
+
+// Hands the checkpoint to writer for the slot its sequence selects.
+void SaveSessionCheckpoint(const SessionCheckpoint& checkpoint,
+                           BackgroundWriter* writer);
+
+#endif  // SESSIONCHECKPOINT_H
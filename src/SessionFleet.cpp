@@ -0,0 +1,207 @@
+// SessionFleet.cpp - Fleet session commands and due-boundary reporting
+
+#include "SessionFleet.h"
+
+#include <utility>
+
+#include "TimerState.h"
+
+void SessionFleet::Reset(int64_t nowMs) {
+  plans.clear();
+  groups.clear();
+  sessions.clear();
+  freeIds.clear();
+  due.clear();
+  dueCursor = 0;
+  wheel.Reset(nowMs);
+}
+
+int SessionFleet::AddPlan(SessionPlan plan) {
+  plans.push_back(std::move(plan));
+  return static_cast<int>(plans.size()) - 1;
+}
+
+int SessionFleet::AddGroup() {
+  groups.emplace_back();
+  return static_cast<int>(groups.size()) - 1;
+}
+
+uint32_t SessionFleet::AddSession(int plan, int group, int64_t nowMs) {
+  uint32_t id;
+  if (!freeIds.empty()) {
+    id = freeIds.back();
+    freeIds.pop_back();
+  } else {
+    id = static_cast<uint32_t>(sessions.size());
+    sessions.emplace_back();
+    wheel.Reserve(sessions.size());
+  }
+
+  Session& session = sessions[id];
+  session = Session();
+  session.plan = plan;
+  session.group = group;
+  session.originMs = nowMs;
+  session.live = true;
+  if (group >= 0) {
+    session.groupSlot = static_cast<uint32_t>(groups[group].size());
+    groups[group].push_back(id);
+  }
+  return id;
+}
+
+void SessionFleet::RemoveSession(uint32_t id) {
+  Session& session = sessions[id];
+  if (!session.live) return;
+
+  if (session.group >= 0) {
+    std::vector<uint32_t>& members = groups[session.group];
+    const uint32_t moved = members.back();
+    members[session.groupSlot] = moved;
+    sessions[moved].groupSlot = session.groupSlot;
+    members.pop_back();
+  }
+  wheel.Cancel(id);
+  session.live = false;
+  freeIds.push_back(id);
+}
+
+void SessionFleet::SyncClock(Session& session, bool wasRunning,
+                             int64_t nowMs) {
+  const bool running = !session.stopped && !session.paused;
+  if (running == wasRunning) return;
+
+  if (running) {
+    session.originMs = nowMs - session.heldMs;
+  } else {
+    session.heldMs = nowMs - session.originMs;
+  }
+}
+
+void SessionFleet::Reschedule(uint32_t id, int64_t nowMs) {
+  const Session& session = sessions[id];
+  const SessionPlan& plan = plans[session.plan];
+  if (session.eventSegment >= plan.SegmentCount()) {
+    wheel.Cancel(id);
+    return;
+  }
+
+  const int64_t boundaryMs = plan.segmentEnds[session.eventSegment] * 1000;
+  if (IsRunning(id)) {
+    wheel.Schedule(id, session.originMs + boundaryMs);
+  } else if (session.heldMs >= boundaryMs) {
+    // Halted just past a boundary nobody has reported yet
+    wheel.Schedule(id, nowMs);
+  } else {
+    wheel.Cancel(id);
+  }
+}
+
+void SessionFleet::Start(uint32_t id, int64_t nowMs) {
+  Session& session = sessions[id];
+  const bool wasRunning = IsRunning(id);
+  session.stopped = false;
+  session.paused = false;
+  SyncClock(session, wasRunning, nowMs);
+  Reschedule(id, nowMs);
+}
+
+void SessionFleet::Stop(uint32_t id, int64_t nowMs) {
+  Session& session = sessions[id];
+  const bool wasRunning = IsRunning(id);
+  session.stopped = true;
+  SyncClock(session, wasRunning, nowMs);
+  Reschedule(id, nowMs);
+}
+
+void SessionFleet::SetPaused(uint32_t id, bool pause, int64_t nowMs) {
+  Session& session = sessions[id];
+  const bool wasRunning = IsRunning(id);
+  session.paused = pause;
+  SyncClock(session, wasRunning, nowMs);
+  Reschedule(id, nowMs);
+}
+
+void SessionFleet::SeekTo(uint32_t id, int64_t elapsedMs, int64_t nowMs) {
+  Session& session = sessions[id];
+  if (elapsedMs < 0) elapsedMs = 0;
+  if (IsRunning(id)) {
+    session.originMs = nowMs - elapsedMs;
+  } else {
+    session.heldMs = elapsedMs;
+  }
+  session.eventSegment = plans[session.plan].FindSegment(elapsedMs / 1000);
+  Reschedule(id, nowMs);
+}
+
+void SessionFleet::StartGroup(int group, int64_t nowMs) {
+  for (const uint32_t id : groups[group]) Start(id, nowMs);
+}
+
+void SessionFleet::StopGroup(int group, int64_t nowMs) {
+  for (const uint32_t id : groups[group]) Stop(id, nowMs);
+}
+
+void SessionFleet::SetGroupPaused(int group, bool pause, int64_t nowMs) {
+  for (const uint32_t id : groups[group]) SetPaused(id, pause, nowMs);
+}
+
+int64_t SessionFleet::GetElapsedMilliseconds(uint32_t id,
+                                             int64_t nowMs) const {
+  return Elapsed(sessions[id], nowMs);
+}
+
+TimerPosition SessionFleet::PositionAt(uint32_t id, int64_t nowMs) const {
+  const Session& session = sessions[id];
+  return plans[session.plan].PositionAt(Elapsed(session, nowMs) / 1000,
+                                        session.eventSegment);
+}
+
+bool SessionFleet::ReportDue(uint32_t id, int64_t nowMs,
+                             FleetEventBatch* batch) {
+  Session& session = sessions[id];
+  if (!session.live) return true;
+  sessionsVisited++;
+
+  // A session can be here more than once, or after a command moved it; what
+  // is reported always follows from its state now.
+  const SessionPlan& plan = plans[session.plan];
+  const int64_t elapsedMs = Elapsed(session, nowMs);
+  const int segmentCount = plan.SegmentCount();
+  while (session.eventSegment < segmentCount &&
+         plan.segmentEnds[session.eventSegment] * 1000 <= elapsedMs) {
+    TimerEvent events[kMaxBoundaryEvents];
+    const int count = GetBoundaryEvents(plan, session.eventSegment, events);
+    if (!batch->HasRoom(count)) return false;
+
+    FleetEvent event = {};
+    event.session = id;
+    event.dueMs = nowMs - elapsedMs + events[0].atSecond * 1000;
+    for (int i = 0; i < count; i++) {
+      event.event = events[i];
+      batch->Push(event);
+    }
+    eventsReported += count;
+    session.eventSegment++;
+  }
+
+  Reschedule(id, nowMs);
+  return true;
+}
+
+bool SessionFleet::Advance(int64_t nowMs, FleetEventBatch* batch) {
+  batch->count = 0;
+  for (;;) {
+    // Sessions left over from a batch that filled up come first.
+    while (dueCursor < due.size()) {
+      if (!ReportDue(due[dueCursor], nowMs, batch)) return true;
+      dueCursor++;
+    }
+    due.clear();
+    dueCursor = 0;
+
+    if (wheel.CurrentTick() > nowMs) return false;
+    wheel.AdvanceTo(nowMs, &due);
+    if (due.empty()) return false;
+  }
+}
@@ -0,0 +1,148 @@
+// SessionFleet.h - Many concurrent timer sessions driven from one timing wheel
+
+#ifndef SESSIONFLEET_H
+#define SESSIONFLEET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "SessionPlan.h"
+#include "TimerEvents.h"
+#include "TimingWheel.h"
+
+// One transition of one session.
+struct FleetEvent {
+  uint32_t session;
+  int64_t dueMs;  // Fleet time at which the boundary was crossed
+  TimerEvent event;
+};
+
+// Fixed-capacity batch filled by SessionFleet::Advance(), the fleet
+// counterpart of TimerEventBatch.
+struct FleetEventBatch {
+  static constexpr int kCapacity = 256;
+
+  FleetEvent events[kCapacity];
+  int count = 0;
+
+  bool HasRoom(int needed) const { return count + needed <= kCapacity; }
+  void Push(const FleetEvent& event) { events[count++] = event; }
+};
+
+// Headless timing engine for a whole testing center: thousands to millions of
+// sessions, each a TimerState in all but name, advanced together.
+//
+// Ticking every session every second is O(N) per second although almost
+// none of them changes. Instead each running session sits in a TimingWheel
+// at its next question, block or completion boundary, and Advance() only
+// touches the sessions whose boundary has come, reporting exactly the
+// transitions TimerState::Advance() would. Sessions share plans by index,
+// so a session costs a few dozen bytes however long its plan is.
+//
+// Sessions belong to a group (a room, a cohort) that can be started, paused
+// and resumed at once. Pausing takes a session out of the wheel, so paused
+// sessions cost nothing until they resume.
+//
+// The fleet reads no clock and is not thread-safe: one thread drives it and
+// passes the current time, in milliseconds of any monotonic clock, to every
+// call. Times must not go backwards.
+struct SessionFleet {
+  static constexpr uint32_t kNoSession = TimingWheel::kNone;
+
+  // Empties the fleet and starts its clock at nowMs.
+  void Reset(int64_t nowMs);
+
+  // Registers a plan for sessions to run and returns its index.
+  int AddPlan(SessionPlan plan);
+
+  // Creates an empty group and returns its index.
+  int AddGroup();
+
+  // Creates a stopped session at the start of plan, in group (or none if -1).
+  // Ids of removed sessions are reused.
+  uint32_t AddSession(int plan, int group, int64_t nowMs);
+  void RemoveSession(uint32_t session);
+
+  // Per-session commands, with TimerState's semantics.
+  void Start(uint32_t session, int64_t nowMs);
+  void Stop(uint32_t session, int64_t nowMs);
+  void SetPaused(uint32_t session, bool pause, int64_t nowMs);
+
+  // Jumps to elapsedMs of the session's plan, keeping its running state.
+  // Skipped transitions are not reported.
+  void SeekTo(uint32_t session, int64_t elapsedMs, int64_t nowMs);
+
+  // The same commands for every member of group. O(members).
+  void StartGroup(int group, int64_t nowMs);
+  void StopGroup(int group, int64_t nowMs);
+  void SetGroupPaused(int group, bool pause, int64_t nowMs);
+
+  // Appends to batch (which is cleared first) the transitions of every
+  // session crossed up to nowMs, each session's in order. Returns true if the
+  // batch filled up; call again until it returns false. Nothing is dropped.
+  bool Advance(int64_t nowMs, FleetEventBatch* batch);
+
+  // Earliest time Advance() may have something to report (see
+  // TimingWheel::NextWakeTick), or -1 if no session is running.
+  int64_t NextWakeMs() const { return wheel.NextWakeTick(); }
+
+  int64_t GetElapsedMilliseconds(uint32_t session, int64_t nowMs) const;
+  TimerPosition PositionAt(uint32_t session, int64_t nowMs) const;
+
+  bool IsRunning(uint32_t session) const {
+    return !sessions[session].stopped && !sessions[session].paused;
+  }
+  bool IsPaused(uint32_t session) const { return sessions[session].paused; }
+  bool IsStopped(uint32_t session) const { return sessions[session].stopped; }
+
+  const std::vector<uint32_t>& GroupMembers(int group) const {
+    return groups[group];
+  }
+
+  size_t SessionCount() const { return sessions.size() - freeIds.size(); }
+  size_t ScheduledCount() const { return wheel.Size(); }
+
+  // Instrumentation
+  uint64_t sessionsVisited = 0;  // Due sessions Advance() looked at
+  uint64_t eventsReported = 0;
+
+ private:
+  struct Session {
+    int64_t originMs = 0;  // Fleet time at elapsed == 0 (while running)
+    int64_t heldMs = 0;    // Elapsed milliseconds (while paused/stopped)
+    int plan = 0;
+    int group = -1;
+    uint32_t groupSlot = 0;  // Index in groups[group]
+    int eventSegment = 0;    // First segment whose end is not yet reported
+    bool paused = false;
+    bool stopped = true;
+    bool live = false;
+  };
+
+  // Moves the elapsed-time anchor across a running <-> halted transition.
+  void SyncClock(Session& session, bool wasRunning, int64_t nowMs);
+
+  // Files the session under its next boundary, or takes it out of the wheel
+  // if it is halted with nothing left to report.
+  void Reschedule(uint32_t id, int64_t nowMs);
+
+  // Reports the session's boundaries crossed by nowMs. Returns false, with
+  // the rest left for the next batch, if the batch fills up.
+  bool ReportDue(uint32_t id, int64_t nowMs, FleetEventBatch* batch);
+
+  int64_t Elapsed(const Session& session, int64_t nowMs) const {
+    return !session.stopped && !session.paused ? nowMs - session.originMs
+                                               : session.heldMs;
+  }
+
+  std::vector<SessionPlan> plans;
+  std::vector<std::vector<uint32_t>> groups;
+  std::vector<Session> sessions;
+  std::vector<uint32_t> freeIds;
+  TimingWheel wheel;
+  std::vector<uint32_t> due;  // Expired from the wheel, not yet reported
+  size_t dueCursor = 0;
+};
+
+#endif  // SESSIONFLEET_H
@@ -0,0 +1,271 @@
+// SessionJournal.cpp - Journal encoding, batching and streaming reader
+
+#include "SessionJournal.h"
+
+#include <utility>
+
+#include "BackgroundWriter.h"
+#include "Crc32.h"
+#include "SettingsStore.h"
+
+namespace {
+
+constexpr char kFrameMagic[4] = {'W', 'T', 'J', 'F'};
+constexpr int kMaxVarintBytes = 10;
+
+void PutVarint(std::string* out, uint64_t value) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+void PutSignedVarint(std::string* out, int64_t value) {
+  // Zigzag: small magnitudes of either sign stay short.
+  PutVarint(out, (static_cast<uint64_t>(value) << 1) ^
+                     static_cast<uint64_t>(value >> 63));
+}
+
+bool GetVarint(const std::string& in, size_t* position, uint64_t* value) {
+  uint64_t result = 0;
+  for (int i = 0; i < kMaxVarintBytes && *position < in.size(); i++) {
+    const uint8_t byte = static_cast<uint8_t>(in[(*position)++]);
+    result |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+    if (!(byte & 0x80)) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool GetSignedVarint(const std::string& in, size_t* position, int64_t* value) {
+  uint64_t raw;
+  if (!GetVarint(in, position, &raw)) return false;
+  *value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+  return true;
+}
+
+bool GetInt(const std::string& in, size_t* position, int* value) {
+  uint64_t raw;
+  if (!GetVarint(in, position, &raw)) return false;
+  *value = static_cast<int>(raw);
+  return true;
+}
+
+// Reads a varint straight from the stream (frame lengths).
+bool ReadStreamVarint(std::istream* in, uint64_t* value) {
+  uint64_t result = 0;
+  for (int i = 0; i < kMaxVarintBytes; i++) {
+    const int byte = in->get();
+    if (byte == std::char_traits<char>::eof()) return false;
+    result |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+    if (!(byte & 0x80)) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Advances in past the next frame magic; false at the end of the stream.
+bool SkipToFrameMagic(std::istream* in) {
+  int matched = 0;
+  while (matched < 4) {
+    const int byte = in->get();
+    if (byte == std::char_traits<char>::eof()) return false;
+    if (byte == static_cast<unsigned char>(kFrameMagic[matched])) {
+      matched++;
+    } else {
+      matched = byte == static_cast<unsigned char>(kFrameMagic[0]) ? 1 : 0;
+    }
+  }
+  return true;
+}
+
+JournalRecordType GetTransitionRecordType(TimerEventType type) {
+  switch (type) {
+    case TimerEventType::QuestionAdvanced:
+      return JournalRecordType::QuestionAdvanced;
+    case TimerEventType::BlockAdvanced:
+      return JournalRecordType::BlockAdvanced;
+    case TimerEventType::BreakStarted:
+      return JournalRecordType::BreakStarted;
+    case TimerEventType::Completed:
+      return JournalRecordType::Completed;
+  }
+  return JournalRecordType::QuestionAdvanced;
+}
+
+}  // namespace
+
+JournalRecord MakeJournalRecord(JournalRecordType type,
+                                const TimerState& state, int64_t wallNowMs) {
+  JournalRecord record;
+  record.type = type;
+  record.wallMs = wallNowMs;
+  record.elapsedMs = state.GetElapsedMilliseconds();
+  record.block = state.currentBlock;
+  record.question = state.currentQuestion;
+  record.timePerBlock = state.config.timePerBlock;
+  record.numBlocks = state.config.numBlocks;
+  record.numQuestions = state.config.numQuestions;
+  record.transparency = state.config.transparency;
+  return record;
+}
+
+void SessionJournal::Append(const JournalRecord& record) {
+  if (pending.empty()) {
+    pending.reserve(kFlushBytes + 64);
+    baseWallMs = record.wallMs;
+    lastWallMs = record.wallMs;
+    lastElapsedMs = 0;
+    PutVarint(&pending, static_cast<uint64_t>(baseWallMs));
+  }
+
+  pending.push_back(static_cast<char>(record.type));
+  PutSignedVarint(&pending, record.wallMs - lastWallMs);
+  PutSignedVarint(&pending, record.elapsedMs - lastElapsedMs);
+  if (JournalRecordHasConfig(record.type)) {
+    PutVarint(&pending, static_cast<uint32_t>(record.timePerBlock));
+    PutVarint(&pending, static_cast<uint32_t>(record.numBlocks));
+    PutVarint(&pending, static_cast<uint32_t>(record.numQuestions));
+    PutVarint(&pending, static_cast<uint32_t>(record.transparency));
+  } else {
+    PutVarint(&pending, static_cast<uint32_t>(record.block));
+    PutVarint(&pending, static_cast<uint32_t>(record.question));
+  }
+  lastWallMs = record.wallMs;
+  lastElapsedMs = record.elapsedMs;
+  halted = record.type == JournalRecordType::Paused ||
+           record.type == JournalRecordType::Stopped ||
+           record.type == JournalRecordType::SessionEnded ||
+           record.type == JournalRecordType::Completed;
+  records++;
+}
+
+bool SessionJournal::NeedsFlush(int64_t wallNowMs) const {
+  if (pending.empty()) return false;
+  return halted || pending.size() >= kFlushBytes ||
+         wallNowMs - baseWallMs >= kFlushIntervalMs;
+}
+
+std::string SessionJournal::TakeFrame() {
+  std::string frame;
+  if (pending.empty()) return frame;
+
+  frame.reserve(pending.size() + 16);
+  frame.append(kFrameMagic, sizeof(kFrameMagic));
+  PutVarint(&frame, pending.size());
+  frame += pending;
+  const uint32_t crc = ComputeCrc32(pending.data(), pending.size());
+  for (int i = 0; i < 4; i++) {
+    frame.push_back(static_cast<char>(crc >> (8 * i)));
+  }
+
+  pending.clear();
+  halted = false;
+  frames++;
+  bytesFlushed += frame.size();
+  return frame;
+}
+
+void SessionJournal::FlushTo(BackgroundWriter* writer) {
+  if (pending.empty()) return;
+  PersistSnapshot snapshot;
+  snapshot.path = path;
+  snapshot.contents = TakeFrame();
+  snapshot.append = true;
+  writer->Enqueue(std::move(snapshot));
+}
+
+void JournalEventRecorder::OnTimerEvent(const TimerEvent& event) {
+  JournalRecord record;
+  record.type = GetTransitionRecordType(event.type);
+  record.elapsedMs = event.atSecond * 1000;
+  record.wallMs = wallOriginMs + record.elapsedMs;
+  record.block = event.block;
+  record.question = event.question;
+  journal->Append(record);
+}
+
+bool JournalReader::ReadFrame() {
+  for (;;) {
+    frame.clear();
+    position = 0;
+    if (!SkipToFrameMagic(in)) return false;
+    const std::streampos afterMagic = in->tellg();
+
+    uint64_t length = 0;
+    bool intact = ReadStreamVarint(in, &length) && length > 0 &&
+                  length <= kMaxFrameBytes;
+    if (intact) {
+      frame.resize(static_cast<size_t>(length));
+      unsigned char crc[4];
+      intact = in->read(&frame[0], static_cast<std::streamsize>(length)) &&
+               in->read(reinterpret_cast<char*>(crc), 4) &&
+               (crc[0] | crc[1] << 8 | crc[2] << 16 |
+                static_cast<uint32_t>(crc[3]) << 24) ==
+                   ComputeCrc32(frame.data(), frame.size());
+    }
+
+    uint64_t base = 0;
+    if (intact && GetVarint(frame, &position, &base)) {
+      wallMs = static_cast<int64_t>(base);
+      elapsedMs = 0;
+      framesRead++;
+      return true;
+    }
+
+    // Torn or corrupt: look for the next frame right after this magic, in
+    // case one was appended on top of the damage.
+    damagedFrames++;
+    in->clear();
+    if (afterMagic == std::streampos(-1)) return false;
+    in->seekg(afterMagic);
+  }
+}
+
+bool JournalReader::Next(JournalRecord* record) {
+  for (;;) {
+    if (position >= frame.size() && !ReadFrame()) return false;
+
+    const uint8_t type = static_cast<uint8_t>(frame[position++]);
+    int64_t wallDelta = 0;
+    int64_t elapsedDelta = 0;
+    bool ok = type < static_cast<uint8_t>(JournalRecordType::kCount) &&
+              GetSignedVarint(frame, &position, &wallDelta) &&
+              GetSignedVarint(frame, &position, &elapsedDelta);
+
+    *record = JournalRecord();
+    record->type = static_cast<JournalRecordType>(type);
+    if (ok && JournalRecordHasConfig(record->type)) {
+      ok = GetInt(frame, &position, &record->timePerBlock) &&
+           GetInt(frame, &position, &record->numBlocks) &&
+           GetInt(frame, &position, &record->numQuestions) &&
+           GetInt(frame, &position, &record->transparency);
+    } else if (ok) {
+      ok = GetInt(frame, &position, &record->block) &&
+           GetInt(frame, &position, &record->question);
+    }
+    if (!ok) {
+      // The checksum matched, so this is a newer format; skip the frame.
+      damagedFrames++;
+      position = frame.size();
+      continue;
+    }
+
+    wallMs += wallDelta;
+    elapsedMs += elapsedDelta;
+    record->wallMs = wallMs;
+    record->elapsedMs = elapsedMs;
+    return true;
+  }
+}
+
+std::filesystem::path GetSessionJournalPath() {
+  const std::filesystem::path& dir = GetSettingsDirectory();
+  return dir.empty() ? std::filesystem::path("session_journal.wtj")
+                     : dir / "session.wtj";
+}
@@ -0,0 +1,149 @@
+// SessionJournal.h - Append-only binary log of what happened in a session
+
+#ifndef SESSIONJOURNAL_H
+#define SESSIONJOURNAL_H
+
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <string>
+
+#include "TimerEvents.h"
+#include "TimerState.h"
+
+struct BackgroundWriter;
+
+enum class JournalRecordType : uint8_t {
+  SessionStarted,    // A new session began with the recorded config
+  SessionResumed,    // A checkpointed session was picked up again
+  SessionEnded,      // The timer window closed
+  ConfigChanged,     // Settings applied mid-session
+  Started,           // Start button
+  Stopped,           // Stop button, or cover-only mode
+  Paused,            // Pause button, or the settings panel opening
+  Resumed,           // Pause released
+  QuestionAdvanced,  // TimerEvent transitions, stamped at their boundary
+  BlockAdvanced,
+  BreakStarted,
+  Completed,
+  kCount
+};
+
+// One decoded journal entry. Every record carries both clocks: when it
+// happened (wall clock, Unix ms) and where the session was (elapsed ms).
+// block/question are the position at that moment; the config fields are
+// only stored for SessionStarted, SessionResumed and ConfigChanged.
+struct JournalRecord {
+  JournalRecordType type = JournalRecordType::SessionStarted;
+  int64_t wallMs = 0;
+  int64_t elapsedMs = 0;
+  int block = 0;
+  int question = 0;
+  int timePerBlock = 0;
+  int numBlocks = 0;
+  int numQuestions = 0;
+  int transparency = 0;
+};
+
+inline bool JournalRecordHasConfig(JournalRecordType type) {
+  return type == JournalRecordType::SessionStarted ||
+         type == JournalRecordType::SessionResumed ||
+         type == JournalRecordType::ConfigChanged;
+}
+
+// A record describing state at wall clock wallNowMs.
+JournalRecord MakeJournalRecord(JournalRecordType type,
+                                const TimerState& state, int64_t wallNowMs);
+
+// On-disk format
+//
+// The file is a sequence of frames, one per flush:
+//
+//   "WTJF"  varint bodyLength  body  CRC-32(body) as 4 bytes little-endian
+//
+// The body starts with the frame's base wall time (varint, Unix ms) followed
+// by records, each:
+//
+//   type byte  zigzag-varint wall delta  zigzag-varint elapsed delta
+//   [varint block, varint question]           (all but config records)
+//   [varint timePerBlock, numBlocks, numQuestions, transparency]
+//                                             (config records)
+//
+// Deltas run from the previous record of the frame (wall from the base,
+// elapsed from 0), so a question advance takes about 9 bytes and every frame
+// decodes on its own. A frame torn by a crash fails its checksum and the
+// reader resynchronizes at the next "WTJF", so appending after one is safe.
+
+// Collects records in memory and hands them to the background writer in
+// batches. Append() only encodes into a buffer; nothing touches the disk on
+// the calling thread.
+struct SessionJournal {
+  static constexpr size_t kFlushBytes = 4096;
+  static constexpr int64_t kFlushIntervalMs = 30000;
+
+  std::filesystem::path path;
+  std::string pending;  // Encoded records of the frame being built
+  int64_t baseWallMs = 0;
+  int64_t lastWallMs = 0;
+  int64_t lastElapsedMs = 0;
+  bool halted = false;  // The last record paused, stopped or ended the session
+
+  // Instrumentation
+  uint64_t records = 0;
+  uint64_t frames = 0;
+  uint64_t bytesFlushed = 0;
+
+  void Append(const JournalRecord& record);
+
+  // True when the pending records should go out: the buffer is large, the
+  // oldest record is kFlushIntervalMs old, or the timer just went idle (no
+  // tick will come by to flush later).
+  bool NeedsFlush(int64_t wallNowMs) const;
+
+  // Closes the pending records into one frame and returns it (empty if
+  // there is nothing pending).
+  std::string TakeFrame();
+
+  // Hands the pending frame to writer as an append to path.
+  void FlushTo(BackgroundWriter* writer);
+};
+
+// Journal subscriber for DrainTimerEvents(): records every transition at the
+// wall time of its boundary.
+struct JournalEventRecorder {
+  SessionJournal* journal;
+  int64_t wallOriginMs;  // Wall clock at elapsed == 0
+
+  void OnTimerEvent(const TimerEvent& event);
+};
+
+// Streams records out of a journal, one frame in memory at a time. Damaged
+// frames are skipped and counted; reading continues with the next intact
+// frame.
+struct JournalReader {
+  static constexpr uint64_t kMaxFrameBytes = 1 << 20;
+
+  std::istream* in = nullptr;
+
+  // Instrumentation
+  uint64_t framesRead = 0;
+  uint64_t damagedFrames = 0;
+
+  explicit JournalReader(std::istream* input) : in(input) {}
+
+  // Next record in file order; false at the end of the journal.
+  bool Next(JournalRecord* record);
+
+ private:
+  bool ReadFrame();
+
+  std::string frame;  // Body of the current frame
+  size_t position = 0;
+  int64_t wallMs = 0;
+  int64_t elapsedMs = 0;
+};
+
+// Default journal location next to the settings.
+std::filesystem::path GetSessionJournalPath();
+
+#endif  // SESSIONJOURNAL_H
@@ -0,0 +1,137 @@
+// SessionPlan.cpp - Session plan construction and position lookup
+
+#include "SessionPlan.h"
+
+#include <algorithm>
+
+int SessionPlan::AddBlock(int section, int64_t lengthSeconds, int numQuestions,
+                          const int* weights) {
+  if (lengthSeconds < 0) lengthSeconds = 0;
+  if (numQuestions < 1) numQuestions = 1;
+
+  int64_t totalWeight = 0;
+  if (weights) {
+    for (int i = 0; i < numQuestions; i++) {
+      if (weights[i] > 0) totalWeight += weights[i];
+    }
+  }
+  const bool uniform = totalWeight <= 0;
+
+  const int blockIndex = BlockCount();
+  const int64_t start = TotalSeconds();
+
+  PlanBlock block = {};
+  block.startSecond = start;
+  block.endSecond = start + lengthSeconds;
+  block.section = section;
+  block.numQuestions = numQuestions;
+  blocks.push_back(block);
+
+  // Boundary k sits at floor(length * cumulativeWeight(k) / totalWeight): the
+  // rounding error never accumulates and the last boundary is the block end.
+  int64_t cumulativeWeight = 0;
+  for (int i = 0; i < numQuestions; i++) {
+    int64_t boundary;
+    if (uniform) {
+      boundary = lengthSeconds * (i + 1) / numQuestions;
+    } else {
+      if (weights[i] > 0) cumulativeWeight += weights[i];
+      boundary = lengthSeconds * cumulativeWeight / totalWeight;
+    }
+
+    PlanSegment segment = {};
+    segment.kind = PlanSegmentKind::Question;
+    segment.section = section;
+    segment.block = blockIndex;
+    segment.question = i + 1;
+    segments.push_back(segment);
+    segmentEnds.push_back(start + boundary);
+  }
+
+  return blockIndex;
+}
+
+void SessionPlan::AddBreak(int section, int64_t lengthSeconds) {
+  if (lengthSeconds < 0) lengthSeconds = 0;
+
+  PlanSegment segment = {};
+  segment.kind = PlanSegmentKind::Break;
+  segment.section = section;
+  segment.block = BlockCount();
+  segment.question = 0;
+  segmentEnds.push_back(TotalSeconds() + lengthSeconds);
+  segments.push_back(segment);
+}
+
+int SessionPlan::FindSegment(int64_t elapsedSeconds, int hint) const {
+  const int count = SegmentCount();
+  if (elapsedSeconds < 0) elapsedSeconds = 0;
+  if (count == 0 || elapsedSeconds >= TotalSeconds()) return count;
+
+  // While ticking, the answer is almost always the previous segment or the
+  // one right after it.
+  for (int candidate = hint; candidate >= 0 && candidate < count &&
+                             candidate <= hint + 1;
+       candidate++) {
+    const int64_t start = candidate > 0 ? segmentEnds[candidate - 1] : 0;
+    if (elapsedSeconds >= start && elapsedSeconds < segmentEnds[candidate]) {
+      return candidate;
+    }
+  }
+
+  // First segment ending after elapsedSeconds; zero-length segments are
+  // skipped naturally.
+  const auto it = std::upper_bound(segmentEnds.begin(), segmentEnds.end(),
+                                   elapsedSeconds);
+  return static_cast<int>(it - segmentEnds.begin());
+}
+
+TimerPosition SessionPlan::PositionAt(int64_t elapsedSeconds, int hint) const {
+  TimerPosition pos = {};
+  if (elapsedSeconds < 0) elapsedSeconds = 0;
+
+  const int index = FindSegment(elapsedSeconds, hint);
+  if (index >= SegmentCount()) {
+    pos.currentQuestion = 1;
+    pos.currentBlock = BlockCount() > 0 ? BlockCount() : 1;
+    pos.questionsInBlock = blocks.empty() ? 0 : blocks.back().numQuestions;
+    pos.segmentIndex = SegmentCount();
+    pos.completed = true;
+    return pos;
+  }
+
+  const PlanSegment& segment = segments[index];
+  const int64_t segmentStart = index > 0 ? segmentEnds[index - 1] : 0;
+  const int64_t segmentEnd = segmentEnds[index];
+
+  pos.currentTime = static_cast<int>(TotalSeconds() - elapsedSeconds);
+  pos.segmentIndex = index;
+  pos.questionTimeElapsed = static_cast<int>(elapsedSeconds - segmentStart);
+  pos.questionLength = static_cast<int>(segmentEnd - segmentStart);
+
+  if (segment.kind == PlanSegmentKind::Break) {
+    // A break is shown against the block it leads into.
+    const int nextBlock = std::min(segment.block, BlockCount() - 1);
+    pos.inBreak = true;
+    pos.currentQuestion = 0;
+    pos.currentBlock = nextBlock + 1 > 0 ? nextBlock + 1 : 1;
+    pos.questionsInBlock = nextBlock >= 0 ? blocks[nextBlock].numQuestions : 0;
+    pos.blockTimeElapsed = pos.questionTimeElapsed;
+    pos.blockLength = pos.questionLength;
+  } else {
+    const PlanBlock& block = blocks[segment.block];
+    pos.currentQuestion = segment.question;
+    pos.currentBlock = segment.block + 1;
+    pos.questionsInBlock = block.numQuestions;
+    pos.blockTimeElapsed = static_cast<int>(elapsedSeconds - block.startSecond);
+    pos.blockLength = static_cast<int>(block.endSecond - block.startSecond);
+  }
+
+  if (pos.questionLength > 0) {
+    pos.questionProgress = (pos.questionTimeElapsed * 100) / pos.questionLength;
+  }
+  if (pos.blockLength > 0) {
+    pos.blockProgress = (pos.blockTimeElapsed * 100) / pos.blockLength;
+  }
+  return pos;
+}
@@ -0,0 +1,87 @@
+// SessionPlan.h - Flattened session timeline with variable question budgets
+
+#ifndef SESSIONPLAN_H
+#define SESSIONPLAN_H
+
+#include <cstdint>
+#include <vector>
+
+// Timer position at a given elapsed time, as produced by StateAt() and
+// SessionPlan::PositionAt()
+struct TimerPosition {
+  int currentTime;          // Total remaining time in seconds
+  int currentQuestion;      // Current question number (1-based, 0 in a break)
+  int currentBlock;         // Current block number (1-based)
+  int blockTimeElapsed;     // Seconds elapsed in current block (or break)
+  int questionTimeElapsed;  // Seconds elapsed in current question (or break)
+  int questionLength;       // Length of the current question (or break)
+  int blockLength;          // Length of the current block (or break)
+  int questionsInBlock;     // Number of questions in the current block
+  int questionProgress;     // 0-100
+  int blockProgress;        // 0-100
+  int segmentIndex;         // Index of the current plan segment
+  bool inBreak;             // Inside a scheduled break
+  bool completed;           // All blocks finished
+};
+
+enum class PlanSegmentKind : uint8_t { Question, Break };
+
+// One question or break on the flattened timeline. Its time span is
+// [segmentEnds[i - 1], segmentEnds[i]) of the owning plan.
+struct PlanSegment {
+  PlanSegmentKind kind;
+  int section;   // Section the segment belongs to
+  int block;     // Owning block index; for a break, the block that follows
+  int question;  // 1-based question number within the block (0 for breaks)
+};
+
+struct PlanBlock {
+  int64_t startSecond;
+  int64_t endSecond;
+  int section;
+  int numQuestions;
+};
+
+// A session flattened from sections, blocks, weighted questions and breaks
+// into one contiguous, prefix-summed array of segment boundaries. Looking up
+// the segment for an elapsed time is a binary search (O(log n)), so plans with
+// tens of thousands of segments stay cheap to tick.
+//
+// Each block's length is split across its questions in proportion to their
+// weights using cumulative rounding, so question lengths differ by at most one
+// second for equal weights and always sum exactly to the block length.
+struct SessionPlan {
+  std::vector<int64_t> segmentEnds;  // Exclusive end second of each segment
+  std::vector<PlanSegment> segments;
+  std::vector<PlanBlock> blocks;
+
+  void Clear() {
+    segmentEnds.clear();
+    segments.clear();
+    blocks.clear();
+  }
+
+  int64_t TotalSeconds() const {
+    return segmentEnds.empty() ? 0 : segmentEnds.back();
+  }
+  int SegmentCount() const { return static_cast<int>(segments.size()); }
+  int BlockCount() const { return static_cast<int>(blocks.size()); }
+
+  // Appends a block of lengthSeconds whose questions get time in proportion
+  // to weights[0..numQuestions). A null weights array, or weights that sum to
+  // zero, gives every question an equal share. Returns the block index.
+  int AddBlock(int section, int64_t lengthSeconds, int numQuestions,
+               const int* weights = nullptr);
+
+  // Appends a break of lengthSeconds.
+  void AddBreak(int section, int64_t lengthSeconds);
+
+  // Index of the segment containing elapsedSeconds, or SegmentCount() once
+  // the plan is complete. hint (usually the previous result) is checked
+  // first so steady ticking avoids the binary search.
+  int FindSegment(int64_t elapsedSeconds, int hint = -1) const;
+
+  TimerPosition PositionAt(int64_t elapsedSeconds, int hint = -1) const;
+};
+
+#endif  // SESSIONPLAN_H
@@ -0,0 +1,241 @@
+// SessionProgress.cpp - Row setup, kernel dispatch, scalar and SSE2 kernels
+
+#include "SessionProgress.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define WOLFTIMER_PROGRESS_X64 1
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+
+bool CpuHasAvx2() {
+#if !defined(WOLFTIMER_PROGRESS_X64)
+  return false;
+#elif defined(_MSC_VER)
+  // AVX needs the OS to save the YMM registers (OSXSAVE, XCR0 bits 1-2).
+  int info[4];
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+}  // namespace
+
+void SessionProgressBatch::Reset(int64_t epoch) {
+  epochMs = epoch;
+  for (auto* column : {&base, &runMask, &questionStart, &questionLength,
+                       &blockStart, &totalLength, &question, &block,
+                       &questionsInBlock, &remainingMs}) {
+    column->clear();
+  }
+  for (auto* column :
+       {&questionScale, &blockScale, &questionProgress, &blockProgress}) {
+    column->clear();
+  }
+  staleRows.clear();
+}
+
+size_t SessionProgressBatch::Add() {
+  const size_t row = Size();
+  for (auto* column : {&base, &runMask, &questionStart, &questionLength,
+                       &blockStart, &totalLength, &question, &block,
+                       &questionsInBlock}) {
+    column->push_back(0);
+  }
+  questionScale.push_back(0.0f);
+  blockScale.push_back(0.0f);
+  return row;
+}
+
+void SessionProgressBatch::Set(size_t row, const TimerPosition& pos,
+                               int64_t elapsedMs, bool running,
+                               int64_t nowMs) {
+  if (elapsedMs < 0) elapsedMs = 0;
+  const int64_t second = elapsedMs / 1000;
+
+  if (running) {
+    runMask[row] = -1;
+    base[row] = static_cast<int32_t>(nowMs - elapsedMs - epochMs);
+  } else {
+    runMask[row] = 0;
+    base[row] = static_cast<int32_t>(-elapsedMs);
+  }
+  totalLength[row] = static_cast<int32_t>((second + pos.currentTime) * 1000);
+  question[row] = pos.currentQuestion;
+  block[row] = pos.currentBlock;
+  questionsInBlock[row] = pos.questionsInBlock;
+
+  if (pos.completed) {
+    // Never leaves its window, shows empty bars and no time left
+    questionStart[row] = 0;
+    questionLength[row] = std::numeric_limits<int32_t>::max();
+    questionScale[row] = 0.0f;
+    blockStart[row] = 0;
+    blockScale[row] = 0.0f;
+    return;
+  }
+
+  const int32_t questionMs = pos.questionLength * 1000;
+  const int32_t blockMs = pos.blockLength * 1000;
+  questionStart[row] =
+      static_cast<int32_t>((second - pos.questionTimeElapsed) * 1000);
+  questionLength[row] = questionMs;
+  questionScale[row] = questionMs > 0 ? 1.0f / questionMs : 0.0f;
+  blockStart[row] = static_cast<int32_t>((second - pos.blockTimeElapsed) * 1000);
+  blockScale[row] = blockMs > 0 ? 1.0f / blockMs : 0.0f;
+}
+
+size_t SessionProgressBatch::Compute(int64_t nowMs, ProgressKernel kernel) {
+  const size_t count = Size();
+  questionProgress.resize(count);
+  blockProgress.resize(count);
+  remainingMs.resize(count);
+  staleRows.clear();
+
+  ProgressKernelArgs args = {};
+  args.base = base.data();
+  args.runMask = runMask.data();
+  args.questionStart = questionStart.data();
+  args.questionLength = questionLength.data();
+  args.questionScale = questionScale.data();
+  args.blockStart = blockStart.data();
+  args.blockScale = blockScale.data();
+  args.totalLength = totalLength.data();
+  args.questionProgress = questionProgress.data();
+  args.blockProgress = blockProgress.data();
+  args.remainingMs = remainingMs.data();
+  args.staleRows = &staleRows;
+  args.count = count;
+  args.now = static_cast<int32_t>(nowMs - epochMs);
+
+  const ProgressKernel best = GetBestProgressKernel();
+  if (kernel == ProgressKernel::Auto ||
+      (kernel == ProgressKernel::Avx2 && best != ProgressKernel::Avx2)) {
+    kernel = best;
+  }
+  switch (kernel) {
+    case ProgressKernel::Avx2:
+      ComputeProgressAvx2(args);
+      break;
+    case ProgressKernel::Sse2:
+      ComputeProgressSse2(args);
+      break;
+    case ProgressKernel::Auto:
+    case ProgressKernel::Scalar:
+      ComputeProgressScalar(args, 0);
+      break;
+  }
+  return staleRows.size();
+}
+
+ProgressKernel GetBestProgressKernel() {
+  static const ProgressKernel best = [] {
+#if defined(WOLFTIMER_PROGRESS_X64)
+    return IsProgressAvx2Built() && CpuHasAvx2() ? ProgressKernel::Avx2
+                                                 : ProgressKernel::Sse2;
+#else
+    return ProgressKernel::Scalar;
+#endif
+  }();
+  return best;
+}
+
+void AppendStaleRows(std::vector<uint32_t>* rows, size_t first,
+                     uint32_t mask) {
+  for (uint32_t bit = 0; mask != 0; bit++, mask >>= 1) {
+    if (mask & 1) rows->push_back(static_cast<uint32_t>(first + bit));
+  }
+}
+
+void ComputeProgressScalar(const ProgressKernelArgs& args, size_t first) {
+  for (size_t i = first; i < args.count; i++) {
+    const int32_t elapsed = (args.now & args.runMask[i]) - args.base[i];
+    const int32_t inQuestion = elapsed - args.questionStart[i];
+    if (inQuestion < 0 || inQuestion >= args.questionLength[i]) {
+      args.staleRows->push_back(static_cast<uint32_t>(i));
+    }
+
+    const float questionFill = inQuestion * args.questionScale[i];
+    const float blockFill = (elapsed - args.blockStart[i]) * args.blockScale[i];
+    args.questionProgress[i] = std::min(std::max(questionFill, 0.0f), 1.0f);
+    args.blockProgress[i] = std::min(std::max(blockFill, 0.0f), 1.0f);
+
+    const int32_t remaining = args.totalLength[i] - elapsed;
+    args.remainingMs[i] = remaining > 0 ? remaining : 0;
+  }
+}
+
+#if defined(WOLFTIMER_PROGRESS_X64)
+
+void ComputeProgressSse2(const ProgressKernelArgs& args) {
+  const __m128i now = _mm_set1_epi32(args.now);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 empty = _mm_setzero_ps();
+  const __m128 full = _mm_set1_ps(1.0f);
+
+  size_t i = 0;
+  for (; i + 4 <= args.count; i += 4) {
+    const __m128i elapsed = _mm_sub_epi32(
+        _mm_and_si128(
+            now, _mm_loadu_si128(
+                     reinterpret_cast<const __m128i*>(args.runMask + i))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(args.base + i)));
+
+    // In the window when 0 <= inQuestion < questionLength
+    const __m128i inQuestion = _mm_sub_epi32(
+        elapsed, _mm_loadu_si128(
+                     reinterpret_cast<const __m128i*>(args.questionStart + i)));
+    const __m128i inWindow = _mm_andnot_si128(
+        _mm_cmplt_epi32(inQuestion, zero),
+        _mm_cmpgt_epi32(
+            _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(args.questionLength + i)),
+            inQuestion));
+    const int stale = _mm_movemask_ps(_mm_castsi128_ps(inWindow)) ^ 0xF;
+    if (stale != 0) {
+      AppendStaleRows(args.staleRows, i, static_cast<uint32_t>(stale));
+    }
+
+    const __m128 questionFill = _mm_mul_ps(
+        _mm_cvtepi32_ps(inQuestion), _mm_loadu_ps(args.questionScale + i));
+    _mm_storeu_ps(args.questionProgress + i,
+                  _mm_min_ps(_mm_max_ps(questionFill, empty), full));
+
+    const __m128i inBlock = _mm_sub_epi32(
+        elapsed,
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(args.blockStart + i)));
+    const __m128 blockFill = _mm_mul_ps(_mm_cvtepi32_ps(inBlock),
+                                        _mm_loadu_ps(args.blockScale + i));
+    _mm_storeu_ps(args.blockProgress + i,
+                  _mm_min_ps(_mm_max_ps(blockFill, empty), full));
+
+    const __m128i remaining = _mm_sub_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(args.totalLength + i)),
+        elapsed);
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(args.remainingMs + i),
+        _mm_and_si128(remaining, _mm_cmpgt_epi32(remaining, zero)));
+  }
+  ComputeProgressScalar(args, i);
+}
+
+#else
+
+void ComputeProgressSse2(const ProgressKernelArgs& args) {
+  ComputeProgressScalar(args, 0);
+}
+
+#endif  // WOLFTIMER_PROGRESS_X64
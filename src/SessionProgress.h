@@ -0,0 +1,110 @@
+// SessionProgress.h - Batch progress for many sessions, structure of arrays
+
+#ifndef SESSIONPROGRESS_H
+#define SESSIONPROGRESS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "SessionPlan.h"
+
+// Implementations of SessionProgressBatch::Compute(). Auto picks the widest
+// one the CPU supports.
+enum class ProgressKernel : uint8_t { Auto, Scalar, Sse2, Avx2 };
+
+// Question/block progress and remaining time of every session a proctor
+// dashboard shows, recomputed each frame in one pass.
+//
+// Each row holds a session's current question and block as windows of
+// elapsed milliseconds, with the reciprocal of each length computed once when
+// the row is set, so the pass is a handful of subtractions, multiplies and
+// clamps per session with no division and no branches. The columns are
+// plain arrays, which the SSE2 and AVX2 kernels walk 4 or 8 rows at a time.
+//
+// Rows only change when a session crosses a question boundary or gets a
+// command. Compute() lists the rows whose elapsed time has left their
+// question window in staleRows; the caller sets those again from the
+// session's authoritative position (TimerState or SessionFleet), which keeps
+// the per-frame pass free of plan lookups.
+//
+// Times are kept as 32-bit milliseconds from an epoch, so the epoch must be
+// within about 24 days of every time passed in.
+struct SessionProgressBatch {
+  // Empties the batch and sets the epoch for the 32-bit times.
+  void Reset(int64_t epochMs);
+
+  // Appends a row and returns its index; set it before the next Compute().
+  size_t Add();
+  size_t Size() const { return base.size(); }
+
+  // Sets row from pos (the session's position at whole second
+  // elapsedMs / 1000), the exact elapsed time and whether it is running.
+  void Set(size_t row, const TimerPosition& pos, int64_t elapsedMs,
+           bool running, int64_t nowMs);
+
+  // Recomputes the outputs for every row at nowMs and lists the rows that
+  // need setting again. Returns the number of such rows.
+  size_t Compute(int64_t nowMs, ProgressKernel kernel = ProgressKernel::Auto);
+
+  // Inputs, one entry per row
+  std::vector<int32_t> base;            // now & runMask - base == elapsed
+  std::vector<int32_t> runMask;         // -1 while running, 0 while halted
+  std::vector<int32_t> questionStart;   // Elapsed ms the question began at
+  std::vector<int32_t> questionLength;  // Question length in ms
+  std::vector<float> questionScale;     // 1 / questionLength
+  std::vector<int32_t> blockStart;
+  std::vector<float> blockScale;        // 1 / block length
+  std::vector<int32_t> totalLength;     // Session length in ms
+  std::vector<int32_t> question;        // Position: 1-based, 0 in a break
+  std::vector<int32_t> block;           // Position: 1-based
+  std::vector<int32_t> questionsInBlock;
+
+  // Outputs of Compute()
+  std::vector<float> questionProgress;  // 0-1
+  std::vector<float> blockProgress;     // 0-1
+  std::vector<int32_t> remainingMs;     // Never negative
+  std::vector<uint32_t> staleRows;      // Left their question window
+
+ private:
+  int64_t epochMs = 0;
+};
+
+// Arguments of one kernel pass over rows [0, count)
+struct ProgressKernelArgs {
+  const int32_t* base;
+  const int32_t* runMask;
+  const int32_t* questionStart;
+  const int32_t* questionLength;
+  const float* questionScale;
+  const int32_t* blockStart;
+  const float* blockScale;
+  const int32_t* totalLength;
+  float* questionProgress;
+  float* blockProgress;
+  int32_t* remainingMs;
+  std::vector<uint32_t>* staleRows;
+  size_t count;
+  int32_t now;
+};
+
+// Appends first + i to rows for every set bit i of mask. Out of line so the
+// AVX2 translation unit, built with -mavx2, instantiates no std::vector code
+// that the linker could pick for the rest of the program.
+void AppendStaleRows(std::vector<uint32_t>* rows, size_t first, uint32_t mask);
+
+// The scalar kernel covers rows [first, args.count); the vector kernels
+// cover every row and finish the last partial group with it. Off x86-64 the
+// vector kernels are the scalar one.
+void ComputeProgressScalar(const ProgressKernelArgs& args, size_t first);
+void ComputeProgressSse2(const ProgressKernelArgs& args);
+void ComputeProgressAvx2(const ProgressKernelArgs& args);
+
+// Whether ComputeProgressAvx2 was compiled with AVX2 code generation. It
+// must then only run on a CPU that has AVX2.
+bool IsProgressAvx2Built();
+
+// The kernel Auto resolves to on this CPU.
+ProgressKernel GetBestProgressKernel();
+
+#endif  // SESSIONPROGRESS_H
@@ -0,0 +1,77 @@
+// SessionProgressAvx2.cpp - AVX2 progress kernel, 8 rows per step
+//
+// Built with AVX2 code generation on x86-64 (see CMakeLists.txt), so nothing
+// here may run before GetBestProgressKernel() has checked the CPU, and
+// nothing here may instantiate inline library code shared with other
+// translation units.
+
+#include "SessionProgress.h"
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+bool IsProgressAvx2Built() { return true; }
+
+void ComputeProgressAvx2(const ProgressKernelArgs& args) {
+  const __m256i now = _mm256_set1_epi32(args.now);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256 empty = _mm256_setzero_ps();
+  const __m256 full = _mm256_set1_ps(1.0f);
+
+  size_t i = 0;
+  for (; i + 8 <= args.count; i += 8) {
+    const __m256i elapsed = _mm256_sub_epi32(
+        _mm256_and_si256(
+            now, _mm256_loadu_si256(
+                     reinterpret_cast<const __m256i*>(args.runMask + i))),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(args.base + i)));
+
+    // In the window when 0 <= inQuestion < questionLength
+    const __m256i inQuestion = _mm256_sub_epi32(
+        elapsed, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+                     args.questionStart + i)));
+    const __m256i inWindow = _mm256_andnot_si256(
+        _mm256_cmpgt_epi32(zero, inQuestion),
+        _mm256_cmpgt_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+                               args.questionLength + i)),
+                           inQuestion));
+    const int stale = _mm256_movemask_ps(_mm256_castsi256_ps(inWindow)) ^ 0xFF;
+    if (stale != 0) {
+      AppendStaleRows(args.staleRows, i, static_cast<uint32_t>(stale));
+    }
+
+    const __m256 questionFill =
+        _mm256_mul_ps(_mm256_cvtepi32_ps(inQuestion),
+                      _mm256_loadu_ps(args.questionScale + i));
+    _mm256_storeu_ps(args.questionProgress + i,
+                     _mm256_min_ps(_mm256_max_ps(questionFill, empty), full));
+
+    const __m256i inBlock = _mm256_sub_epi32(
+        elapsed, _mm256_loadu_si256(
+                     reinterpret_cast<const __m256i*>(args.blockStart + i)));
+    const __m256 blockFill = _mm256_mul_ps(
+        _mm256_cvtepi32_ps(inBlock), _mm256_loadu_ps(args.blockScale + i));
+    _mm256_storeu_ps(args.blockProgress + i,
+                     _mm256_min_ps(_mm256_max_ps(blockFill, empty), full));
+
+    const __m256i remaining = _mm256_sub_epi32(
+        _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(args.totalLength + i)),
+        elapsed);
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(args.remainingMs + i),
+        _mm256_and_si256(remaining, _mm256_cmpgt_epi32(remaining, zero)));
+  }
+  ComputeProgressScalar(args, i);
+}
+
+#else
+
+bool IsProgressAvx2Built() { return false; }
+
+void ComputeProgressAvx2(const ProgressKernelArgs& args) {
+  ComputeProgressSse2(args);
+}
+
+#endif  // __AVX2__
@@ -0,0 +1,289 @@
+// SettingsStore.cpp - INI parsing, serialization and atomic replacement
+
+#include "SettingsStore.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+#include "BackgroundWriter.h"
+
+namespace {
+
+std::string Trim(const std::string& text) {
+  const char* whitespace = " \t\r\n";
+  const size_t first = text.find_first_not_of(whitespace);
+  if (first == std::string::npos) return std::string();
+  const size_t last = text.find_last_not_of(whitespace);
+  return text.substr(first, last - first + 1);
+}
+
+std::filesystem::path ResolveSettingsDirectory() {
+  std::filesystem::path dir;
+#ifdef _WIN32
+  const wchar_t* appData = _wgetenv(L"APPDATA");
+  if (appData && appData[0]) dir = std::filesystem::path(appData) / L"WolfTimer";
+#else
+  const char* configHome = std::getenv("XDG_CONFIG_HOME");
+  const char* home = std::getenv("HOME");
+  if (configHome && configHome[0]) {
+    dir = std::filesystem::path(configHome) / "wolftimer";
+  } else if (home && home[0]) {
+    dir = std::filesystem::path(home) / ".config" / "wolftimer";
+  }
+#endif
+  if (dir.empty()) return dir;
+
+  std::error_code error;
+  std::filesystem::create_directories(dir, error);
+  if (error) dir.clear();
+  return dir;
+}
+
+// Writes contents to file and waits until they are on the disk: _commit()
+// is FlushFileBuffers() on Windows.
+bool WriteFileDurably(const std::filesystem::path& file,
+                      const std::string& contents) {
+#ifdef _WIN32
+  int fd = -1;
+  if (_wsopen_s(&fd, file.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+                _SH_DENYWR, _S_IREAD | _S_IWRITE) != 0) {
+    return false;
+  }
+  bool ok = true;
+  for (size_t done = 0; ok && done < contents.size();) {
+    const size_t chunk = contents.size() - done < 0x40000000u
+                             ? contents.size() - done
+                             : 0x40000000u;
+    const int written =
+        _write(fd, contents.data() + done, static_cast<unsigned>(chunk));
+    ok = written > 0;
+    if (ok) done += static_cast<size_t>(written);
+  }
+  ok = ok && _commit(fd) == 0;
+  return _close(fd) == 0 && ok;
+#else
+  const int fd = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                      0644);
+  if (fd < 0) return false;
+  bool ok = true;
+  for (size_t done = 0; ok && done < contents.size();) {
+    const ssize_t written =
+        write(fd, contents.data() + done, contents.size() - done);
+    if (written < 0 && errno == EINTR) continue;
+    ok = written > 0;
+    if (ok) done += static_cast<size_t>(written);
+  }
+  ok = ok && fsync(fd) == 0;
+  return close(fd) == 0 && ok;
+#endif
+}
+
+// Makes a rename within dir durable. Windows has no directory handle to
+// sync; the rename is journaled by NTFS.
+void SyncDirectory(const std::filesystem::path& dir) {
+#ifdef _WIN32
+  (void)dir;
+#else
+  const int fd = open(dir.empty() ? "." : dir.c_str(),
+                      O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) return;
+  fsync(fd);
+  close(fd);
+#endif
+}
+
+}  // namespace
+
+const std::filesystem::path& GetSettingsDirectory() {
+  static const std::filesystem::path dir = ResolveSettingsDirectory();
+  return dir;
+}
+
+bool WriteFileAtomically(const std::filesystem::path& file,
+                         const std::string& contents) {
+  std::filesystem::path temp = file;
+  temp += ".tmp";
+
+  // The data must reach the disk before the rename does, or a power loss
+  // can leave the new name pointing at an empty or partial file.
+  std::error_code error;
+  if (!WriteFileDurably(temp, contents)) {
+    std::filesystem::remove(temp, error);
+    return false;
+  }
+
+  std::filesystem::rename(temp, file, error);
+  if (error) {
+    std::filesystem::remove(temp, error);
+    return false;
+  }
+  SyncDirectory(file.parent_path());
+  return true;
+}
+
+bool AppendToFile(const std::filesystem::path& file,
+                  const std::string& contents) {
+  std::ofstream out(file, std::ios::binary | std::ios::app);
+  out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+  out.flush();
+  return static_cast<bool>(out);
+}
+
+bool SettingsStore::Load(const std::filesystem::path& file) {
+  path = file;
+  sections.clear();
+  dirty = false;
+
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    std::error_code error;
+    return !std::filesystem::exists(path, error);
+  }
+
+  std::ostringstream text;
+  text << in.rdbuf();
+  Parse(text.str());
+  return true;
+}
+
+void SettingsStore::Parse(const std::string& text) {
+  sections.clear();
+  Section* current = nullptr;
+
+  size_t start = 0;
+  if (text.compare(0, 3, "\xEF\xBB\xBF") == 0) start = 3;  // UTF-8 BOM
+
+  while (start < text.size()) {
+    size_t end = text.find('\n', start);
+    if (end == std::string::npos) end = text.size();
+    const std::string line = Trim(text.substr(start, end - start));
+    start = end + 1;
+
+    if (line.empty() || line[0] == ';' || line[0] == '#') continue;
+
+    if (line.front() == '[' && line.back() == ']') {
+      sections.push_back({Trim(line.substr(1, line.size() - 2)), {}});
+      current = &sections.back();
+      continue;
+    }
+
+    const size_t equals = line.find('=');
+    if (!current || equals == std::string::npos) continue;
+    current->values.emplace_back(Trim(line.substr(0, equals)),
+                                 Trim(line.substr(equals + 1)));
+  }
+}
+
+std::string SettingsStore::Serialize() const {
+  std::string text;
+  for (const Section& section : sections) {
+    if (!text.empty()) text += '\n';
+    text += '[';
+    text += section.name;
+    text += "]\n";
+    for (const auto& value : section.values) {
+      text += value.first;
+      text += '=';
+      text += value.second;
+      text += '\n';
+    }
+  }
+  return text;
+}
+
+const std::string* SettingsStore::Find(const char* section,
+                                       const char* key) const {
+  for (const Section& candidate : sections) {
+    if (candidate.name != section) continue;
+    for (const auto& value : candidate.values) {
+      if (value.first == key) return &value.second;
+    }
+  }
+  return nullptr;
+}
+
+bool SettingsStore::GetInt(const char* section, const char* key,
+                           int* value) const {
+  const std::string* text = Find(section, key);
+  if (!text || text->empty()) return false;
+  *value = static_cast<int>(std::strtol(text->c_str(), nullptr, 10));
+  return true;
+}
+
+void SettingsStore::SetString(const char* section, const char* key,
+                              const std::string& value) {
+  setCalls++;
+
+  Section* target = nullptr;
+  for (Section& candidate : sections) {
+    if (candidate.name == section) {
+      target = &candidate;
+      break;
+    }
+  }
+  if (!target) {
+    sections.push_back({section, {}});
+    target = &sections.back();
+  }
+
+  for (auto& existing : target->values) {
+    if (existing.first != key) continue;
+    if (existing.second == value) return;  // Unchanged: nothing to save
+    existing.second = value;
+    changedValues++;
+    dirty = true;
+    return;
+  }
+
+  target->values.emplace_back(key, value);
+  changedValues++;
+  dirty = true;
+}
+
+void SettingsStore::SetInt(const char* section, const char* key, int value) {
+  SetString(section, key, std::to_string(value));
+}
+
+bool SettingsStore::Flush() {
+  if (!dirty) return true;
+  if (path.empty()) {
+    failedFlushes++;
+    return false;
+  }
+
+  const std::string text = Serialize();
+  if (!WriteFileAtomically(path, text)) {
+    failedFlushes++;
+    return false;
+  }
+
+  dirty = false;
+  flushes++;
+  bytesWritten += text.size();
+  return true;
+}
+
+void SettingsStore::FlushTo(BackgroundWriter* writer) {
+  if (!dirty || path.empty()) return;
+
+  PersistSnapshot snapshot;
+  snapshot.path = path;
+  snapshot.contents = Serialize();
+  bytesWritten += snapshot.contents.size();
+  writer->Enqueue(std::move(snapshot));
+  dirty = false;
+  flushes++;
+}
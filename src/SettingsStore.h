@@ -0,0 +1,77 @@
+// SettingsStore.h - In-memory INI settings saved in one atomic write
+
+#ifndef SETTINGSSTORE_H
+#define SETTINGSSTORE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct BackgroundWriter;
+
+// Per-user directory for Wolf-Timer's files (%APPDATA%\WolfTimer on Windows,
+// $XDG_CONFIG_HOME/wolftimer or ~/.config/wolftimer elsewhere). Resolved and
+// created on first use only; empty if no such directory is available.
+const std::filesystem::path& GetSettingsDirectory();
+
+// Replaces file with contents by writing a temporary sibling and renaming it
+// over the original, so readers see either the old file or the new one. The
+// temporary is synced before the rename and the directory after it, so after
+// a crash or power loss the file is also either old or new, never torn.
+bool WriteFileAtomically(const std::filesystem::path& file,
+                         const std::string& contents);
+
+// Adds contents to the end of file, creating it if needed.
+bool AppendToFile(const std::filesystem::path& file,
+                  const std::string& contents);
+
+// Keeps an INI file in memory. Reads never touch the disk; writes only mark
+// the store dirty, and Flush() replaces the whole file at once with
+// WriteFileAtomically(). Callers coalesce bursts of changes by deferring
+// Flush() (e.g. behind a timer), so any number of Set calls costs one write.
+struct SettingsStore {
+  struct Section {
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> values;  // In file order
+  };
+
+  std::filesystem::path path;
+  std::vector<Section> sections;
+  bool dirty = false;
+
+  // Instrumentation
+  uint64_t setCalls = 0;       // Set calls, including unchanged values
+  uint64_t changedValues = 0;  // Set calls that changed a value
+  uint64_t flushes = 0;        // Successful file replacements
+  uint64_t failedFlushes = 0;
+  uint64_t bytesWritten = 0;
+
+  // Points the store at file and reads it. A missing file leaves the store
+  // empty; returns false only if the file exists but cannot be read.
+  bool Load(const std::filesystem::path& file);
+
+  // Parses INI text, replacing the current contents.
+  void Parse(const std::string& text);
+
+  // Serializes the current contents as INI text.
+  std::string Serialize() const;
+
+  const std::string* Find(const char* section, const char* key) const;
+  bool GetInt(const char* section, const char* key, int* value) const;
+
+  void SetString(const char* section, const char* key,
+                 const std::string& value);
+  void SetInt(const char* section, const char* key, int value);
+
+  // Writes the file if anything changed since the last flush. Returns false
+  // if the write failed; the store stays dirty so a later flush retries.
+  bool Flush();
+
+  // Like Flush(), but hands a snapshot to writer instead of touching the
+  // disk on the calling thread.
+  void FlushTo(BackgroundWriter* writer);
+};
+
+#endif  // SETTINGSSTORE_H
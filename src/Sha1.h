@@ -0,0 +1,98 @@
+// Sha1.h - SHA-1 digest, for the WebSocket opening handshake
+
+#ifndef SHA1_H
+#define SHA1_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// FIPS 180-4 SHA-1. Only used where a protocol demands it (RFC 6455 derives
+// Sec-WebSocket-Accept with it); it is not collision resistant.
+struct Sha1Digest {
+  uint8_t bytes[20];
+};
+
+namespace sha1 {
+
+inline uint32_t RotateLeft(uint32_t value, int bits) {
+  return (value << bits) | (value >> (32 - bits));
+}
+
+inline void ProcessBlock(const uint8_t* block, uint32_t state[5]) {
+  uint32_t w[80];
+  for (int i = 0; i < 16; i++) {
+    w[i] = static_cast<uint32_t>(block[i * 4]) << 24 |
+           static_cast<uint32_t>(block[i * 4 + 1]) << 16 |
+           static_cast<uint32_t>(block[i * 4 + 2]) << 8 | block[i * 4 + 3];
+  }
+  for (int i = 16; i < 80; i++) {
+    w[i] = RotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+  }
+
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3],
+           e = state[4];
+  for (int i = 0; i < 80; i++) {
+    uint32_t f, k;
+    if (i < 20) {
+      f = (b & c) | (~b & d);
+      k = 0x5A827999u;
+    } else if (i < 40) {
+      f = b ^ c ^ d;
+      k = 0x6ED9EBA1u;
+    } else if (i < 60) {
+      f = (b & c) | (b & d) | (c & d);
+      k = 0x8F1BBCDCu;
+    } else {
+      f = b ^ c ^ d;
+      k = 0xCA62C1D6u;
+    }
+    const uint32_t next = RotateLeft(a, 5) + f + e + k + w[i];
+    e = d;
+    d = c;
+    c = RotateLeft(b, 30);
+    b = a;
+    a = next;
+  }
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+}
+
+}  // namespace sha1
+
+// SHA-1 of size bytes at data.
+inline Sha1Digest ComputeSha1(const void* data, size_t size) {
+  uint32_t state[5] = {0x67452301u, 0xEFCDAB89u, 0x98BADCFEu, 0x10325476u,
+                       0xC3D2E1F0u};
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  size_t remaining = size;
+  for (; remaining >= 64; remaining -= 64, bytes += 64) {
+    sha1::ProcessBlock(bytes, state);
+  }
+
+  // Final one or two blocks: the tail, 0x80, zeros, then the bit length
+  uint8_t tail[128] = {};
+  std::memcpy(tail, bytes, remaining);
+  tail[remaining] = 0x80;
+  const size_t tailSize = remaining < 56 ? 64 : 128;
+  const uint64_t bits = static_cast<uint64_t>(size) * 8;
+  for (int i = 0; i < 8; i++) {
+    tail[tailSize - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+  }
+  sha1::ProcessBlock(tail, state);
+  if (tailSize == 128) sha1::ProcessBlock(tail + 64, state);
+
+  Sha1Digest digest;
+  for (int i = 0; i < 5; i++) {
+    digest.bytes[i * 4] = static_cast<uint8_t>(state[i] >> 24);
+    digest.bytes[i * 4 + 1] = static_cast<uint8_t>(state[i] >> 16);
+    digest.bytes[i * 4 + 2] = static_cast<uint8_t>(state[i] >> 8);
+    digest.bytes[i * 4 + 3] = static_cast<uint8_t>(state[i]);
+  }
+  return digest;
+}
+
+#endif  // SHA1_H
@@ -0,0 +1,197 @@
+// SharedMemory.cpp - Named shared-memory mappings (Win32 or POSIX shm)
+
+#include "SharedMemory.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+#ifdef _WIN32
+
+namespace {
+
+std::wstring WidenName(const std::string& name) {
+  return std::wstring(name.begin(), name.end());  // Names are ASCII
+}
+
+}  // namespace
+
+bool SharedMemoryMapping::Create(const std::string& regionName, size_t bytes) {
+  Close();
+  HANDLE mapping = CreateFileMappingW(
+      INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+      static_cast<DWORD>(static_cast<unsigned long long>(bytes) >> 32),
+      static_cast<DWORD>(bytes), WidenName(regionName).c_str());
+  if (!mapping) return false;
+  if (GetLastError() == ERROR_ALREADY_EXISTS) {
+    CloseHandle(mapping);  // Another instance is publishing
+    return false;
+  }
+
+  void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+  if (!view) {
+    CloseHandle(mapping);
+    return false;
+  }
+  handle = mapping;
+  address = view;
+  size = bytes;
+  name = regionName;
+  owner = true;
+  return true;
+}
+
+bool SharedMemoryMapping::Open(const std::string& regionName, size_t bytes) {
+  Close();
+  HANDLE mapping =
+      OpenFileMappingW(FILE_MAP_READ, FALSE, WidenName(regionName).c_str());
+  if (!mapping) return false;
+
+  // Fails if the region is smaller than bytes
+  void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, bytes);
+  if (!view) {
+    CloseHandle(mapping);
+    return false;
+  }
+  handle = mapping;
+  address = view;
+  size = bytes;
+  name = regionName;
+  owner = false;
+  return true;
+}
+
+void SharedMemoryMapping::Close() {
+  if (address) UnmapViewOfFile(address);
+  if (handle) CloseHandle(handle);  // The name goes with the last handle
+  address = nullptr;
+  handle = nullptr;
+  size = 0;
+  owner = false;
+}
+
+#else
+
+namespace {
+
+// True if regionName currently names the object with this identity (it may
+// have been unlinked and recreated by someone else since it was opened).
+bool IsNamedObject(const std::string& regionName, dev_t device, ino_t inode) {
+  const int fd = shm_open(regionName.c_str(), O_RDONLY, 0);
+  if (fd < 0) return false;
+  struct stat info;
+  const bool same = fstat(fd, &info) == 0 && info.st_dev == device &&
+                    info.st_ino == inode;
+  close(fd);
+  return same;
+}
+
+// Opens and locks an object at regionName that already exists. Returns -1
+// with errno EEXIST if its owner still holds the lock.
+int LockExistingObject(const std::string& regionName) {
+  const int fd = shm_open(regionName.c_str(), O_RDWR, 0);
+  if (fd < 0) return -1;
+  if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+    close(fd);
+    errno = EEXIST;
+    return -1;
+  }
+  return fd;
+}
+
+}  // namespace
+
+bool SharedMemoryMapping::Create(const std::string& regionName, size_t bytes) {
+  Close();
+  int fd = shm_open(regionName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0 && errno == EEXIST) {
+    // POSIX objects outlive their creator. The creator holds an exclusive
+    // flock() for as long as it runs, so an object nobody holds was left by
+    // one that crashed and can be replaced; a held one belongs to another
+    // live instance, and creation fails as it does on Windows.
+    const int stale = LockExistingObject(regionName);
+    if (stale < 0) return false;
+    struct stat info;
+    if (fstat(stale, &info) == 0 &&
+        IsNamedObject(regionName, info.st_dev, info.st_ino)) {
+      shm_unlink(regionName.c_str());
+    }
+    close(stale);
+    fd = shm_open(regionName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  }
+  if (fd < 0) return false;
+
+  // Another instance may have judged the object stale and unlinked it in
+  // the moment before it was locked; only the one still named may own it.
+  struct stat info;
+  if (flock(fd, LOCK_EX | LOCK_NB) != 0 || fstat(fd, &info) != 0 ||
+      !IsNamedObject(regionName, info.st_dev, info.st_ino)) {
+    close(fd);
+    return false;
+  }
+
+  if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+    shm_unlink(regionName.c_str());
+    close(fd);
+    return false;
+  }
+  void* view = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (view == MAP_FAILED) {
+    shm_unlink(regionName.c_str());
+    close(fd);
+    return false;
+  }
+  descriptor = fd;  // Kept open to hold the lock
+  device = static_cast<unsigned long long>(info.st_dev);
+  inode = static_cast<unsigned long long>(info.st_ino);
+  address = view;
+  size = bytes;
+  name = regionName;
+  owner = true;
+  return true;
+}
+
+bool SharedMemoryMapping::Open(const std::string& regionName, size_t bytes) {
+  Close();
+  const int fd = shm_open(regionName.c_str(), O_RDONLY, 0);
+  if (fd < 0) return false;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < bytes) {
+    close(fd);
+    return false;
+  }
+  void* view = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (view == MAP_FAILED) return false;
+  address = view;
+  size = bytes;
+  name = regionName;
+  owner = false;
+  return true;
+}
+
+void SharedMemoryMapping::Close() {
+  if (address) munmap(address, size);
+  // A successor may have replaced the object if this one was judged stale;
+  // only remove the name while it is still ours.
+  if (owner && IsNamedObject(name, static_cast<dev_t>(device),
+                             static_cast<ino_t>(inode))) {
+    shm_unlink(name.c_str());
+  }
+  if (descriptor >= 0) close(descriptor);  // Releases the lock
+  descriptor = -1;
+  address = nullptr;
+  size = 0;
+  owner = false;
+}
+
+#endif
@@ -0,0 +1,52 @@
+// SharedMemory.h - Named shared-memory mappings (Win32 or POSIX shm)
+
+#ifndef SHAREDMEMORY_H
+#define SHAREDMEMORY_H
+
+#include <cstddef>
+#include <string>
+
+// A named region of memory visible to every process on the machine that
+// opens the same name. On Windows it is a pagefile-backed file mapping
+// (names like "Local\\Name"); elsewhere a POSIX shm_open() object (names
+// like "/Name").
+//
+// One process creates the region read-write; any number of others open it
+// read-only, so a misbehaving reader can never disturb the writer.
+struct SharedMemoryMapping {
+  void* address = nullptr;
+  size_t size = 0;
+
+  SharedMemoryMapping() = default;
+  ~SharedMemoryMapping() { Close(); }
+
+  SharedMemoryMapping(const SharedMemoryMapping&) = delete;
+  SharedMemoryMapping& operator=(const SharedMemoryMapping&) = delete;
+
+  // Creates the region zero-filled and maps it read-write. Fails if a live
+  // process already owns it; a POSIX object left behind by a crashed owner
+  // (detected by its flock() being free) is replaced.
+  bool Create(const std::string& name, size_t bytes);
+
+  // Maps an existing region of at least bytes read-only.
+  bool Open(const std::string& name, size_t bytes);
+
+  // Unmaps the region. The creator also removes the name, unless it has
+  // been taken over by another object since.
+  void Close();
+
+  bool IsOpen() const { return address != nullptr; }
+
+ private:
+  std::string name;
+  bool owner = false;
+#ifdef _WIN32
+  void* handle = nullptr;
+#else
+  int descriptor = -1;  // The creator's, held open with an exclusive flock()
+  unsigned long long device = 0;  // Identity (st_dev, st_ino) of the object
+  unsigned long long inode = 0;   // the creator made
+#endif
+};
+
+#endif  // SHAREDMEMORY_H
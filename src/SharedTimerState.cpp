@@ -0,0 +1,80 @@
+// SharedTimerState.cpp - Publishing and reading the shared timer record
+
+#include "SharedTimerState.h"
+
+#include <new>
+#include <thread>
+
+namespace {
+
+// Attempts between yields while a read keeps overlapping writes
+constexpr uint32_t kReadAttemptsPerYield = 64;
+
+}  // namespace
+
+bool SharedTimerStatePublisher::Open(const std::string& name) {
+  Close();
+  if (!mapping.Create(name, sizeof(SharedTimerRegion))) return false;
+
+  region = new (mapping.address) SharedTimerRegion();
+  region->version = kSharedTimerLayoutVersion;
+  region->regionSize = sizeof(SharedTimerRegion);
+  last = SharedTimerState();
+  region->record.Write(last);
+  // Readers check the magic first, so everything above is visible by then.
+  region->magic.store(kSharedTimerMagic, std::memory_order_release);
+  return true;
+}
+
+void SharedTimerStatePublisher::Publish(const SharedTimerState& state) {
+  if (!region) return;
+  if (last.generation != 0 && IsSameSharedSecond(state, last)) return;
+
+  last = state;
+  last.generation = ++publishes;
+  last.reserved = 0;
+  region->record.Write(last);
+}
+
+void SharedTimerStatePublisher::Close() {
+  if (!region) return;
+  last.flags |= kSharedTimerClosed;
+  last.generation = ++publishes;
+  region->record.Write(last);
+  region = nullptr;
+  mapping.Close();
+}
+
+bool SharedTimerStateReader::Open(const std::string& name) {
+  Close();
+  if (!mapping.Open(name, sizeof(SharedTimerRegion))) return false;
+
+  const auto* candidate =
+      static_cast<const SharedTimerRegion*>(mapping.address);
+  if (candidate->magic.load(std::memory_order_acquire) != kSharedTimerMagic ||
+      candidate->version != kSharedTimerLayoutVersion ||
+      candidate->regionSize != sizeof(SharedTimerRegion)) {
+    mapping.Close();  // Still initializing, or a layout we do not know
+    return false;
+  }
+  region = candidate;
+  return true;
+}
+
+void SharedTimerStateReader::Close() {
+  region = nullptr;
+  mapping.Close();
+}
+
+bool SharedTimerStateReader::Read(SharedTimerState* state) {
+  if (!region) return false;
+  for (uint32_t attempt = 1; attempt <= kMaxReadAttempts; attempt++) {
+    if (region->record.TryRead(state)) {
+      reads++;
+      return true;
+    }
+    tornReads++;
+    if (attempt % kReadAttemptsPerYield == 0) std::this_thread::yield();
+  }
+  return false;
+}
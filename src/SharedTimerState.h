@@ -0,0 +1,206 @@
+// SharedTimerState.h - Live timer state published to other processes
+
+#ifndef SHAREDTIMERSTATE_H
+#define SHAREDTIMERSTATE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "SeqLock.h"
+#include "SharedMemory.h"
+
+// Overlays, proctoring tools and scripts read the running timer from a named
+// shared-memory region instead of asking the process. The timer publishes a
+// fixed-layout SharedTimerState through a SeqLock on every transition and
+// once per displayed second; readers poll it without locks, system calls or
+// any way of slowing the timer down.
+//
+// Region layout (little-endian, native alignment):
+//
+//   offset  0  uint32 magic "WTSM", written last
+//   offset  4  uint32 layout version (kSharedTimerLayoutVersion)
+//   offset  8  uint32 region size in bytes
+//   offset 64  uint32 seqlock sequence (odd while a write is in progress)
+//   offset 72  SharedTimerState as 11 64-bit words
+//
+// Any change to this layout or to SharedTimerState bumps the version;
+// readers refuse versions they do not know.
+
+#ifdef _WIN32
+constexpr const char* kSharedTimerStateName = "Local\\WolfTimerState";
+#else
+constexpr const char* kSharedTimerStateName = "/WolfTimerState";
+#endif
+
+constexpr uint32_t kSharedTimerMagic = 0x4D535457;  // "WTSM"
+constexpr uint32_t kSharedTimerLayoutVersion = 1;
+
+enum SharedTimerFlags : uint32_t {
+  kSharedTimerPaused = 1u << 0,
+  kSharedTimerStopped = 1u << 1,
+  kSharedTimerInBreak = 1u << 2,
+  kSharedTimerCompleted = 1u << 3,  // All blocks finished
+  kSharedTimerClosed = 1u << 4,     // The timer exited; nothing more follows
+};
+
+// Clock that capturedAtMs is read from: the system-wide monotonic clock
+// (QueryPerformanceCounter, CLOCK_MONOTONIC), comparable between processes.
+inline int64_t GetSharedClockMilliseconds() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// One published record. Times are exact at capturedAtMs; while running,
+// readers extrapolate with the *At() helpers instead of waiting for the next
+// publication.
+struct SharedTimerState {
+  uint64_t generation;        // Bumped by every publication
+  int64_t capturedAtMs;       // GetSharedClockMilliseconds() at capture
+  int64_t wallMs;             // Wall clock at capture, Unix ms
+  int64_t elapsedMs;          // Session time elapsed, excluding pauses
+  int64_t totalMs;            // Session length
+  int64_t questionElapsedMs;  // Into the current question (or break)
+  int64_t blockElapsedMs;     // Into the current block
+  int32_t block;              // 1-based
+  int32_t blockCount;
+  int32_t question;           // 1-based, 0 during a break
+  int32_t questionsInBlock;
+  int32_t questionSeconds;    // Length of the current question
+  int32_t blockSeconds;       // Length of the current block
+  uint32_t flags;             // SharedTimerFlags
+  uint32_t reserved;
+
+  bool IsRunning() const {
+    return !(flags & (kSharedTimerPaused | kSharedTimerStopped |
+                      kSharedTimerCompleted | kSharedTimerClosed));
+  }
+
+  // Session time elapsed at shared clock reading nowMs.
+  int64_t ElapsedMillisecondsAt(int64_t nowMs) const {
+    if (!IsRunning() || nowMs <= capturedAtMs) return elapsedMs;
+    const int64_t elapsed = elapsedMs + (nowMs - capturedAtMs);
+    return elapsed < totalMs ? elapsed : totalMs;
+  }
+
+  int64_t RemainingMillisecondsAt(int64_t nowMs) const {
+    const int64_t remaining = totalMs - ElapsedMillisecondsAt(nowMs);
+    return remaining > 0 ? remaining : 0;
+  }
+
+  // Time into the current question and block at nowMs, clamped to their
+  // lengths (the next publication moves on to the following one).
+  int64_t QuestionElapsedMillisecondsAt(int64_t nowMs) const {
+    return Clamp(questionElapsedMs + ElapsedMillisecondsAt(nowMs) - elapsedMs,
+                 questionSeconds);
+  }
+  int64_t BlockElapsedMillisecondsAt(int64_t nowMs) const {
+    return Clamp(blockElapsedMs + ElapsedMillisecondsAt(nowMs) - elapsedMs,
+                 blockSeconds);
+  }
+
+ private:
+  static int64_t Clamp(int64_t ms, int32_t seconds) {
+    const int64_t limit = static_cast<int64_t>(seconds) * 1000;
+    return ms < 0 ? 0 : ms > limit ? limit : ms;
+  }
+};
+
+static_assert(sizeof(SharedTimerState) == 88,
+              "SharedTimerState is a fixed layout; bump the version");
+
+// True if b differs from a only in its clock readings within the same
+// elapsed second: nothing a reader could not extrapolate on its own.
+inline bool IsSameSharedSecond(const SharedTimerState& a,
+                               const SharedTimerState& b) {
+  return a.flags == b.flags && a.block == b.block && a.question == b.question &&
+         a.blockCount == b.blockCount &&
+         a.questionsInBlock == b.questionsInBlock && a.totalMs == b.totalMs &&
+         a.elapsedMs / 1000 == b.elapsedMs / 1000;
+}
+
+// "running", "paused", "stopped", "completed" or "closed".
+inline const char* DescribeSharedTimerState(const SharedTimerState& state) {
+  if (state.flags & kSharedTimerClosed) return "closed";
+  if (state.flags & kSharedTimerCompleted) return "completed";
+  if (state.flags & kSharedTimerStopped) return "stopped";
+  if (state.flags & kSharedTimerPaused) return "paused";
+  return "running";
+}
+
+// What lives at the start of the mapping.
+struct SharedTimerRegion {
+  std::atomic<uint32_t> magic;  // kSharedTimerMagic once initialized
+  uint32_t version;
+  uint32_t regionSize;
+  uint32_t reserved;
+  SeqLock<SharedTimerState> record;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+                  std::atomic<uint64_t>::is_always_lock_free,
+              "Shared atomics must be address-free");
+static_assert(offsetof(SharedTimerRegion, record) == 64,
+              "SharedTimerRegion is a fixed layout; bump the version");
+
+// Writer side, owned by the timer. Publish() must not be called from two
+// threads at once.
+struct SharedTimerStatePublisher {
+  // Instrumentation
+  uint64_t publishes = 0;
+
+  // Creates and initializes the region; false if it could not be created
+  // (e.g. another timer instance already publishes under name).
+  bool Open(const std::string& name = kSharedTimerStateName);
+
+  bool IsOpen() const { return region != nullptr; }
+
+  // Publishes state unless IsSameSharedSecond() as the last one. generation
+  // is assigned here.
+  void Publish(const SharedTimerState& state);
+
+  // Publishes a final record flagged kSharedTimerClosed and removes the
+  // region.
+  void Close();
+
+ private:
+  SharedMemoryMapping mapping;
+  SharedTimerRegion* region = nullptr;
+  SharedTimerState last = {};
+};
+
+// Reader side, for any process. Every call is lock-free and never blocks the
+// writer.
+struct SharedTimerStateReader {
+  // A writer that died mid-write leaves the record permanently torn; give up
+  // after this many attempts rather than spin forever.
+  static constexpr uint32_t kMaxReadAttempts = 100000;
+
+  // Instrumentation
+  uint64_t reads = 0;
+  uint64_t tornReads = 0;  // Attempts rejected because a write overlapped
+
+  // Maps the region read-only; false if no timer is publishing under name
+  // or it uses a different layout version.
+  bool Open(const std::string& name = kSharedTimerStateName);
+
+  bool IsOpen() const { return region != nullptr; }
+  void Close();
+
+  // Copies the latest record into *state. False if the region is not open
+  // or no consistent copy could be read.
+  bool Read(SharedTimerState* state);
+
+  // Changes whenever a record is published: poll this and Read() only when
+  // it moves.
+  uint32_t Version() const { return region ? region->record.Version() : 0; }
+
+ private:
+  SharedMemoryMapping mapping;
+  const SharedTimerRegion* region = nullptr;
+};
+
+#endif  // SHAREDTIMERSTATE_H
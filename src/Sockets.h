@@ -0,0 +1,102 @@
+// Sockets.h - Thin portability layer over Winsock and POSIX sockets
+//
+// Include only from translation units that do not include <windows.h>
+// first: <winsock2.h> must come before it.
+
+#ifndef SOCKETS_H
+#define SOCKETS_H
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+#include <cstddef>
+
+#ifdef _WIN32
+
+using SocketHandle = SOCKET;
+using PollDescriptor = WSAPOLLFD;
+constexpr SocketHandle kInvalidSocket = INVALID_SOCKET;
+constexpr int kSendFlags = 0;
+
+// Winsock is reference counted: pair every successful call with
+// ShutdownSockets().
+inline bool InitializeSockets() {
+  WSADATA data;
+  return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+}
+inline void ShutdownSockets() { WSACleanup(); }
+
+inline void CloseSocket(SocketHandle socket) { closesocket(socket); }
+
+inline bool SetNonBlocking(SocketHandle socket) {
+  u_long enabled = 1;
+  return ioctlsocket(socket, FIONBIO, &enabled) == 0;
+}
+
+inline int PollSockets(PollDescriptor* descriptors, size_t count,
+                       int timeoutMs) {
+  return WSAPoll(descriptors, static_cast<ULONG>(count), timeoutMs);
+}
+
+// The last call failed only because it would have blocked.
+inline bool LastSocketCallWouldBlock() {
+  const int error = WSAGetLastError();
+  return error == WSAEWOULDBLOCK || error == WSAEINTR;
+}
+
+#else
+
+using SocketHandle = int;
+using PollDescriptor = pollfd;
+constexpr SocketHandle kInvalidSocket = -1;
+#ifdef MSG_NOSIGNAL
+// A send to a closed peer fails instead of raising SIGPIPE
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+inline bool InitializeSockets() { return true; }
+inline void ShutdownSockets() {}
+
+inline void CloseSocket(SocketHandle socket) { close(socket); }
+
+inline bool SetNonBlocking(SocketHandle socket) {
+  const int flags = fcntl(socket, F_GETFL, 0);
+  return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+inline int PollSockets(PollDescriptor* descriptors, size_t count,
+                       int timeoutMs) {
+  return poll(descriptors, static_cast<nfds_t>(count), timeoutMs);
+}
+
+inline bool LastSocketCallWouldBlock() {
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+#endif
+
+// Disables Nagle's algorithm: small pushes go out immediately.
+inline void SetNoDelay(SocketHandle socket) {
+  int enabled = 1;
+  setsockopt(socket, IPPROTO_TCP, TCP_NODELAY,
+             reinterpret_cast<const char*>(&enabled), sizeof(enabled));
+}
+
+#endif  // SOCKETS_H
@@ -0,0 +1,53 @@
+// SpscQueue.h - Bounded lock-free single-producer/single-consumer queue
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Fixed-capacity ring buffer for exactly one producer thread and one consumer
+// thread. Neither side ever blocks or takes a lock: TryPush() fails when the
+// ring is full and TryPop() fails when it is empty. The head and tail indices
+// live on separate cache lines so the two threads do not false-share.
+template <typename T, size_t Capacity>
+struct SpscQueue {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "Capacity must be a power of two");
+
+  // Producer only.
+  bool TryPush(T&& value) {
+    const size_t back = tail.load(std::memory_order_relaxed);
+    if (back - head.load(std::memory_order_acquire) == Capacity) {
+      return false;
+    }
+    slots[back & (Capacity - 1)] = std::move(value);
+    tail.store(back + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only.
+  bool TryPop(T* value) {
+    const size_t front = head.load(std::memory_order_relaxed);
+    if (front == tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    *value = std::move(slots[front & (Capacity - 1)]);
+    head.store(front + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Either side; only a hint while the other side is active.
+  bool Empty() const {
+    return head.load(std::memory_order_acquire) ==
+           tail.load(std::memory_order_acquire);
+  }
+
+ private:
+  alignas(64) std::atomic<size_t> head{0};  // Next slot to pop
+  alignas(64) std::atomic<size_t> tail{0};  // Next slot to push
+  T slots[Capacity];
+};
+
+#endif  // SPSCQUEUE_H
@@ -0,0 +1,381 @@
+// StateLoadGenerator.cpp - wolftimer-loadgen: fan-out cost of the state server
+//
+//   wolftimer-loadgen [--clients N] [--rounds R] [--seconds S] [--port PORT]
+//
+// Opens N WebSocket subscribers to the state endpoint (StateServer.h), then
+// alternately pauses and resumes the timer R times over HTTP and times each
+// subscriber from sending the command to receiving the delta that reports
+// the new state.
+//
+// Without --port it hosts its own StateServer over a TimingThread on a free
+// loopback port, so it runs on any platform the core builds on, and also
+// reports the server thread's wakeups and busy time for S seconds with the
+// subscribers idle (timer paused) and S seconds with per-second updates
+// (timer running). With --port it measures a running timer instead, which
+// really gets paused and resumed.
+
+#include "Sockets.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SessionCheckpoint.h"
+#include "StateServer.h"
+#include "TimingThread.h"
+
+namespace {
+
+constexpr const char* kHandshakeKey = "dGhlIHNhbXBsZSBub25jZQ==";
+constexpr const char* kHandshakeAccept = "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=";
+constexpr int64_t kRoundTimeoutUs = 5000000;
+
+int64_t NowMicroseconds() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct Options {
+  int clients = 200;
+  int rounds = 50;
+  int seconds = 5;
+  int port = 0;  // 0: host a server in-process
+};
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; i++) {
+    int* target = nullptr;
+    if (std::strcmp(argv[i], "--clients") == 0) {
+      target = &options->clients;
+    } else if (std::strcmp(argv[i], "--rounds") == 0) {
+      target = &options->rounds;
+    } else if (std::strcmp(argv[i], "--seconds") == 0) {
+      target = &options->seconds;
+    } else if (std::strcmp(argv[i], "--port") == 0) {
+      target = &options->port;
+    }
+    if (!target || i + 1 >= argc) return false;
+    *target = std::atoi(argv[++i]);
+  }
+  return options->clients > 0 && options->rounds >= 0 &&
+         options->seconds >= 0 && options->port >= 0 && options->port < 65536;
+}
+
+SocketHandle ConnectLoopback(int port) {
+  const SocketHandle connection = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (connection == kInvalidSocket) return kInvalidSocket;
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(static_cast<uint16_t>(port));
+  if (connect(connection, reinterpret_cast<sockaddr*>(&address),
+              sizeof(address)) != 0) {
+    CloseSocket(connection);
+    return kInvalidSocket;
+  }
+  SetNoDelay(connection);
+  return connection;
+}
+
+bool SendAll(SocketHandle connection, const std::string& data) {
+  size_t offset = 0;
+  while (offset < data.size()) {
+    const int sent = send(connection, data.data() + offset,
+                          static_cast<int>(data.size() - offset), kSendFlags);
+    if (sent <= 0) return false;
+    offset += static_cast<size_t>(sent);
+  }
+  return true;
+}
+
+// A WebSocket subscriber, reading the server's unmasked text frames.
+struct Subscriber {
+  SocketHandle socket = kInvalidSocket;
+  std::string in;
+  int64_t receivedAtUs = -1;  // This round's matching delta
+
+  // Blocking handshake; frames that arrive with it stay in `in`.
+  bool Connect(int port) {
+    socket = ConnectLoopback(port);
+    if (socket == kInvalidSocket) return false;
+    const std::string request =
+        "GET /ws HTTP/1.1\r\nHost: 127.0.0.1:" + std::to_string(port) +
+        "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Key: " + kHandshakeKey +
+        "\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    if (!SendAll(socket, request)) return false;
+
+    char chunk[1024];
+    size_t headEnd;
+    while ((headEnd = in.find("\r\n\r\n")) == std::string::npos) {
+      const int received = recv(socket, chunk, sizeof(chunk), 0);
+      if (received <= 0) return false;
+      in.append(chunk, static_cast<size_t>(received));
+    }
+    const bool upgraded = in.compare(0, 12, "HTTP/1.1 101") == 0 &&
+                          in.find(kHandshakeAccept) < headEnd;
+    in.erase(0, headEnd + 4);
+    return upgraded && SetNonBlocking(socket);
+  }
+
+  // Reads what is available; true if a message containing needle arrived.
+  bool Receive(const char* needle) {
+    char chunk[4096];
+    bool matched = false;
+    for (;;) {
+      const int received = recv(socket, chunk, sizeof(chunk), 0);
+      if (received <= 0) break;
+      in.append(chunk, static_cast<size_t>(received));
+    }
+    for (;;) {
+      if (in.size() < 2) break;
+      size_t header = 2;
+      uint64_t length = static_cast<uint8_t>(in[1]) & 0x7F;
+      if (length >= 126) {
+        const size_t bytes = length == 126 ? 2 : 8;
+        if (in.size() < header + bytes) break;
+        length = 0;
+        for (size_t b = 0; b < bytes; b++) {
+          length = length << 8 | static_cast<uint8_t>(in[header + b]);
+        }
+        header += bytes;
+      }
+      if (in.size() < header + length) break;
+      if (needle && in.find(needle, header) < header + length) {
+        matched = true;
+      }
+      in.erase(0, header + static_cast<size_t>(length));
+    }
+    return matched;
+  }
+};
+
+// Sends a command without waiting for the answer, so subscribers can be
+// timed while the server handles it.
+SocketHandle PostCommand(int port, const char* command) {
+  const SocketHandle connection = ConnectLoopback(port);
+  if (connection == kInvalidSocket) return kInvalidSocket;
+  const std::string request = std::string("POST /") + command +
+                              " HTTP/1.1\r\nHost: 127.0.0.1:" +
+                              std::to_string(port) +
+                              "\r\nContent-Length: 0\r\n\r\n";
+  if (!SendAll(connection, request)) {
+    CloseSocket(connection);
+    return kInvalidSocket;
+  }
+  return connection;
+}
+
+// Reads and drops incoming frames on every subscriber for durationUs.
+void DrainSubscribers(std::vector<Subscriber>& subscribers,
+                      int64_t durationUs) {
+  std::vector<PollDescriptor> descriptors;
+  const int64_t end = NowMicroseconds() + durationUs;
+  for (int64_t now = NowMicroseconds(); now < end; now = NowMicroseconds()) {
+    descriptors.clear();
+    for (const Subscriber& subscriber : subscribers) {
+      descriptors.push_back({subscriber.socket, POLLIN, 0});
+    }
+    PollSockets(descriptors.data(), descriptors.size(),
+                static_cast<int>((end - now + 999) / 1000));
+    for (size_t i = 0; i < subscribers.size(); i++) {
+      if (descriptors[i].revents) subscribers[i].Receive(nullptr);
+    }
+  }
+}
+
+int64_t Percentile(const std::vector<int64_t>& sorted, double fraction) {
+  if (sorted.empty()) return 0;
+  size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+void PrintLatencies(const char* label, std::vector<int64_t>* latencies) {
+  std::sort(latencies->begin(), latencies->end());
+  std::printf("%s (%zu): p50 %" PRId64 " us  p90 %" PRId64 " us  p99 %" PRId64
+              " us  max %" PRId64 " us\n",
+              label, latencies->size(), Percentile(*latencies, 0.5),
+              Percentile(*latencies, 0.9), Percentile(*latencies, 0.99),
+              latencies->empty() ? 0 : latencies->back());
+}
+
+// Hosts the endpoint over a real timing thread, as the timer window does.
+struct LocalTimer {
+  TimingThread timing;
+  StateServer server;
+
+  bool Start() {
+    TimerConfig config = {};
+    config.timePerBlock = 60;
+    config.numBlocks = 4;
+    config.numQuestions = 10;
+    config.transparency = 100;
+    timing.Command([&](TimerState& state) { state.Initialize(config); });
+    timing.SetViewport(true, 0, 0);  // Labels only: one wake per second
+
+    const auto handler = [this](StateCommand command) {
+      timing.Command([command](TimerState& state) {
+        switch (command) {
+          case StateCommand::Start:
+            state.Start();
+            break;
+          case StateCommand::Stop:
+            state.Stop();
+            break;
+          case StateCommand::Pause:
+          case StateCommand::Resume:
+            if (!state.stopped) {
+              state.SetPaused(command == StateCommand::Pause);
+            }
+            break;
+          case StateCommand::NextBlock:
+            state.SkipToNextBlock();
+            break;
+          case StateCommand::kCount:
+            break;
+        }
+      });
+      return true;
+    };
+    if (!server.Start(0, handler)) return false;
+    timing.SetPublishHook([this](const TimerSnapshot& snapshot) {
+      server.Publish(ToSharedTimerState(snapshot, GetWallClockMilliseconds()));
+    });
+    timing.Start(nullptr);
+    return true;
+  }
+
+  void Stop() {
+    timing.Stop();
+    timing.SetPublishHook(nullptr);
+    server.Stop();
+  }
+};
+
+// Server wakeups and busy time over one phase.
+void MeasureServerPhase(const char* label, LocalTimer* local,
+                        std::vector<Subscriber>& subscribers, int seconds) {
+  const uint64_t wakeups = local->server.loopWakeups.load();
+  const uint64_t busyNs = local->server.busyNs.load();
+  const uint64_t broadcasts = local->server.broadcasts.load();
+  DrainSubscribers(subscribers, static_cast<int64_t>(seconds) * 1000000);
+  const uint64_t phaseBroadcasts = local->server.broadcasts.load() - broadcasts;
+  const uint64_t phaseBusyUs = (local->server.busyNs.load() - busyNs) / 1000;
+  std::printf("%s, %d s: %" PRIu64 " wakeups, %" PRIu64 " broadcasts, %" PRIu64
+              " us busy (%.3f%% of a core)",
+              label, seconds, local->server.loopWakeups.load() - wakeups,
+              phaseBroadcasts, phaseBusyUs,
+              seconds > 0 ? phaseBusyUs / (seconds * 10000.0) : 0.0);
+  if (phaseBroadcasts > 0) {
+    std::printf(", %" PRIu64 " us per broadcast", phaseBusyUs / phaseBroadcasts);
+  }
+  std::printf("\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    std::fprintf(stderr,
+                 "usage: wolftimer-loadgen [--clients N] [--rounds R] "
+                 "[--seconds S] [--port PORT]\n");
+    return 2;
+  }
+  if (!InitializeSockets()) return 1;
+
+  LocalTimer local;
+  int port = options.port;
+  if (port == 0) {
+    if (!local.Start()) {
+      std::fprintf(stderr, "Could not start a local state server\n");
+      return 1;
+    }
+    port = local.server.Port();
+  }
+
+  std::vector<Subscriber> subscribers(static_cast<size_t>(options.clients));
+  for (size_t i = 0; i < subscribers.size(); i++) {
+    if (!subscribers[i].Connect(port)) {
+      std::fprintf(stderr, "Subscriber %zu could not connect to port %d\n", i,
+                   port);
+      return 1;
+    }
+  }
+  std::printf("%d subscribers on 127.0.0.1:%d\n", options.clients, port);
+  std::fflush(stdout);
+
+  if (options.port == 0) {
+    CloseSocket(PostCommand(port, "pause"));
+    DrainSubscribers(subscribers, 200000);
+    MeasureServerPhase("idle (paused)", &local, subscribers, options.seconds);
+    CloseSocket(PostCommand(port, "resume"));
+    DrainSubscribers(subscribers, 200000);
+    MeasureServerPhase("running", &local, subscribers, options.seconds);
+  }
+
+  // Fan-out rounds: pause, resume, pause, ... ending where we started
+  std::vector<int64_t> deliveries;
+  std::vector<int64_t> lastPerRound;
+  std::vector<PollDescriptor> descriptors;
+  int incomplete = 0;
+  for (int round = 0; round < options.rounds; round++) {
+    const bool pause = round % 2 == 0;
+    const char* needle = pause ? "\"state\":\"paused\"" : "\"state\":\"running\"";
+    for (Subscriber& subscriber : subscribers) subscriber.receivedAtUs = -1;
+
+    const int64_t sentAt = NowMicroseconds();
+    const SocketHandle command = PostCommand(port, pause ? "pause" : "resume");
+    if (command == kInvalidSocket) {
+      std::fprintf(stderr, "Could not send a command\n");
+      return 1;
+    }
+
+    size_t pending = subscribers.size();
+    int64_t last = 0;
+    while (pending > 0 && NowMicroseconds() - sentAt < kRoundTimeoutUs) {
+      descriptors.clear();
+      for (const Subscriber& subscriber : subscribers) {
+        descriptors.push_back({subscriber.socket, POLLIN, 0});
+      }
+      PollSockets(descriptors.data(), descriptors.size(), 100);
+      for (size_t i = 0; i < subscribers.size(); i++) {
+        Subscriber& subscriber = subscribers[i];
+        if (!descriptors[i].revents || !subscriber.Receive(needle) ||
+            subscriber.receivedAtUs >= 0) {
+          continue;
+        }
+        subscriber.receivedAtUs = NowMicroseconds();
+        const int64_t latency = subscriber.receivedAtUs - sentAt;
+        deliveries.push_back(latency);
+        last = std::max(last, latency);
+        pending--;
+      }
+    }
+    CloseSocket(command);
+    if (pending > 0) incomplete++;
+    lastPerRound.push_back(last);
+    DrainSubscribers(subscribers, 20000);
+  }
+
+  if (options.rounds > 0) {
+    PrintLatencies("command to each subscriber", &deliveries);
+    PrintLatencies("command to last subscriber", &lastPerRound);
+    if (incomplete > 0) {
+      std::printf("%d rounds timed out before every subscriber heard\n",
+                  incomplete);
+    }
+  }
+
+  for (Subscriber& subscriber : subscribers) CloseSocket(subscriber.socket);
+  if (options.port == 0) local.Stop();
+  ShutdownSockets();
+  return incomplete > 0 ? 1 : 0;
+}
@@ -0,0 +1,164 @@
+// StateMonitor.cpp - wolftimer-state: prints the live state of a running timer
+//
+//   wolftimer-state [--watch] [--json] [--name NAME]
+//
+// Reads the shared-memory record the timer publishes (SharedTimerState.h).
+// By default prints the state once and exits (1 if no timer is running);
+// --watch keeps printing a line whenever the displayed second or the
+// position changes, and waits for a timer to start if none is running.
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "SharedTimerState.h"
+#include "TimeFormat.h"
+
+namespace {
+
+constexpr auto kPollInterval = std::chrono::milliseconds(50);
+constexpr auto kReopenInterval = std::chrono::milliseconds(500);
+
+void PrintText(const SharedTimerState& state, int64_t nowMs) {
+  char position[72];
+  if (state.flags & kSharedTimerInBreak) {
+    FormatCountLabel("Break ", state.block - 1, state.blockCount, position,
+                     sizeof(position));
+  } else {
+    char block[32];
+    char question[32];
+    FormatCountLabel("Block ", state.block, state.blockCount, block,
+                     sizeof(block));
+    FormatCountLabel("Q ", state.question, state.questionsInBlock, question,
+                     sizeof(question));
+    std::snprintf(position, sizeof(position), "%s  %s", block, question);
+  }
+
+  char questionElapsed[timeformat::kMaxChars];
+  char questionLength[timeformat::kMaxChars];
+  char blockLeft[timeformat::kMaxChars];
+  char totalLeft[timeformat::kMaxChars];
+  FormatMinutesSeconds(state.QuestionElapsedMillisecondsAt(nowMs) / 1000,
+                       questionElapsed, sizeof(questionElapsed));
+  FormatMinutesSeconds(state.questionSeconds, questionLength,
+                       sizeof(questionLength));
+  // Ceiling, like the timer bar's countdown
+  const int64_t blockLeftMs =
+      static_cast<int64_t>(state.blockSeconds) * 1000 -
+      state.BlockElapsedMillisecondsAt(nowMs);
+  FormatMinutesSeconds((blockLeftMs + 999) / 1000, blockLeft,
+                       sizeof(blockLeft));
+  const int64_t totalLeftMs = state.RemainingMillisecondsAt(nowMs);
+  FormatHoursMinutesSeconds((totalLeftMs + 999) / 1000, totalLeft,
+                            sizeof(totalLeft));
+
+  std::printf("%s  %s/%s  block %s left  total %s left  %s\n", position,
+              questionElapsed, questionLength, blockLeft, totalLeft,
+              DescribeSharedTimerState(state));
+}
+
+void PrintJson(const SharedTimerState& state, int64_t nowMs) {
+  std::printf(
+      "{\"generation\":%" PRIu64 ",\"state\":\"%s\",\"inBreak\":%s,"
+      "\"block\":%d,\"blockCount\":%d,\"question\":%d,"
+      "\"questionsInBlock\":%d,\"questionElapsedMs\":%" PRId64
+      ",\"questionMs\":%" PRId64 ",\"blockElapsedMs\":%" PRId64
+      ",\"blockMs\":%" PRId64 ",\"elapsedMs\":%" PRId64
+      ",\"remainingMs\":%" PRId64 ",\"totalMs\":%" PRId64
+      ",\"capturedAtWallMs\":%" PRId64 "}\n",
+      state.generation, DescribeSharedTimerState(state),
+      (state.flags & kSharedTimerInBreak) ? "true" : "false", state.block,
+      state.blockCount, state.question, state.questionsInBlock,
+      state.QuestionElapsedMillisecondsAt(nowMs),
+      static_cast<int64_t>(state.questionSeconds) * 1000,
+      state.BlockElapsedMillisecondsAt(nowMs),
+      static_cast<int64_t>(state.blockSeconds) * 1000,
+      state.ElapsedMillisecondsAt(nowMs), state.RemainingMillisecondsAt(nowMs),
+      state.totalMs, state.wallMs);
+}
+
+struct Options {
+  bool watch = false;
+  bool json = false;
+  std::string name = kSharedTimerStateName;
+};
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--watch") == 0) {
+      options->watch = true;
+    } else if (std::strcmp(argv[i], "--json") == 0) {
+      options->json = true;
+    } else if (std::strcmp(argv[i], "--name") == 0 && i + 1 < argc) {
+      options->name = argv[++i];
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    std::fprintf(stderr,
+                 "usage: wolftimer-state [--watch] [--json] [--name NAME]\n");
+    return 2;
+  }
+
+  SharedTimerStateReader reader;
+  SharedTimerState state = {};
+  uint32_t lastVersion = 0;
+  int64_t lastSecond = -1;
+  for (;;) {
+    if (!reader.IsOpen() && !reader.Open(options.name)) {
+      if (!options.watch) {
+        std::fprintf(stderr, "No timer is publishing under %s\n",
+                     options.name.c_str());
+        return 1;
+      }
+      std::this_thread::sleep_for(kReopenInterval);
+      continue;
+    }
+
+    // Only copy the record when something was published; in between, the
+    // clock alone moves the countdown.
+    const uint32_t version = reader.Version();
+    if ((version != lastVersion || state.generation == 0) &&
+        !reader.Read(&state)) {
+      std::fprintf(stderr, "The timer's record is unreadable\n");
+      reader.Close();
+      if (!options.watch) return 1;
+      std::this_thread::sleep_for(kReopenInterval);
+      continue;
+    }
+    const int64_t nowMs = GetSharedClockMilliseconds();
+    const int64_t second = state.ElapsedMillisecondsAt(nowMs) / 1000;
+
+    if (state.generation != 0 &&
+        (version != lastVersion || second != lastSecond)) {
+      if (options.json) {
+        PrintJson(state, nowMs);
+      } else {
+        PrintText(state, nowMs);
+      }
+      std::fflush(stdout);
+      lastVersion = version;
+      lastSecond = second;
+    }
+
+    if (!options.watch && state.generation != 0) return 0;
+    if (state.flags & kSharedTimerClosed) {
+      // That timer is gone; wait for the next one under the same name
+      reader.Close();
+      state = SharedTimerState();
+      lastVersion = 0;
+    }
+    std::this_thread::sleep_for(kPollInterval);
+  }
+}
@@ -0,0 +1,790 @@
+// StateServer.cpp - HTTP and WebSocket handling on a poll() event loop
+
+#include "StateServer.h"
+
+#include "Sockets.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "Sha1.h"
+
+namespace {
+
+constexpr int64_t kLingerMs = 1000;  // Wait for a closing peer's FIN this long
+constexpr size_t kReadChunk = 4096;
+constexpr const char* kWebSocketGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+enum WebSocketOpcode : uint8_t {
+  kOpText = 0x1,
+  kOpClose = 0x8,
+  kOpPing = 0x9,
+  kOpPong = 0xA,
+};
+
+int64_t NowMilliseconds() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+int64_t NowNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// JSON fields of a state message. Every value is carried as an integer and
+// compared as one for deltas.
+enum class JsonKind { Integer, Boolean, StateName };
+
+struct JsonField {
+  const char* name;
+  JsonKind kind;
+  int64_t (*value)(const SharedTimerState&);
+};
+
+constexpr uint32_t kStateNameFlags = kSharedTimerPaused | kSharedTimerStopped |
+                                     kSharedTimerCompleted | kSharedTimerClosed;
+
+const JsonField kStateFields[] = {
+    {"generation", JsonKind::Integer,
+     [](const SharedTimerState& s) {
+       return static_cast<int64_t>(s.generation);
+     }},
+    {"state", JsonKind::StateName,
+     [](const SharedTimerState& s) {
+       return static_cast<int64_t>(s.flags & kStateNameFlags);
+     }},
+    {"inBreak", JsonKind::Boolean,
+     [](const SharedTimerState& s) {
+       return static_cast<int64_t>((s.flags & kSharedTimerInBreak) != 0);
+     }},
+    {"block", JsonKind::Integer,
+     [](const SharedTimerState& s) { return static_cast<int64_t>(s.block); }},
+    {"blockCount", JsonKind::Integer,
+     [](const SharedTimerState& s) {
+       return static_cast<int64_t>(s.blockCount);
+     }},
+    {"question", JsonKind::Integer,
+     [](const SharedTimerState& s) {
+       return static_cast<int64_t>(s.question);
+     }},
+    {"questionsInBlock", JsonKind::Integer,
+     [](const SharedTimerState& s) {
+       return static_cast<int64_t>(s.questionsInBlock);
+     }},
+    {"questionMs", JsonKind::Integer,
+     [](const SharedTimerState& s) {
+       return static_cast<int64_t>(s.questionSeconds) * 1000;
+     }},
+    {"blockMs", JsonKind::Integer,
+     [](const SharedTimerState& s) {
+       return static_cast<int64_t>(s.blockSeconds) * 1000;
+     }},
+    {"questionElapsedMs", JsonKind::Integer,
+     [](const SharedTimerState& s) { return s.questionElapsedMs; }},
+    {"blockElapsedMs", JsonKind::Integer,
+     [](const SharedTimerState& s) { return s.blockElapsedMs; }},
+    {"elapsedMs", JsonKind::Integer,
+     [](const SharedTimerState& s) { return s.elapsedMs; }},
+    {"totalMs", JsonKind::Integer,
+     [](const SharedTimerState& s) { return s.totalMs; }},
+    {"wallMs", JsonKind::Integer,
+     [](const SharedTimerState& s) { return s.wallMs; }},
+};
+
+void AppendInteger(std::string* out, int64_t value) {
+  char digits[24];
+  const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+  out->append(digits, result.ptr);
+}
+
+// Base64 of a SHA-1 digest, for Sec-WebSocket-Accept.
+std::string EncodeBase64(const uint8_t* data, size_t size) {
+  static const char kAlphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  out.reserve((size + 2) / 3 * 4);
+  for (size_t i = 0; i < size; i += 3) {
+    const uint32_t chunk = static_cast<uint32_t>(data[i]) << 16 |
+                           (i + 1 < size ? data[i + 1] << 8 : 0) |
+                           (i + 2 < size ? data[i + 2] : 0);
+    out.push_back(kAlphabet[(chunk >> 18) & 63]);
+    out.push_back(kAlphabet[(chunk >> 12) & 63]);
+    out.push_back(i + 1 < size ? kAlphabet[(chunk >> 6) & 63] : '=');
+    out.push_back(i + 2 < size ? kAlphabet[chunk & 63] : '=');
+  }
+  return out;
+}
+
+void AppendWebSocketFrame(std::string* out, uint8_t opcode, const char* data,
+                          size_t size) {
+  out->push_back(static_cast<char>(0x80 | opcode));  // FIN, unmasked
+  if (size < 126) {
+    out->push_back(static_cast<char>(size));
+  } else if (size <= 0xFFFF) {
+    out->push_back(static_cast<char>(126));
+    out->push_back(static_cast<char>(size >> 8));
+    out->push_back(static_cast<char>(size));
+  } else {
+    out->push_back(static_cast<char>(127));
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      out->push_back(static_cast<char>(static_cast<uint64_t>(size) >> shift));
+    }
+  }
+  out->append(data, size);
+}
+
+bool EqualsIgnoreCase(const std::string& a, const char* b) {
+  const size_t length = std::strlen(b);
+  if (a.size() != length) return false;
+  for (size_t i = 0; i < length; i++) {
+    if (std::tolower(static_cast<unsigned char>(a[i])) !=
+        std::tolower(static_cast<unsigned char>(b[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ContainsIgnoreCase(const std::string& haystack, const char* needle) {
+  const size_t length = std::strlen(needle);
+  for (size_t i = 0; i + length <= haystack.size(); i++) {
+    if (EqualsIgnoreCase(haystack.substr(i, length), needle)) return true;
+  }
+  return false;
+}
+
+// "localhost", "127.0.0.1" or "[::1]", with or without a port.
+bool IsLoopbackHost(const std::string& host) {
+  std::string name = host;
+  if (!name.empty() && name[0] == '[') {
+    name = name.substr(0, name.find(']') + 1);
+  } else {
+    name = name.substr(0, name.find(':'));
+  }
+  return EqualsIgnoreCase(name, "localhost") ||
+         EqualsIgnoreCase(name, "127.0.0.1") || EqualsIgnoreCase(name, "[::1]");
+}
+
+bool IsLoopbackOrigin(const std::string& origin) {
+  for (const char* scheme : {"http://", "https://"}) {
+    const size_t length = std::strlen(scheme);
+    if (origin.size() > length &&
+        EqualsIgnoreCase(origin.substr(0, length), scheme)) {
+      return IsLoopbackHost(origin.substr(length));
+    }
+  }
+  return false;
+}
+
+struct HttpRequest {
+  std::string method;
+  std::string path;
+  std::string host;
+  std::string origin;
+  std::string upgrade;
+  std::string webSocketKey;
+  std::string webSocketVersion;
+};
+
+// Parses the request line and the headers we act on; false if malformed.
+bool ParseHttpRequest(const std::string& head, HttpRequest* request) {
+  size_t lineEnd = head.find("\r\n");
+  const std::string requestLine = head.substr(0, lineEnd);
+  const size_t methodEnd = requestLine.find(' ');
+  const size_t pathEnd = requestLine.find(' ', methodEnd + 1);
+  if (methodEnd == std::string::npos || pathEnd == std::string::npos) {
+    return false;
+  }
+  request->method = requestLine.substr(0, methodEnd);
+  request->path = requestLine.substr(methodEnd + 1, pathEnd - methodEnd - 1);
+  request->path = request->path.substr(0, request->path.find('?'));
+
+  while (lineEnd != std::string::npos && lineEnd + 2 < head.size()) {
+    const size_t start = lineEnd + 2;
+    lineEnd = head.find("\r\n", start);
+    const std::string line = head.substr(start, lineEnd - start);
+    const size_t colon = line.find(':');
+    if (colon == std::string::npos) continue;
+
+    const std::string name = line.substr(0, colon);
+    size_t valueStart = colon + 1;
+    while (valueStart < line.size() && line[valueStart] == ' ') valueStart++;
+    const std::string value = line.substr(valueStart);
+    if (EqualsIgnoreCase(name, "Host")) {
+      request->host = value;
+    } else if (EqualsIgnoreCase(name, "Origin")) {
+      request->origin = value;
+    } else if (EqualsIgnoreCase(name, "Upgrade")) {
+      request->upgrade = value;
+    } else if (EqualsIgnoreCase(name, "Sec-WebSocket-Key")) {
+      request->webSocketKey = value;
+    } else if (EqualsIgnoreCase(name, "Sec-WebSocket-Version")) {
+      request->webSocketVersion = value;
+    }
+  }
+  return true;
+}
+
+bool ParseStateCommand(const std::string& path, StateCommand* command) {
+  for (int i = 0; i < static_cast<int>(StateCommand::kCount); i++) {
+    const StateCommand candidate = static_cast<StateCommand>(i);
+    if (path.size() > 1 && path[0] == '/' &&
+        path.compare(1, std::string::npos,
+                     GetStateCommandName(candidate)) == 0) {
+      *command = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+enum class ConnectionKind { Http, WebSocket, Lingering };
+
+struct Connection {
+  SocketHandle socket = kInvalidSocket;
+  ConnectionKind kind = ConnectionKind::Http;
+  std::string in;
+  std::string out;
+  size_t outOffset = 0;          // Bytes of out already sent
+  bool closeAfterFlush = false;  // Response queued; close once it is sent
+  bool closed = false;           // Remove at the end of this loop iteration
+  bool subscribed = false;       // Counted in StateServer::subscribers
+  int64_t deadlineMs = 0;        // Http and Lingering only
+
+  size_t Backlog() const { return out.size() - outOffset; }
+};
+
+}  // namespace
+
+// Sockets and connections of a running server. The listener and waker are
+// set up by Start(); everything else belongs to the I/O thread.
+struct StateServerLoop {
+  SocketHandle listener = kInvalidSocket;
+  SocketHandle waker = kInvalidSocket;  // UDP socket Publish() pokes
+  sockaddr_in wakerAddress = {};
+  std::vector<Connection> connections;
+  std::vector<PollDescriptor> descriptors;
+  SharedTimerState broadcast = {};  // Last state pushed to subscribers
+  std::string message;              // Scratch frame for broadcasts
+
+  ~StateServerLoop() {
+    for (Connection& connection : connections) CloseSocket(connection.socket);
+    if (listener != kInvalidSocket) CloseSocket(listener);
+    if (waker != kInvalidSocket) CloseSocket(waker);
+  }
+
+  // Sends as much of the pending output as the socket takes.
+  void Flush(Connection& connection) {
+    while (connection.Backlog() > 0) {
+      const int sent =
+          send(connection.socket, connection.out.data() + connection.outOffset,
+               static_cast<int>(connection.Backlog()), kSendFlags);
+      if (sent > 0) {
+        connection.outOffset += static_cast<size_t>(sent);
+      } else {
+        if (sent < 0 && LastSocketCallWouldBlock()) return;
+        connection.closed = true;
+        return;
+      }
+    }
+    connection.out.clear();
+    connection.outOffset = 0;
+    if (connection.closeAfterFlush) {
+      // Half-close and wait for the peer's FIN, so unread request bytes
+      // cannot turn the close into a reset that eats the response.
+#ifdef _WIN32
+      shutdown(connection.socket, SD_SEND);
+#else
+      shutdown(connection.socket, SHUT_WR);
+#endif
+      connection.closeAfterFlush = false;
+      connection.kind = ConnectionKind::Lingering;
+      connection.deadlineMs = NowMilliseconds() + kLingerMs;
+    }
+  }
+
+  // Queues data and sends it right away when nothing is queued before it.
+  void Send(Connection& connection, const char* data, size_t size) {
+    if (connection.Backlog() == 0) {
+      const int sent = send(connection.socket, data, static_cast<int>(size),
+                            kSendFlags);
+      if (sent < 0 && !LastSocketCallWouldBlock()) {
+        connection.closed = true;
+        return;
+      }
+      const size_t taken = sent > 0 ? static_cast<size_t>(sent) : 0;
+      if (taken == size) return;
+      data += taken;
+      size -= taken;
+    }
+    connection.out.append(data, size);
+  }
+
+  void Respond(Connection& connection, int status, const char* reason,
+               const char* contentType, const std::string& body,
+               const std::string& allowOrigin) {
+    std::string response = "HTTP/1.1 ";
+    AppendInteger(&response, status);
+    response += ' ';
+    response += reason;
+    response += "\r\nContent-Type: ";
+    response += contentType;
+    response += "\r\nContent-Length: ";
+    AppendInteger(&response, static_cast<int64_t>(body.size()));
+    response += "\r\nCache-Control: no-store\r\nConnection: close\r\n";
+    if (!allowOrigin.empty()) {
+      response += "Access-Control-Allow-Origin: " + allowOrigin +
+                  "\r\nVary: Origin\r\n";
+    }
+    if (status == 204) {
+      response +=
+          "Access-Control-Allow-Methods: GET, POST\r\n"
+          "Access-Control-Allow-Headers: Content-Type\r\n";
+    }
+    response += "\r\n";
+    response += body;
+    connection.closeAfterFlush = true;
+    connection.in.clear();
+    Send(connection, response.data(), response.size());
+    Flush(connection);
+  }
+};
+
+const char* GetStateCommandName(StateCommand command) {
+  switch (command) {
+    case StateCommand::Start:
+      return "start";
+    case StateCommand::Stop:
+      return "stop";
+    case StateCommand::Pause:
+      return "pause";
+    case StateCommand::Resume:
+      return "resume";
+    case StateCommand::NextBlock:
+      return "next-block";
+    case StateCommand::kCount:
+      break;
+  }
+  return "";
+}
+
+void AppendStateJson(const SharedTimerState& state,
+                     const SharedTimerState* previous, std::string* out) {
+  *out += previous ? "{\"type\":\"delta\"" : "{\"type\":\"state\"";
+  for (const JsonField& field : kStateFields) {
+    const int64_t value = field.value(state);
+    if (previous && field.value(*previous) == value) continue;
+
+    *out += ",\"";
+    *out += field.name;
+    *out += "\":";
+    switch (field.kind) {
+      case JsonKind::Integer:
+        AppendInteger(out, value);
+        break;
+      case JsonKind::Boolean:
+        *out += value ? "true" : "false";
+        break;
+      case JsonKind::StateName:
+        *out += '"';
+        *out += DescribeSharedTimerState(state);
+        *out += '"';
+        break;
+    }
+  }
+  *out += '}';
+}
+
+StateServer::StateServer() = default;
+
+StateServer::~StateServer() { Stop(); }
+
+bool StateServer::Start(uint16_t listenPort, CommandHandler commandHandler) {
+  if (IsRunning() || !InitializeSockets()) return false;
+
+  auto created = std::make_unique<StateServerLoop>();
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(listenPort);
+
+  created->listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  created->waker = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  bool ok = created->listener != kInvalidSocket &&
+            created->waker != kInvalidSocket;
+  if (ok) {
+    int enabled = 1;
+#ifdef _WIN32
+    // Nobody else may bind the port underneath us
+    setsockopt(created->listener, SOL_SOCKET, SO_EXCLUSIVEADDRUSE,
+               reinterpret_cast<const char*>(&enabled), sizeof(enabled));
+#else
+    // Rebind right after a restart despite TIME_WAIT connections
+    setsockopt(created->listener, SOL_SOCKET, SO_REUSEADDR, &enabled,
+               sizeof(enabled));
+#endif
+    ok = bind(created->listener, reinterpret_cast<sockaddr*>(&address),
+              sizeof(address)) == 0 &&
+         listen(created->listener, SOMAXCONN) == 0 &&
+         SetNonBlocking(created->listener);
+  }
+  sockaddr_in bound = {};
+  socklen_t boundSize = sizeof(bound);
+  ok = ok &&
+       getsockname(created->listener, reinterpret_cast<sockaddr*>(&bound),
+                   &boundSize) == 0;
+
+  sockaddr_in wakerAddress = {};
+  wakerAddress.sin_family = AF_INET;
+  wakerAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t wakerSize = sizeof(wakerAddress);
+  ok = ok &&
+       bind(created->waker, reinterpret_cast<sockaddr*>(&wakerAddress),
+            sizeof(wakerAddress)) == 0 &&
+       getsockname(created->waker, reinterpret_cast<sockaddr*>(&wakerAddress),
+                   &wakerSize) == 0 &&
+       SetNonBlocking(created->waker);
+  if (!ok) {
+    created.reset();
+    ShutdownSockets();
+    return false;
+  }
+
+  created->wakerAddress = wakerAddress;
+  port = ntohs(bound.sin_port);
+  handler = std::move(commandHandler);
+  loop = std::move(created);
+  stopping.store(false);
+  wakePending.store(false);
+  thread = std::thread(&StateServer::Run, this);
+  return true;
+}
+
+void StateServer::Stop() {
+  if (!IsRunning()) return;
+  stopping.store(true);
+  sendto(loop->waker, "s", 1, 0,
+         reinterpret_cast<const sockaddr*>(&loop->wakerAddress),
+         sizeof(loop->wakerAddress));
+  thread.join();
+  loop.reset();
+  subscribers.store(0);
+  ShutdownSockets();
+}
+
+void StateServer::Publish(const SharedTimerState& state) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (latest.generation != 0 && IsSameSharedSecond(state, latest)) return;
+    latest = state;
+    latest.generation = ++publishes;
+  }
+  if (IsRunning() && !wakePending.exchange(true)) Wake();
+}
+
+void StateServer::Wake() {
+  sendto(loop->waker, "w", 1, 0,
+         reinterpret_cast<const sockaddr*>(&loop->wakerAddress),
+         sizeof(loop->wakerAddress));
+}
+
+void StateServer::Run() {
+  StateServerLoop& l = *loop;
+  std::vector<char> chunk(kReadChunk);
+
+  for (;;) {
+    // Rebuild the poll set: listener, waker, then one per connection
+    l.descriptors.clear();
+    l.descriptors.push_back({l.listener, POLLIN, 0});
+    l.descriptors.push_back({l.waker, POLLIN, 0});
+    int64_t nextDeadline = -1;
+    for (const Connection& connection : l.connections) {
+      PollDescriptor descriptor = {connection.socket, POLLIN, 0};
+      if (connection.Backlog() > 0) descriptor.events |= POLLOUT;
+      l.descriptors.push_back(descriptor);
+      if (connection.kind != ConnectionKind::WebSocket &&
+          (nextDeadline < 0 || connection.deadlineMs < nextDeadline)) {
+        nextDeadline = connection.deadlineMs;
+      }
+    }
+    int timeoutMs = -1;  // Nothing pending: sleep until woken
+    if (nextDeadline >= 0) {
+      const int64_t wait = nextDeadline - NowMilliseconds();
+      timeoutMs =
+          wait <= 0 ? 0 : static_cast<int>(std::min<int64_t>(wait, 60000));
+    }
+
+    PollSockets(l.descriptors.data(), l.descriptors.size(), timeoutMs);
+    if (stopping.load()) break;
+    const int64_t busyStart = NowNanoseconds();
+    loopWakeups.fetch_add(1, std::memory_order_relaxed);
+
+    // Publications: clear the flag before reading the state, so a publish
+    // racing with us always leaves another wakeup behind.
+    if (l.descriptors[1].revents & POLLIN) {
+      wakePending.store(false);
+      char drain[64];
+      while (recv(l.waker, drain, static_cast<int>(sizeof(drain)), 0) > 0) {
+      }
+      SharedTimerState next;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        next = latest;
+      }
+      if (next.generation != 0 && next.generation != l.broadcast.generation) {
+        std::string json;
+        AppendStateJson(next,
+                        l.broadcast.generation != 0 ? &l.broadcast : nullptr,
+                        &json);
+        l.message.clear();
+        AppendWebSocketFrame(&l.message, kOpText, json.data(), json.size());
+        for (Connection& connection : l.connections) {
+          if (connection.kind != ConnectionKind::WebSocket ||
+              connection.closed || connection.closeAfterFlush) {
+            continue;
+          }
+          if (connection.Backlog() + l.message.size() > kMaxBacklogBytes) {
+            connection.closed = true;  // Not reading; don't hoard for it
+            droppedSubscribers.fetch_add(1, std::memory_order_relaxed);
+            continue;
+          }
+          l.Send(connection, l.message.data(), l.message.size());
+          messagesSent.fetch_add(1, std::memory_order_relaxed);
+        }
+        l.broadcast = next;
+        broadcasts.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    // Connections known to this poll; accepted ones join the next
+    const size_t polled = l.descriptors.size() - 2;
+    for (size_t i = 0; i < polled; i++) {
+      Connection& connection = l.connections[i];
+      const short revents = l.descriptors[i + 2].revents;
+      if (connection.closed) continue;
+      if ((revents & (POLLERR | POLLNVAL)) ||
+          ((revents & POLLHUP) && !(revents & POLLIN))) {
+        connection.closed = true;
+        continue;
+      }
+      if (revents & POLLOUT) l.Flush(connection);
+
+      if (!(revents & POLLIN) || connection.closed) continue;
+      const int received = recv(connection.socket, chunk.data(),
+                                static_cast<int>(chunk.size()), 0);
+      if (received <= 0) {
+        if (received == 0 || !LastSocketCallWouldBlock()) {
+          connection.closed = true;
+        }
+        continue;
+      }
+      if (connection.kind == ConnectionKind::Lingering ||
+          connection.closeAfterFlush) {
+        continue;  // Discard whatever follows the request
+      }
+      connection.in.append(chunk.data(), static_cast<size_t>(received));
+
+      if (connection.kind == ConnectionKind::Http) {
+        const size_t headEnd = connection.in.find("\r\n\r\n");
+        if (headEnd == std::string::npos) {
+          if (connection.in.size() > kMaxRequestBytes) {
+            l.Respond(connection, 431, "Request Header Fields Too Large",
+                      "text/plain", "Request too large\n", "");
+          }
+          continue;
+        }
+
+        HttpRequest request;
+        if (!ParseHttpRequest(connection.in.substr(0, headEnd + 2),
+                              &request)) {
+          l.Respond(connection, 400, "Bad Request", "text/plain",
+                    "Bad request\n", "");
+          continue;
+        }
+        connection.in.erase(0, headEnd + 4);
+        requests.fetch_add(1, std::memory_order_relaxed);
+
+        const bool loopbackOrigin = IsLoopbackOrigin(request.origin);
+        const std::string allowOrigin = loopbackOrigin ? request.origin : "";
+        if (!IsLoopbackHost(request.host)) {
+          l.Respond(connection, 403, "Forbidden", "text/plain",
+                    "Loopback hosts only\n", "");
+          continue;
+        }
+
+        StateCommand command;
+        if (request.path == "/ws" ||
+            ContainsIgnoreCase(request.upgrade, "websocket")) {
+          if (request.method != "GET" || request.webSocketKey.empty() ||
+              request.webSocketVersion != "13") {
+            l.Respond(connection, 400, "Bad Request", "text/plain",
+                      "Expected a version 13 WebSocket handshake\n", "");
+            continue;
+          }
+          if (!request.origin.empty() && !loopbackOrigin) {
+            // Browsers let any page open a WebSocket; only ours may listen.
+            l.Respond(connection, 403, "Forbidden", "text/plain",
+                      "Subscriptions are only accepted from loopback pages\n",
+                      "");
+            continue;
+          }
+          const std::string keyed = request.webSocketKey + kWebSocketGuid;
+          const Sha1Digest digest = ComputeSha1(keyed.data(), keyed.size());
+          std::string response =
+              "HTTP/1.1 101 Switching Protocols\r\n"
+              "Upgrade: websocket\r\n"
+              "Connection: Upgrade\r\n"
+              "Sec-WebSocket-Accept: " +
+              EncodeBase64(digest.bytes, sizeof(digest.bytes)) + "\r\n\r\n";
+          if (l.broadcast.generation != 0) {
+            std::string json;
+            AppendStateJson(l.broadcast, nullptr, &json);
+            AppendWebSocketFrame(&response, kOpText, json.data(), json.size());
+          }
+          connection.kind = ConnectionKind::WebSocket;
+          connection.subscribed = true;
+          subscribers.fetch_add(1, std::memory_order_relaxed);
+          l.Send(connection, response.data(), response.size());
+        } else if (request.path == "/state") {
+          if (request.method != "GET") {
+            l.Respond(connection, 405, "Method Not Allowed", "text/plain",
+                      "Use GET\n", allowOrigin);
+            continue;
+          }
+          SharedTimerState current;
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            current = latest;
+          }
+          std::string json;
+          AppendStateJson(current, nullptr, &json);
+          json += '\n';
+          l.Respond(connection, 200, "OK", "application/json", json,
+                    allowOrigin);
+        } else if (ParseStateCommand(request.path, &command)) {
+          if (request.method == "OPTIONS") {
+            l.Respond(connection, loopbackOrigin ? 204 : 403,
+                      loopbackOrigin ? "No Content" : "Forbidden",
+                      "text/plain", "", loopbackOrigin ? request.origin : "");
+          } else if (request.method != "POST") {
+            l.Respond(connection, 405, "Method Not Allowed", "text/plain",
+                      "Use POST\n", allowOrigin);
+          } else if (!request.origin.empty() && !loopbackOrigin) {
+            // Includes "null": sandboxed frames of any site send that
+            l.Respond(connection, 403, "Forbidden", "text/plain",
+                      "Commands are only accepted from loopback pages\n", "");
+          } else {
+            commands.fetch_add(1, std::memory_order_relaxed);
+            const bool accepted = handler && handler(command);
+            std::string body = "{\"";
+            body += accepted ? "accepted" : "error";
+            body += "\":\"";
+            body += accepted ? GetStateCommandName(command) : "unavailable";
+            body += "\"}\n";
+            l.Respond(connection, accepted ? 202 : 503,
+                      accepted ? "Accepted" : "Service Unavailable",
+                      "application/json", body, allowOrigin);
+          }
+        } else {
+          l.Respond(connection, 404, "Not Found", "text/plain",
+                    "Not found\n", allowOrigin);
+        }
+        if (connection.kind != ConnectionKind::WebSocket) continue;
+      }
+
+      // WebSocket frames from the client: answer pings and close requests,
+      // ignore everything else.
+      while (!connection.closed && !connection.closeAfterFlush) {
+        const std::string& in = connection.in;
+        if (in.size() < 2) break;
+        const uint8_t opcode = static_cast<uint8_t>(in[0]) & 0x0F;
+        const bool masked = (static_cast<uint8_t>(in[1]) & 0x80) != 0;
+        uint64_t length = static_cast<uint8_t>(in[1]) & 0x7F;
+        size_t header = 2;
+        if (length == 126 || length == 127) {
+          const size_t bytes = length == 126 ? 2 : 8;
+          if (in.size() < header + bytes) break;
+          length = 0;
+          for (size_t b = 0; b < bytes; b++) {
+            length = length << 8 | static_cast<uint8_t>(in[header + b]);
+          }
+          header += bytes;
+        }
+        if (!masked || length > kMaxRequestBytes) {
+          connection.closed = true;  // Protocol violation or oversized
+          break;
+        }
+        if (in.size() < header + 4 + length) break;
+
+        std::string payload = in.substr(header + 4, length);
+        for (size_t b = 0; b < payload.size(); b++) {
+          payload[b] ^= in[header + (b & 3)];
+        }
+        connection.in.erase(0, header + 4 + length);
+        if (opcode == kOpClose) {
+          std::string reply;
+          AppendWebSocketFrame(&reply, kOpClose, payload.data(),
+                               std::min<size_t>(payload.size(), 2));
+          connection.closeAfterFlush = true;
+          l.Send(connection, reply.data(), reply.size());
+          l.Flush(connection);
+        } else if (opcode == kOpPing) {
+          std::string reply;
+          AppendWebSocketFrame(&reply, kOpPong, payload.data(),
+                               payload.size());
+          l.Send(connection, reply.data(), reply.size());
+        }
+      }
+    }
+
+    // New connections
+    if (l.descriptors[0].revents & POLLIN) {
+      for (;;) {
+        const SocketHandle accepted = accept(l.listener, nullptr, nullptr);
+        if (accepted == kInvalidSocket) break;
+        if (l.connections.size() >= kMaxConnections ||
+            !SetNonBlocking(accepted)) {
+          CloseSocket(accepted);
+          continue;
+        }
+        SetNoDelay(accepted);
+        Connection connection;
+        connection.socket = accepted;
+        connection.deadlineMs = NowMilliseconds() + kRequestTimeoutMs;
+        l.connections.push_back(std::move(connection));
+      }
+    }
+
+    // Expire idle requests and lingering closes, then drop closed ones
+    const int64_t now = NowMilliseconds();
+    for (size_t i = 0; i < l.connections.size();) {
+      Connection& connection = l.connections[i];
+      if (connection.kind != ConnectionKind::WebSocket &&
+          connection.deadlineMs <= now) {
+        connection.closed = true;
+      }
+      if (!connection.closed) {
+        i++;
+        continue;
+      }
+      if (connection.subscribed) {
+        subscribers.fetch_sub(1, std::memory_order_relaxed);
+      }
+      CloseSocket(connection.socket);
+      if (i + 1 < l.connections.size()) {
+        connection = std::move(l.connections.back());
+      }
+      l.connections.pop_back();
+    }
+
+    busyNs.fetch_add(static_cast<uint64_t>(NowNanoseconds() - busyStart),
+                     std::memory_order_relaxed);
+  }
+}
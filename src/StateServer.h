@@ -0,0 +1,112 @@
+// StateServer.h - Loopback HTTP/WebSocket endpoint for the live timer state
+
+#ifndef STATESERVER_H
+#define STATESERVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "SharedTimerState.h"
+
+// Remote controls, named in URLs as "start", "stop", "pause", "resume" and
+// "next-block".
+enum class StateCommand : uint8_t {
+  Start,
+  Stop,
+  Pause,
+  Resume,
+  NextBlock,
+  kCount
+};
+
+const char* GetStateCommandName(StateCommand command);
+
+// Appends state to out as a JSON object. Without previous, every field is
+// written ("type":"state"); with it, only the fields that differ from it
+// ("type":"delta"), which always include generation and wallMs.
+void AppendStateJson(const SharedTimerState& state,
+                     const SharedTimerState* previous, std::string* out);
+
+struct StateServerLoop;
+
+// Serves the live timer state to browser dashboards on 127.0.0.1:
+//
+//   GET  /state    the current state as JSON
+//   POST /start, /stop, /pause, /resume, /next-block
+//   GET  /ws       WebSocket: the full state on connect, then one delta
+//                  message each time it changes
+//
+// One I/O thread runs a poll() event loop over every connection. Publish()
+// wakes it through a loopback datagram; the delta is encoded once and fanned
+// out to all subscribers. While nothing is published the thread sleeps in
+// poll() however many subscribers are connected, and a subscriber too slow
+// to keep up is disconnected rather than buffered without bound.
+//
+// Loopback only: the listener is bound to 127.0.0.1, requests must name a
+// loopback Host (which defeats DNS rebinding), and commands and WebSocket
+// subscriptions are refused from pages of non-loopback origins, so a web page
+// can neither drive nor watch the timer.
+struct StateServer {
+  static constexpr uint16_t kDefaultPort = 47821;
+  static constexpr size_t kMaxConnections = 1024;
+  static constexpr size_t kMaxRequestBytes = 8192;
+  static constexpr size_t kMaxBacklogBytes = 256 * 1024;  // Per subscriber
+  static constexpr int64_t kRequestTimeoutMs = 10000;
+
+  // Runs on the I/O thread for each accepted command. Returns false if the
+  // command cannot be delivered (the client gets 503).
+  using CommandHandler = std::function<bool(StateCommand)>;
+
+  StateServer();
+  ~StateServer();
+
+  StateServer(const StateServer&) = delete;
+  StateServer& operator=(const StateServer&) = delete;
+
+  // Listens on 127.0.0.1:port (0 picks a free port) and starts the I/O
+  // thread. False if the port cannot be bound, e.g. another timer has it.
+  bool Start(uint16_t port, CommandHandler handler);
+
+  // Disconnects everyone and joins the I/O thread.
+  void Stop();
+
+  bool IsRunning() const { return thread.joinable(); }
+  uint16_t Port() const { return port; }
+
+  // Any thread, while running. Pushes state to subscribers unless
+  // IsSameSharedSecond() as the last one; generation is assigned here.
+  void Publish(const SharedTimerState& state);
+
+  // Instrumentation
+  std::atomic<uint64_t> requests{0};
+  std::atomic<uint64_t> commands{0};
+  std::atomic<uint64_t> subscribers{0};  // Currently connected
+  std::atomic<uint64_t> broadcasts{0};
+  std::atomic<uint64_t> messagesSent{0};
+  std::atomic<uint64_t> droppedSubscribers{0};
+  std::atomic<uint64_t> loopWakeups{0};
+  std::atomic<uint64_t> busyNs{0};  // I/O thread time outside poll()
+
+ private:
+  void Run();
+  void Wake();
+
+  std::mutex mutex;
+  SharedTimerState latest = {};  // Guarded by mutex; generation 0: none yet
+  uint64_t publishes = 0;        // Guarded by mutex
+
+  std::unique_ptr<StateServerLoop> loop;  // Owned by the I/O thread
+  CommandHandler handler;
+  uint16_t port = 0;
+  std::atomic<bool> stopping{false};
+  std::atomic<bool> wakePending{false};
+  std::thread thread;
+};
+
+#endif  // STATESERVER_H
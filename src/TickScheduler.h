@@ -0,0 +1,45 @@
+// TickScheduler.h - Decides when the timer window next needs to wake up
+
+#ifndef TICKSCHEDULER_H
+#define TICKSCHEDULER_H
+
+#include <cstdint>
+
+#include "TimerState.h"
+
+// Instead of a fixed 1 Hz tick, the timing thread (TimingThread) sleeps until
+// the next moment the window's output can change and not at all while nothing
+// will change.
+struct TickScheduler {
+  // Pixel crossings closer together than this are coalesced into one frame.
+  static constexpr int64_t kMinPixelWakeMs = 16;
+
+  // Delay in milliseconds until the next wakeup, or -1 if none is needed.
+  // A visible timer changes its labels every whole second and its progress
+  // bars whenever a fill edge crosses a pixel boundary (bar widths of 0 skip
+  // the bars); a hidden one only needs to wake to report completion.
+  static int64_t NextWakeDelay(const TimerState& state, bool visible,
+                               int questionBarWidth = 0,
+                               int blockBarWidth = 0) {
+    if (!state.IsRunning() || state.currentTime <= 0) {
+      return -1;
+    }
+    if (visible) {
+      int64_t delay = state.GetMillisecondsUntilNextSecond();
+      int64_t pixel =
+          state.GetMillisecondsUntilNextPixel(questionBarWidth, blockBarWidth);
+      if (pixel >= 0) {
+        if (pixel < kMinPixelWakeMs) pixel = kMinPixelWakeMs;
+        if (pixel < delay) delay = pixel;
+      }
+      return delay;
+    }
+
+    const int64_t delay =
+        static_cast<int64_t>(state.config.totalTime) * 1000 -
+        state.GetElapsedMilliseconds();
+    return delay > 0 ? delay : 0;
+  }
+};
+
+#endif  // TICKSCHEDULER_H
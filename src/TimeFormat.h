@@ -0,0 +1,141 @@
+// TimeFormat.h - Allocation-free duration and counter formatting
+
+#ifndef TIMEFORMAT_H
+#define TIMEFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Table-driven replacements for swprintf-style "%02d:%02d" formatting. Output
+// goes into a caller-provided buffer of char or wchar_t, with no locale or
+// format-string parsing. Every function returns the number of characters
+// written (excluding the terminator); if the text does not fit, the buffer is
+// set to an empty string and 0 is returned.
+//
+// Negative durations are written with a leading '-'. Minutes in MM:SS and
+// hours in H:MM:SS grow to as many digits as needed, so large values are
+// never truncated or wrapped.
+
+namespace timeformat {
+
+// "00" "01" ... "99"
+constexpr char kTwoDigits[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Longest output: '-' + 20-digit hours + ":MM:SS"
+constexpr size_t kMaxChars = 32;
+
+// Writes value (< 100) as exactly two digits, back to front.
+inline char* PutTwoDigitsReversed(char* end, unsigned value) {
+  *--end = kTwoDigits[value * 2 + 1];
+  *--end = kTwoDigits[value * 2];
+  return end;
+}
+
+// Writes value with at least minDigits digits, back to front.
+inline char* PutDecimalReversed(char* end, uint64_t value, int minDigits) {
+  int digits = 0;
+  while (value >= 100) {
+    end = PutTwoDigitsReversed(end, static_cast<unsigned>(value % 100));
+    value /= 100;
+    digits += 2;
+  }
+  if (value >= 10) {
+    end = PutTwoDigitsReversed(end, static_cast<unsigned>(value));
+    digits += 2;
+  } else {
+    *--end = static_cast<char>('0' + value);
+    digits += 1;
+  }
+  for (; digits < minDigits; digits++) *--end = '0';
+  return end;
+}
+
+inline uint64_t Magnitude(int64_t value) {
+  return value < 0 ? 0 - static_cast<uint64_t>(value)
+                   : static_cast<uint64_t>(value);
+}
+
+template <typename CharT>
+size_t Emit(const char* begin, const char* end, CharT* buffer, size_t size) {
+  const size_t length = static_cast<size_t>(end - begin);
+  if (!buffer || size == 0) return 0;
+  if (length + 1 > size) {
+    buffer[0] = CharT(0);
+    return 0;
+  }
+  for (size_t i = 0; i < length; i++) buffer[i] = static_cast<CharT>(begin[i]);
+  buffer[length] = CharT(0);
+  return length;
+}
+
+}  // namespace timeformat
+
+// [-]MM:SS, e.g. 75 -> "01:15", 7200 -> "120:00"
+template <typename CharT>
+size_t FormatMinutesSeconds(int64_t seconds, CharT* buffer, size_t size) {
+  char scratch[timeformat::kMaxChars];
+  char* const end = scratch + sizeof(scratch);
+  const uint64_t magnitude = timeformat::Magnitude(seconds);
+
+  char* p = timeformat::PutTwoDigitsReversed(
+      end, static_cast<unsigned>(magnitude % 60));
+  *--p = ':';
+  p = timeformat::PutDecimalReversed(p, magnitude / 60, 2);
+  if (seconds < 0) *--p = '-';
+  return timeformat::Emit(p, end, buffer, size);
+}
+
+// [-]H:MM:SS, e.g. 75 -> "0:01:15", 7200 -> "2:00:00"
+template <typename CharT>
+size_t FormatHoursMinutesSeconds(int64_t seconds, CharT* buffer, size_t size) {
+  char scratch[timeformat::kMaxChars];
+  char* const end = scratch + sizeof(scratch);
+  const uint64_t magnitude = timeformat::Magnitude(seconds);
+
+  char* p = timeformat::PutTwoDigitsReversed(
+      end, static_cast<unsigned>(magnitude % 60));
+  *--p = ':';
+  p = timeformat::PutTwoDigitsReversed(
+      p, static_cast<unsigned>((magnitude / 60) % 60));
+  *--p = ':';
+  p = timeformat::PutDecimalReversed(p, magnitude / 3600, 1);
+  if (seconds < 0) *--p = '-';
+  return timeformat::Emit(p, end, buffer, size);
+}
+
+// "<prefix>n/m", e.g. ("Q: ", 3, 40) -> "Q: 3/40". prefix must be ASCII.
+template <typename CharT>
+size_t FormatCountLabel(const char* prefix, int64_t current, int64_t total,
+                        CharT* buffer, size_t size) {
+  char scratch[timeformat::kMaxChars * 3];
+  char* const end = scratch + sizeof(scratch);
+
+  char* p =
+      timeformat::PutDecimalReversed(end, timeformat::Magnitude(total), 1);
+  if (total < 0) *--p = '-';
+  *--p = '/';
+  p = timeformat::PutDecimalReversed(p, timeformat::Magnitude(current), 1);
+  if (current < 0) *--p = '-';
+
+  size_t prefixLength = 0;
+  while (prefix[prefixLength]) prefixLength++;
+  if (prefixLength > static_cast<size_t>(p - scratch)) {
+    if (buffer && size > 0) buffer[0] = CharT(0);
+    return 0;
+  }
+  p -= prefixLength;
+  for (size_t i = 0; i < prefixLength; i++) p[i] = prefix[i];
+  return timeformat::Emit(p, end, buffer, size);
+}
+
+#endif  // TIMEFORMAT_H
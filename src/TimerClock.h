@@ -0,0 +1,39 @@
+// TimerClock.h - Monotonic time sources for the timing engine
+
+#ifndef TIMERCLOCK_H
+#define TIMERCLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+// Source of monotonic time in milliseconds. The epoch is arbitrary; only
+// differences between readings are meaningful. Implementations must never go
+// backwards. Swap in a virtual clock to drive TimerState deterministically.
+struct TimerClock {
+  virtual ~TimerClock() = default;
+  virtual int64_t NowMilliseconds() const = 0;
+};
+
+// Default clock backed by std::chrono::steady_clock (QueryPerformanceCounter
+// on Windows), which keeps counting across message-loop stalls and sleep.
+struct SteadyTimerClock : TimerClock {
+  int64_t NowMilliseconds() const override {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+};
+
+inline const TimerClock* GetSteadyTimerClock() {
+  static const SteadyTimerClock clock;
+  return &clock;
+}
+
+// Clock that only moves when nowMs is set, for tests, benchmarks and
+// simulations that drive TimerState through virtual time.
+struct ManualTimerClock : TimerClock {
+  int64_t nowMs = 0;
+  int64_t NowMilliseconds() const override { return nowMs; }
+};
+
+#endif  // TIMERCLOCK_H
@@ -0,0 +1,46 @@
+// TimerEvents.h - Typed timer transitions and zero-allocation dispatch
+
+#ifndef TIMEREVENTS_H
+#define TIMEREVENTS_H
+
+#include <cstdint>
+
+enum class TimerEventType : uint8_t {
+  QuestionAdvanced,  // A new question started
+  BlockAdvanced,     // A new block started (followed by its QuestionAdvanced)
+  BreakStarted,      // A scheduled break started
+  Completed          // All blocks finished
+};
+
+// One transition, stamped with the elapsed session second it happened at.
+struct TimerEvent {
+  TimerEventType type;
+  int64_t atSecond;  // Elapsed session time of the boundary
+  int block;         // 1-based block entered (or led into, for a break)
+  int question;      // 1-based question entered (0 if not a question)
+};
+
+// Fixed-capacity batch filled by TimerState::Advance(). Lives on the stack;
+// nothing is allocated on the tick path.
+struct TimerEventBatch {
+  static constexpr int kCapacity = 32;
+
+  TimerEvent events[kCapacity];
+  int count = 0;
+
+  bool HasRoom(int needed) const { return count + needed <= kCapacity; }
+  void Push(const TimerEvent& event) { events[count++] = event; }
+};
+
+// Delivers every event of batch to each subscriber in order. Subscribers are
+// any types with an OnTimerEvent(const TimerEvent&) member; the calls are
+// resolved at compile time, with no virtual dispatch or type erasure.
+template <typename... Subscribers>
+void DispatchTimerEvents(const TimerEventBatch& batch,
+                         Subscribers&... subscribers) {
+  for (int i = 0; i < batch.count; i++) {
+    (subscribers.OnTimerEvent(batch.events[i]), ...);
+  }
+}
+
+#endif  // TIMEREVENTS_H
@@ -0,0 +1,117 @@
+// TimerLayout.cpp - Timer bar geometry
+
+#include "TimerLayout.h"
+
+namespace {
+
+// How wide an element is: a fixed base width, or whatever the row has left.
+constexpr int kFillWidth = 0;
+
+// One element of a row, described in 96 DPI units.
+struct LayoutItem {
+  TimerElement element;
+  int baseWidth;   // Or kFillWidth
+  int baseInset;   // Offset from the top of the row
+  int baseShrink;  // Height removed from the row height
+  bool gapAfter;   // A margin separates this element from the next
+};
+
+constexpr int kRowLength = 5;
+
+// Margins left free at the right end of each row, after the last element.
+constexpr int kRowTrailingMargins = 3;
+
+// The bar, row by row and left to right. Each row starts one margin in and
+// ends kRowTrailingMargins margins before the window edge.
+constexpr LayoutItem kLayoutRows[][kRowLength] = {
+    {
+        {kElementQuestionLabel, BASE_LABEL_WIDTH, BASE_LABEL_INSET,
+         BASE_LABEL_SHRINK, false},
+        {kElementQuestionTime, BASE_TIME_WIDTH, BASE_LABEL_INSET,
+         BASE_LABEL_SHRINK, false},
+        {kElementQuestionProgress, kFillWidth, BASE_PROGRESS_INSET,
+         BASE_PROGRESS_SHRINK, true},
+        {kElementSettingsButton, BASE_BTN_SMALL, BASE_BUTTON_INSET,
+         BASE_BUTTON_SHRINK, true},
+        {kElementCloseButton, BASE_BTN_SMALL, BASE_BUTTON_INSET,
+         BASE_BUTTON_SHRINK, false},
+    },
+    {
+        {kElementBlockLabel, BASE_LABEL_WIDTH, BASE_LABEL_INSET,
+         BASE_LABEL_SHRINK, false},
+        {kElementBlockTime, BASE_TIME_WIDTH, BASE_LABEL_INSET,
+         BASE_LABEL_SHRINK, false},
+        {kElementBlockProgress, kFillWidth, BASE_PROGRESS_INSET,
+         BASE_PROGRESS_SHRINK, true},
+        {kElementStartStopButton, BASE_BTN_WIDTH, BASE_BUTTON_INSET,
+         BASE_BUTTON_SHRINK, true},
+        {kElementPauseButton, BASE_BTN_WIDTH, BASE_BUTTON_INSET,
+         BASE_BUTTON_SHRINK, false},
+    },
+};
+
+constexpr int kRowCount = sizeof(kLayoutRows) / sizeof(kLayoutRows[0]);
+static_assert(kRowCount * kRowLength == kTimerElementCount,
+              "Every element must be placed exactly once");
+
+}  // namespace
+
+int ClampTimerWindowWidth(int dpi, int windowWidth) {
+  if (dpi <= 0) dpi = 96;
+  if (windowWidth <= 0) return ScaleForDpi(BASE_WINDOW_WIDTH, dpi);
+
+  const int minWidth = ScaleForDpi(BASE_MIN_WINDOW_WIDTH, dpi);
+  const int maxWidth = ScaleForDpi(BASE_MAX_WINDOW_WIDTH, dpi);
+  if (windowWidth < minWidth) return minWidth;
+  if (windowWidth > maxWidth) return maxWidth;
+  return windowWidth;
+}
+
+TimerLayout ComputeTimerLayout(int dpi, int windowWidth) {
+  if (dpi <= 0) dpi = 96;
+
+  TimerLayout layout = {};
+  layout.dpi = dpi;
+  layout.windowWidth = ClampTimerWindowWidth(dpi, windowWidth);
+  layout.windowHeight = ScaleForDpi(BASE_WINDOW_HEIGHT, dpi);
+  layout.fontHeight = ScaleForDpi(BASE_FONT_SIZE, dpi);
+
+  const int margin = ScaleForDpi(BASE_MARGIN, dpi);
+  const int rowHeight = ScaleForDpi(BASE_ROW_HEIGHT, dpi);
+
+  for (int row = 0; row < kRowCount; row++) {
+    const LayoutItem* items = kLayoutRows[row];
+
+    // The fill element gets the width no fixed element or margin takes.
+    int fillWidth = layout.windowWidth - margin * (1 + kRowTrailingMargins);
+    for (int i = 0; i < kRowLength; i++) {
+      if (items[i].baseWidth != kFillWidth) {
+        fillWidth -= ScaleForDpi(items[i].baseWidth, dpi);
+      }
+      if (items[i].gapAfter) fillWidth -= margin;
+    }
+
+    int x = margin;
+    const int y = margin + rowHeight * row;
+    for (int i = 0; i < kRowLength; i++) {
+      const LayoutItem& item = items[i];
+      const int width = item.baseWidth == kFillWidth
+                            ? fillWidth
+                            : ScaleForDpi(item.baseWidth, dpi);
+      const int top = y + ScaleForDpi(item.baseInset, dpi);
+      const int height = rowHeight - ScaleForDpi(item.baseShrink, dpi);
+      layout.rects[item.element] = {x, top, x + width, top + height};
+      x += width;
+      if (item.gapAfter) x += margin;
+    }
+  }
+
+  return layout;
+}
+
+int HitTestTimerLayout(const TimerLayout& layout, int x, int y) {
+  for (int element = 0; element < kTimerElementCount; element++) {
+    if (layout.rects[element].Contains(x, y)) return element;
+  }
+  return -1;
+}
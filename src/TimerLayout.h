@@ -0,0 +1,93 @@
+// TimerLayout.h - DPI-scaled geometry of the timer bar
+
+#ifndef TIMERLAYOUT_H
+#define TIMERLAYOUT_H
+
+// Base dimensions at 96 DPI (100% scaling)
+constexpr int BASE_WINDOW_WIDTH = 600;
+constexpr int BASE_WINDOW_HEIGHT = 56;
+constexpr int BASE_ROW_HEIGHT = 26;
+constexpr int BASE_MARGIN = 4;
+constexpr int BASE_BTN_WIDTH = 60;
+constexpr int BASE_BTN_SMALL = 28;
+constexpr int BASE_LABEL_WIDTH = 70;
+constexpr int BASE_TIME_WIDTH = 50;
+constexpr int BASE_FONT_SIZE = 14;
+
+// Range the user can resize the bar's width within; the progress bars
+// absorb the difference from BASE_WINDOW_WIDTH.
+constexpr int BASE_MIN_WINDOW_WIDTH = 360;
+constexpr int BASE_MAX_WINDOW_WIDTH = 2400;
+constexpr int BASE_RESIZE_GRIP = 6;  // Width of the left/right resize edges
+
+// Vertical placement of each kind of element within its row: offset from
+// the row's top, and how much shorter than the row it is.
+constexpr int BASE_LABEL_INSET = 3;
+constexpr int BASE_LABEL_SHRINK = 6;
+constexpr int BASE_PROGRESS_INSET = 4;
+constexpr int BASE_PROGRESS_SHRINK = 10;
+constexpr int BASE_BUTTON_INSET = 1;
+constexpr int BASE_BUTTON_SHRINK = 4;
+
+// Rectangle in client pixels (right/bottom exclusive), layout-compatible with
+// the Win32 RECT.
+struct BarRect {
+  int left;
+  int top;
+  int right;
+  int bottom;
+
+  int Width() const { return right - left; }
+  int Height() const { return bottom - top; }
+  bool Contains(int x, int y) const {
+    return x >= left && x < right && y >= top && y < bottom;
+  }
+};
+
+// Elements of the timer bar, in creation order
+enum TimerElement {
+  kElementQuestionLabel,
+  kElementQuestionTime,
+  kElementQuestionProgress,
+  kElementSettingsButton,
+  kElementCloseButton,
+  kElementBlockLabel,
+  kElementBlockTime,
+  kElementBlockProgress,
+  kElementStartStopButton,
+  kElementPauseButton,
+  kTimerElementCount
+};
+
+struct TimerLayout {
+  int dpi;
+  int windowWidth;
+  int windowHeight;
+  int fontHeight;  // Font em height in pixels
+  BarRect rects[kTimerElementCount];
+};
+
+// MulDiv(value, dpi, 96) for non-negative values
+inline int ScaleForDpi(int value, int dpi) {
+  return static_cast<int>((static_cast<long long>(value) * dpi + 48) / 96);
+}
+
+// windowWidth (in pixels at dpi) limited to the resizable range; 0 picks the
+// default width.
+int ClampTimerWindowWidth(int dpi, int windowWidth);
+
+// Places every element of a bar windowWidth pixels wide (clamped with
+// ClampTimerWindowWidth) for the given DPI. Pure: the result depends only on
+// its arguments and the BASE_* constants, so callers can apply it to child
+// windows, the owner-draw renderer or nothing at all.
+TimerLayout ComputeTimerLayout(int dpi, int windowWidth = 0);
+
+// Element under the client point (x, y), or -1.
+int HitTestTimerLayout(const TimerLayout& layout, int x, int y);
+
+inline bool IsTimerButton(int element) {
+  return element == kElementSettingsButton || element == kElementCloseButton ||
+         element == kElementStartStopButton || element == kElementPauseButton;
+}
+
+#endif  // TIMERLAYOUT_H
@@ -0,0 +1,120 @@
+// TimerState.cpp - Timer position evaluation and transition reporting
+
+#include "TimerState.h"
+
+TimerPosition StateAt(const TimerConfig& config, int64_t elapsedSeconds) {
+  TimerPosition pos = {};
+  pos.currentQuestion = 1;
+
+  const int numQuestions = config.numQuestions > 0 ? config.numQuestions : 1;
+
+  if (elapsedSeconds < 0) elapsedSeconds = 0;
+  if (elapsedSeconds >= config.totalTime || config.timePerBlockSeconds <= 0) {
+    pos.currentBlock = config.numBlocks > 0 ? config.numBlocks : 1;
+    pos.questionsInBlock = config.numBlocks > 0 ? numQuestions : 0;
+    pos.segmentIndex =
+        config.numBlocks > 0 ? config.numBlocks * numQuestions : 0;
+    pos.completed = true;
+    return pos;
+  }
+
+  const int64_t blockLength = config.timePerBlockSeconds;
+  const int64_t blockIndex = elapsedSeconds / blockLength;
+  const int64_t inBlock = elapsedSeconds % blockLength;
+
+  // Question k spans [k * L / n, (k + 1) * L / n) with floor division, which
+  // spreads the remainder over the block. The question containing second b is
+  // therefore floor(((b + 1) * n - 1) / L).
+  int64_t question = ((inBlock + 1) * numQuestions - 1) / blockLength;
+  if (question > numQuestions - 1) question = numQuestions - 1;
+  const int64_t questionStart = question * blockLength / numQuestions;
+  const int64_t questionEnd = (question + 1) * blockLength / numQuestions;
+
+  pos.currentTime = static_cast<int>(config.totalTime - elapsedSeconds);
+  pos.currentBlock = static_cast<int>(blockIndex) + 1;
+  pos.currentQuestion = static_cast<int>(question) + 1;
+  pos.blockTimeElapsed = static_cast<int>(inBlock);
+  pos.questionTimeElapsed = static_cast<int>(inBlock - questionStart);
+  pos.questionLength = static_cast<int>(questionEnd - questionStart);
+  pos.blockLength = static_cast<int>(blockLength);
+  pos.questionsInBlock = numQuestions;
+  pos.segmentIndex = static_cast<int>(blockIndex * numQuestions + question);
+
+  if (pos.questionLength > 0) {
+    pos.questionProgress = (pos.questionTimeElapsed * 100) / pos.questionLength;
+  }
+  pos.blockProgress = (pos.blockTimeElapsed * 100) / pos.blockLength;
+  return pos;
+}
+
+SessionPlan BuildSessionPlan(const TimerConfig& config) {
+  SessionPlan plan;
+  const int numBlocks = config.numBlocks > 0 ? config.numBlocks : 0;
+  const int numQuestions = config.numQuestions > 0 ? config.numQuestions : 1;
+
+  plan.blocks.reserve(numBlocks);
+  plan.segments.reserve(static_cast<size_t>(numBlocks) * numQuestions);
+  plan.segmentEnds.reserve(static_cast<size_t>(numBlocks) * numQuestions);
+  for (int block = 0; block < numBlocks; block++) {
+    plan.AddBlock(0, config.timePerBlockSeconds, numQuestions);
+  }
+  return plan;
+}
+
+TickStatus TimerState::Tick() {
+  if (!IsRunning()) {
+    return TickStatus::Continue;
+  }
+  return DrainTimerEvents(*this);
+}
+
+int GetBoundaryEvents(const SessionPlan& plan, int segment,
+                      TimerEvent* events) {
+  const int next = segment + 1;
+  const PlanSegment& from = plan.segments[segment];
+
+  TimerEvent event = {};
+  event.atSecond = plan.segmentEnds[segment];
+
+  if (next >= plan.SegmentCount()) {
+    event.type = TimerEventType::Completed;
+    event.block = plan.BlockCount();
+    events[0] = event;
+    return 1;
+  }
+
+  const PlanSegment& to = plan.segments[next];
+  event.block = to.block + 1;
+  if (to.kind == PlanSegmentKind::Break) {
+    event.type = TimerEventType::BreakStarted;
+    events[0] = event;
+    return 1;
+  }
+
+  int count = 0;
+  event.question = to.question;
+  if (from.kind == PlanSegmentKind::Break || from.block != to.block) {
+    event.type = TimerEventType::BlockAdvanced;
+    events[count++] = event;
+  }
+  event.type = TimerEventType::QuestionAdvanced;
+  events[count++] = event;
+  return count;
+}
+
+bool TimerState::Advance(TimerEventBatch* batch) {
+  batch->count = 0;
+  ApplyPosition(plan.PositionAt(GetElapsedMilliseconds() / 1000, segmentIndex));
+
+  // Report each boundary between eventSegment and the current segment. A
+  // boundary's events go into the same batch, so a batch never splits one.
+  const int segmentCount = plan.SegmentCount();
+  while (eventSegment < segmentIndex && eventSegment < segmentCount) {
+    TimerEvent events[kMaxBoundaryEvents];
+    const int count = GetBoundaryEvents(plan, eventSegment, events);
+    if (!batch->HasRoom(count)) return true;
+    for (int i = 0; i < count; i++) batch->Push(events[i]);
+    eventSegment++;
+  }
+  return false;
+}
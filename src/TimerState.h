@@ -3,9 +3,14 @@
 #ifndef TIMERSTATE_H
 #define TIMERSTATE_H
 
-#include <windows.h>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
 
-#include <cstdio>
+#include "SessionPlan.h"
+#include "TimeFormat.h"
+#include "TimerClock.h"
+#include "TimerEvents.h"
 
 // Configuration from setup dialog
 struct TimerConfig {
@@ -13,6 +18,7 @@ struct TimerConfig {
   int numBlocks;     // Total number of blocks
   int numQuestions;  // Questions per block
   int transparency;  // Window transparency 0-100 (100 = opaque)
+  bool ownerDraw;    // Paint the bar into one back buffer, no child controls
 
   // Computed values
   int timePerBlockSeconds;
@@ -35,100 +41,304 @@ enum class TickStatus {
   Completed          // All blocks finished
 };
 
+// Closed-form evaluation of the position reached after elapsedSeconds of
+// running time for the uniform plan described by config, in O(1). Question
+// boundaries distribute the block's remainder exactly like SessionPlan, so
+// the result equals BuildSessionPlan(config).PositionAt(elapsedSeconds).
+// config must have its derived values computed.
+TimerPosition StateAt(const TimerConfig& config, int64_t elapsedSeconds);
+
+// Flattens config's numBlocks x numQuestions layout into a SessionPlan.
+SessionPlan BuildSessionPlan(const TimerConfig& config);
+
+// Most transitions reported for a single segment boundary.
+constexpr int kMaxBoundaryEvents = 2;
+
+// Transitions reported when the timeline crosses the end of plan's segment
+// `segment`: Completed after the last one, BreakStarted into a break, and
+// otherwise QuestionAdvanced, preceded by BlockAdvanced when a new block
+// starts. Writes them to events (room for kMaxBoundaryEvents) and returns
+// how many there are.
+int GetBoundaryEvents(const SessionPlan& plan, int segment, TimerEvent* events);
+
+// Fill, in whole pixels (0..barWidth), of a bar barWidth pixels wide after
+// elapsedMs of an interval lengthSeconds long: floor(elapsed * width / length).
+inline int ProgressPixels(int64_t elapsedMs, int64_t lengthSeconds,
+                          int barWidth) {
+  if (lengthSeconds <= 0 || barWidth <= 0 || elapsedMs <= 0) return 0;
+  const int64_t lengthMs = lengthSeconds * 1000;
+  if (elapsedMs >= lengthMs) return barWidth;
+  return static_cast<int>(elapsedMs * barWidth / lengthMs);
+}
+
+// Milliseconds from elapsedMs until ProgressPixels() next grows by a pixel,
+// or -1 once the bar is full.
+inline int64_t MillisecondsUntilNextPixel(int64_t elapsedMs,
+                                          int64_t lengthSeconds,
+                                          int barWidth) {
+  if (lengthSeconds <= 0 || barWidth <= 0) return -1;
+  const int filled = ProgressPixels(elapsedMs, lengthSeconds, barWidth);
+  if (filled >= barWidth) return -1;
+
+  // First instant t with floor(t * width / length) == filled + 1
+  const int64_t lengthMs = lengthSeconds * 1000;
+  const int64_t crossing = ((filled + 1) * lengthMs + barWidth - 1) / barWidth;
+  return crossing > elapsedMs ? crossing - elapsedMs : 1;
+}
+
 // Current timer state
+//
+// Elapsed session time is derived from a monotonic clock rather than counted
+// per WM_TIMER, so late or missed ticks never accumulate into drift. While
+// running, elapsed time is clock->NowMilliseconds() - originMs (the instant the
+// session would have started had it never been halted); while paused or
+// stopped it is frozen in heldMs. The per-second fields below are brought up to
+// date with that elapsed time by Tick(), which looks the position up in plan.
 struct TimerState {
   int currentTime;          // Total remaining time in seconds
-  int currentQuestion;      // Current question number (1-based)
+  int currentQuestion;      // Current question number (1-based, 0 in a break)
   int currentBlock;         // Current block number (1-based)
   int blockTimeElapsed;     // Seconds elapsed in current block
   int questionTimeElapsed;  // Seconds elapsed in current question
+  int questionLength;       // Length of the current question in seconds
+  int blockLength;          // Length of the current block in seconds
+  int questionsInBlock;     // Questions in the current block
+  int segmentIndex;         // Current segment of plan
+  int eventSegment;         // First segment whose start is not yet reported
+  bool inBreak;             // Inside a scheduled break
   bool paused;              // Timer is paused
   bool stopped;             // Timer is stopped (not running)
 
   TimerConfig config;
+  SessionPlan plan;         // Timeline the position is looked up in
+
+  const TimerClock* clock;  // Time source (steady clock unless injected)
+  int64_t originMs;         // Clock reading at elapsed == 0 (while running)
+  int64_t heldMs;           // Elapsed milliseconds (while paused/stopped)
 
-  void Initialize(const TimerConfig& cfg) {
+  void Initialize(const TimerConfig& cfg,
+                  const TimerClock* timeSource = GetSteadyTimerClock()) {
     config = cfg;
     config.ComputeDerivedValues();
+    InitializeWithPlan(config, BuildSessionPlan(config), timeSource);
+  }
+
+  // Runs an arbitrary plan (sections, weighted questions, breaks). config
+  // still supplies the non-timing settings; its totalTime follows the plan.
+  void InitializeWithPlan(
+      const TimerConfig& cfg, SessionPlan sessionPlan,
+      const TimerClock* timeSource = GetSteadyTimerClock()) {
+    config = cfg;
+    plan = std::move(sessionPlan);
+    config.totalTime = static_cast<int>(plan.TotalSeconds());
+    clock = timeSource;
     Reset();
   }
 
   void Reset() {
-    currentTime = config.totalTime;
-    currentQuestion = 1;
-    currentBlock = 1;
-    blockTimeElapsed = 0;
-    questionTimeElapsed = 0;
+    ApplyPosition(plan.PositionAt(0));
+    eventSegment = segmentIndex;
     paused = false;
     stopped = false;  // Auto-start since user clicked "Start" in setup
+    heldMs = 0;
+    originMs = clock->NowMilliseconds();
   }
 
-  TickStatus Tick() {
-    if (paused || stopped) {
-      return TickStatus::Continue;
-    }
+  // Elapsed session time in milliseconds, excluding paused/stopped intervals.
+  int64_t GetElapsedMilliseconds() const {
+    return IsRunning() ? clock->NowMilliseconds() - originMs : heldMs;
+  }
 
-    currentTime--;
-    blockTimeElapsed++;
-    questionTimeElapsed++;
+  // Milliseconds until the elapsed time next crosses a whole second, i.e. the
+  // delay to arm the next tick for.
+  int GetMillisecondsUntilNextSecond() const {
+    return 1000 - static_cast<int>(GetElapsedMilliseconds() % 1000);
+  }
 
-    TickStatus status = TickStatus::Continue;
+  // Catches the per-second fields up with the clock and returns the most
+  // significant transition crossed since the previous call. Listeners that
+  // need every transition should use Advance()/DrainTimerEvents() instead.
+  TickStatus Tick();
 
-    // Check if question time is up
-    if (questionTimeElapsed >= config.timePerQuestion) {
-      questionTimeElapsed = 0;
-      if (currentQuestion < config.numQuestions) {
-        currentQuestion++;
-        status = TickStatus::QuestionAdvanced;
-      }
-    }
+  // Catches the per-second fields up with the clock, then appends to batch
+  // (which is cleared first) every transition crossed since the last call, in
+  // order and with its own timestamp. The displayed position always jumps
+  // straight to the current time; if the batch fills up, the remaining
+  // transitions are kept and Advance() returns true so the caller can drain
+  // them with further calls. Nothing is ever dropped.
+  bool Advance(TimerEventBatch* batch);
 
-    // Check if block time is up
-    if (blockTimeElapsed >= config.timePerBlockSeconds) {
-      blockTimeElapsed = 0;
-      questionTimeElapsed = 0;
-      currentQuestion = 1;
-
-      if (currentBlock < config.numBlocks) {
-        currentBlock++;
-        status = TickStatus::BlockAdvanced;
-      } else {
-        status = TickStatus::Completed;
-      }
+  // Jumps straight to the given elapsed session time, keeping the current
+  // running/paused/stopped state. Used to resume or fast-forward a session
+  // without replaying intermediate ticks.
+  void SeekTo(int64_t elapsedMs) {
+    if (elapsedMs < 0) elapsedMs = 0;
+    if (IsRunning()) {
+      originMs = clock->NowMilliseconds() - elapsedMs;
+    } else {
+      heldMs = elapsedMs;
     }
+    ApplyPosition(plan.PositionAt(elapsedMs / 1000));
+    eventSegment = segmentIndex;  // Skipped transitions are not reported
+  }
 
-    return status;
+  // Skips the rest of the current block (or break) and continues from the
+  // start of whatever follows, keeping the running/paused/stopped state. Of
+  // the skipped transitions only the one into the new block is reported.
+  // Returns false, changing nothing, in the last block.
+  bool SkipToNextBlock() {
+    const int64_t elapsedSeconds = GetElapsedMilliseconds() / 1000;
+    const TimerPosition pos = plan.PositionAt(elapsedSeconds, segmentIndex);
+    const int64_t next =
+        elapsedSeconds - pos.blockTimeElapsed + pos.blockLength;
+    if (pos.completed || next >= plan.TotalSeconds()) return false;
+
+    SeekTo(next * 1000);
+    eventSegment = segmentIndex - 1;
+    return true;
   }
 
-  void TogglePause() { paused = !paused; }
+  void TogglePause() { SetPaused(!paused); }
+
+  void SetPaused(bool pause) {
+    const bool wasRunning = IsRunning();
+    paused = pause;
+    SyncClock(wasRunning);
+  }
 
   void Start() {
+    const bool wasRunning = IsRunning();
     stopped = false;
     paused = false;
+    SyncClock(wasRunning);
   }
 
-  void Stop() { stopped = true; }
+  void Stop() {
+    const bool wasRunning = IsRunning();
+    stopped = true;
+    SyncClock(wasRunning);
+  }
 
   bool IsRunning() const { return !stopped && !paused; }
 
   // Get formatted time string MM:SS
   static void FormatTime(int seconds, wchar_t* buffer, size_t bufferSize) {
-    int mins = seconds / 60;
-    int secs = seconds % 60;
-    swprintf_s(buffer, bufferSize, L"%02d:%02d", mins, secs);
+    FormatMinutesSeconds(seconds, buffer, bufferSize);
+  }
+
+  // Milliseconds into the displayed question and block. The displayed
+  // position only advances on Tick(); these follow the clock between ticks.
+  int64_t GetQuestionElapsedMilliseconds() const {
+    const int64_t startSecond =
+        config.totalTime - currentTime - questionTimeElapsed;
+    return GetElapsedMilliseconds() - startSecond * 1000;
+  }
+
+  int64_t GetBlockElapsedMilliseconds() const {
+    const int64_t startSecond = config.totalTime - currentTime - blockTimeElapsed;
+    return GetElapsedMilliseconds() - startSecond * 1000;
+  }
+
+  // Question bar fill in pixels (0..barWidth)
+  int GetQuestionProgressPixels(int barWidth) const {
+    return ProgressPixels(GetQuestionElapsedMilliseconds(), questionLength,
+                          barWidth);
+  }
+
+  // Block bar fill in pixels (0..barWidth)
+  int GetBlockProgressPixels(int barWidth) const {
+    return ProgressPixels(GetBlockElapsedMilliseconds(), blockLength, barWidth);
+  }
+
+  // Milliseconds until the fill edge of either bar next crosses a pixel
+  // boundary, or -1 if neither will move before the next tick.
+  int64_t GetMillisecondsUntilNextPixel(int questionBarWidth,
+                                        int blockBarWidth) const {
+    const int64_t question = MillisecondsUntilNextPixel(
+        GetQuestionElapsedMilliseconds(), questionLength, questionBarWidth);
+    const int64_t block = MillisecondsUntilNextPixel(
+        GetBlockElapsedMilliseconds(), blockLength, blockBarWidth);
+    if (question < 0) return block;
+    if (block < 0) return question;
+    return question < block ? question : block;
   }
 
   // Get question progress (0-100)
   int GetQuestionProgress() const {
-    if (config.timePerQuestion == 0) return 0;
-    return (questionTimeElapsed * 100) / config.timePerQuestion;
+    if (questionLength == 0) return 0;
+    return (questionTimeElapsed * 100) / questionLength;
   }
 
   // Get block progress (0-100)
   int GetBlockProgress() const {
-    if (config.timePerBlockSeconds == 0) return 0;
-    return (blockTimeElapsed * 100) / config.timePerBlockSeconds;
+    if (blockLength == 0) return 0;
+    return (blockTimeElapsed * 100) / blockLength;
+  }
+
+ private:
+  // Moves the elapsed-time anchor across a running <-> halted transition.
+  void SyncClock(bool wasRunning) {
+    const bool running = IsRunning();
+    if (running == wasRunning) return;
+
+    const int64_t now = clock->NowMilliseconds();
+    if (running) {
+      originMs = now - heldMs;
+    } else {
+      heldMs = now - originMs;
+    }
+  }
+
+  void ApplyPosition(const TimerPosition& pos) {
+    currentTime = pos.currentTime;
+    currentQuestion = pos.currentQuestion;
+    currentBlock = pos.currentBlock;
+    blockTimeElapsed = pos.blockTimeElapsed;
+    questionTimeElapsed = pos.questionTimeElapsed;
+    questionLength = pos.questionLength;
+    blockLength = pos.blockLength;
+    questionsInBlock = pos.questionsInBlock;
+    segmentIndex = pos.segmentIndex;
+    inBreak = pos.inBreak;
   }
 };
 
+// Folds a batch of events into the TickStatus that Tick() reports.
+inline TickStatus SummarizeTimerEvents(const TimerEventBatch& batch,
+                                       TickStatus status) {
+  for (int i = 0; i < batch.count; i++) {
+    TickStatus eventStatus = TickStatus::QuestionAdvanced;
+    switch (batch.events[i].type) {
+      case TimerEventType::QuestionAdvanced:
+        eventStatus = TickStatus::QuestionAdvanced;
+        break;
+      case TimerEventType::BlockAdvanced:
+      case TimerEventType::BreakStarted:
+        eventStatus = TickStatus::BlockAdvanced;
+        break;
+      case TimerEventType::Completed:
+        eventStatus = TickStatus::Completed;
+        break;
+    }
+    if (eventStatus > status) status = eventStatus;
+  }
+  return status;
+}
+
+// Brings state up to date and delivers every pending transition to each
+// subscriber (see DispatchTimerEvents), batch by batch, without allocating.
+// Returns the same summary as Tick().
+template <typename... Subscribers>
+TickStatus DrainTimerEvents(TimerState& state, Subscribers&... subscribers) {
+  TickStatus status = TickStatus::Continue;
+  TimerEventBatch batch;
+  bool more = true;
+  while (more) {
+    more = state.Advance(&batch);
+    DispatchTimerEvents(batch, subscribers...);
+    status = SummarizeTimerEvents(batch, status);
+  }
+  return status;
+}
+
 #endif  // TIMERSTATE_H
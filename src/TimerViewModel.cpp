@@ -0,0 +1,143 @@
+// TimerViewModel.cpp - Timer bar view model formatting and diffing
+
+#include "TimerViewModel.h"
+
+#include <cwchar>
+
+#include "TimeFormat.h"
+
+bool TimerSnapshot::SameDisplay(const TimerSnapshot& other) const {
+  return currentTime == other.currentTime &&
+         currentQuestion == other.currentQuestion &&
+         currentBlock == other.currentBlock &&
+         blockCount == other.blockCount &&
+         questionsInBlock == other.questionsInBlock &&
+         questionTimeElapsed == other.questionTimeElapsed &&
+         blockTimeElapsed == other.blockTimeElapsed &&
+         blockLength == other.blockLength &&
+         questionProgress == other.questionProgress &&
+         blockProgress == other.blockProgress && inBreak == other.inBreak &&
+         paused == other.paused && stopped == other.stopped;
+}
+
+TimerSnapshot CaptureTimerSnapshot(const TimerState& state,
+                                   int questionBarWidth, int blockBarWidth) {
+  TimerSnapshot snapshot = {};
+  snapshot.capturedAtMs = state.clock->NowMilliseconds();
+  snapshot.elapsedMs = state.IsRunning()
+                           ? snapshot.capturedAtMs - state.originMs
+                           : state.heldMs;
+  // Same arithmetic as TimerState's getters, from the one clock reading above
+  const int64_t passedSeconds = state.config.totalTime - state.currentTime;
+  snapshot.questionElapsedMs =
+      snapshot.elapsedMs - (passedSeconds - state.questionTimeElapsed) * 1000;
+  snapshot.blockElapsedMs =
+      snapshot.elapsedMs - (passedSeconds - state.blockTimeElapsed) * 1000;
+  snapshot.currentTime = state.currentTime;
+  snapshot.totalTime = state.config.totalTime;
+  snapshot.currentQuestion = state.currentQuestion;
+  snapshot.currentBlock = state.currentBlock;
+  snapshot.blockCount = state.plan.BlockCount();
+  snapshot.questionsInBlock = state.questionsInBlock;
+  snapshot.questionTimeElapsed = state.questionTimeElapsed;
+  snapshot.blockTimeElapsed = state.blockTimeElapsed;
+  snapshot.questionLength = state.questionLength;
+  snapshot.blockLength = state.blockLength;
+  snapshot.questionProgress =
+      ProgressPixels(snapshot.questionElapsedMs, state.questionLength,
+                     questionBarWidth);
+  snapshot.blockProgress = ProgressPixels(snapshot.blockElapsedMs,
+                                          state.blockLength, blockBarWidth);
+  snapshot.inBreak = state.inBreak;
+  snapshot.paused = state.paused;
+  snapshot.stopped = state.stopped;
+  return snapshot;
+}
+
+SharedTimerState ToSharedTimerState(const TimerSnapshot& snapshot,
+                                    int64_t wallNowMs) {
+  SharedTimerState shared = {};
+  shared.capturedAtMs = snapshot.capturedAtMs;
+  shared.wallMs = wallNowMs;
+  shared.elapsedMs = snapshot.elapsedMs;
+  shared.totalMs = static_cast<int64_t>(snapshot.totalTime) * 1000;
+  shared.questionElapsedMs = snapshot.questionElapsedMs;
+  shared.blockElapsedMs = snapshot.blockElapsedMs;
+  shared.block = snapshot.currentBlock;
+  shared.blockCount = snapshot.blockCount;
+  shared.question = snapshot.currentQuestion;
+  shared.questionsInBlock = snapshot.questionsInBlock;
+  shared.questionSeconds = snapshot.questionLength;
+  shared.blockSeconds = snapshot.blockLength;
+  if (snapshot.paused) shared.flags |= kSharedTimerPaused;
+  if (snapshot.stopped) shared.flags |= kSharedTimerStopped;
+  if (snapshot.inBreak) shared.flags |= kSharedTimerInBreak;
+  if (snapshot.currentTime <= 0) shared.flags |= kSharedTimerCompleted;
+  return shared;
+}
+
+void BuildTimerViewModel(const TimerSnapshot& snapshot, int questionBarWidth,
+                         int blockBarWidth, TimerViewModel* view) {
+  if (snapshot.inBreak) {
+    FormatCountLabel("Break ", snapshot.currentBlock - 1, snapshot.blockCount,
+                     view->questionLabel, 32);
+  } else {
+    FormatCountLabel("Q: ", snapshot.currentQuestion, snapshot.questionsInBlock,
+                     view->questionLabel, 32);
+  }
+  FormatMinutesSeconds(snapshot.questionTimeElapsed, view->questionTime, 16);
+  FormatCountLabel("Block ", snapshot.currentBlock, snapshot.blockCount,
+                   view->blockLabel, 32);
+  FormatMinutesSeconds(snapshot.blockLength - snapshot.blockTimeElapsed,
+                       view->blockTime, 16);
+
+  view->questionProgress =
+      ProgressPixels(snapshot.questionElapsedMs, snapshot.questionLength,
+                     questionBarWidth);
+  view->blockProgress = ProgressPixels(snapshot.blockElapsedMs,
+                                       snapshot.blockLength, blockBarWidth);
+  view->startStopText = snapshot.stopped ? L"Start" : L"Stop";
+  view->pauseText = snapshot.paused ? L"Resume" : L"Pause";
+  view->pauseEnabled = !snapshot.stopped;
+}
+
+void BuildTimerViewModel(const TimerState& state, int questionBarWidth,
+                         int blockBarWidth, TimerViewModel* view) {
+  BuildTimerViewModel(
+      CaptureTimerSnapshot(state, questionBarWidth, blockBarWidth),
+      questionBarWidth, blockBarWidth, view);
+}
+
+unsigned TimerViewDiffer::Commit(const TimerViewModel& next) {
+  unsigned changed = kViewAllFields;
+  if (hasRendered) {
+    changed = 0;
+    if (std::wcscmp(rendered.questionLabel, next.questionLabel) != 0)
+      changed |= kViewQuestionLabel;
+    if (std::wcscmp(rendered.questionTime, next.questionTime) != 0)
+      changed |= kViewQuestionTime;
+    if (rendered.questionProgress != next.questionProgress)
+      changed |= kViewQuestionProgress;
+    if (std::wcscmp(rendered.blockLabel, next.blockLabel) != 0)
+      changed |= kViewBlockLabel;
+    if (std::wcscmp(rendered.blockTime, next.blockTime) != 0)
+      changed |= kViewBlockTime;
+    if (rendered.blockProgress != next.blockProgress)
+      changed |= kViewBlockProgress;
+    if (std::wcscmp(rendered.startStopText, next.startStopText) != 0)
+      changed |= kViewStartStopText;
+    if (std::wcscmp(rendered.pauseText, next.pauseText) != 0)
+      changed |= kViewPauseText;
+    if (rendered.pauseEnabled != next.pauseEnabled)
+      changed |= kViewPauseEnabled;
+  }
+
+  unsigned count = 0;
+  for (unsigned bits = changed; bits; bits &= bits - 1) count++;
+  issuedUpdates += count;
+  suppressedUpdates += kViewFieldCount - count;
+
+  rendered = next;
+  hasRendered = true;
+  return changed;
+}
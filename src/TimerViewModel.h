@@ -0,0 +1,111 @@
+// TimerViewModel.h - Platform-neutral snapshot of what the timer bar shows
+
+#ifndef TIMERVIEWMODEL_H
+#define TIMERVIEWMODEL_H
+
+#include <cstdint>
+
+#include "SharedTimerState.h"
+#include "TimerState.h"
+
+// The part of TimerState the bar displays, as one trivially copyable value
+// that the timing thread can publish and the UI thread can read while the
+// state itself keeps changing.
+struct TimerSnapshot {
+  uint64_t generation;    // Publication count, for telling frames apart
+  int64_t elapsedMs;      // Elapsed session time when captured
+  int64_t capturedAtMs;   // Clock reading when captured
+  int64_t questionElapsedMs;
+  int64_t blockElapsedMs;
+  int currentTime;
+  int totalTime;
+  int currentQuestion;
+  int currentBlock;
+  int blockCount;
+  int questionsInBlock;
+  int questionTimeElapsed;
+  int blockTimeElapsed;
+  int questionLength;
+  int blockLength;
+  int questionProgress;   // Filled pixels at the capturing bar widths
+  int blockProgress;
+  bool inBreak;
+  bool paused;
+  bool stopped;
+
+  bool IsRunning() const { return !paused && !stopped; }
+
+  // Elapsed session time at clock reading nowMs.
+  int64_t ElapsedMillisecondsAt(int64_t nowMs) const {
+    return IsRunning() ? elapsedMs + (nowMs - capturedAtMs) : elapsedMs;
+  }
+
+  // True if both would draw the same frame at the capturing bar widths.
+  bool SameDisplay(const TimerSnapshot& other) const;
+};
+
+// Captures state, measuring progress in bars of the given widths.
+TimerSnapshot CaptureTimerSnapshot(const TimerState& state,
+                                   int questionBarWidth, int blockBarWidth);
+
+// The record published to other processes for snapshot, captured at wall
+// clock wallNowMs. capturedAtMs carries over, so snapshot must come from a
+// state on the steady clock.
+SharedTimerState ToSharedTimerState(const TimerSnapshot& snapshot,
+                                    int64_t wallNowMs);
+
+// Everything the timer bar displays, formatted once per tick. Diffing two
+// models tells the window exactly which controls need to be touched.
+struct TimerViewModel {
+  wchar_t questionLabel[32];   // "Q: n/m"
+  wchar_t questionTime[16];    // Elapsed time in the current question
+  wchar_t blockLabel[32];      // "Block n/m"
+  wchar_t blockTime[16];       // Remaining time in the current block
+  int questionProgress;        // Filled pixels, 0..question bar width
+  int blockProgress;           // Filled pixels, 0..block bar width
+  const wchar_t* startStopText;
+  const wchar_t* pauseText;
+  bool pauseEnabled;
+};
+
+// Bit flags identifying the fields of TimerViewModel
+enum TimerViewField : unsigned {
+  kViewQuestionLabel = 1u << 0,
+  kViewQuestionTime = 1u << 1,
+  kViewQuestionProgress = 1u << 2,
+  kViewBlockLabel = 1u << 3,
+  kViewBlockTime = 1u << 4,
+  kViewBlockProgress = 1u << 5,
+  kViewStartStopText = 1u << 6,
+  kViewPauseText = 1u << 7,
+  kViewPauseEnabled = 1u << 8,
+};
+
+constexpr unsigned kViewFieldCount = 9;
+constexpr unsigned kViewAllFields = (1u << kViewFieldCount) - 1;
+
+// Formats the current state of the timer bar into view. Progress is measured
+// in pixels of bars of the given widths, so a frame only differs from the last
+// one when a fill edge has actually moved.
+void BuildTimerViewModel(const TimerSnapshot& snapshot, int questionBarWidth,
+                         int blockBarWidth, TimerViewModel* view);
+void BuildTimerViewModel(const TimerState& state, int questionBarWidth,
+                         int blockBarWidth, TimerViewModel* view);
+
+// Remembers the last frame pushed to the controls and reports which fields of
+// a new frame differ from it.
+struct TimerViewDiffer {
+  TimerViewModel rendered = {};
+  bool hasRendered = false;         // false forces a full update
+  uint64_t issuedUpdates = 0;       // Field updates passed to the controls
+  uint64_t suppressedUpdates = 0;   // Field updates skipped as unchanged
+
+  // Returns the TimerViewField mask of fields that must be pushed, and records
+  // next as the rendered frame.
+  unsigned Commit(const TimerViewModel& next);
+
+  // Call after the controls are recreated so the next frame is pushed whole.
+  void Invalidate() { hasRendered = false; }
+};
+
+#endif  // TIMERVIEWMODEL_H
@@ -6,47 +6,130 @@
 #include <uxtheme.h>
 #include <windowsx.h>
 
-#include <cstdio>
+#include <chrono>
+#include <vector>
 
+#include "BackgroundWriter.h"
+#include "BarRenderer.h"
 #include "CoverSquareWindow.h"
+#include "FramePacer.h"
+#include "SessionJournal.h"
+#include "SettingsStore.h"
 #include "SetupDialog.h"
+#include "StateServer.h"
+#include "TimerLayout.h"
+#include "TimerViewModel.h"
+#include "TimingThread.h"
 #include "resource.h"
 
 #pragma comment(lib, "uxtheme.lib")
 
-// Base dimensions at 96 DPI (100% scaling)
-static const int BASE_WINDOW_WIDTH = 600;
-static const int BASE_WINDOW_HEIGHT = 56;
-static const int BASE_ROW_HEIGHT = 26;
-static const int BASE_MARGIN = 4;
-static const int BASE_BTN_WIDTH = 60;
-static const int BASE_BTN_SMALL = 28;
-static const int BASE_LABEL_WIDTH = 70;
-static const int BASE_TIME_WIDTH = 50;
-static const int BASE_FONT_SIZE = 14;
 static const int HOTKEY_ID_TOGGLE_COVER = 0x5301;
 static const int BASE_SCREEN_MARGIN = 0;
+static const char TIMER_SETTINGS_SECTION[] = "TimerBar";
+static const char TIMER_SETTINGS_KEY_WIDTH[] = "width";  // At 96 DPI
+static const wchar_t TIMER_SETTINGS_FILE[] = L"timer_bar.ini";
+static const wchar_t TIMER_FALLBACK_SETTINGS_FILE[] =
+    L".\\session_timer_bar.ini";
+
+// One control font per DPI, created on first use and kept until the window
+// closes, so moving between monitors never recreates a font twice.
+struct TimerFontCache {
+  struct Entry {
+    UINT dpi;
+    HFONT hFont;
+  };
+  std::vector<Entry> fonts;
+
+  HFONT Get(UINT dpi) {
+    for (const Entry& entry : fonts) {
+      if (entry.dpi == dpi) return entry.hFont;
+    }
+    HFONT hFont = CreateFont(
+        -ScaleForDpi(BASE_FONT_SIZE, static_cast<int>(dpi)), 0, 0, 0,
+        FW_NORMAL, FALSE, FALSE, FALSE, DEFAULT_CHARSET, OUT_DEFAULT_PRECIS,
+        CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_SWISS,
+        L"Segoe UI");
+    if (hFont) fonts.push_back({dpi, hFont});
+    return hFont;
+  }
+
+  void Release() {
+    for (const Entry& entry : fonts) DeleteObject(entry.hFont);
+    fonts.clear();
+  }
+};
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+// Waits for the timing thread on a high-resolution waitable timer (Windows
+// 10 1803+), which fires within a fraction of a millisecond without raising
+// the system timer resolution. Older systems get a normal waitable timer.
+struct HighResolutionWaiter : PreciseWaiter {
+  HANDLE hTimer;
+  HANDLE hInterrupt;  // Auto-reset, so a pending Interrupt() is consumed once
+
+  HighResolutionWaiter() {
+    hTimer = CreateWaitableTimerExW(NULL, NULL,
+                                    CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+                                    TIMER_ALL_ACCESS);
+    if (!hTimer) {
+      hTimer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+    }
+    hInterrupt = CreateEvent(NULL, FALSE, FALSE, NULL);
+  }
+
+  ~HighResolutionWaiter() override {
+    if (hTimer) CloseHandle(hTimer);
+    if (hInterrupt) CloseHandle(hInterrupt);
+  }
+
+  void WaitUntil(int64_t deadlineUs) override {
+    HANDLE handles[2] = {hInterrupt, hTimer};
+    DWORD timeoutMs = INFINITE;
+    DWORD count = 1;
+    if (deadlineUs >= 0) {
+      const int64_t remainingUs = deadlineUs - GetSteadyMicroseconds();
+      if (remainingUs <= 0) return;
+      LARGE_INTEGER due;
+      due.QuadPart = -remainingUs * 10;  // Relative, in 100 ns units
+      if (hTimer && SetWaitableTimer(hTimer, &due, 0, NULL, NULL, FALSE)) {
+        count = 2;
+      } else {
+        timeoutMs = static_cast<DWORD>((remainingUs + 999) / 1000);
+      }
+    }
+    WaitForMultipleObjects(count, handles, FALSE, timeoutMs);
+  }
+
+  void Interrupt() override { SetEvent(hInterrupt); }
+};
 
 // Window data stored in GWLP_USERDATA
 struct TimerWindowData {
   HINSTANCE hInstance;
-  TimerState state;
-  HFONT hFont;
+  HighResolutionWaiter waiter;  // Outlives timing, which waits on it
+  TimingThread timing;          // Owns the TimerState
+  bool completed;               // The completion message is showing
+  TimerViewDiffer view;  // Last frame pushed to the child controls
+  TimerFontCache fonts;
+  HFONT hFont;  // Font of the child controls, owned by fonts
   HBRUSH hBackBrush;
 
   // DPI scaling
   UINT dpi;
   float dpiScale;
 
-  // Scaled dimensions
-  int windowWidth;
-  int windowHeight;
-  int rowHeight;
-  int margin;
-  int btnWidth;
-  int btnSmall;
-  int labelWidth;
-  int timeWidth;
+  // Geometry of every child control (or owner-drawn element) at dpi
+  TimerLayout layout;
+
+  // Live resizing: at most one layout pass per display frame
+  int barWidth;      // Width chosen by the user at 96 DPI, 0 = default
+  int pendingWidth;  // Newest client width not laid out yet
+  FramePacer layoutPacer;
+  bool layoutTimerArmed;
 
   // Child controls
   HWND hLabelQuestion;
@@ -61,21 +144,50 @@ struct TimerWindowData {
   HWND hBtnClose;
   HWND hBtnSettings;
   HWND hCoverSquare;
+
+  // Owner-draw mode: the whole bar is painted into one DIB section
+  bool ownerDraw;
+  BarRenderer renderer;
+  GlyphAtlasCache glyphs;
+  HDC hBackDC;
+  HBITMAP hBackBitmap;
+  HGDIOBJ hOldBitmap;
+
   bool coverHotkeyRegistered;
   bool squareOnlyMode;
 
-  // Scale a value by DPI
-  int Scale(int value) const { return MulDiv(value, dpi, 96); }
+  // Sequence number of the next session checkpoint
+  uint32_t checkpointSequence;
+
+  // Everything that happens in the session, flushed in batches
+  SessionJournal journal;
+  std::vector<TimerEvent> pendingEvents;  // Reused for TakeEvents()
+
+  // Live state for overlays and proctoring tools in other processes
+  SharedTimerStatePublisher sharedState;
+  // ... and for browser dashboards on this machine
+  StateServer stateServer;
 
   void ComputeScaledDimensions() {
-    windowWidth = Scale(BASE_WINDOW_WIDTH);
-    windowHeight = Scale(BASE_WINDOW_HEIGHT);
-    rowHeight = Scale(BASE_ROW_HEIGHT);
-    margin = Scale(BASE_MARGIN);
-    btnWidth = Scale(BASE_BTN_WIDTH);
-    btnSmall = Scale(BASE_BTN_SMALL);
-    labelWidth = Scale(BASE_LABEL_WIDTH);
-    timeWidth = Scale(BASE_TIME_WIDTH);
+    const int scaledWidth =
+        barWidth > 0 ? ScaleForDpi(barWidth, static_cast<int>(dpi)) : 0;
+    layout = ComputeTimerLayout(static_cast<int>(dpi), scaledWidth);
+  }
+
+  int QuestionBarWidth() const {
+    return layout.rects[kElementQuestionProgress].Width();
+  }
+  int BlockBarWidth() const { return layout.rects[kElementBlockProgress].Width(); }
+};
+
+// Receives every timer transition delivered to the window on a tick.
+struct TimerWindowEvents {
+  bool completed = false;
+
+  void OnTimerEvent(const TimerEvent& event) {
+    if (event.type == TimerEventType::Completed) {
+      completed = true;
+    }
   }
 };
 
@@ -143,6 +255,138 @@ static bool IsTimingConfigChanged(const TimerConfig& oldConfig,
 
 static void UpdateUI(HWND hWnd);
 static void CreateChildControls(HWND hWnd, TimerWindowData* pData);
+static void ApplyChildLayout(HWND hWnd, TimerWindowData* pData);
+static void RebuildBackBuffer(HWND hWnd, TimerWindowData* pData);
+static void ScheduleNextTick(HWND hWnd, TimerWindowData* pData);
+
+// What WM_CREATE receives through lpCreateParams
+struct TimerCreateParams {
+  const TimerConfig* config;
+  const SessionCheckpoint* previous;
+};
+
+// Records where the session stands so a crash or reboot can resume it. The
+// record is anchored to the wall clock, so it only needs rewriting when the
+// session changes state, never on ticks. Inactive records mark a session
+// that ended or was never timed (cover-only mode).
+static void SaveCheckpoint(TimerWindowData* pData, bool active) {
+  const int64_t now = GetWallClockMilliseconds();
+  const uint32_t sequence = pData->checkpointSequence++;
+  SaveSessionCheckpoint(
+      pData->timing.Inspect([&](const TimerState& state) {
+        return CaptureSessionCheckpoint(state, now, sequence, active);
+      }),
+      &GetBackgroundWriter());
+}
+
+static void FlushJournalIfDue(TimerWindowData* pData, int64_t wallNowMs) {
+  if (pData->journal.NeedsFlush(wallNowMs)) {
+    pData->journal.FlushTo(&GetBackgroundWriter());
+  }
+}
+
+// Adds a record of what the user (or the settings panel) just did.
+static void LogSession(TimerWindowData* pData, JournalRecordType type) {
+  const int64_t now = GetWallClockMilliseconds();
+  pData->journal.Append(
+      pData->timing.Inspect([&](const TimerState& state) {
+        return MakeJournalRecord(type, state, now);
+      }));
+  FlushJournalIfDue(pData, now);
+}
+
+// The timer bar's own settings (its width), loaded on first use only.
+static SettingsStore& GetTimerSettings() {
+  static SettingsStore store;
+  static bool loaded = false;
+  if (!loaded) {
+    const std::filesystem::path& dir = GetSettingsDirectory();
+    store.Load(dir.empty()
+                   ? std::filesystem::path(TIMER_FALLBACK_SETTINGS_FILE)
+                   : dir / TIMER_SETTINGS_FILE);
+    loaded = true;
+  }
+  return store;
+}
+
+static int64_t NowMicroseconds() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Refresh rate of the monitor showing hWnd in Hz, or 0 if unknown.
+static int GetMonitorRefreshRate(HWND hWnd) {
+  MONITORINFOEX monitor = {};
+  monitor.cbSize = sizeof(monitor);
+  if (!GetMonitorInfo(MonitorFromWindow(hWnd, MONITOR_DEFAULTTONEAREST),
+                      &monitor)) {
+    return 0;
+  }
+  DEVMODE mode = {};
+  mode.dmSize = sizeof(mode);
+  if (!EnumDisplaySettings(monitor.szDevice, ENUM_CURRENT_SETTINGS, &mode)) {
+    return 0;
+  }
+  return static_cast<int>(mode.dmDisplayFrequency);
+}
+
+// Lays the bar out for the newest width seen while resizing, in place.
+static void ApplyPendingWidth(HWND hWnd, TimerWindowData* pData) {
+  if (pData->layoutTimerArmed) {
+    KillTimer(hWnd, IDT_LAYOUT);
+    pData->layoutTimerArmed = false;
+  }
+  if (!pData->layoutPacer.pending) return;
+
+  const int dpi = static_cast<int>(pData->dpi);
+  pData->layout = ComputeTimerLayout(dpi, pData->pendingWidth);
+  pData->barWidth = MulDiv(pData->layout.windowWidth, 96, dpi);
+  if (pData->ownerDraw) {
+    RebuildBackBuffer(hWnd, pData);
+  } else {
+    ApplyChildLayout(hWnd, pData);
+    UpdateUI(hWnd);
+  }
+  ScheduleNextTick(hWnd, pData);  // Bar widths changed
+  pData->layoutPacer.OnApplied(NowMicroseconds());
+}
+
+// Applies a pending width now if a frame has passed since the last layout,
+// otherwise arms a one-shot timer for the start of the next frame.
+static void PaceRelayout(HWND hWnd, TimerWindowData* pData) {
+  const int64_t delayUs =
+      pData->layoutPacer.DelayUntilNextFrameUs(NowMicroseconds());
+  if (delayUs < 0) return;
+  if (delayUs == 0) {
+    ApplyPendingWidth(hWnd, pData);
+    return;
+  }
+  SetTimer(hWnd, IDT_LAYOUT, static_cast<UINT>((delayUs + 999) / 1000), NULL);
+  pData->layoutTimerArmed = true;
+}
+
+static void SaveBarWidth(TimerWindowData* pData) {
+  SettingsStore& settings = GetTimerSettings();
+  settings.SetInt(TIMER_SETTINGS_SECTION, TIMER_SETTINGS_KEY_WIDTH,
+                  pData->barWidth);
+  settings.FlushTo(&GetBackgroundWriter());
+}
+
+// Tells the timing thread what the window shows, so it wakes for the next
+// moment the output can change (a whole second of elapsed session time, or a
+// progress bar edge crossing a pixel) and sleeps while paused, stopped or
+// hidden behind the cover-only mode.
+static void ScheduleNextTick(HWND hWnd, TimerWindowData* pData) {
+  pData->timing.SetViewport(IsWindowVisible(hWnd) != FALSE,
+                            pData->QuestionBarWidth(), pData->BlockBarWidth());
+}
+
+static TimerSnapshot ReadTimerSnapshot(const TimerWindowData* pData) {
+  TimerSnapshot snapshot;
+  pData->timing.ReadSnapshot(&snapshot);
+  return snapshot;
+}
 
 static void ToggleCoverSquareWindow(HWND hCoverSquare) {
   if (!hCoverSquare || !IsWindow(hCoverSquare)) {
@@ -158,37 +402,211 @@ static void ToggleCoverSquareWindow(HWND hCoverSquare) {
   }
 }
 
-static void DestroyChildControls(TimerWindowData* pData) {
-  if (!pData) return;
+// Child control showing element, or NULL in owner-draw mode
+static HWND GetChildControl(const TimerWindowData* pData, int element) {
+  switch (element) {
+    case kElementQuestionLabel:
+      return pData->hLabelQuestion;
+    case kElementQuestionTime:
+      return pData->hLabelQuestionTime;
+    case kElementQuestionProgress:
+      return pData->hProgressQuestion;
+    case kElementSettingsButton:
+      return pData->hBtnSettings;
+    case kElementCloseButton:
+      return pData->hBtnClose;
+    case kElementBlockLabel:
+      return pData->hLabelBlock;
+    case kElementBlockTime:
+      return pData->hLabelBlockTime;
+    case kElementBlockProgress:
+      return pData->hProgressBlock;
+    case kElementStartStopButton:
+      return pData->hBtnStartStop;
+    case kElementPauseButton:
+      return pData->hBtnPause;
+  }
+  return NULL;
+}
 
-  HWND controls[] = {
-      pData->hLabelQuestion,   pData->hLabelQuestionTime, pData->hProgressQuestion,
-      pData->hBtnStartStop,    pData->hLabelBlock,        pData->hLabelBlockTime,
-      pData->hProgressBlock,   pData->hBtnPause,          pData->hBtnClose,
-      pData->hBtnSettings,
-  };
+// Moves every existing child control to pData->layout in one DeferWindowPos
+// batch and gives it the font for the current DPI. Controls are never
+// destroyed or recreated, so their state (text, enabled) carries over.
+static void ApplyChildLayout(HWND hWnd, TimerWindowData* pData) {
+  HDWP hdwp = BeginDeferWindowPos(kTimerElementCount);
+  for (int element = 0; hdwp && element < kTimerElementCount; element++) {
+    HWND hCtrl = GetChildControl(pData, element);
+    if (!hCtrl) continue;
+    const BarRect& rc = pData->layout.rects[element];
+    hdwp = DeferWindowPos(hdwp, hCtrl, NULL, rc.left, rc.top, rc.Width(),
+                          rc.Height(), SWP_NOZORDER | SWP_NOACTIVATE);
+  }
+  if (hdwp) EndDeferWindowPos(hdwp);
+
+  HFONT hFont = pData->fonts.Get(pData->dpi);
+  if (hFont && hFont != pData->hFont) {
+    pData->hFont = hFont;
+    for (int element = 0; element < kTimerElementCount; element++) {
+      HWND hCtrl = GetChildControl(pData, element);
+      if (hCtrl) SendMessage(hCtrl, WM_SETFONT, (WPARAM)hFont, FALSE);
+    }
+    RedrawWindow(hWnd, NULL, NULL,
+                 RDW_INVALIDATE | RDW_ERASE | RDW_ALLCHILDREN);
+  }
+
+  // Progress is measured in pixels of the resized bars
+  if (pData->hProgressQuestion) {
+    SendMessage(pData->hProgressQuestion, PBM_SETRANGE32, 0,
+                pData->QuestionBarWidth());
+  }
+  if (pData->hProgressBlock) {
+    SendMessage(pData->hProgressBlock, PBM_SETRANGE32, 0,
+                pData->BlockBarWidth());
+  }
+  pData->view.Invalidate();
+}
+
+// Rasterizes the bar's character set with an antialiased Segoe UI into a
+// coverage atlas (white text on black; the green channel is the coverage).
+static void BuildGdiGlyphAtlas(int dpi, GlyphAtlas* atlas) {
+  HDC hdc = CreateCompatibleDC(NULL);
+  HFONT hFont = CreateFont(-ScaleForDpi(BASE_FONT_SIZE, dpi), 0, 0, 0,
+                           FW_NORMAL, FALSE, FALSE, FALSE, DEFAULT_CHARSET,
+                           OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
+                           ANTIALIASED_QUALITY, DEFAULT_PITCH | FF_SWISS,
+                           L"Segoe UI");
+  HGDIOBJ hOldFont = SelectObject(hdc, hFont);
+
+  TEXTMETRIC tm = {};
+  GetTextMetrics(hdc, &tm);
+
+  atlas->entries.clear();
+  int x = 0;
+  for (int i = 0; i < GlyphAtlasCharCount(); i++) {
+    const wchar_t ch = GlyphAtlasChar(i);
+    SIZE size = {};
+    GetTextExtentPoint32W(hdc, &ch, 1, &size);
+    atlas->entries.push_back({ch, x, size.cx});
+    x += size.cx + 1;  // Keep antialiasing from bleeding into neighbours
+  }
+  atlas->width = x;
+  atlas->height = tm.tmHeight;
+
+  BITMAPINFO bmi = {};
+  bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+  bmi.bmiHeader.biWidth = atlas->width;
+  bmi.bmiHeader.biHeight = -atlas->height;  // Top-down
+  bmi.bmiHeader.biPlanes = 1;
+  bmi.bmiHeader.biBitCount = 32;
+  bmi.bmiHeader.biCompression = BI_RGB;
+
+  void* bits = NULL;
+  HBITMAP hBitmap =
+      CreateDIBSection(hdc, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+  if (hBitmap && bits) {
+    HGDIOBJ hOldBitmap = SelectObject(hdc, hBitmap);
+    PatBlt(hdc, 0, 0, atlas->width, atlas->height, BLACKNESS);
+    SetTextColor(hdc, RGB(255, 255, 255));
+    SetBkMode(hdc, TRANSPARENT);
+    for (const GlyphAtlas::Entry& entry : atlas->entries) {
+      TextOutW(hdc, entry.x, 0, &entry.ch, 1);
+    }
+    GdiFlush();
 
-  for (HWND hCtrl : controls) {
-    if (hCtrl && IsWindow(hCtrl)) {
-      DestroyWindow(hCtrl);
+    const uint32_t* pixels = static_cast<const uint32_t*>(bits);
+    atlas->coverage.resize(static_cast<size_t>(atlas->width) * atlas->height);
+    for (size_t i = 0; i < atlas->coverage.size(); i++) {
+      atlas->coverage[i] = static_cast<uint8_t>((pixels[i] >> 8) & 0xFF);
     }
+    SelectObject(hdc, hOldBitmap);
+  }
+
+  if (hBitmap) DeleteObject(hBitmap);
+  SelectObject(hdc, hOldFont);
+  DeleteObject(hFont);
+  DeleteDC(hdc);
+
+  if (atlas->coverage.empty()) {
+    BuildBuiltinGlyphAtlas(dpi, atlas);
+  }
+}
+
+static void ReleaseBackBuffer(TimerWindowData* pData) {
+  if (pData->hBackDC) {
+    SelectObject(pData->hBackDC, pData->hOldBitmap);
+    DeleteDC(pData->hBackDC);
+    pData->hBackDC = NULL;
+  }
+  if (pData->hBackBitmap) {
+    DeleteObject(pData->hBackBitmap);
+    pData->hBackBitmap = NULL;
+  }
+  pData->hOldBitmap = NULL;
+  pData->renderer.surface.Attach(nullptr, 0, 0);
+}
+
+// Sizes the owner-draw back buffer for the current DPI and repaints it whole.
+static void RebuildBackBuffer(HWND hWnd, TimerWindowData* pData) {
+  ReleaseBackBuffer(pData);
+
+  BarRenderer& renderer = pData->renderer;
+  renderer.layout = pData->layout;
+  renderer.atlas = &pData->glyphs.Get(pData->dpi, BuildGdiGlyphAtlas);
+  renderer.pressedElement = -1;
+
+  BITMAPINFO bmi = {};
+  bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+  bmi.bmiHeader.biWidth = renderer.layout.windowWidth;
+  bmi.bmiHeader.biHeight = -renderer.layout.windowHeight;  // Top-down
+  bmi.bmiHeader.biPlanes = 1;
+  bmi.bmiHeader.biBitCount = 32;
+  bmi.bmiHeader.biCompression = BI_RGB;
+
+  HDC hdc = GetDC(hWnd);
+  pData->hBackDC = CreateCompatibleDC(hdc);
+  ReleaseDC(hWnd, hdc);
+
+  void* bits = NULL;
+  pData->hBackBitmap =
+      CreateDIBSection(pData->hBackDC, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+  if (!pData->hBackBitmap || !bits) {
+    ReleaseBackBuffer(pData);
+    return;
   }
+  pData->hOldBitmap = SelectObject(pData->hBackDC, pData->hBackBitmap);
+  renderer.surface.Attach(static_cast<uint32_t*>(bits),
+                          renderer.layout.windowWidth,
+                          renderer.layout.windowHeight);
+
+  TimerViewModel view;
+  BuildTimerViewModel(ReadTimerSnapshot(pData), pData->QuestionBarWidth(),
+                      pData->BlockBarWidth(), &view);
+  renderer.RenderAll(view);
+  pData->view.Commit(view);
+  InvalidateRect(hWnd, NULL, FALSE);
+}
 
-  pData->hLabelQuestion = NULL;
-  pData->hLabelQuestionTime = NULL;
-  pData->hProgressQuestion = NULL;
-  pData->hBtnStartStop = NULL;
-  pData->hLabelBlock = NULL;
-  pData->hLabelBlockTime = NULL;
-  pData->hProgressBlock = NULL;
-  pData->hBtnPause = NULL;
-  pData->hBtnClose = NULL;
-  pData->hBtnSettings = NULL;
+static void InvalidateDirtyRects(HWND hWnd, const BarRenderer& renderer) {
+  for (int i = 0; i < renderer.dirtyCount; i++) {
+    const BarRect& dirty = renderer.dirty[i];
+    RECT rc = {dirty.left, dirty.top, dirty.right, dirty.bottom};
+    InvalidateRect(hWnd, &rc, FALSE);
+  }
+}
 
-  if (pData->hFont) {
-    DeleteObject(pData->hFont);
-    pData->hFont = NULL;
+// Command sent when an owner-drawn button is clicked
+static int GetTimerElementCommand(int element) {
+  switch (element) {
+    case kElementSettingsButton:
+      return IDC_BTN_SETTINGS;
+    case kElementCloseButton:
+      return IDC_BTN_CLOSE;
+    case kElementStartStopButton:
+      return IDC_BTN_START_STOP;
+    case kElementPauseButton:
+      return IDC_BTN_PAUSE;
   }
+  return 0;
 }
 
 static void EnsureCoverVisible(HWND hCoverSquare) {
@@ -198,44 +616,44 @@ static void EnsureCoverVisible(HWND hCoverSquare) {
                SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
 }
 
-static void RebuildTimerControls(HWND hWnd, TimerWindowData* pData) {
-  if (!pData) return;
-  pData->ComputeScaledDimensions();
-  SetWindowPos(hWnd, NULL, 0, 0, pData->windowWidth, pData->windowHeight,
-               SWP_NOMOVE | SWP_NOZORDER);
-  DestroyChildControls(pData);
-  CreateChildControls(hWnd, pData);
-}
-
 static void ApplyConfigAndState(HWND hWnd, TimerWindowData* pData,
                                 const TimerConfig& newConfig, bool wasStopped,
                                 bool wasPaused, bool timingChanged) {
   SetLayeredWindowAttributes(hWnd, 0, (BYTE)(255 * newConfig.transparency / 100),
                              LWA_ALPHA);
 
-  if (timingChanged) {
-    pData->state.Initialize(newConfig);
-    if (wasStopped) {
-      pData->state.Stop();
-    } else if (wasPaused) {
-      pData->state.paused = true;
-    }
-    RebuildTimerControls(hWnd, pData);
-  } else {
-    pData->state.config.transparency = newConfig.transparency;
-    if (!wasStopped) {
-      pData->state.paused = wasPaused;
+  pData->timing.Command([&](TimerState& state) {
+    if (timingChanged) {
+      state.Initialize(newConfig);
+      if (wasStopped) {
+        state.Stop();
+      } else if (wasPaused) {
+        state.SetPaused(true);
+      }
+    } else {
+      state.config.transparency = newConfig.transparency;
+      if (!wasStopped) {
+        state.SetPaused(wasPaused);
+      }
     }
+  });
+  if (timingChanged) {
+    pData->view.Invalidate();  // New totals; the layout is unchanged
   }
 }
 
 static void EnterCoverOnlyMode(HWND hWnd, TimerWindowData* pData) {
   if (!pData) return;
   pData->squareOnlyMode = true;
-  pData->state.Stop();
-  pData->state.paused = false;
+  pData->timing.Command([](TimerState& state) {
+    state.Stop();
+    state.SetPaused(false);
+  });
+  LogSession(pData, JournalRecordType::Stopped);
+  SaveCheckpoint(pData, false);
   UpdateUI(hWnd);
   ShowWindow(hWnd, SW_HIDE);
+  ScheduleNextTick(hWnd, pData);
   EnsureCoverVisible(pData->hCoverSquare);
 }
 
@@ -243,23 +661,31 @@ static void OpenSettingsPanel(HWND hWnd, TimerWindowData* pData) {
   if (!pData) return;
 
   const bool wasSquareOnly = pData->squareOnlyMode;
-  const bool wasStopped = pData->state.stopped;
-  const bool wasPaused = pData->state.paused;
-  const bool wasRunning = pData->state.IsRunning();
+  const TimerConfig oldConfig = pData->timing.Inspect(
+      [](const TimerState& state) { return state.config; });
+  const TimerSnapshot before = ReadTimerSnapshot(pData);
+  const bool wasStopped = before.stopped;
+  const bool wasPaused = before.paused;
+  const bool wasRunning = before.IsRunning();
 
   if (wasRunning) {
-    pData->state.TogglePause();
+    pData->timing.Command([](TimerState& state) { state.SetPaused(true); });
+    LogSession(pData, JournalRecordType::Paused);
+    SaveCheckpoint(pData, !wasSquareOnly);
     UpdateUI(hWnd);
+    ScheduleNextTick(hWnd, pData);
   }
 
-  TimerConfig newConfig = pData->state.config;
+  TimerConfig newConfig = oldConfig;
   const HWND hParent = wasSquareOnly ? NULL : hWnd;
   const SetupDialogResult result =
       ShowSettingsDialog(pData->hInstance, hParent, newConfig);
 
   if (result == SetupDialogResult::Cancelled) {
     if (wasRunning) {
-      pData->state.TogglePause();
+      pData->timing.Command([](TimerState& state) { state.SetPaused(false); });
+      LogSession(pData, JournalRecordType::Resumed);
+      SaveCheckpoint(pData, !wasSquareOnly);
     }
     if (wasSquareOnly) {
       pData->squareOnlyMode = true;
@@ -267,11 +693,13 @@ static void OpenSettingsPanel(HWND hWnd, TimerWindowData* pData) {
       EnsureCoverVisible(pData->hCoverSquare);
     }
     UpdateUI(hWnd);
+    ScheduleNextTick(hWnd, pData);
     return;
   }
 
-  const bool timingChanged = IsTimingConfigChanged(pData->state.config, newConfig);
+  const bool timingChanged = IsTimingConfigChanged(oldConfig, newConfig);
   ApplyConfigAndState(hWnd, pData, newConfig, wasStopped, wasPaused, timingChanged);
+  LogSession(pData, JournalRecordType::ConfigChanged);
 
   if (result == SetupDialogResult::SquareOnly) {
     EnterCoverOnlyMode(hWnd, pData);
@@ -283,190 +711,119 @@ static void OpenSettingsPanel(HWND hWnd, TimerWindowData* pData) {
     ShowWindow(hWnd, SW_SHOWNORMAL);
     SetForegroundWindow(hWnd);
   } else if (wasRunning && !timingChanged) {
-    pData->state.TogglePause();
+    pData->timing.Command([](TimerState& state) { state.SetPaused(false); });
   }
+  if (wasRunning && ReadTimerSnapshot(pData).IsRunning()) {
+    LogSession(pData, JournalRecordType::Resumed);
+  }
+  SaveCheckpoint(pData, true);
 
   UpdateUI(hWnd);
+  ScheduleNextTick(hWnd, pData);
 }
 
 static void UpdateUI(HWND hWnd) {
   TimerWindowData* pData = GetWindowData(hWnd);
   if (!pData) return;
 
-  TimerState& state = pData->state;
-  wchar_t buf[64];
-
-  // Update question label
-  if (pData->hLabelQuestion) {
-    swprintf_s(buf, L"Q: %d/%d", state.currentQuestion, state.config.numQuestions);
-    SetWindowText(pData->hLabelQuestion, buf);
+  // Only touch controls whose content changed since the last frame; every
+  // SetWindowText/PBM_SETPOS repaints part of the layered window.
+  TimerViewModel view;
+  BuildTimerViewModel(ReadTimerSnapshot(pData), pData->QuestionBarWidth(),
+                      pData->BlockBarWidth(), &view);
+  const unsigned changed = pData->view.Commit(view);
+
+  if (pData->ownerDraw) {
+    if (!pData->renderer.surface.pixels) return;
+    GdiFlush();  // GDI must be done with the DIB before we write to it
+    pData->renderer.Render(view, changed);
+    InvalidateDirtyRects(hWnd, pData->renderer);
+    return;
   }
 
-  // Update question time
-  if (pData->hLabelQuestionTime) {
-    TimerState::FormatTime(state.questionTimeElapsed, buf, 64);
-    SetWindowText(pData->hLabelQuestionTime, buf);
+  if ((changed & kViewQuestionLabel) && pData->hLabelQuestion) {
+    SetWindowText(pData->hLabelQuestion, view.questionLabel);
   }
-
-  // Update question progress bar
-  if (pData->hProgressQuestion) {
-    SendMessage(pData->hProgressQuestion, PBM_SETPOS, state.GetQuestionProgress(),
-                0);
+  if ((changed & kViewQuestionTime) && pData->hLabelQuestionTime) {
+    SetWindowText(pData->hLabelQuestionTime, view.questionTime);
   }
-
-  // Update block label
-  if (pData->hLabelBlock) {
-    swprintf_s(buf, L"Block %d/%d", state.currentBlock, state.config.numBlocks);
-    SetWindowText(pData->hLabelBlock, buf);
+  if ((changed & kViewQuestionProgress) && pData->hProgressQuestion) {
+    SendMessage(pData->hProgressQuestion, PBM_SETPOS, view.questionProgress, 0);
   }
-
-  // Update block time (show remaining time in current block)
-  if (pData->hLabelBlockTime) {
-    int blockRemaining = state.config.timePerBlockSeconds - state.blockTimeElapsed;
-    TimerState::FormatTime(blockRemaining, buf, 64);
-    SetWindowText(pData->hLabelBlockTime, buf);
+  if ((changed & kViewBlockLabel) && pData->hLabelBlock) {
+    SetWindowText(pData->hLabelBlock, view.blockLabel);
   }
-
-  // Update block progress bar
-  if (pData->hProgressBlock) {
-    SendMessage(pData->hProgressBlock, PBM_SETPOS, state.GetBlockProgress(), 0);
+  if ((changed & kViewBlockTime) && pData->hLabelBlockTime) {
+    SetWindowText(pData->hLabelBlockTime, view.blockTime);
   }
-
-  // Update button states
-  if (state.stopped) {
-    SetWindowText(pData->hBtnStartStop, L"Start");
-    EnableWindow(pData->hBtnPause, FALSE);
-  } else {
-    SetWindowText(pData->hBtnStartStop, L"Stop");
-    EnableWindow(pData->hBtnPause, TRUE);
+  if ((changed & kViewBlockProgress) && pData->hProgressBlock) {
+    SendMessage(pData->hProgressBlock, PBM_SETPOS, view.blockProgress, 0);
   }
-
-  if (state.paused) {
-    SetWindowText(pData->hBtnPause, L"Resume");
-  } else {
-    SetWindowText(pData->hBtnPause, L"Pause");
+  if (changed & kViewStartStopText) {
+    SetWindowText(pData->hBtnStartStop, view.startStopText);
+  }
+  if (changed & kViewPauseText) {
+    SetWindowText(pData->hBtnPause, view.pauseText);
+  }
+  if (changed & kViewPauseEnabled) {
+    EnableWindow(pData->hBtnPause, view.pauseEnabled ? TRUE : FALSE);
   }
 }
 
+// Creates a visible child control at element's place in pData->layout.
+static HWND CreateChildControl(HWND hWnd, TimerWindowData* pData, int element,
+                               const wchar_t* className, const wchar_t* text,
+                               DWORD style, int id) {
+  const BarRect& rc = pData->layout.rects[element];
+  return CreateWindow(className, text, WS_CHILD | WS_VISIBLE | style, rc.left,
+                      rc.top, rc.Width(), rc.Height(), hWnd,
+                      (HMENU)(INT_PTR)id, pData->hInstance, NULL);
+}
+
 static void CreateChildControls(HWND hWnd, TimerWindowData* pData) {
-  HINSTANCE hInst = pData->hInstance;
-
-  pData->hLabelQuestion = NULL;
-  pData->hLabelQuestionTime = NULL;
-  pData->hProgressQuestion = NULL;
-  pData->hBtnStartStop = NULL;
-  pData->hLabelBlock = NULL;
-  pData->hLabelBlockTime = NULL;
-  pData->hProgressBlock = NULL;
-  pData->hBtnPause = NULL;
-  pData->hBtnClose = NULL;
-  pData->hBtnSettings = NULL;
-
-  // Create DPI-scaled font
-  int fontSize = pData->Scale(BASE_FONT_SIZE);
-  pData->hFont =
-      CreateFont(-fontSize, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-                 DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                 CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_SWISS, L"Segoe UI");
-
-  // Use scaled dimensions
-  int margin = pData->margin;
-  int rowHeight = pData->rowHeight;
-  int labelWidth = pData->labelWidth;
-  int timeWidth = pData->timeWidth;
-  int btnWidth = pData->btnWidth;
-  int btnSmall = pData->btnSmall;
-  int windowWidth = pData->windowWidth;
-
-  // Row 1: Question info
-  int x = margin;
-  int y = margin;
-
-  // Question label
+  // Row 1: Question info, settings (gear) and close (X) buttons
   pData->hLabelQuestion =
-      CreateWindow(L"STATIC", L"Q: 1/5", WS_CHILD | WS_VISIBLE | SS_LEFT, x,
-                   y + pData->Scale(3), labelWidth, rowHeight - pData->Scale(6),
-                   hWnd, (HMENU)IDC_STATIC_QUESTION, hInst, NULL);
-  x += labelWidth;
-
-  // Question time
+      CreateChildControl(hWnd, pData, kElementQuestionLabel, L"STATIC",
+                         L"Q: 1/5", SS_LEFT, IDC_STATIC_QUESTION);
   pData->hLabelQuestionTime =
-      CreateWindow(L"STATIC", L"00:00", WS_CHILD | WS_VISIBLE | SS_CENTER, x,
-                   y + pData->Scale(3), timeWidth, rowHeight - pData->Scale(6),
-                   hWnd, (HMENU)IDC_STATIC_QUESTION_TIME, hInst, NULL);
-  x += timeWidth;
-
-  // Question progress bar
-  int progressWidth = windowWidth - x - btnSmall * 2 - margin * 5;
-  pData->hProgressQuestion = CreateWindow(
-      PROGRESS_CLASS, NULL, WS_CHILD | WS_VISIBLE | PBS_SMOOTH, x,
-      y + pData->Scale(4), progressWidth, rowHeight - pData->Scale(10), hWnd,
-      (HMENU)IDC_PROGRESS_QUESTION, hInst, NULL);
+      CreateChildControl(hWnd, pData, kElementQuestionTime, L"STATIC",
+                         L"00:00", SS_CENTER, IDC_STATIC_QUESTION_TIME);
+  pData->hProgressQuestion =
+      CreateChildControl(hWnd, pData, kElementQuestionProgress,
+                         PROGRESS_CLASS, NULL, PBS_SMOOTH,
+                         IDC_PROGRESS_QUESTION);
   SetWindowTheme(pData->hProgressQuestion, L"", L"");
-  SendMessage(pData->hProgressQuestion, PBM_SETRANGE, 0, MAKELPARAM(0, 100));
   SendMessage(pData->hProgressQuestion, PBM_SETBARCOLOR, 0, RGB(0, 180, 0));
   SendMessage(pData->hProgressQuestion, PBM_SETBKCOLOR, 0, RGB(220, 220, 220));
-  x += progressWidth + margin;
-
-  // Settings button (gear) - top row
-  pData->hBtnSettings = CreateWindow(
-      L"BUTTON", L"\u2699", WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON, x,
-      y + pData->Scale(1), btnSmall, rowHeight - pData->Scale(4), hWnd,
-      (HMENU)IDC_BTN_SETTINGS, hInst, NULL);
-  x += btnSmall + margin;
-
-  // Close button (red X) - top row
+  pData->hBtnSettings =
+      CreateChildControl(hWnd, pData, kElementSettingsButton, L"BUTTON",
+                         L"\u2699", BS_PUSHBUTTON, IDC_BTN_SETTINGS);
   pData->hBtnClose =
-      CreateWindow(L"BUTTON", L"X", WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON, x,
-                   y + pData->Scale(1), btnSmall, rowHeight - pData->Scale(4),
-                   hWnd, (HMENU)IDC_BTN_CLOSE, hInst, NULL);
-
-  // Row 2: Block info
-  x = margin;
-  y = margin + rowHeight;
-
-  pData->hLabelBlock = CreateWindow(
-      L"STATIC", L"Block 1/3", WS_CHILD | WS_VISIBLE | SS_LEFT, x,
-      y + pData->Scale(3), labelWidth, rowHeight - pData->Scale(6), hWnd,
-      (HMENU)IDC_STATIC_BLOCK, hInst, NULL);
-  x += labelWidth;
-
-  pData->hLabelBlockTime = CreateWindow(
-      L"STATIC", L"00:00", WS_CHILD | WS_VISIBLE | SS_CENTER, x,
-      y + pData->Scale(3), timeWidth, rowHeight - pData->Scale(6), hWnd,
-      (HMENU)IDC_STATIC_BLOCK_TIME, hInst, NULL);
-  x += timeWidth;
-
-  int blockProgressWidth = windowWidth - x - btnWidth * 2 - margin * 5;
-  pData->hProgressBlock = CreateWindow(
-      PROGRESS_CLASS, NULL, WS_CHILD | WS_VISIBLE | PBS_SMOOTH, x,
-      y + pData->Scale(4), blockProgressWidth, rowHeight - pData->Scale(10),
-      hWnd, (HMENU)IDC_PROGRESS_BLOCK, hInst, NULL);
+      CreateChildControl(hWnd, pData, kElementCloseButton, L"BUTTON", L"X",
+                         BS_PUSHBUTTON, IDC_BTN_CLOSE);
+
+  // Row 2: Block info, start/stop and pause buttons
+  pData->hLabelBlock =
+      CreateChildControl(hWnd, pData, kElementBlockLabel, L"STATIC",
+                         L"Block 1/3", SS_LEFT, IDC_STATIC_BLOCK);
+  pData->hLabelBlockTime =
+      CreateChildControl(hWnd, pData, kElementBlockTime, L"STATIC", L"00:00",
+                         SS_CENTER, IDC_STATIC_BLOCK_TIME);
+  pData->hProgressBlock =
+      CreateChildControl(hWnd, pData, kElementBlockProgress, PROGRESS_CLASS,
+                         NULL, PBS_SMOOTH, IDC_PROGRESS_BLOCK);
   SetWindowTheme(pData->hProgressBlock, L"", L"");
-  SendMessage(pData->hProgressBlock, PBM_SETRANGE, 0, MAKELPARAM(0, 100));
   SendMessage(pData->hProgressBlock, PBM_SETBARCOLOR, 0, RGB(0, 120, 215));
   SendMessage(pData->hProgressBlock, PBM_SETBKCOLOR, 0, RGB(220, 220, 220));
-  x += blockProgressWidth + margin;
-
-  pData->hBtnStartStop = CreateWindow(
-      L"BUTTON", L"Start", WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON, x,
-      y + pData->Scale(1), btnWidth, rowHeight - pData->Scale(4), hWnd,
-      (HMENU)IDC_BTN_START_STOP, hInst, NULL);
-  x += btnWidth + margin;
-
-  pData->hBtnPause = CreateWindow(
-      L"BUTTON", L"Pause", WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON | WS_DISABLED,
-      x, y + pData->Scale(1), btnWidth, rowHeight - pData->Scale(4), hWnd,
-      (HMENU)IDC_BTN_PAUSE, hInst, NULL);
-
-  // Apply font to all controls
-  HWND controls[] = {pData->hLabelQuestion, pData->hLabelQuestionTime,
-                     pData->hLabelBlock,    pData->hLabelBlockTime,
-                     pData->hBtnStartStop,  pData->hBtnPause,
-                     pData->hBtnClose,      pData->hBtnSettings};
-  for (HWND hCtrl : controls) {
-    SendMessage(hCtrl, WM_SETFONT, (WPARAM)pData->hFont, TRUE);
-  }
+  pData->hBtnStartStop =
+      CreateChildControl(hWnd, pData, kElementStartStopButton, L"BUTTON",
+                         L"Start", BS_PUSHBUTTON, IDC_BTN_START_STOP);
+  pData->hBtnPause =
+      CreateChildControl(hWnd, pData, kElementPauseButton, L"BUTTON",
+                         L"Pause", BS_PUSHBUTTON | WS_DISABLED, IDC_BTN_PAUSE);
+
+  // Font and progress ranges
+  ApplyChildLayout(hWnd, pData);
 }
 
 LRESULT CALLBACK TimerWindowProc(HWND hWnd, UINT message, WPARAM wParam,
@@ -476,17 +833,57 @@ LRESULT CALLBACK TimerWindowProc(HWND hWnd, UINT message, WPARAM wParam,
   switch (message) {
     case WM_CREATE: {
       CREATESTRUCT* pcs = reinterpret_cast<CREATESTRUCT*>(lParam);
-      TimerConfig* pConfig =
-          reinterpret_cast<TimerConfig*>(pcs->lpCreateParams);
+      const TimerCreateParams* params =
+          reinterpret_cast<const TimerCreateParams*>(pcs->lpCreateParams);
+      const SessionCheckpoint* previous = params->previous;
 
       // Allocate window data
       pData = new TimerWindowData();
       pData->hInstance = (HINSTANCE)GetWindowLongPtr(hWnd, GWLP_HINSTANCE);
-      pData->state.Initialize(*pConfig);
+      pData->checkpointSequence = previous ? previous->sequence + 1 : 0;
+      pData->journal.path = GetSessionJournalPath();
+      // Another instance may already publish, or hold the port; this one
+      // then just doesn't. Both ignore publications until opened.
+      pData->sharedState.Open();
+      pData->stateServer.Start(
+          StateServer::kDefaultPort, [hWnd](StateCommand command) {
+            return PostMessage(hWnd, WM_REMOTE_COMMAND,
+                               static_cast<WPARAM>(command), 0) != FALSE;
+          });
+      pData->timing.SetPublishHook([pData](const TimerSnapshot& snapshot) {
+        const SharedTimerState state =
+            ToSharedTimerState(snapshot, GetWallClockMilliseconds());
+        pData->sharedState.Publish(state);
+        pData->stateServer.Publish(state);
+      });
+      pData->completed = false;
+      if (previous && previous->active) {
+        // Pick up an interrupted session where the wall clock says it is now
+        pData->timing.Command([&](TimerState& state) {
+          state.Initialize(previous->ToConfig(*params->config));
+          RestoreSessionCheckpoint(*previous, GetWallClockMilliseconds(),
+                                   &state);
+        });
+        LogSession(pData, JournalRecordType::SessionResumed);
+        if (previous->stopped) {
+          LogSession(pData, JournalRecordType::Stopped);
+        } else if (previous->paused) {
+          LogSession(pData, JournalRecordType::Paused);
+        }
+      } else {
+        pData->timing.Command([&](TimerState& state) {
+          state.Initialize(*params->config);
+        });
+        LogSession(pData, JournalRecordType::SessionStarted);
+      }
+      const TimerConfig config = pData->timing.Inspect(
+          [](const TimerState& state) { return state.config; });
+      const TimerConfig* pConfig = &config;
       pData->hBackBrush = CreateSolidBrush(RGB(45, 45, 48));
       pData->hCoverSquare = NULL;
       pData->coverHotkeyRegistered = false;
       pData->squareOnlyMode = false;
+      pData->ownerDraw = pConfig->ownerDraw;
 
       // Get DPI for this window
       pData->dpi = GetDpiForWindow(hWnd);
@@ -497,16 +894,22 @@ LRESULT CALLBACK TimerWindowProc(HWND hWnd, UINT message, WPARAM wParam,
         ReleaseDC(hWnd, hdc);
       }
       pData->dpiScale = pData->dpi / 96.0f;
+      GetTimerSettings().GetInt(TIMER_SETTINGS_SECTION,
+                                TIMER_SETTINGS_KEY_WIDTH, &pData->barWidth);
       pData->ComputeScaledDimensions();
 
       SetWindowLongPtr(hWnd, GWLP_USERDATA, (LONG_PTR)pData);
 
       // Resize window to DPI-scaled size
-      SetWindowPos(hWnd, NULL, 0, 0, pData->windowWidth, pData->windowHeight,
-                   SWP_NOMOVE | SWP_NOZORDER);
-
-      // Create child controls
-      CreateChildControls(hWnd, pData);
+      SetWindowPos(hWnd, NULL, 0, 0, pData->layout.windowWidth,
+                   pData->layout.windowHeight, SWP_NOMOVE | SWP_NOZORDER);
+
+      // Create child controls, or the back buffer that replaces them
+      if (pData->ownerDraw) {
+        RebuildBackBuffer(hWnd, pData);
+      } else {
+        CreateChildControls(hWnd, pData);
+      }
 
       // Create always-on-top black cover square for hiding answer choices.
       pData->hCoverSquare = CreateCoverSquareWindow(pData->hInstance, hWnd);
@@ -526,26 +929,96 @@ LRESULT CALLBACK TimerWindowProc(HWND hWnd, UINT message, WPARAM wParam,
       SetLayeredWindowAttributes(
           hWnd, 0, (BYTE)(255 * pConfig->transparency / 100), LWA_ALPHA);
 
+      SaveCheckpoint(pData, true);
+
       // Update UI with initial values
       UpdateUI(hWnd);
 
-      // Start the timer (1 second intervals)
-      SetTimer(hWnd, IDT_TIMER, 1000, NULL);
+      // Start ticking, aligned to whole seconds of elapsed session time. The
+      // thread posts WM_TIMING_UPDATE (one at a time) when the bar changes.
+      ScheduleNextTick(hWnd, pData);
+      pData->timing.Start(
+          [hWnd] { return PostMessage(hWnd, WM_TIMING_UPDATE, 0, 0) != FALSE; },
+          &pData->waiter);
 
       return 0;
     }
 
-    case WM_TIMER: {
-      if (wParam == IDT_TIMER && pData) {
-        TickStatus status = pData->state.Tick();
-        UpdateUI(hWnd);
-
-        if (status == TickStatus::Completed) {
-          KillTimer(hWnd, IDT_TIMER);
-          MessageBox(hWnd, L"All blocks completed!", L"Timer Finished",
-                     MB_OK | MB_ICONINFORMATION | MB_TOPMOST);
-          DestroyWindow(hWnd);
+    case WM_TIMING_UPDATE: {
+      if (!pData || pData->completed) return 0;
+
+      // Allow the next notification first, so a change published while we
+      // read is never missed.
+      pData->timing.AcknowledgeNotify();
+      const TimerSnapshot snapshot = ReadTimerSnapshot(pData);
+      const int64_t wallNow = GetWallClockMilliseconds();
+      pData->timing.TakeEvents(&pData->pendingEvents);
+
+      TimerWindowEvents events;
+      JournalEventRecorder journalEvents = {
+          &pData->journal,
+          wallNow - snapshot.ElapsedMillisecondsAt(
+                        GetSteadyTimerClock()->NowMilliseconds())};
+      for (const TimerEvent& event : pData->pendingEvents) {
+        events.OnTimerEvent(event);
+        journalEvents.OnTimerEvent(event);
+      }
+      FlushJournalIfDue(pData, wallNow);
+      UpdateUI(hWnd);
+
+      if (events.completed) {
+        pData->completed = true;
+        MessageBox(hWnd, L"All blocks completed!", L"Timer Finished",
+                   MB_OK | MB_ICONINFORMATION | MB_TOPMOST);
+        DestroyWindow(hWnd);
+      }
+      return 0;
+    }
+
+    case WM_REMOTE_COMMAND: {
+      if (!pData || pData->completed) return 0;
+
+      // Same effect as the buttons, but idempotent: a dashboard asking to
+      // pause a paused timer must not resume it.
+      const TimerSnapshot snapshot = ReadTimerSnapshot(pData);
+      switch (static_cast<StateCommand>(wParam)) {
+        case StateCommand::Start:
+        case StateCommand::Stop:
+          if (snapshot.stopped ==
+              (static_cast<StateCommand>(wParam) == StateCommand::Start)) {
+            SendMessage(hWnd, WM_COMMAND, IDC_BTN_START_STOP, 0);
+          }
+          break;
+        case StateCommand::Pause:
+        case StateCommand::Resume:
+          if (!snapshot.stopped &&
+              snapshot.paused ==
+                  (static_cast<StateCommand>(wParam) == StateCommand::Resume)) {
+            SendMessage(hWnd, WM_COMMAND, IDC_BTN_PAUSE, 0);
+          }
+          break;
+        case StateCommand::NextBlock: {
+          bool skipped = false;
+          pData->timing.Command(
+              [&](TimerState& state) { skipped = state.SkipToNextBlock(); });
+          if (skipped) {
+            SaveCheckpoint(pData, true);
+            UpdateUI(hWnd);
+            ScheduleNextTick(hWnd, pData);
+          }
+          break;
         }
+        case StateCommand::kCount:
+          break;
+      }
+      return 0;
+    }
+
+    case WM_TIMER: {
+      if (wParam == IDT_LAYOUT && pData) {
+        KillTimer(hWnd, IDT_LAYOUT);
+        pData->layoutTimerArmed = false;
+        PaceRelayout(hWnd, pData);
       }
       return 0;
     }
@@ -577,17 +1050,29 @@ LRESULT CALLBACK TimerWindowProc(HWND hWnd, UINT message, WPARAM wParam,
 
       switch (LOWORD(wParam)) {
         case IDC_BTN_START_STOP:
-          if (pData->state.stopped) {
-            pData->state.Start();
-          } else {
-            pData->state.Stop();
-          }
+          pData->timing.Command([](TimerState& state) {
+            if (state.stopped) {
+              state.Start();
+            } else {
+              state.Stop();
+            }
+          });
+          LogSession(pData, ReadTimerSnapshot(pData).stopped
+                                ? JournalRecordType::Stopped
+                                : JournalRecordType::Started);
+          SaveCheckpoint(pData, true);
           UpdateUI(hWnd);
+          ScheduleNextTick(hWnd, pData);
           return 0;
 
         case IDC_BTN_PAUSE:
-          pData->state.TogglePause();
+          pData->timing.Command([](TimerState& state) { state.TogglePause(); });
+          LogSession(pData, ReadTimerSnapshot(pData).paused
+                                ? JournalRecordType::Paused
+                                : JournalRecordType::Resumed);
+          SaveCheckpoint(pData, true);
           UpdateUI(hWnd);
+          ScheduleNextTick(hWnd, pData);
           return 0;
 
         case IDC_BTN_CLOSE:
@@ -608,7 +1093,9 @@ LRESULT CALLBACK TimerWindowProc(HWND hWnd, UINT message, WPARAM wParam,
       SetLayeredWindowAttributes(hWnd, 0, (BYTE)(255 * transparency / 100),
                                  LWA_ALPHA);
       if (pData) {
-        pData->state.config.transparency = transparency;
+        pData->timing.Command([transparency](TimerState& state) {
+          state.config.transparency = transparency;
+        });
       }
       return 0;
     }
@@ -620,39 +1107,68 @@ LRESULT CALLBACK TimerWindowProc(HWND hWnd, UINT message, WPARAM wParam,
         pData->dpiScale = pData->dpi / 96.0f;
         pData->ComputeScaledDimensions();
 
-        // Get suggested new window rect
+        // Use the suggested position, but the exact size of the new layout
         RECT* prcNewWindow = (RECT*)lParam;
         RECT clamped = *prcNewWindow;
+        clamped.right = clamped.left + pData->layout.windowWidth;
+        clamped.bottom = clamped.top + pData->layout.windowHeight;
         ClampRectToVirtualBounds(&clamped, GetTimerVirtualBounds(pData->dpi));
         SetWindowPos(hWnd, NULL, clamped.left, clamped.top,
                      clamped.right - clamped.left, clamped.bottom - clamped.top,
                      SWP_NOZORDER | SWP_NOACTIVATE);
 
-        // Recreate font with new size
-        if (pData->hFont) {
-          DeleteObject(pData->hFont);
-        }
-        int fontSize = pData->Scale(BASE_FONT_SIZE);
-        pData->hFont = CreateFont(-fontSize, 0, 0, 0, FW_NORMAL, FALSE, FALSE,
-                                  FALSE, DEFAULT_CHARSET, OUT_DEFAULT_PRECIS,
-                                  CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY,
-                                  DEFAULT_PITCH | FF_SWISS, L"Segoe UI");
-
-        // Update font on all controls
-        HWND controls[] = {pData->hLabelQuestion, pData->hLabelQuestionTime,
-                           pData->hLabelBlock,    pData->hLabelBlockTime,
-                           pData->hBtnStartStop,  pData->hBtnPause,
-                           pData->hBtnClose,      pData->hBtnSettings};
-        for (HWND hCtrl : controls) {
-          SendMessage(hCtrl, WM_SETFONT, (WPARAM)pData->hFont, TRUE);
+        // Move, resize and re-font the controls in place
+        if (pData->ownerDraw) {
+          RebuildBackBuffer(hWnd, pData);
+        } else {
+          ApplyChildLayout(hWnd, pData);
+          UpdateUI(hWnd);
         }
+        ScheduleNextTick(hWnd, pData);  // Bar widths changed
+      }
+      return 0;
+    }
+
+    case WM_GETMINMAXINFO: {
+      MINMAXINFO* mmi = reinterpret_cast<MINMAXINFO*>(lParam);
+      if (!pData || !mmi) break;
+      const int dpi = pData->layout.dpi;
+      mmi->ptMinTrackSize.x = ScaleForDpi(BASE_MIN_WINDOW_WIDTH, dpi);
+      mmi->ptMaxTrackSize.x = ScaleForDpi(BASE_MAX_WINDOW_WIDTH, dpi);
+      mmi->ptMinTrackSize.y = pData->layout.windowHeight;
+      mmi->ptMaxTrackSize.y = pData->layout.windowHeight;
+      return 0;
+    }
+
+    case WM_ENTERSIZEMOVE:
+      if (pData) {
+        pData->layoutPacer.SetRefreshRate(GetMonitorRefreshRate(hWnd));
+      }
+      return 0;
 
-        // Force redraw
-        InvalidateRect(hWnd, NULL, TRUE);
+    case WM_SIZE: {
+      // Controls follow the new width in place, one layout pass per frame
+      if (!pData || wParam == SIZE_MINIMIZED) break;
+      const int width = LOWORD(lParam);
+      if (width == pData->layout.windowWidth && !pData->layoutPacer.pending) {
+        return 0;
+      }
+      pData->pendingWidth = width;
+      if (pData->layoutPacer.OnInput(NowMicroseconds())) {
+        ApplyPendingWidth(hWnd, pData);
+      } else if (!pData->layoutTimerArmed) {
+        PaceRelayout(hWnd, pData);
       }
       return 0;
     }
 
+    case WM_EXITSIZEMOVE:
+      if (pData) {
+        ApplyPendingWidth(hWnd, pData);
+        SaveBarWidth(pData);
+      }
+      return 0;
+
     case WM_WINDOWPOSCHANGING: {
       WINDOWPOS* wp = reinterpret_cast<WINDOWPOS*>(lParam);
       if (wp && ((wp->flags & SWP_NOMOVE) == 0 || (wp->flags & SWP_NOSIZE) == 0)) {
@@ -672,12 +1188,83 @@ LRESULT CALLBACK TimerWindowProc(HWND hWnd, UINT message, WPARAM wParam,
     case WM_NCHITTEST: {
       // Allow dragging from anywhere on the window
       LRESULT hit = DefWindowProc(hWnd, message, wParam, lParam);
+      if (hit == HTCLIENT && pData) {
+        // Resize horizontally from the left and right edges
+        POINT pt = {GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam)};
+        ScreenToClient(hWnd, &pt);
+        RECT rc;
+        GetClientRect(hWnd, &rc);
+        const int grip = ScaleForDpi(BASE_RESIZE_GRIP, pData->layout.dpi);
+        if (pt.x < grip) return HTLEFT;
+        if (pt.x >= rc.right - grip) return HTRIGHT;
+      }
       if (hit == HTCLIENT) {
+        // Owner-drawn buttons are part of the client area, not child windows
+        if (pData && pData->ownerDraw) {
+          POINT pt = {GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam)};
+          ScreenToClient(hWnd, &pt);
+          if (IsTimerButton(HitTestTimerLayout(pData->renderer.layout, pt.x,
+                                               pt.y))) {
+            return HTCLIENT;
+          }
+        }
         return HTCAPTION;
       }
       return hit;
     }
 
+    case WM_LBUTTONDOWN: {
+      if (!pData || !pData->ownerDraw) break;
+      const int element = HitTestTimerLayout(
+          pData->renderer.layout, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
+      if (!IsTimerButton(element)) return 0;
+      if (element == kElementPauseButton && !pData->view.rendered.pauseEnabled) {
+        return 0;
+      }
+      SetCapture(hWnd);
+      GdiFlush();
+      pData->renderer.SetPressed(element, pData->view.rendered);
+      InvalidateDirtyRects(hWnd, pData->renderer);
+      return 0;
+    }
+
+    case WM_LBUTTONUP: {
+      if (!pData || !pData->ownerDraw) break;
+      const int pressed = pData->renderer.pressedElement;
+      if (pressed < 0) return 0;
+      const int element = HitTestTimerLayout(
+          pData->renderer.layout, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
+      ReleaseCapture();  // Clears the pressed state via WM_CAPTURECHANGED
+
+      // Last: the command may destroy the window and its data
+      if (element == pressed) {
+        SendMessage(hWnd, WM_COMMAND,
+                    MAKEWPARAM(GetTimerElementCommand(element), BN_CLICKED), 0);
+      }
+      return 0;
+    }
+
+    case WM_CAPTURECHANGED: {
+      if (pData && pData->ownerDraw && pData->renderer.surface.pixels) {
+        GdiFlush();
+        pData->renderer.SetPressed(-1, pData->view.rendered);
+        InvalidateDirtyRects(hWnd, pData->renderer);
+      }
+      return 0;
+    }
+
+    case WM_PAINT: {
+      if (!pData || !pData->ownerDraw || !pData->hBackDC) break;
+      PAINTSTRUCT ps;
+      HDC hdc = BeginPaint(hWnd, &ps);
+      BitBlt(hdc, ps.rcPaint.left, ps.rcPaint.top,
+             ps.rcPaint.right - ps.rcPaint.left,
+             ps.rcPaint.bottom - ps.rcPaint.top, pData->hBackDC,
+             ps.rcPaint.left, ps.rcPaint.top, SRCCOPY);
+      EndPaint(hWnd, &ps);
+      return 0;
+    }
+
     case WM_CTLCOLORSTATIC: {
       // Dark background for static controls
       if (pData) {
@@ -690,7 +1277,10 @@ LRESULT CALLBACK TimerWindowProc(HWND hWnd, UINT message, WPARAM wParam,
     }
 
     case WM_ERASEBKGND: {
-      // Dark background
+      // Dark background; the owner-draw back buffer covers every pixel
+      if (pData && pData->ownerDraw) {
+        return 1;
+      }
       if (pData) {
         HDC hdc = (HDC)wParam;
         RECT rc;
@@ -702,8 +1292,16 @@ LRESULT CALLBACK TimerWindowProc(HWND hWnd, UINT message, WPARAM wParam,
     }
 
     case WM_DESTROY: {
-      KillTimer(hWnd, IDT_TIMER);
+      KillTimer(hWnd, IDT_LAYOUT);
       if (pData) {
+        pData->timing.Stop();  // Nothing posts to the window after this
+        pData->timing.SetPublishHook(nullptr);
+        pData->stateServer.Stop();  // Nor does the I/O thread
+        pData->sharedState.Close();
+
+        // The session ended (completed or closed); don't resume it.
+        LogSession(pData, JournalRecordType::SessionEnded);
+        SaveCheckpoint(pData, false);
         if (pData->coverHotkeyRegistered) {
           UnregisterHotKey(hWnd, HOTKEY_ID_TOGGLE_COVER);
           pData->coverHotkeyRegistered = false;
@@ -712,7 +1310,8 @@ LRESULT CALLBACK TimerWindowProc(HWND hWnd, UINT message, WPARAM wParam,
           DestroyWindow(pData->hCoverSquare);
           pData->hCoverSquare = NULL;
         }
-        if (pData->hFont) DeleteObject(pData->hFont);
+        ReleaseBackBuffer(pData);
+        pData->fonts.Release();
         if (pData->hBackBrush) DeleteObject(pData->hBackBrush);
         delete pData;
         SetWindowLongPtr(hWnd, GWLP_USERDATA, 0);
@@ -749,7 +1348,8 @@ bool RegisterTimerWindowClass(HINSTANCE hInstance) {
   return RegisterClassEx(&wc) != 0;
 }
 
-HWND CreateTimerWindow(HINSTANCE hInstance, const TimerConfig& config) {
+HWND CreateTimerWindow(HINSTANCE hInstance, const TimerConfig& config,
+                       const SessionCheckpoint* previous) {
   // Get DPI for primary monitor to calculate initial size
   UINT dpi = 96;
   HDC hdc = GetDC(NULL);
@@ -767,17 +1367,19 @@ HWND CreateTimerWindow(HINSTANCE hInstance, const TimerConfig& config) {
   int screenWidth = GetSystemMetrics(SM_CXSCREEN);
   int x = (screenWidth - scaledWidth) / 2;
 
+  TimerCreateParams params = {&config, previous};
+
   // Create with WS_POPUP (no title bar), WS_EX_TOPMOST (always on top),
   // WS_EX_LAYERED (transparency)
   HWND hWnd = CreateWindowEx(WS_EX_TOPMOST | WS_EX_LAYERED, TIMER_WINDOW_CLASS,
                              L"Wolf-Timer", WS_POPUP | WS_VISIBLE, x,
                              scaledY, scaledWidth, scaledHeight, NULL, NULL,
-                             hInstance, (LPVOID)&config);
+                             hInstance, (LPVOID)&params);
 
   return hWnd;
 }
 
-TimerState* GetTimerState(HWND hWnd) {
+TimingThread* GetTimingThread(HWND hWnd) {
   TimerWindowData* pData = GetWindowData(hWnd);
-  return pData ? &pData->state : nullptr;
+  return pData ? &pData->timing : nullptr;
 }
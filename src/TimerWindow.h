@@ -5,7 +5,8 @@
 
 #include <windows.h>
 
-#include "TimerState.h"
+#include "SessionCheckpoint.h"
+#include "TimingThread.h"
 
 // Window class name
 #define TIMER_WINDOW_CLASS L"WolfTimerWindowClass"
@@ -13,18 +14,25 @@
 // Custom messages
 #define WM_UPDATE_TRANSPARENCY (WM_USER + 100)
 #define WM_ENTER_COVER_ONLY_MODE (WM_APP + 230)
+// Posted by the timing thread when a new snapshot is ready to show
+#define WM_TIMING_UPDATE (WM_APP + 231)
+// Posted by the state server's I/O thread; wParam is a StateCommand
+#define WM_REMOTE_COMMAND (WM_APP + 232)
 
 // Register the timer window class
 bool RegisterTimerWindowClass(HINSTANCE hInstance);
 
-// Create and show the timer window
-HWND CreateTimerWindow(HINSTANCE hInstance, const TimerConfig& config);
+// Create and show the timer window. previous is the newest checkpoint on disk,
+// if any; when it is still active its session is resumed instead of starting
+// a new one with config (which then only supplies ownerDraw).
+HWND CreateTimerWindow(HINSTANCE hInstance, const TimerConfig& config,
+                       const SessionCheckpoint* previous = nullptr);
 
 // Window procedure
 LRESULT CALLBACK TimerWindowProc(HWND hWnd, UINT message, WPARAM wParam,
                                  LPARAM lParam);
 
-// Get timer state for external access
-TimerState* GetTimerState(HWND hWnd);
+// Get the timing thread (which owns the timer state) for external access
+TimingThread* GetTimingThread(HWND hWnd);
 
 #endif  // TIMERWINDOW_H
@@ -0,0 +1,137 @@
+// TimingThread.cpp - Timing loop, snapshot publication and portable waits
+
+#include "TimingThread.h"
+
+#include "TickScheduler.h"
+
+void PortableWaiter::WaitUntil(int64_t deadlineUs) {
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    if (interrupted) {
+      interrupted = false;
+      return;
+    }
+    if (deadlineUs < 0) {
+      wakeup.wait(lock);
+      continue;
+    }
+
+    const int64_t remainingUs = deadlineUs - GetSteadyMicroseconds();
+    if (remainingUs <= 0) return;
+    if (remainingUs > kSpinUs) {
+      const auto sleepUntil =
+          std::chrono::steady_clock::time_point(
+              std::chrono::microseconds(deadlineUs - kSpinUs));
+      wakeup.wait_until(lock, sleepUntil);
+    } else {
+      // Close enough that a timed sleep could overshoot: stay runnable.
+      lock.unlock();
+      std::this_thread::yield();
+      lock.lock();
+    }
+  }
+}
+
+void PortableWaiter::Interrupt() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    interrupted = true;
+  }
+  wakeup.notify_one();
+}
+
+void TimingThread::Start(Notify notifyFn, PreciseWaiter* preciseWaiter) {
+  if (IsRunning()) return;
+  notify = std::move(notifyFn);
+  waiter = preciseWaiter ? preciseWaiter : &portableWaiter;
+  stopping.store(false);
+  thread = std::thread(&TimingThread::Run, this);
+}
+
+void TimingThread::Stop() {
+  if (!IsRunning()) return;
+  stopping.store(true);
+  waiter->Interrupt();
+  thread.join();
+}
+
+void TimingThread::SetViewport(bool isVisible, int questionWidth,
+                               int blockWidth) {
+  Command([&](TimerState&) {
+    visible = isVisible;
+    questionBarWidth = questionWidth;
+    blockBarWidth = blockWidth;
+  });
+}
+
+void TimingThread::SetPublishHook(PublishHook hook) {
+  std::lock_guard<std::mutex> lock(mutex);
+  publishHook = std::move(hook);
+  if (publishHook && hasPublished) publishHook(last);
+}
+
+void TimingThread::TakeEvents(std::vector<TimerEvent>* taken) {
+  taken->clear();
+  std::lock_guard<std::mutex> lock(mutex);
+  taken->swap(events);
+}
+
+bool TimingThread::UpdateLocked() {
+  TimerEventBatch batch;
+  bool transitions = false;
+  bool more = true;
+  while (more) {
+    more = state.Advance(&batch);
+    events.insert(events.end(), batch.events, batch.events + batch.count);
+    transitions |= batch.count > 0;
+  }
+
+  TimerSnapshot next =
+      CaptureTimerSnapshot(state, questionBarWidth, blockBarWidth);
+  if (hasPublished && !transitions && next.SameDisplay(last)) return false;
+
+  next.generation = last.generation + 1;
+  published.Write(next);
+  last = next;
+  hasPublished = true;
+  if (publishHook) publishHook(next);
+  publishes.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void TimingThread::NotifyOnce() {
+  if (!notify || notifyPending.exchange(true)) return;
+  if (notify()) {
+    notifications.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    notifyPending.store(false);
+  }
+}
+
+void TimingThread::Run() {
+  int64_t deadlineUs = -1;
+  for (;;) {
+    bool notifyUi;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (stopping.load()) break;
+
+      const int64_t wokeUs = GetSteadyMicroseconds();
+      const bool dueWake = deadlineUs >= 0 && wokeUs >= deadlineUs;
+      notifyUi = UpdateLocked();
+      if (dueWake) {
+        wakeups.fetch_add(1, std::memory_order_relaxed);
+        wakeLateness.Record((wokeUs - deadlineUs) * 1000);
+        if (notifyUi) {
+          publishLatency.Record((GetSteadyMicroseconds() - deadlineUs) * 1000);
+        }
+      }
+
+      const int64_t delayMs = TickScheduler::NextWakeDelay(
+          state, visible, questionBarWidth, blockBarWidth);
+      deadlineUs = delayMs < 0 ? -1 : GetSteadyMicroseconds() + delayMs * 1000;
+    }
+    if (notifyUi) NotifyOnce();
+    waiter->WaitUntil(deadlineUs);
+  }
+}
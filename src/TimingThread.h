@@ -0,0 +1,169 @@
+// TimingThread.h - Timer engine on its own thread, published lock-free
+
+#ifndef TIMINGTHREAD_H
+#define TIMINGTHREAD_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "BackgroundWriter.h"
+#include "SeqLock.h"
+#include "TimerEvents.h"
+#include "TimerState.h"
+#include "TimerViewModel.h"
+
+// steady_clock in microseconds: the time base of PreciseWaiter deadlines.
+inline int64_t GetSteadyMicroseconds() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Blocks the timing thread until a deadline, as close to it as the platform
+// allows, or until interrupted.
+struct PreciseWaiter {
+  virtual ~PreciseWaiter() = default;
+
+  // Returns once GetSteadyMicroseconds() reaches deadlineUs (never, if it is
+  // negative) or Interrupt() is called. An Interrupt() while nobody waits
+  // makes the next wait return immediately, so none is lost.
+  virtual void WaitUntil(int64_t deadlineUs) = 0;
+  virtual void Interrupt() = 0;
+};
+
+// Portable waiter: sleeps on a condition variable until kSpinUs before the
+// deadline, then yields until it arrives, trading up to kSpinUs of CPU per
+// wake for wakeups that are not at the mercy of the OS timer granularity.
+struct PortableWaiter : PreciseWaiter {
+  static constexpr int64_t kSpinUs = 1000;
+
+  void WaitUntil(int64_t deadlineUs) override;
+  void Interrupt() override;
+
+ private:
+  std::mutex mutex;
+  std::condition_variable wakeup;
+  bool interrupted = false;
+};
+
+// Runs a TimerState on a dedicated thread so ticks keep their timing while
+// the UI thread is busy painting, dragging or sitting in a modal loop.
+//
+// The thread sleeps until the next moment the display can change (see
+// TickScheduler::NextWakeDelay), advances the state and publishes a
+// TimerSnapshot through a SeqLock that the UI reads without locking. When
+// the snapshot differs visibly from the previous one, or transitions
+// happened, it calls notify, at most once until the UI acknowledges; the
+// window posts itself one message from it.
+//
+// The state is guarded by a mutex: the UI changes it with Command() and
+// reads it with Inspect(), never directly while the thread runs.
+struct TimingThread {
+  // Called on the timing thread (or in Command()). Returns false if the
+  // notification could not be delivered, so a later change retries.
+  using Notify = std::function<bool()>;
+
+  // Called with every snapshot as it is published, under the state lock (so
+  // never concurrently), on the timing thread or in Command().
+  using PublishHook = std::function<void(const TimerSnapshot&)>;
+
+  TimingThread() = default;
+  ~TimingThread() { Stop(); }
+
+  TimingThread(const TimingThread&) = delete;
+  TimingThread& operator=(const TimingThread&) = delete;
+
+  // Starts the thread. waiter (PortableWaiter if null) must outlive it.
+  void Start(Notify notify, PreciseWaiter* waiter = nullptr);
+
+  // Joins the thread. The state stays readable through Inspect().
+  void Stop();
+
+  bool IsRunning() const { return thread.joinable(); }
+
+  // Runs fn(TimerState&) under the lock, republishes, and wakes the thread
+  // to reschedule around the change.
+  template <typename F>
+  void Command(F&& fn) {
+    bool notify;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      fn(state);
+      notify = UpdateLocked();
+      commands++;
+    }
+    waiter->Interrupt();
+    if (notify) NotifyOnce();
+  }
+
+  // Returns fn(const TimerState&), evaluated under the lock.
+  template <typename F>
+  auto Inspect(F&& fn) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fn(static_cast<const TimerState&>(state));
+  }
+
+  // What the window currently shows, which decides how often the thread
+  // needs to wake: bar widths of 0 skip pixel crossings, and a hidden
+  // window only wakes for completion.
+  void SetViewport(bool visible, int questionBarWidth, int blockBarWidth);
+
+  // Mirrors publications into hook, starting with the current snapshot if
+  // one was published already. Pass nullptr to stop.
+  void SetPublishHook(PublishHook hook);
+
+  // Lock-free; any thread. Returns the number of torn reads retried.
+  uint32_t ReadSnapshot(TimerSnapshot* snapshot) const {
+    return published.Read(snapshot);
+  }
+
+  // UI thread: call before reading the snapshot in response to a
+  // notification, to allow the next one.
+  void AcknowledgeNotify() { notifyPending.store(false); }
+
+  // Moves the transitions reported since the last call into *events.
+  void TakeEvents(std::vector<TimerEvent>* events);
+
+  // Instrumentation
+  LatencyHistogram wakeLateness;    // Deadline to wakeup
+  LatencyHistogram publishLatency;  // Deadline to snapshot published
+  std::atomic<uint64_t> wakeups{0};
+  std::atomic<uint64_t> publishes{0};
+  std::atomic<uint64_t> notifications{0};
+  std::atomic<uint64_t> commands{0};
+
+ private:
+  void Run();
+
+  // Advances the state, queues its transitions and publishes a snapshot if
+  // anything visible changed. Returns true if the UI should be notified.
+  bool UpdateLocked();
+  void NotifyOnce();
+
+  mutable std::mutex mutex;
+  TimerState state;  // Guarded by mutex
+  bool visible = true;
+  int questionBarWidth = 0;
+  int blockBarWidth = 0;
+  std::vector<TimerEvent> events;  // Not yet taken by the UI
+  TimerSnapshot last = {};         // Most recently published
+  bool hasPublished = false;
+
+  SeqLock<TimerSnapshot> published;
+  PortableWaiter portableWaiter;
+  PreciseWaiter* waiter = &portableWaiter;
+  Notify notify;
+  PublishHook publishHook;  // Guarded by mutex
+  std::atomic<bool> notifyPending{false};
+  std::atomic<bool> stopping{false};
+  std::thread thread;
+};
+
+#endif  // TIMINGTHREAD_H
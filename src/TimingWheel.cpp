@@ -0,0 +1,178 @@
+// TimingWheel.cpp - Timing wheel scheduling, cascading and expiry
+
+#include "TimingWheel.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+constexpr int64_t kSlotMask = TimingWheel::kSlots - 1;
+
+// Farthest distance the top level can file a deadline at
+constexpr int64_t kMaxDelta =
+    (int64_t{1} << (TimingWheel::kLevelBits * TimingWheel::kLevels)) - 1;
+
+int CountTrailingZeros(uint64_t word) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward64(&index, word);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctzll(word);
+#endif
+}
+
+}  // namespace
+
+void TimingWheel::Reset(int64_t startTick) {
+  for (Entry& entry : entries) entry = Entry();
+  for (uint32_t& head : heads) head = kNone;
+  for (auto& level : occupied) {
+    for (uint64_t& word : level) word = 0;
+  }
+  current = startTick;
+  size = 0;
+}
+
+void TimingWheel::Reserve(size_t count) {
+  if (entries.size() < count) entries.resize(count);
+}
+
+void TimingWheel::Schedule(uint32_t id, int64_t tick) {
+  if (id >= entries.size()) entries.resize(static_cast<size_t>(id) + 1);
+  if (entries[id].slot != kUnlinked) {
+    Unlink(id);
+  } else {
+    size++;
+  }
+  entries[id].deadline = tick;
+  Link(id);
+}
+
+void TimingWheel::Cancel(uint32_t id) {
+  if (!IsScheduled(id)) return;
+  Unlink(id);
+  size--;
+}
+
+void TimingWheel::Link(uint32_t id) {
+  Entry& entry = entries[id];
+  int64_t tick = entry.deadline > current ? entry.deadline : current;
+  int64_t delta = tick - current;
+  if (delta > kMaxDelta) {
+    delta = kMaxDelta;
+    tick = current + kMaxDelta;
+  }
+
+  // File under the coarsest level whose slot width the delta reaches. That
+  // slot cascades at the deadline rounded down to its width, which is still
+  // after the current tick and never after the deadline.
+  int level = 0;
+  while (level < kLevels - 1 && delta >> (kLevelBits * (level + 1)) != 0) {
+    level++;
+  }
+  const int index =
+      static_cast<int>((tick >> (kLevelBits * level)) & kSlotMask);
+  const int slot = level * kSlots + index;
+
+  entry.slot = static_cast<uint16_t>(slot);
+  entry.prev = kNone;
+  entry.next = heads[slot];
+  if (entry.next != kNone) {
+    entries[entry.next].prev = id;
+  } else {
+    occupied[level][index / 64] |= uint64_t{1} << (index % 64);
+  }
+  heads[slot] = id;
+}
+
+void TimingWheel::Unlink(uint32_t id) {
+  Entry& entry = entries[id];
+  const int slot = entry.slot;
+  if (entry.prev != kNone) {
+    entries[entry.prev].next = entry.next;
+  } else {
+    heads[slot] = entry.next;
+  }
+  if (entry.next != kNone) entries[entry.next].prev = entry.prev;
+  if (heads[slot] == kNone) {
+    const int index = slot % kSlots;
+    occupied[slot / kSlots][index / 64] &= ~(uint64_t{1} << (index % 64));
+  }
+  entry.slot = kUnlinked;
+  entry.prev = kNone;
+  entry.next = kNone;
+}
+
+void TimingWheel::Cascade(int level) {
+  const int index =
+      static_cast<int>((current >> (kLevelBits * level)) & kSlotMask);
+  const int slot = level * kSlots + index;
+  uint32_t id = heads[slot];
+  heads[slot] = kNone;
+  occupied[level][index / 64] &= ~(uint64_t{1} << (index % 64));
+
+  while (id != kNone) {
+    const uint32_t next = entries[id].next;
+    Link(id);
+    cascaded++;
+    id = next;
+  }
+}
+
+int TimingWheel::NextOccupied(int level, int index) const {
+  while (index < kSlots) {
+    const uint64_t word = occupied[level][index / 64] >> (index % 64);
+    if (word != 0) return index + CountTrailingZeros(word);
+    index = (index | 63) + 1;
+  }
+  return kSlots;
+}
+
+void TimingWheel::AdvanceTo(int64_t tick, std::vector<uint32_t>* expired) {
+  while (current <= tick) {
+    if (size == 0) {
+      current = tick + 1;
+      break;
+    }
+
+    // Crossing into a new span of a level refiles that span's entries; a
+    // level above is only crossed when the level below wraps to slot 0.
+    const int index = static_cast<int>(current & kSlotMask);
+    if (index == 0) {
+      for (int level = 1; level < kLevels; level++) {
+        Cascade(level);
+        if (((current >> (kLevelBits * level)) & kSlotMask) != 0) break;
+      }
+    }
+
+    uint32_t id = heads[index];
+    heads[index] = kNone;
+    occupied[0][index / 64] &= ~(uint64_t{1} << (index % 64));
+    while (id != kNone) {
+      Entry& entry = entries[id];
+      const uint32_t next = entry.next;
+      entry.slot = kUnlinked;
+      entry.prev = kNone;
+      entry.next = kNone;
+      expired->push_back(id);
+      size--;
+      id = next;
+    }
+
+    // Jump straight to the next occupied slot, or the next cascade.
+    const int64_t target = current - index + NextOccupied(0, index + 1);
+    current = target < tick + 1 ? target : tick + 1;
+  }
+}
+
+int64_t TimingWheel::NextWakeTick() const {
+  if (size == 0) return -1;
+
+  // On a span boundary the cascade into level 0 has not happened yet.
+  const int index = static_cast<int>(current & kSlotMask);
+  if (index == 0) return current;
+  return current - index + NextOccupied(0, index);
+}
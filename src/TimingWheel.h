@@ -0,0 +1,97 @@
+// TimingWheel.h - Hierarchical timing wheel over dense integer ids
+
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Deadlines for up to millions of entries, each identified by a small
+// integer id, at a resolution of one tick. Scheduling and cancelling are
+// O(1); advancing costs O(1) per elapsed tick plus the entries that expire,
+// and empty stretches of the wheel are skipped with occupancy bitmaps, so an
+// entry whose deadline is hours away is touched only a handful of times
+// before it fires.
+//
+// The wheel has kLevels levels of kSlots slots. Level 0 holds deadlines less
+// than kSlots ticks ahead, one tick per slot; each level above covers kSlots
+// times the span of the one below. When the current tick crosses a level-n
+// boundary, the entries of the level-n slot for the new span are cascaded
+// down to finer levels. Deadlines beyond the top level's span wait in its
+// farthest slot and are re-filed when it cascades.
+//
+// Entries are linked intrusively through per-id arrays, so nothing is
+// allocated once the ids have been seen. The wheel reads no clock; callers
+// pass ticks in, which lets a simulated clock drive it.
+struct TimingWheel {
+  static constexpr int kLevelBits = 8;
+  static constexpr int kSlots = 1 << kLevelBits;
+  static constexpr int kLevels = 4;
+  static constexpr uint32_t kNone = 0xFFFFFFFFu;
+
+  TimingWheel() { Reset(0); }
+
+  // Empties the wheel and makes startTick the next tick to expire.
+  void Reset(int64_t startTick);
+
+  // Arms id (replacing any earlier deadline) to expire at tick. A deadline
+  // that has already passed expires on the next AdvanceTo().
+  void Schedule(uint32_t id, int64_t tick);
+
+  // Disarms id if it is scheduled.
+  void Cancel(uint32_t id);
+
+  bool IsScheduled(uint32_t id) const {
+    return id < entries.size() && entries[id].slot != kUnlinked;
+  }
+
+  // Deadline id was last scheduled for.
+  int64_t Deadline(uint32_t id) const { return entries[id].deadline; }
+
+  // Expires every entry due at or before tick, appending their ids to
+  // expired in deadline order (ties in no particular order). Expired entries
+  // are no longer scheduled.
+  void AdvanceTo(int64_t tick, std::vector<uint32_t>* expired);
+
+  // Earliest tick at which AdvanceTo() may expire something: exact when the
+  // next deadline is within kSlots ticks, otherwise the next cascade, which
+  // is never later than the next deadline. -1 if the wheel is empty.
+  int64_t NextWakeTick() const;
+
+  // Next tick AdvanceTo() will look at.
+  int64_t CurrentTick() const { return current; }
+
+  size_t Size() const { return size; }
+
+  // Grows the per-id arrays up front for ids below count.
+  void Reserve(size_t count);
+
+  // Instrumentation
+  uint64_t cascaded = 0;  // Entries moved down a level
+
+ private:
+  static constexpr uint16_t kUnlinked = 0xFFFF;
+
+  struct Entry {
+    int64_t deadline = 0;
+    uint32_t prev = kNone;
+    uint32_t next = kNone;
+    uint16_t slot = kUnlinked;  // level * kSlots + index
+  };
+
+  void Link(uint32_t id);
+  void Unlink(uint32_t id);
+  void Cascade(int level);
+
+  // First occupied slot of level at or after index, or kSlots if none.
+  int NextOccupied(int level, int index) const;
+
+  std::vector<Entry> entries;
+  uint32_t heads[kLevels * kSlots];
+  uint64_t occupied[kLevels][kSlots / 64] = {};
+  int64_t current = 0;
+  size_t size = 0;
+};
+
+#endif  // TIMINGWHEEL_H
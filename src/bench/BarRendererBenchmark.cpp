@@ -0,0 +1,72 @@
+// BarRendererBenchmark.cpp - Full against incremental repaints of the bar
+
+#include <cstdio>
+#include <vector>
+
+#include "BarRenderer.h"
+#include "BenchmarkHarness.h"
+
+namespace {
+
+// Frames of a running question: the clocks change every second and the
+// question bar fills one pixel at a time, as in the window.
+void RenderFrames(int dpi, int64_t frames) {
+  const TimerLayout layout = ComputeTimerLayout(dpi);
+  GlyphAtlas atlas;
+  BuildBuiltinGlyphAtlas(dpi, &atlas);
+  const int questionWidth = layout.rects[kElementQuestionProgress].Width();
+
+  TimerConfig config = {};
+  config.timePerBlock = 60;
+  config.numBlocks = 4;
+  config.numQuestions = 40;
+  config.transparency = 100;
+  ManualTimerClock clock;
+  TimerState state = {};
+  state.Initialize(config, &clock);
+
+  // The views are built up front so only painting is timed.
+  std::vector<TimerViewModel> views(static_cast<size_t>(frames));
+  const int64_t questionMs = int64_t{state.questionLength} * 1000;
+  for (int64_t i = 0; i < frames; i++) {
+    clock.nowMs = i * questionMs / questionWidth % (3600 * 1000);
+    state.SeekTo(clock.nowMs);
+    BuildTimerViewModel(state, questionWidth,
+                        layout.rects[kElementBlockProgress].Width(),
+                        &views[static_cast<size_t>(i)]);
+  }
+
+  BarRenderer renderer;
+  renderer.layout = layout;
+  renderer.atlas = &atlas;
+  renderer.surface.Allocate(layout.windowWidth, layout.windowHeight);
+
+  int64_t start = BenchmarkNowNanoseconds();
+  for (const TimerViewModel& view : views) renderer.RenderAll(view);
+  int64_t ns = BenchmarkNowNanoseconds() - start;
+  const uint64_t fullPixels = renderer.pixelsPainted;
+  char label[64];
+  std::snprintf(label, sizeof(label), "%d DPI RenderAll per frame", dpi);
+  PrintBenchmarkRate(label, ns, static_cast<double>(frames));
+
+  TimerViewDiffer differ;
+  differ.Commit(views[0]);
+  renderer.RenderAll(views[0]);
+  renderer.pixelsPainted = 0;
+  start = BenchmarkNowNanoseconds();
+  for (const TimerViewModel& view : views) {
+    renderer.Render(view, differ.Commit(view));
+  }
+  ns = BenchmarkNowNanoseconds() - start;
+  std::snprintf(label, sizeof(label), "%d DPI diffed Render per frame", dpi);
+  PrintBenchmarkRate(label, ns, static_cast<double>(frames));
+  std::printf("  %-36s %12.0f full %10.0f diffed\n", "pixels painted per frame",
+              static_cast<double>(fullPixels) / frames,
+              static_cast<double>(renderer.pixelsPainted) / frames);
+}
+
+}  // namespace
+
+BENCHMARK(BarRenderer) {
+  for (const int dpi : {96, 192}) RenderFrames(dpi, context.Scale(20000));
+}
@@ -0,0 +1,51 @@
+// BenchmarkHarness.h - Registry and timing helpers for wolftimer-bench
+
+#ifndef BENCHMARKHARNESS_H
+#define BENCHMARKHARNESS_H
+
+#include <chrono>
+#include <cstdint>
+
+// Benchmarks are functions registered by name with BENCHMARK(). Each times
+// its own loops and prints its own lines through PrintBenchmarkRate().
+// wolftimer-bench runs every benchmark, or only those named on its command
+// line; --quick shrinks the work so ctest can smoke-test them.
+struct BenchmarkContext {
+  bool quick;  // Run a token amount of work
+
+  // iterations, or a hundredth of it (at least 1) in a quick run
+  int64_t Scale(int64_t iterations) const {
+    if (!quick) return iterations;
+    return iterations / 100 > 0 ? iterations / 100 : 1;
+  }
+};
+
+using BenchmarkFunction = void (*)(const BenchmarkContext&);
+
+bool RegisterBenchmark(const char* name, BenchmarkFunction function);
+
+#define BENCHMARK(name)                                                   \
+  static void Benchmark_##name(const BenchmarkContext& context);          \
+  [[maybe_unused]] static const bool Benchmark_##name##_registered =      \
+      RegisterBenchmark(#name, Benchmark_##name);                         \
+  static void Benchmark_##name(const BenchmarkContext& context)
+
+inline int64_t BenchmarkNowNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Folds value into a sink the optimizer cannot see through, so the work that
+// produced it is not removed.
+void KeepAlive(int64_t value);
+
+// Prints the time per operation and operations per second for operations
+// done in ns.
+void PrintBenchmarkRate(const char* label, int64_t ns, double operations);
+
+// Prints what went wrong and makes wolftimer-bench exit with status 1, for
+// benchmarks that check the results of the code they time.
+void ReportBenchmarkFailure(const char* what);
+
+#endif  // BENCHMARKHARNESS_H
@@ -0,0 +1,83 @@
+// BenchmarkMain.cpp - wolftimer-bench: runs the registered microbenchmarks
+//
+//   wolftimer-bench [--quick] [name ...]
+//
+// Runs the named benchmarks (all of them if none are named). --quick does a
+// token amount of work in each, to check they still run. Exits with 1 if a
+// benchmark found its results wrong.
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "BenchmarkHarness.h"
+
+namespace {
+
+struct Benchmark {
+  const char* name;
+  BenchmarkFunction function;
+};
+
+std::vector<Benchmark>& Registry() {
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+volatile int64_t sink = 0;
+bool failed = false;
+
+}  // namespace
+
+bool RegisterBenchmark(const char* name, BenchmarkFunction function) {
+  Registry().push_back({name, function});
+  return true;
+}
+
+void KeepAlive(int64_t value) { sink = sink + value; }
+
+void PrintBenchmarkRate(const char* label, int64_t ns, double operations) {
+  if (operations <= 0) operations = 1;
+  std::printf("  %-36s %12.2f ns/op %14.0f ops/s\n", label,
+              ns / operations, ns > 0 ? operations * 1e9 / ns : 0.0);
+}
+
+void ReportBenchmarkFailure(const char* what) {
+  std::printf("  FAILED: %s\n", what);
+  failed = true;
+}
+
+int main(int argc, char** argv) {
+  BenchmarkContext context = {};
+  std::vector<const char*> names;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--quick") == 0) {
+      context.quick = true;
+      continue;
+    }
+    bool known = false;
+    for (const Benchmark& benchmark : Registry()) {
+      known = known || std::strcmp(benchmark.name, argv[i]) == 0;
+    }
+    if (!known) {
+      std::fprintf(stderr,
+                   "usage: wolftimer-bench [--quick] [name ...]\n"
+                   "no benchmark named %s\n",
+                   argv[i]);
+      return 2;
+    }
+    names.push_back(argv[i]);
+  }
+
+  for (const Benchmark& benchmark : Registry()) {
+    bool selected = names.empty();
+    for (const char* name : names) {
+      selected = selected || std::strcmp(name, benchmark.name) == 0;
+    }
+    if (!selected) continue;
+    std::printf("%s:\n", benchmark.name);
+    benchmark.function(context);
+    std::fflush(stdout);
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,77 @@
+// CoverGeometryBenchmark.cpp - Drag math replayed from a 1000 Hz mouse trace
+
+#include <cmath>
+#include <vector>
+
+#include "BenchmarkHarness.h"
+#include "CoverGeometry.h"
+
+namespace {
+
+struct MouseSample {
+  int dx;  // Offset from the press point
+  int dy;
+};
+
+// Ten seconds of a 1000 Hz mouse sweeping in loops across three 1920x1080
+// monitors and past their edges, with sensor jitter.
+std::vector<MouseSample> MakeTrace(int samples) {
+  std::vector<MouseSample> trace(static_cast<size_t>(samples));
+  uint64_t state = 0x9E3779B97F4A7C15ull;
+  for (int i = 0; i < samples; i++) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    const double t = i / 1000.0;
+    MouseSample& sample = trace[static_cast<size_t>(i)];
+    sample.dx = static_cast<int>(3400 * std::sin(t * 0.9) + state % 5);
+    sample.dy = static_cast<int>(700 * std::sin(t * 1.7) + (state >> 8) % 5);
+  }
+  return trace;
+}
+
+}  // namespace
+
+// One ApplyDrag() per WM_MOUSEMOVE, from the rectangle captured at the
+// press, in every drag mode.
+BENCHMARK(CoverGeometryTrace) {
+  const CoverLimits limits =
+      ComputeCoverLimits({-1920, 0, 3840, 1080}, 10, 20);
+  const CoverRect start = {400, 300, 800, 500};
+  const std::vector<MouseSample> trace =
+      MakeTrace(static_cast<int>(context.Scale(10000)));
+
+  const DragMode modes[] = {
+      DragMode::Move,    DragMode::Left,     DragMode::Right,
+      DragMode::Top,     DragMode::Bottom,   DragMode::TopLeft,
+      DragMode::TopRight, DragMode::BottomLeft, DragMode::BottomRight};
+  const int passes = context.quick ? 1 : 20;
+
+  const int64_t begin = BenchmarkNowNanoseconds();
+  for (int pass = 0; pass < passes; pass++) {
+    for (const DragMode mode : modes) {
+      for (const MouseSample& sample : trace) {
+        const CoverRect next =
+            ApplyDrag(limits, mode, start, sample.dx, sample.dy);
+        KeepAlive(next.left + next.bottom);
+      }
+    }
+  }
+  const int64_t ns = BenchmarkNowNanoseconds() - begin;
+  const double moves =
+      static_cast<double>(passes) * (sizeof(modes) / sizeof(modes[0])) *
+      trace.size();
+  PrintBenchmarkRate("ApplyDrag per mouse move", ns, moves);
+  PrintBenchmarkRate("one second of 1000 Hz moves", ns, moves / 1000);
+
+  const CoverRect client = {0, 0, 400, 200};
+  const int64_t hitBegin = BenchmarkNowNanoseconds();
+  for (const MouseSample& sample : trace) {
+    const int x = (sample.dx % 400 + 400) % 400;
+    const int y = (sample.dy % 200 + 200) % 200;
+    KeepAlive(static_cast<int64_t>(HitTestDragMode(client, 8, x, y)));
+  }
+  PrintBenchmarkRate("HitTestDragMode per press",
+                     BenchmarkNowNanoseconds() - hitBegin,
+                     static_cast<double>(trace.size()));
+}
@@ -0,0 +1,94 @@
+// CoverRegionBenchmark.cpp - Union and hit-testing of hundreds of covers
+
+#include <cstdio>
+#include <vector>
+
+#include "BenchmarkHarness.h"
+#include "CoverRegion.h"
+
+namespace {
+
+struct Random {
+  uint64_t state = 0x9E3779B97F4A7C15ull;
+
+  int Below(int limit) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return static_cast<int>(state % static_cast<uint64_t>(limit));
+  }
+};
+
+// count covers of 40-400 px scattered over a 5760x1080 desktop
+std::vector<CoverRect> MakeCovers(int count) {
+  Random random;
+  std::vector<CoverRect> rects;
+  for (int i = 0; i < count; i++) {
+    const int left = random.Below(5760 - 400);
+    const int top = random.Below(1080 - 400);
+    rects.push_back({left, top, left + 40 + random.Below(360),
+                     top + 40 + random.Below(360)});
+  }
+  return rects;
+}
+
+}  // namespace
+
+// Rebuilding the region (union plus grid) as a cover is dragged, and the
+// hit-test of every press, against scanning all the rects.
+BENCHMARK(CoverRegion) {
+  for (const int count : {100, 300, 1000}) {
+    const std::vector<CoverRect> rects = MakeCovers(count);
+    const int64_t rebuilds = context.Scale(500);
+
+    int64_t start = BenchmarkNowNanoseconds();
+    size_t bands = 0;
+    for (int64_t i = 0; i < rebuilds; i++) {
+      bands = ComputeRectUnion(rects).size();
+      KeepAlive(static_cast<int64_t>(bands));
+    }
+    char label[64];
+    std::snprintf(label, sizeof(label), "%d rects: union (%zu bands)", count,
+                  bands);
+    PrintBenchmarkRate(label, BenchmarkNowNanoseconds() - start,
+                       static_cast<double>(rebuilds));
+
+    CoverGridIndex index;
+    start = BenchmarkNowNanoseconds();
+    for (int64_t i = 0; i < rebuilds; i++) {
+      index.Build(rects, 64);
+      KeepAlive(static_cast<int64_t>(index.entries.size()));
+    }
+    std::snprintf(label, sizeof(label), "%d rects: grid build", count);
+    PrintBenchmarkRate(label, BenchmarkNowNanoseconds() - start,
+                       static_cast<double>(rebuilds));
+
+    Random random;
+    const int64_t probes = context.Scale(1000000);
+    start = BenchmarkNowNanoseconds();
+    for (int64_t i = 0; i < probes; i++) {
+      KeepAlive(index.HitTest(rects, random.Below(5760), random.Below(1080)));
+    }
+    std::snprintf(label, sizeof(label), "%d rects: grid hit-test", count);
+    PrintBenchmarkRate(label, BenchmarkNowNanoseconds() - start,
+                       static_cast<double>(probes));
+
+    start = BenchmarkNowNanoseconds();
+    for (int64_t i = 0; i < probes; i++) {
+      const int x = random.Below(5760);
+      const int y = random.Below(1080);
+      int hit = -1;
+      for (int r = count - 1; r >= 0 && hit < 0; r--) {
+        const CoverRect& rect = rects[static_cast<size_t>(r)];
+        if (x >= rect.left && x < rect.right && y >= rect.top &&
+            y < rect.bottom) {
+          hit = r;
+        }
+      }
+      KeepAlive(hit);
+    }
+    std::snprintf(label, sizeof(label), "%d rects: linear hit-test", count);
+    PrintBenchmarkRate(label, BenchmarkNowNanoseconds() - start,
+                       static_cast<double>(probes));
+  }
+}
@@ -0,0 +1,88 @@
+// SeqLockBenchmark.cpp - Publish and read cost of the shared state SeqLock
+//
+// Times SeqLock<SharedTimerState>::Write() alone and with reader threads
+// polling the record as fast as they can (the worst an overlay could do),
+// and reports how many of those readers' attempts were rejected as torn.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "BenchmarkHarness.h"
+#include "SeqLock.h"
+#include "SharedTimerState.h"
+
+namespace {
+
+SharedTimerState MakeRecord(uint64_t generation) {
+  SharedTimerState state = {};
+  state.generation = generation;
+  state.elapsedMs = static_cast<int64_t>(generation);
+  state.totalMs = 4 * 3600 * 1000;
+  return state;
+}
+
+void TimePublish(const char* label, int readerCount, int64_t count) {
+  SeqLock<SharedTimerState> lock;
+  std::atomic<bool> done{false};
+  std::vector<uint64_t> reads(readerCount, 0);
+  std::vector<uint64_t> rejected(readerCount, 0);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < readerCount; r++) {
+    readers.emplace_back([&lock, &done, &reads, &rejected, r] {
+      SharedTimerState state;
+      while (!done.load(std::memory_order_relaxed)) {
+        rejected[r] += lock.Read(&state);
+        reads[r]++;
+      }
+    });
+  }
+
+  const int64_t start = BenchmarkNowNanoseconds();
+  for (int64_t i = 0; i < count; i++) {
+    lock.Write(MakeRecord(static_cast<uint64_t>(i)));
+  }
+  PrintBenchmarkRate(label, BenchmarkNowNanoseconds() - start,
+                     static_cast<double>(count));
+  done.store(true);
+  for (std::thread& reader : readers) reader.join();
+
+  if (readerCount > 0) {
+    uint64_t totalReads = 0;
+    uint64_t totalRejected = 0;
+    for (int r = 0; r < readerCount; r++) {
+      totalReads += reads[r];
+      totalRejected += rejected[r];
+    }
+    std::printf("  %llu reads, %llu attempts rejected as torn (%.3f%%)\n",
+                static_cast<unsigned long long>(totalReads),
+                static_cast<unsigned long long>(totalRejected),
+                totalReads + totalRejected
+                    ? 100.0 * totalRejected / (totalReads + totalRejected)
+                    : 0.0);
+  }
+}
+
+}  // namespace
+
+BENCHMARK(SeqLock) {
+  const int64_t count = context.Scale(10000000);
+  TimePublish("publish, no readers", 0, count);
+  TimePublish("publish, 1 polling reader", 1, count);
+  TimePublish("publish, 4 polling readers", 4, count);
+
+  SeqLock<SharedTimerState> lock;
+  lock.Write(MakeRecord(1));
+  SharedTimerState state;
+  int64_t checksum = 0;
+  const int64_t start = BenchmarkNowNanoseconds();
+  for (int64_t i = 0; i < count; i++) {
+    lock.Read(&state);
+    checksum += state.elapsedMs;
+  }
+  PrintBenchmarkRate("uncontended read", BenchmarkNowNanoseconds() - start,
+                     static_cast<double>(count));
+  KeepAlive(checksum);
+}
@@ -0,0 +1,208 @@
+// SessionFleetBenchmark.cpp - Cost of driving many sessions from one wheel
+//
+// Builds a SessionFleet of running sessions spread over groups, each
+// somewhere random in a 4 x 60 minute, 40-question plan, so about one in 90
+// sessions has a boundary due every second. SessionFleet advances a simulated
+// clock one second per Advance() and times pausing and resuming every group,
+// next to ticking one TimerState per session the way a TimerState per
+// station would be driven. SessionFleetRealtime follows the steady clock
+// instead, sleeping until NextWakeMs() between passes, and reports how late
+// each transition was dispatched after its boundary.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+#include "BenchmarkHarness.h"
+#include "SessionFleet.h"
+#include "TimerClock.h"
+#include "TimerState.h"
+
+namespace {
+
+constexpr int kBlocks = 4;
+constexpr int kMinutesPerBlock = 60;
+constexpr int kQuestionsPerBlock = 40;
+constexpr int kGroups = 100;
+
+TimerConfig FleetConfig() {
+  TimerConfig config = {};
+  config.timePerBlock = kMinutesPerBlock;
+  config.numBlocks = kBlocks;
+  config.numQuestions = kQuestionsPerBlock;
+  config.transparency = 100;
+  config.ComputeDerivedValues();
+  return config;
+}
+
+// Deterministic spread of start positions across runs.
+struct Random {
+  uint64_t state = 0x9E3779B97F4A7C15ull;
+
+  uint64_t Next() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+  }
+};
+
+// Starts sessions at nowMs, each at a random point of its plan.
+void Populate(SessionFleet* fleet, int64_t sessions, int64_t nowMs) {
+  fleet->Reset(nowMs);
+  const int plan = fleet->AddPlan(BuildSessionPlan(FleetConfig()));
+  for (int group = 0; group < kGroups; group++) fleet->AddGroup();
+
+  Random random;
+  const int64_t totalMs = int64_t{kBlocks} * kMinutesPerBlock * 60 * 1000;
+  for (int64_t i = 0; i < sessions; i++) {
+    const uint32_t session =
+        fleet->AddSession(plan, static_cast<int>(i % kGroups), nowMs);
+    fleet->Start(session, nowMs);
+    fleet->SeekTo(session, static_cast<int64_t>(random.Next() % totalMs),
+                  nowMs);
+  }
+}
+
+int64_t Percentile(const std::vector<int64_t>& sorted, double fraction) {
+  if (sorted.empty()) return 0;
+  size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+}  // namespace
+
+BENCHMARK(SessionFleet) {
+  const int64_t sessions = context.Scale(100000);
+  const int64_t seconds = context.Scale(600);
+
+  SessionFleet fleet;
+  int64_t start = BenchmarkNowNanoseconds();
+  Populate(&fleet, sessions, 0);
+  PrintBenchmarkRate("set up (per session)", BenchmarkNowNanoseconds() - start,
+                     static_cast<double>(sessions));
+
+  FleetEventBatch batch;
+  uint64_t events = 0;
+  start = BenchmarkNowNanoseconds();
+  for (int64_t second = 1; second <= seconds; second++) {
+    bool more = true;
+    while (more) {
+      more = fleet.Advance(second * 1000, &batch);
+      events += batch.count;
+    }
+  }
+  int64_t ns = BenchmarkNowNanoseconds() - start;
+  PrintBenchmarkRate("Advance() per simulated second", ns,
+                     static_cast<double>(seconds));
+  PrintBenchmarkRate("events reported", ns, static_cast<double>(events));
+  std::printf("  %lld sessions: %.0f events/s, %.0f sessions visited/s\n",
+              static_cast<long long>(sessions),
+              static_cast<double>(events) / seconds,
+              static_cast<double>(fleet.sessionsVisited) / seconds);
+
+  // Pause and resume every group, as at a fire alarm
+  const int64_t nowMs = seconds * 1000;
+  start = BenchmarkNowNanoseconds();
+  for (int group = 0; group < kGroups; group++) {
+    fleet.SetGroupPaused(group, true, nowMs);
+  }
+  PrintBenchmarkRate("pause (per session)", BenchmarkNowNanoseconds() - start,
+                     static_cast<double>(sessions));
+  const size_t scheduledWhilePaused = fleet.ScheduledCount();
+  start = BenchmarkNowNanoseconds();
+  for (int group = 0; group < kGroups; group++) {
+    fleet.SetGroupPaused(group, false, nowMs + 60000);
+  }
+  PrintBenchmarkRate("resume (per session)", BenchmarkNowNanoseconds() - start,
+                     static_cast<double>(sessions));
+  std::printf("  %zu sessions still scheduled while paused\n",
+              scheduledWhilePaused);
+
+  // The same sessions as TimerStates, each ticked every simulated second
+  ManualTimerClock clock;
+  const TimerConfig config = FleetConfig();
+  std::vector<TimerState> states(static_cast<size_t>(sessions));
+  Random random;
+  for (TimerState& state : states) {
+    state.Initialize(config, &clock);
+    state.SeekTo(static_cast<int64_t>(random.Next() %
+                                      (int64_t{config.totalTime} * 1000)));
+  }
+  uint64_t transitions = 0;
+  start = BenchmarkNowNanoseconds();
+  for (int64_t second = 1; second <= seconds; second++) {
+    clock.nowMs = second * 1000;
+    for (TimerState& state : states) {
+      if (state.Tick() != TickStatus::Continue) transitions++;
+    }
+  }
+  ns = BenchmarkNowNanoseconds() - start;
+  PrintBenchmarkRate("TimerState Tick()s per simulated second", ns,
+                     static_cast<double>(seconds));
+  KeepAlive(static_cast<int64_t>(transitions));
+}
+
+// Boundary-to-dispatch latency on the steady clock: 1M sessions for 10 s,
+// or 10k for a tenth of a second in a quick run.
+BENCHMARK(SessionFleetRealtime) {
+  const int64_t sessions = context.Scale(1000000);
+  const int64_t runMs = context.Scale(10000);
+
+  SessionFleet fleet;
+  Populate(&fleet, sessions, BenchmarkNowNanoseconds() / 1000000);
+
+  // Boundaries that fell due while populating are late by construction.
+  FleetEventBatch batch;
+  size_t backlog = 0;
+  bool pending = true;
+  while (pending) {
+    pending = fleet.Advance(BenchmarkNowNanoseconds() / 1000000, &batch);
+    backlog += batch.count;
+  }
+
+  std::vector<int64_t> latencies;
+  uint64_t passes = 0;
+  const std::clock_t cpuStart = std::clock();
+  const int64_t runStart = BenchmarkNowNanoseconds();
+  const int64_t end = runStart + runMs * 1000000;
+  for (int64_t now = runStart; now < end; now = BenchmarkNowNanoseconds()) {
+    const int64_t wakeMs = fleet.NextWakeMs();
+    const int64_t wake = wakeMs < 0 ? end : std::min(wakeMs * 1000000, end);
+    if (wake > now) {
+      std::this_thread::sleep_for(std::chrono::nanoseconds(wake - now));
+    }
+
+    const int64_t nowMs = BenchmarkNowNanoseconds() / 1000000;
+    bool more = true;
+    while (more) {
+      more = fleet.Advance(nowMs, &batch);
+      const int64_t dispatched = BenchmarkNowNanoseconds();
+      for (int i = 0; i < batch.count; i++) {
+        latencies.push_back((dispatched - batch.events[i].dueMs * 1000000) /
+                            1000);
+      }
+    }
+    passes++;
+  }
+  const double cpuMs = (std::clock() - cpuStart) * 1000.0 / CLOCKS_PER_SEC;
+  const double wallMs = (BenchmarkNowNanoseconds() - runStart) / 1e6;
+
+  std::sort(latencies.begin(), latencies.end());
+  std::printf("  %lld sessions, %lld ms: %zu events in %llu passes (%zu due "
+              "during setup not counted), %.2f%% of a core\n",
+              static_cast<long long>(sessions), static_cast<long long>(runMs),
+              latencies.size(), static_cast<unsigned long long>(passes),
+              backlog, wallMs > 0 ? cpuMs * 100.0 / wallMs : 0.0);
+  std::printf("  boundary to dispatch: p50 %lld us  p90 %lld us  p99 %lld us"
+              "  max %lld us\n",
+              static_cast<long long>(Percentile(latencies, 0.5)),
+              static_cast<long long>(Percentile(latencies, 0.9)),
+              static_cast<long long>(Percentile(latencies, 0.99)),
+              static_cast<long long>(latencies.empty() ? 0
+                                                       : latencies.back()));
+}
@@ -0,0 +1,76 @@
+// SessionJournalBenchmark.cpp - Journal records per second, written and read
+//
+// Encodes a run of question advances (with a pause/resume and a config
+// record now and then) into frames the way SessionJournal batches them for
+// the background writer, then streams the same bytes back through
+// JournalReader.
+
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include "BenchmarkHarness.h"
+#include "SessionJournal.h"
+
+namespace {
+
+JournalRecord MakeRecord(int64_t i) {
+  JournalRecord record;
+  record.type = JournalRecordType::QuestionAdvanced;
+  if (i % 100 == 50) record.type = JournalRecordType::Paused;
+  if (i % 100 == 51) record.type = JournalRecordType::Resumed;
+  if (i % 1000 == 0) record.type = JournalRecordType::ConfigChanged;
+  record.wallMs = 1700000000000 + i * 90000;
+  record.elapsedMs = i * 90000;
+  record.block = static_cast<int>(i / 40);
+  record.question = static_cast<int>(i % 40);
+  record.timePerBlock = 60;
+  record.numBlocks = 4;
+  record.numQuestions = 40;
+  record.transparency = 100;
+  return record;
+}
+
+}  // namespace
+
+BENCHMARK(SessionJournal) {
+  const int64_t count = context.Scale(2000000);
+
+  SessionJournal journal;
+  std::string file;
+  file.reserve(static_cast<size_t>(count) * 12);
+  int64_t start = BenchmarkNowNanoseconds();
+  for (int64_t i = 0; i < count; i++) {
+    journal.Append(MakeRecord(i));
+    if (journal.pending.size() >= SessionJournal::kFlushBytes) {
+      file += journal.TakeFrame();
+    }
+  }
+  file += journal.TakeFrame();
+  PrintBenchmarkRate("append + frame", BenchmarkNowNanoseconds() - start,
+                     static_cast<double>(count));
+  std::printf("  %llu records in %llu frames, %.2f bytes/record\n",
+              static_cast<unsigned long long>(journal.records),
+              static_cast<unsigned long long>(journal.frames),
+              static_cast<double>(file.size()) / static_cast<double>(count));
+
+  std::istringstream in(file);
+  JournalReader reader(&in);
+  JournalRecord record;
+  int64_t read = 0;
+  int64_t checksum = 0;
+  start = BenchmarkNowNanoseconds();
+  while (reader.Next(&record)) {
+    checksum += record.elapsedMs + record.question;
+    read++;
+  }
+  PrintBenchmarkRate("read + parse", BenchmarkNowNanoseconds() - start,
+                     static_cast<double>(read));
+  KeepAlive(checksum);
+  if (read != count || reader.damagedFrames != 0) {
+    std::printf("  read back %lld of %lld records, %llu damaged frames\n",
+                static_cast<long long>(read), static_cast<long long>(count),
+                static_cast<unsigned long long>(reader.damagedFrames));
+  }
+}
@@ -0,0 +1,209 @@
+// SessionProgressBenchmark.cpp - Dashboard progress pass over many sessions
+//
+// For 10k, 100k and 1M sessions, each somewhere random in a 4 x 60 minute,
+// 40-question plan with one in ten paused, times one dashboard frame:
+// question/block progress and remaining time for every session. It compares
+// SessionProgressBatch::Compute() with each kernel the CPU supports against
+// calling GetQuestionProgress(), GetBlockProgress() and
+// GetElapsedMilliseconds() on one heap-allocated TimerState per session.
+//
+// Frames advance 16 ms each. Rows whose question ended are set again from a
+// SessionFleet holding the same sessions, timed separately. The vector
+// kernels' outputs are checked against the scalar kernel's, and a difference
+// fails the run.
+
+#include <algorithm>
+#include <cstdio>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+#include "BenchmarkHarness.h"
+#include "SessionFleet.h"
+#include "SessionProgress.h"
+#include "TimerClock.h"
+#include "TimerState.h"
+
+namespace {
+
+constexpr int kBlocks = 4;
+constexpr int kMinutesPerBlock = 60;
+constexpr int kQuestionsPerBlock = 40;
+constexpr int64_t kFrameMs = 16;
+constexpr int64_t kEpochMs = 1000000;
+
+// Deterministic spread of start positions across runs.
+struct Random {
+  uint64_t state = 0x9E3779B97F4A7C15ull;
+
+  uint64_t Next() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+  }
+};
+
+struct Dashboard {
+  SessionFleet fleet;
+  SessionProgressBatch batch;
+  ManualTimerClock clock;
+  std::vector<std::unique_ptr<TimerState>> states;
+
+  void Populate(int64_t sessions) {
+    TimerConfig config = {};
+    config.timePerBlock = kMinutesPerBlock;
+    config.numBlocks = kBlocks;
+    config.numQuestions = kQuestionsPerBlock;
+    config.transparency = 100;
+    config.ComputeDerivedValues();
+
+    fleet.Reset(kEpochMs);
+    batch.Reset(kEpochMs);
+    clock.nowMs = kEpochMs;
+    states.clear();
+    const int plan = fleet.AddPlan(BuildSessionPlan(config));
+
+    Random random;
+    const int64_t totalMs = int64_t{config.totalTime} * 1000;
+    for (int64_t i = 0; i < sessions; i++) {
+      const uint32_t session = fleet.AddSession(plan, -1, kEpochMs);
+      fleet.Start(session, kEpochMs);
+      fleet.SeekTo(session, static_cast<int64_t>(random.Next() % totalMs),
+                   kEpochMs);
+      if (i % 10 == 0) fleet.SetPaused(session, true, kEpochMs);
+      batch.Add();
+      SetRow(session, kEpochMs);
+
+      // The same session as a TimerState, without a plan of its own: only
+      // the fields the progress getters read are filled in.
+      const TimerPosition pos = fleet.PositionAt(session, kEpochMs);
+      auto state = std::make_unique<TimerState>();
+      state->InitializeWithPlan(config, SessionPlan(), &clock);
+      state->SetPaused(fleet.IsPaused(session));
+      state->SeekTo(fleet.GetElapsedMilliseconds(session, kEpochMs));
+      state->config.totalTime = config.totalTime;
+      state->currentTime = pos.currentTime;
+      state->questionTimeElapsed = pos.questionTimeElapsed;
+      state->questionLength = pos.questionLength;
+      state->blockTimeElapsed = pos.blockTimeElapsed;
+      state->blockLength = pos.blockLength;
+      states.push_back(std::move(state));
+    }
+  }
+
+  void SetRow(uint32_t session, int64_t nowMs) {
+    batch.Set(session, fleet.PositionAt(session, nowMs),
+              fleet.GetElapsedMilliseconds(session, nowMs),
+              fleet.IsRunning(session), nowMs);
+  }
+};
+
+const char* KernelName(ProgressKernel kernel) {
+  switch (kernel) {
+    case ProgressKernel::Auto:
+      return "auto";
+    case ProgressKernel::Scalar:
+      return "scalar";
+    case ProgressKernel::Sse2:
+      return "sse2";
+    case ProgressKernel::Avx2:
+      return "avx2";
+  }
+  return "?";
+}
+
+bool SameOutputs(const SessionProgressBatch& a, const SessionProgressBatch& b) {
+  return a.questionProgress == b.questionProgress &&
+         a.blockProgress == b.blockProgress && a.remainingMs == b.remainingMs &&
+         a.staleRows == b.staleRows;
+}
+
+void RunSize(int64_t sessions, int64_t frames) {
+  Dashboard dashboard;
+  dashboard.Populate(sessions);
+  std::printf("  %lld sessions, %lld frames, best kernel %s\n",
+              static_cast<long long>(sessions), static_cast<long long>(frames),
+              KernelName(GetBestProgressKernel()));
+  const double updates = static_cast<double>(sessions * frames);
+
+  const ProgressKernel best = GetBestProgressKernel();
+  std::vector<ProgressKernel> kernels = {ProgressKernel::Scalar};
+  if (best == ProgressKernel::Sse2 || best == ProgressKernel::Avx2) {
+    kernels.push_back(ProgressKernel::Sse2);
+  }
+  if (best == ProgressKernel::Avx2) kernels.push_back(ProgressKernel::Avx2);
+
+  // Each kernel replays the same frames from the same rows, and must end
+  // with the scalar kernel's outputs.
+  const SessionProgressBatch saved = dashboard.batch;
+  SessionProgressBatch reference;
+  for (const ProgressKernel kernel : kernels) {
+    SessionProgressBatch& batch = dashboard.batch;
+    batch = saved;
+    int64_t kernelNs = 0;
+    int64_t refreshNs = 0;
+    size_t refreshed = 0;
+    for (int64_t frame = 1; frame <= frames; frame++) {
+      const int64_t nowMs = kEpochMs + frame * kFrameMs;
+      const int64_t start = BenchmarkNowNanoseconds();
+      batch.Compute(nowMs, kernel);
+      const int64_t computed = BenchmarkNowNanoseconds();
+      for (const uint32_t row : batch.staleRows) dashboard.SetRow(row, nowMs);
+      refreshNs += BenchmarkNowNanoseconds() - computed;
+      kernelNs += computed - start;
+      refreshed += batch.staleRows.size();
+    }
+
+    char label[64];
+    std::snprintf(label, sizeof(label), "batch %s (per session)",
+                  KernelName(kernel));
+    PrintBenchmarkRate(label, kernelNs, updates);
+    std::printf("  %zu rows set again, %.3f ms total\n", refreshed,
+                refreshNs / 1e6);
+
+    if (kernel == ProgressKernel::Scalar) {
+      reference = batch;
+    } else if (!SameOutputs(reference, batch)) {
+      std::snprintf(label, sizeof(label), "%s output differs from scalar",
+                    KernelName(kernel));
+      ReportBenchmarkFailure(label);
+    }
+  }
+  dashboard.batch = saved;
+
+  // One object per session, as a dashboard over TimerStates would do it
+  std::vector<int> questionProgress(static_cast<size_t>(sessions));
+  std::vector<int> blockProgress(static_cast<size_t>(sessions));
+  std::vector<int64_t> remainingMs(static_cast<size_t>(sessions));
+  int64_t baselineNs = 0;
+  for (int64_t frame = 1; frame <= frames; frame++) {
+    dashboard.clock.nowMs = kEpochMs + frame * kFrameMs;
+    const int64_t start = BenchmarkNowNanoseconds();
+    for (size_t i = 0; i < dashboard.states.size(); i++) {
+      const TimerState& state = *dashboard.states[i];
+      questionProgress[i] = state.GetQuestionProgress();
+      blockProgress[i] = state.GetBlockProgress();
+      remainingMs[i] = int64_t{state.config.totalTime} * 1000 -
+                       state.GetElapsedMilliseconds();
+    }
+    baselineNs += BenchmarkNowNanoseconds() - start;
+  }
+  PrintBenchmarkRate("TimerState objects (per session)", baselineNs, updates);
+
+  int64_t sum = 0;
+  for (size_t i = 0; i < remainingMs.size(); i++) {
+    sum += questionProgress[i] + blockProgress[i] + remainingMs[i];
+  }
+  KeepAlive(sum);
+}
+
+}  // namespace
+
+// About 20M session updates per size, a hundredth of that in a quick run
+BENCHMARK(SessionProgress) {
+  for (const int64_t sessions : {10000, 100000, 1000000}) {
+    RunSize(context.Scale(sessions),
+            context.Scale(std::max<int64_t>(10, 20000000 / sessions)));
+  }
+}
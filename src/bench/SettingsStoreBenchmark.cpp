@@ -0,0 +1,85 @@
+// SettingsStoreBenchmark.cpp - Settings saves per second and bytes written
+//
+// Drives the cover window's save pattern: bursts of Set calls (a drag moving
+// the cover, most of them repeating a value already stored) each followed by
+// one FlushTo() onto the background writer, into a scratch directory under
+// the system temp directory. Reports the UI-thread cost of Set and FlushTo,
+// and how many saves per second actually reached the disk.
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+#include "BackgroundWriter.h"
+#include "BenchmarkHarness.h"
+#include "SettingsStore.h"
+
+namespace {
+
+constexpr int kSetsPerBurst = 64;
+
+void SetCoverPlacement(SettingsStore* store, int burst, int step) {
+  store->SetInt("Cover", "x", burst + step);
+  store->SetInt("Cover", "y", burst);
+  store->SetInt("Cover", "width", 400);
+  store->SetInt("Cover", "height", 300);
+}
+
+}  // namespace
+
+BENCHMARK(SettingsStore) {
+  const int64_t bursts = context.Scale(20000);
+  std::error_code error;
+  const std::filesystem::path dir =
+      std::filesystem::temp_directory_path() / "wolftimer-bench-settings";
+  std::filesystem::remove_all(dir, error);
+  std::filesystem::create_directories(dir, error);
+
+  SettingsStore store;
+  store.Load(dir / "settings.ini");
+  store.SetString("Timer", "font", "Segoe UI");
+  store.SetInt("Timer", "transparency", 90);
+
+  int64_t setNs = 0;
+  int64_t flushNs = 0;
+  const int64_t start = BenchmarkNowNanoseconds();
+  {
+    BackgroundWriter writer;
+    for (int64_t burst = 0; burst < bursts; burst++) {
+      int64_t mark = BenchmarkNowNanoseconds();
+      for (int step = 0; step < kSetsPerBurst; step++) {
+        SetCoverPlacement(&store, static_cast<int>(burst), step);
+      }
+      const int64_t flushStart = BenchmarkNowNanoseconds();
+      setNs += flushStart - mark;
+      store.FlushTo(&writer);
+      flushNs += BenchmarkNowNanoseconds() - flushStart;
+    }
+    writer.Shutdown();
+
+    const int64_t totalNs = BenchmarkNowNanoseconds() - start;
+    const uint64_t written = writer.written.load();
+    PrintBenchmarkRate("Set", setNs,
+                       static_cast<double>(bursts) * kSetsPerBurst * 4);
+    PrintBenchmarkRate("FlushTo", flushNs, static_cast<double>(bursts));
+    PrintBenchmarkRate("saves reaching disk", totalNs,
+                       static_cast<double>(written));
+    std::printf("  %llu Set calls, %llu changed values, %llu flushes, "
+                "%llu written, %llu coalesced, %llu failed\n",
+                static_cast<unsigned long long>(store.setCalls),
+                static_cast<unsigned long long>(store.changedValues),
+                static_cast<unsigned long long>(store.flushes),
+                static_cast<unsigned long long>(written),
+                static_cast<unsigned long long>(writer.coalesced.load()),
+                static_cast<unsigned long long>(writer.failed.load()));
+    std::printf("  %llu bytes serialized for the writer, %.1f bytes/flush\n",
+                static_cast<unsigned long long>(store.bytesWritten),
+                store.flushes ? static_cast<double>(store.bytesWritten) /
+                                    static_cast<double>(store.flushes)
+                              : 0.0);
+  }
+
+  std::filesystem::remove_all(dir, error);
+}
@@ -0,0 +1,65 @@
+// TimeFormatBenchmark.cpp - Table-driven formatting against swprintf
+
+#include <cwchar>
+
+#include "BenchmarkHarness.h"
+#include "TimeFormat.h"
+
+// The formatting UpdateUI does every second (two clocks and two labels),
+// done with the <cwchar> swprintf it replaced and with TimeFormat.h.
+BENCHMARK(TimeFormat) {
+  const int64_t iterations = context.Scale(2000000);
+  wchar_t text[32];
+
+  int64_t start = BenchmarkNowNanoseconds();
+  for (int64_t i = 0; i < iterations; i++) {
+    const int seconds = static_cast<int>(i % 36000);
+    std::swprintf(text, 32, L"%02d:%02d", seconds / 60, seconds % 60);
+    KeepAlive(text[1]);
+  }
+  PrintBenchmarkRate("swprintf MM:SS", BenchmarkNowNanoseconds() - start,
+                     static_cast<double>(iterations));
+
+  start = BenchmarkNowNanoseconds();
+  for (int64_t i = 0; i < iterations; i++) {
+    KeepAlive(static_cast<int64_t>(
+        FormatMinutesSeconds(static_cast<int>(i % 36000), text, 32)));
+  }
+  PrintBenchmarkRate("FormatMinutesSeconds", BenchmarkNowNanoseconds() - start,
+                     static_cast<double>(iterations));
+
+  start = BenchmarkNowNanoseconds();
+  for (int64_t i = 0; i < iterations; i++) {
+    const int seconds = static_cast<int>(i % 36000);
+    std::swprintf(text, 32, L"%d:%02d:%02d", seconds / 3600,
+                  seconds / 60 % 60, seconds % 60);
+    KeepAlive(text[1]);
+  }
+  PrintBenchmarkRate("swprintf H:MM:SS", BenchmarkNowNanoseconds() - start,
+                     static_cast<double>(iterations));
+
+  start = BenchmarkNowNanoseconds();
+  for (int64_t i = 0; i < iterations; i++) {
+    KeepAlive(static_cast<int64_t>(
+        FormatHoursMinutesSeconds(static_cast<int>(i % 36000), text, 32)));
+  }
+  PrintBenchmarkRate("FormatHoursMinutesSeconds",
+                     BenchmarkNowNanoseconds() - start,
+                     static_cast<double>(iterations));
+
+  start = BenchmarkNowNanoseconds();
+  for (int64_t i = 0; i < iterations; i++) {
+    std::swprintf(text, 32, L"Q: %d/%d", static_cast<int>(i % 40) + 1, 40);
+    KeepAlive(text[3]);
+  }
+  PrintBenchmarkRate("swprintf Q: n/m", BenchmarkNowNanoseconds() - start,
+                     static_cast<double>(iterations));
+
+  start = BenchmarkNowNanoseconds();
+  for (int64_t i = 0; i < iterations; i++) {
+    KeepAlive(static_cast<int64_t>(
+        FormatCountLabel("Q: ", i % 40 + 1, 40, text, 32)));
+  }
+  PrintBenchmarkRate("FormatCountLabel", BenchmarkNowNanoseconds() - start,
+                     static_cast<double>(iterations));
+}
@@ -0,0 +1,36 @@
+// TimerLayoutBenchmark.cpp - Layout and hit-testing across DPIs
+
+#include <cstdio>
+#include <initializer_list>
+
+#include "BenchmarkHarness.h"
+#include "TimerLayout.h"
+
+// A full relayout, as on WM_DPICHANGED or each step of a resize, and the
+// hit-test of a mouse press, at 96 to 384 DPI.
+BENCHMARK(TimerLayout) {
+  const int64_t iterations = context.Scale(1000000);
+  for (const int dpi : {96, 144, 192, 288, 384}) {
+    int64_t start = BenchmarkNowNanoseconds();
+    for (int64_t i = 0; i < iterations; i++) {
+      const int width = ScaleForDpi(360 + static_cast<int>(i % 1200), dpi);
+      const TimerLayout layout = ComputeTimerLayout(dpi, width);
+      KeepAlive(layout.rects[kElementBlockProgress].right);
+    }
+    char label[64];
+    std::snprintf(label, sizeof(label), "%d DPI ComputeTimerLayout", dpi);
+    PrintBenchmarkRate(label, BenchmarkNowNanoseconds() - start,
+                       static_cast<double>(iterations));
+
+    const TimerLayout layout = ComputeTimerLayout(dpi);
+    start = BenchmarkNowNanoseconds();
+    for (int64_t i = 0; i < iterations; i++) {
+      const int x = static_cast<int>(i % layout.windowWidth);
+      const int y = static_cast<int>(i / 7 % layout.windowHeight);
+      KeepAlive(HitTestTimerLayout(layout, x, y));
+    }
+    std::snprintf(label, sizeof(label), "%d DPI HitTestTimerLayout", dpi);
+    PrintBenchmarkRate(label, BenchmarkNowNanoseconds() - start,
+                       static_cast<double>(iterations));
+  }
+}
@@ -0,0 +1,87 @@
+// TimerStateBenchmark.cpp - Closed-form position lookup against tick replay
+
+#include <vector>
+
+#include "BenchmarkHarness.h"
+#include "TimerState.h"
+
+namespace {
+
+// 8 hours: 4 blocks of 120 minutes, 50 questions each
+TimerConfig EightHourConfig() {
+  TimerConfig config = {};
+  config.timePerBlock = 120;
+  config.numBlocks = 4;
+  config.numQuestions = 50;
+  config.transparency = 100;
+  config.ComputeDerivedValues();
+  return config;
+}
+
+std::vector<int64_t> RandomSeconds(int64_t count, int64_t totalSeconds) {
+  std::vector<int64_t> seconds(static_cast<size_t>(count));
+  uint64_t state = 0x9E3779B97F4A7C15ull;
+  for (int64_t& second : seconds) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    second = static_cast<int64_t>(state % static_cast<uint64_t>(totalSeconds));
+  }
+  return seconds;
+}
+
+}  // namespace
+
+// Reaching a position by ticking once per second from the start, as the
+// counting timer had to, against looking it up directly.
+BENCHMARK(StateAtVsTick) {
+  const TimerConfig config = EightHourConfig();
+  const SessionPlan plan = BuildSessionPlan(config);
+  const int64_t totalSeconds = config.totalTime;
+
+  const int64_t replays = context.Scale(200);
+  ManualTimerClock clock;
+  TimerState state = {};
+  int64_t start = BenchmarkNowNanoseconds();
+  for (int64_t replay = 0; replay < replays; replay++) {
+    clock.nowMs = 0;
+    state.Initialize(config, &clock);
+    for (int64_t second = 1; second <= totalSeconds; second++) {
+      clock.nowMs = second * 1000;
+      state.Tick();
+    }
+    KeepAlive(state.currentTime);
+  }
+  int64_t ns = BenchmarkNowNanoseconds() - start;
+  PrintBenchmarkRate("Tick() per simulated second", ns,
+                     static_cast<double>(replays * totalSeconds));
+  PrintBenchmarkRate("Tick() replay of all 8 h", ns,
+                     static_cast<double>(replays));
+
+  const int64_t lookups = context.Scale(2000000);
+  const std::vector<int64_t> seconds = RandomSeconds(lookups, totalSeconds);
+  start = BenchmarkNowNanoseconds();
+  for (const int64_t second : seconds) {
+    KeepAlive(StateAt(config, second).currentQuestion);
+  }
+  ns = BenchmarkNowNanoseconds() - start;
+  PrintBenchmarkRate("StateAt() at a random second", ns,
+                     static_cast<double>(lookups));
+
+  start = BenchmarkNowNanoseconds();
+  for (const int64_t second : seconds) {
+    KeepAlive(plan.PositionAt(second).currentQuestion);
+  }
+  ns = BenchmarkNowNanoseconds() - start;
+  PrintBenchmarkRate("SessionPlan::PositionAt() random", ns,
+                     static_cast<double>(lookups));
+
+  start = BenchmarkNowNanoseconds();
+  for (const int64_t second : seconds) {
+    state.SeekTo(second * 1000);
+    KeepAlive(state.currentQuestion);
+  }
+  ns = BenchmarkNowNanoseconds() - start;
+  PrintBenchmarkRate("TimerState::SeekTo() random", ns,
+                     static_cast<double>(lookups));
+}
@@ -0,0 +1,91 @@
+// TimerViewModelBenchmark.cpp - Replay of a session through the view differ
+//
+// Replays a 4 x 60 minute session, waking whenever TickScheduler asks for a
+// visible bar with 200/300 px progress bars (and, for comparison, on a fixed
+// 1 Hz tick), with a pause every 20 minutes. Every frame is built and diffed
+// the way TimerWindow::UpdateUI does it, and the controls the differ issued
+// and suppressed are reported against pushing every field every frame.
+
+#include <cstdint>
+#include <cstdio>
+
+#include "BenchmarkHarness.h"
+#include "TickScheduler.h"
+#include "TimerViewModel.h"
+
+namespace {
+
+constexpr int kQuestionBarWidth = 200;
+constexpr int kBlockBarWidth = 300;
+
+struct ReplayResult {
+  uint64_t frames = 0;
+  int64_t ns = 0;
+  TimerViewDiffer differ;
+};
+
+// fixedTickMs > 0 ticks on that period; otherwise wakes as the scheduler asks.
+void Replay(int64_t fixedTickMs, int64_t limitMs, ReplayResult* result) {
+  TimerConfig config = {};
+  config.timePerBlock = 60;
+  config.numBlocks = 4;
+  config.numQuestions = 40;
+  config.transparency = 100;
+  ManualTimerClock clock;
+  TimerState state = {};
+  state.Initialize(config, &clock);
+
+  int64_t nextPauseMs = 20 * 60 * 1000;
+  while (state.currentTime > 0) {
+    // The fixed tick keeps firing while paused; the scheduler sleeps until
+    // the next wakeup or the next pause/resume, whichever comes first.
+    int64_t wakeMs = clock.nowMs + fixedTickMs;
+    if (fixedTickMs <= 0) {
+      const int64_t delay = TickScheduler::NextWakeDelay(
+          state, true, kQuestionBarWidth, kBlockBarWidth);
+      wakeMs = delay < 0 ? nextPauseMs : clock.nowMs + delay;
+      if (wakeMs > nextPauseMs) wakeMs = nextPauseMs;
+    }
+    if (wakeMs > limitMs) break;
+    clock.nowMs = wakeMs;
+    if (clock.nowMs >= nextPauseMs) {
+      state.TogglePause();
+      nextPauseMs += state.paused ? 60 * 1000 : 20 * 60 * 1000;
+    }
+
+    const int64_t start = BenchmarkNowNanoseconds();
+    state.Tick();
+    TimerViewModel view;
+    BuildTimerViewModel(state, kQuestionBarWidth, kBlockBarWidth, &view);
+    KeepAlive(result->differ.Commit(view));
+    result->ns += BenchmarkNowNanoseconds() - start;
+    result->frames++;
+  }
+}
+
+void Report(const char* label, const ReplayResult& result) {
+  const uint64_t issued = result.differ.issuedUpdates;
+  const uint64_t total = issued + result.differ.suppressedUpdates;
+  std::printf("  %s: %llu frames, %llu of %llu control updates issued, "
+              "%.1f%% fewer redraws\n",
+              label, static_cast<unsigned long long>(result.frames),
+              static_cast<unsigned long long>(issued),
+              static_cast<unsigned long long>(total),
+              total ? 100.0 * (total - issued) / total : 0.0);
+  PrintBenchmarkRate("  tick + build + diff per frame", result.ns,
+                     static_cast<double>(result.frames));
+}
+
+}  // namespace
+
+BENCHMARK(ViewModelReplay) {
+  const int64_t limitMs = context.quick ? 10 * 60 * 1000 : INT64_MAX;
+
+  ReplayResult scheduled;
+  Replay(0, limitMs, &scheduled);
+  Report("scheduler wakeups", scheduled);
+
+  ReplayResult fixed;
+  Replay(1000, limitMs, &fixed);
+  Report("fixed 1 Hz tick", fixed);
+}
@@ -3,7 +3,11 @@
 #include <windows.h>
 #include <commctrl.h>
 
+#include <cwchar>
+
 #include "resource.h"
+#include "BackgroundWriter.h"
+#include "SessionCheckpoint.h"
 #include "SetupDialog.h"
 #include "TimerState.h"
 #include "TimerWindow.h"
@@ -13,7 +17,6 @@
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
                     LPWSTR lpCmdLine, int nCmdShow) {
   UNREFERENCED_PARAMETER(hPrevInstance);
-  UNREFERENCED_PARAMETER(lpCmdLine);
 
   // Set DPI awareness for crisp rendering on high-DPI displays
   SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
@@ -32,16 +35,29 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
   }
 
   TimerConfig config = {};
+  config.ownerDraw = lpCmdLine && wcsstr(lpCmdLine, L"--owner-draw") != NULL;
+
+  // A session still in progress when the app last went down (crash, kill,
+  // power loss) continues where it is now, without the setup dialog.
+  SessionCheckpoint checkpoint;
+  const bool hasCheckpoint = LoadSessionCheckpoint(&checkpoint);
+  if (hasCheckpoint && !checkpoint.IsResumableAt(GetWallClockMilliseconds())) {
+    checkpoint.active = false;
+  }
 
-  // Show setup dialog
-  SetupDialogResult setupResult = ShowSetupDialog(hInstance, NULL, config);
-  if (setupResult == SetupDialogResult::Cancelled) {
-    // User cancelled
-    return 0;
+  SetupDialogResult setupResult = SetupDialogResult::Accepted;
+  if (!checkpoint.active) {
+    // Show setup dialog
+    setupResult = ShowSetupDialog(hInstance, NULL, config);
+    if (setupResult == SetupDialogResult::Cancelled) {
+      // User cancelled
+      return 0;
+    }
   }
 
   // Create and show timer window
-  HWND hTimerWnd = CreateTimerWindow(hInstance, config);
+  HWND hTimerWnd = CreateTimerWindow(hInstance, config,
+                                     hasCheckpoint ? &checkpoint : nullptr);
   if (!hTimerWnd) {
     MessageBox(NULL, L"Failed to create timer window.", L"Error",
                MB_OK | MB_ICONERROR);
@@ -59,5 +75,8 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
     DispatchMessage(&msg);
   }
 
+  // Settings saved while closing are still queued; write them before exit.
+  GetBackgroundWriter().Shutdown();
+
   return 0;
 }
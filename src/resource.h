@@ -29,8 +29,8 @@
 #define IDC_BTN_CLOSE 208
 #define IDC_BTN_SETTINGS 209
 
-// Timer ID
-#define IDT_TIMER 1
+// Timer IDs
+#define IDT_LAYOUT 2
 
 // Icon
 #define IDI_APP_ICON 300
@@ -0,0 +1,133 @@
+// BackgroundWriterTest.cpp - Hammering the writer queue until it overflows
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BackgroundWriter.h"
+#include "TestHarness.h"
+
+namespace {
+
+// Sink that records what would have been written, slowly enough that the
+// producer overruns the queue, and holds the writer until released.
+struct RecordingSink {
+  std::mutex mutex;
+  std::map<std::string, std::vector<std::string>> writes;  // Per path
+  std::map<std::string, std::string> appended;
+  std::atomic<bool> released{false};
+
+  bool Write(const PersistSnapshot& snapshot) {
+    while (!released.load()) std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::microseconds(20));
+    std::lock_guard<std::mutex> lock(mutex);
+    if (snapshot.append) {
+      appended[snapshot.path.string()] += snapshot.contents;
+    } else {
+      writes[snapshot.path.string()].push_back(snapshot.contents);
+    }
+    return true;
+  }
+};
+
+// Snapshots carry "<path>:<sequence>" so order can be checked.
+int SequenceOf(const std::string& contents) {
+  return std::stoi(contents.substr(contents.find(':') + 1));
+}
+
+std::string ReadFile(const std::filesystem::path& file) {
+  std::ifstream in(file, std::ios::binary);
+  std::ostringstream text;
+  text << in.rdbuf();
+  return text.str();
+}
+
+}  // namespace
+
+// Thousands of snapshots for a handful of files, enqueued while the writer
+// is held up so the queue fills and overflows into the stash. Per file the
+// writes must come out in order and end with the newest snapshot, appends
+// must all arrive in order, and every snapshot is either written or
+// superseded.
+TEST(BackgroundWriter, LastWriteWinsUnderOverflow) {
+  constexpr int kSnapshots = 5000;
+  constexpr int kPaths = 4;
+
+  RecordingSink recorder;
+  BackgroundWriter writer;
+  writer.Start([&recorder](const PersistSnapshot& snapshot) {
+    return recorder.Write(snapshot);
+  });
+
+  std::string expectedLog;
+  int last[kPaths] = {};
+  for (int i = 0; i < kSnapshots; i++) {
+    const int path = i % kPaths;
+    const std::string name = "file" + std::to_string(path);
+    writer.Enqueue({name, name + ":" + std::to_string(i), false});
+    last[path] = i;
+    if (i % 3 == 0) {
+      const std::string line = std::to_string(i) + "\n";
+      writer.Enqueue({"journal", line, true});
+      expectedLog += line;
+    }
+    if (i == kSnapshots / 10) recorder.released.store(true);
+    if (i % 64 == 0) std::this_thread::yield();  // Let writes interleave
+  }
+  writer.Shutdown();
+
+  std::printf("  %llu enqueued, %llu written, %llu coalesced, %llu stashed\n",
+              static_cast<unsigned long long>(writer.enqueued.load()),
+              static_cast<unsigned long long>(writer.written.load()),
+              static_cast<unsigned long long>(writer.coalesced.load()),
+              static_cast<unsigned long long>(writer.stashed.load()));
+  CHECK(writer.stashed.load() > 0);
+  CHECK_EQ(writer.failed.load(), 0u);
+  CHECK_EQ(writer.written.load() + writer.coalesced.load(),
+           writer.enqueued.load());
+  CHECK(recorder.appended["journal"] == expectedLog);
+
+  for (int path = 0; path < kPaths; path++) {
+    const std::vector<std::string>& writes =
+        recorder.writes["file" + std::to_string(path)];
+    REQUIRE(!writes.empty());
+    CHECK_EQ(SequenceOf(writes.back()), last[path]);
+    for (size_t i = 1; i < writes.size(); i++) {
+      CHECK(SequenceOf(writes[i - 1]) < SequenceOf(writes[i]));
+    }
+  }
+}
+
+// The same through the default sink onto real files.
+TEST(BackgroundWriter, FilesEndWithNewestSnapshot) {
+  ScratchDirectory scratch("background-writer");
+  const std::filesystem::path settings = scratch.path / "settings.ini";
+  const std::filesystem::path journal = scratch.path / "journal.log";
+
+  BackgroundWriter writer;
+  std::string expectedLog;
+  for (int i = 0; i < 2000; i++) {
+    writer.Enqueue({settings, "[Cover]\nCount=" + std::to_string(i) + "\n",
+                    false});
+    const std::string line = std::to_string(i) + "\n";
+    writer.Enqueue({journal, line, true});
+    expectedLog += line;
+  }
+  writer.Shutdown();
+
+  CHECK(ReadFile(settings) == "[Cover]\nCount=1999\n");
+  CHECK(ReadFile(journal) == expectedLog);
+  CHECK(!std::filesystem::exists(scratch.path / "settings.ini.tmp"));
+  CHECK_EQ(writer.failed.load(), 0u);
+  std::printf("  enqueue p50 %lld ns, p99 %lld ns; write p50 %lld ns\n",
+              static_cast<long long>(writer.enqueueLatency.PercentileNs(0.5)),
+              static_cast<long long>(writer.enqueueLatency.PercentileNs(0.99)),
+              static_cast<long long>(writer.writeLatency.PercentileNs(0.5)));
+}
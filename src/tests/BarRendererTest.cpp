@@ -0,0 +1,161 @@
+// BarRendererTest.cpp - Incremental repaints against full renders, per pixel
+
+#include <cstring>
+#include <vector>
+
+#include "BarRenderer.h"
+#include "TestHarness.h"
+#include "TickScheduler.h"
+
+namespace {
+
+struct Frame {
+  TimerState state = {};
+  ManualTimerClock clock;
+  GlyphAtlas atlas;
+  TimerLayout layout = {};
+
+  explicit Frame(int dpi) {
+    TimerConfig config = {};
+    config.timePerBlock = 3;
+    config.numBlocks = 2;
+    config.numQuestions = 4;
+    config.transparency = 100;
+    state.Initialize(config, &clock);
+    layout = ComputeTimerLayout(dpi);
+    BuildBuiltinGlyphAtlas(dpi, &atlas);
+  }
+
+  int QuestionBarWidth() const {
+    return layout.rects[kElementQuestionProgress].Width();
+  }
+  int BlockBarWidth() const {
+    return layout.rects[kElementBlockProgress].Width();
+  }
+
+  void Build(TimerViewModel* view) const {
+    BuildTimerViewModel(state, QuestionBarWidth(), BlockBarWidth(), view);
+  }
+
+  void Attach(BarRenderer* renderer, uint32_t* memory) const {
+    renderer->layout = layout;
+    renderer->atlas = &atlas;
+    if (memory) {
+      renderer->surface.Attach(memory, layout.windowWidth,
+                               layout.windowHeight);
+    } else {
+      renderer->surface.Allocate(layout.windowWidth, layout.windowHeight);
+    }
+  }
+};
+
+size_t PixelCount(const PixelSurface& surface) {
+  return static_cast<size_t>(surface.width) * surface.height;
+}
+
+bool SamePixels(const PixelSurface& a, const PixelSurface& b) {
+  return a.width == b.width && a.height == b.height &&
+         std::memcmp(a.pixels, b.pixels, PixelCount(a) * sizeof(uint32_t)) ==
+             0;
+}
+
+// Pixels that differ between before and after but lie in no dirty rect
+int CountUnreportedChanges(const std::vector<uint32_t>& before,
+                           const BarRenderer& renderer) {
+  int unreported = 0;
+  const PixelSurface& surface = renderer.surface;
+  for (int y = 0; y < surface.height; y++) {
+    const size_t row = static_cast<size_t>(y) * surface.width;
+    if (std::memcmp(&before[row], surface.pixels + row,
+                    surface.width * sizeof(uint32_t)) == 0) {
+      continue;  // Most rows do not change between frames
+    }
+    for (int x = 0; x < surface.width; x++) {
+      const size_t i = row + x;
+      if (before[i] == surface.pixels[i]) continue;
+      bool covered = false;
+      for (int d = 0; d < renderer.dirtyCount && !covered; d++) {
+        covered = renderer.dirty[d].Contains(x, y);
+      }
+      if (!covered) unreported++;
+    }
+  }
+  return unreported;
+}
+
+}  // namespace
+
+// Replays a whole session frame by frame, repainting only what the differ
+// reports, into an external memory bitmap as the window's DIB section. After
+// every frame the bitmap must equal a from-scratch render of the same view
+// pixel for pixel, and every changed pixel must lie in a dirty rectangle.
+TEST(BarRenderer, IncrementalFramesMatchFullRenders) {
+  for (const int dpi : {96, 120, 144, 192}) {
+    Frame frame(dpi);
+    std::vector<uint32_t> bitmap(
+        static_cast<size_t>(frame.layout.windowWidth) *
+        frame.layout.windowHeight);
+    BarRenderer incremental;
+    frame.Attach(&incremental, bitmap.data());
+    BarRenderer full;
+    frame.Attach(&full, nullptr);
+
+    TimerViewModel view;
+    frame.Build(&view);
+    TimerViewDiffer differ;
+    differ.Commit(view);
+    incremental.RenderAll(view);
+
+    int frames = 0;
+    int mismatches = 0;
+    int unreported = 0;
+    std::vector<uint32_t> before;
+    while (frame.state.currentTime > 0) {
+      const int64_t delay = TickScheduler::NextWakeDelay(
+          frame.state, true, frame.QuestionBarWidth(), frame.BlockBarWidth());
+      frame.clock.nowMs += delay < 0 ? 1000 : delay;  // Paused: stay a second
+      frames++;
+      if (frames % 97 == 0) frame.state.TogglePause();
+      if (frames % 211 == 0) frame.state.SetPaused(false);
+      frame.state.Tick();
+
+      before = bitmap;
+      frame.Build(&view);
+      incremental.Render(view, differ.Commit(view));
+      unreported += CountUnreportedChanges(before, incremental);
+      if (frames % 50 == 0) {
+        // Press and release a button between frames, as a click does
+        for (const int pressed : {int{kElementPauseButton}, -1}) {
+          before = bitmap;
+          incremental.SetPressed(pressed, view);
+          unreported += CountUnreportedChanges(before, incremental);
+        }
+      }
+
+      full.RenderAll(view);
+      if (!SamePixels(incremental.surface, full.surface)) mismatches++;
+    }
+    CHECK(frames > 360);
+    CHECK_EQ(mismatches, 0);
+    CHECK_EQ(unreported, 0);
+  }
+}
+
+TEST(BarRenderer, PressedButtonChangesOnlyThatButton) {
+  Frame frame(96);
+  BarRenderer renderer;
+  frame.Attach(&renderer, nullptr);
+  TimerViewModel view;
+  frame.Build(&view);
+  renderer.RenderAll(view);
+
+  const std::vector<uint32_t> before = renderer.surface.storage;
+  CHECK_EQ(renderer.SetPressed(kElementStartStopButton, view), 1);
+  CHECK_EQ(CountUnreportedChanges(before, renderer), 0);
+  CHECK(std::memcmp(before.data(), renderer.surface.pixels,
+                    before.size() * sizeof(uint32_t)) != 0);
+  CHECK_EQ(renderer.SetPressed(kElementStartStopButton, view), 0);
+  CHECK_EQ(renderer.SetPressed(-1, view), 1);
+  CHECK(std::memcmp(before.data(), renderer.surface.pixels,
+                    before.size() * sizeof(uint32_t)) == 0);
+}
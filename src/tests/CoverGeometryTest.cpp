@@ -0,0 +1,58 @@
+// CoverGeometryTest.cpp - Drag invariants over a random mouse trace
+
+#include "CoverGeometry.h"
+#include "TestHarness.h"
+
+// Every drag result stays inside the bounds and above the minimum size, and
+// resizing never moves the edges opposite the grip.
+TEST(CoverGeometry, DragsRespectLimitsAndAnchors) {
+  const CoverLimits limits = ComputeCoverLimits({-1920, 0, 3840, 1080}, 10, 20);
+  const CoverRect start = {400, 300, 800, 500};
+  TestRandom random;
+
+  for (int mode = static_cast<int>(DragMode::Move);
+       mode <= static_cast<int>(DragMode::BottomRight); mode++) {
+    const DragMode drag = static_cast<DragMode>(mode);
+    for (int i = 0; i < 20000; i++) {
+      const int dx = static_cast<int>(random.Between(-8000, 8000));
+      const int dy = static_cast<int>(random.Between(-3000, 3000));
+      const CoverRect next = ApplyDrag(limits, drag, start, dx, dy);
+      CHECK(next.left >= limits.bounds.left);
+      CHECK(next.top >= limits.bounds.top);
+      CHECK(next.right <= limits.bounds.right);
+      CHECK(next.bottom <= limits.bounds.bottom);
+      CHECK(next.Width() >= limits.minWidth);
+      CHECK(next.Height() >= limits.minHeight);
+
+      if (drag == DragMode::Move) {
+        CHECK_EQ(next.Width(), start.Width());
+        CHECK_EQ(next.Height(), start.Height());
+      }
+      if (drag == DragMode::Right || drag == DragMode::BottomRight ||
+          drag == DragMode::TopRight) {
+        CHECK_EQ(next.left, start.left);
+      }
+      if (drag == DragMode::Left || drag == DragMode::BottomLeft ||
+          drag == DragMode::TopLeft) {
+        CHECK_EQ(next.right, start.right);
+      }
+      if (drag == DragMode::Bottom || drag == DragMode::BottomLeft ||
+          drag == DragMode::BottomRight) {
+        CHECK_EQ(next.top, start.top);
+      }
+      if (drag == DragMode::Top || drag == DragMode::TopLeft ||
+          drag == DragMode::TopRight) {
+        CHECK_EQ(next.bottom, start.bottom);
+      }
+    }
+  }
+}
+
+TEST(CoverGeometry, HitTestFindsGrips) {
+  const CoverRect client = {0, 0, 400, 200};
+  CHECK_EQ(HitTestDragMode(client, 8, 200, 100), DragMode::Move);
+  CHECK_EQ(HitTestDragMode(client, 8, 2, 2), DragMode::TopLeft);
+  CHECK_EQ(HitTestDragMode(client, 8, 398, 198), DragMode::BottomRight);
+  CHECK_EQ(HitTestDragMode(client, 8, 399, 100), DragMode::Right);
+  CHECK_EQ(HitTestDragMode(client, 8, 200, 1), DragMode::Top);
+}
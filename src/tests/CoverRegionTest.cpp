@@ -0,0 +1,73 @@
+// CoverRegionTest.cpp - Rect union and grid hit-testing against brute force
+
+#include <vector>
+
+#include "CoverRegion.h"
+#include "TestHarness.h"
+
+namespace {
+
+bool Contains(const CoverRect& rect, int x, int y) {
+  return x >= rect.left && x < rect.right && y >= rect.top && y < rect.bottom;
+}
+
+int LinearHitTest(const std::vector<CoverRect>& rects, int x, int y) {
+  for (int i = static_cast<int>(rects.size()) - 1; i >= 0; i--) {
+    if (Contains(rects[static_cast<size_t>(i)], x, y)) return i;
+  }
+  return -1;
+}
+
+std::vector<CoverRect> RandomRects(TestRandom* random, int count, int extent) {
+  std::vector<CoverRect> rects;
+  for (int i = 0; i < count; i++) {
+    const int left = static_cast<int>(random->Between(0, extent - 1));
+    const int top = static_cast<int>(random->Between(0, extent - 1));
+    const int width = static_cast<int>(random->Between(0, extent / 4));
+    const int height = static_cast<int>(random->Between(0, extent / 4));
+    rects.push_back({left, top, left + width, top + height});
+  }
+  return rects;
+}
+
+}  // namespace
+
+// Hundreds of overlapping (and some empty) rects: the union must cover
+// exactly the same pixels, with disjoint rects in y-x banded order.
+TEST(CoverRegion, UnionCoversExactlyTheSamePixels) {
+  TestRandom random;
+  for (const int count : {1, 10, 200, 400}) {
+    const int extent = 240;
+    const std::vector<CoverRect> rects = RandomRects(&random, count, extent);
+    const std::vector<CoverRect> bands = ComputeRectUnion(rects);
+
+    for (size_t i = 1; i < bands.size(); i++) {
+      const CoverRect& a = bands[i - 1];
+      const CoverRect& b = bands[i];
+      CHECK(a.top < b.top || (a.top == b.top && a.right <= b.left));
+    }
+    for (int y = 0; y < extent + extent / 4; y++) {
+      for (int x = 0; x < extent + extent / 4; x++) {
+        const bool covered = LinearHitTest(rects, x, y) >= 0;
+        int hits = 0;
+        for (const CoverRect& band : bands) hits += Contains(band, x, y);
+        CHECK_EQ(hits, covered ? 1 : 0);
+      }
+    }
+  }
+  CHECK(ComputeRectUnion({}).empty());
+}
+
+TEST(CoverRegion, GridHitTestMatchesLinearScan) {
+  TestRandom random;
+  for (const int count : {0, 1, 50, 300, 1000}) {
+    const std::vector<CoverRect> rects = RandomRects(&random, count, 4000);
+    CoverGridIndex index;
+    index.Build(rects, 64);
+    for (int i = 0; i < 20000; i++) {
+      const int x = static_cast<int>(random.Between(-100, 5100));
+      const int y = static_cast<int>(random.Between(-100, 5100));
+      CHECK_EQ(index.HitTest(rects, x, y), LinearHitTest(rects, x, y));
+    }
+  }
+}
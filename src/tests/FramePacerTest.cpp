@@ -0,0 +1,102 @@
+// FramePacerTest.cpp - Frame pacing of mouse input on a simulated clock
+
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+
+#include "FramePacer.h"
+#include "TestHarness.h"
+
+namespace {
+
+struct PacedRun {
+  int applies = 0;
+  int64_t minGapUs = INT64_MAX;  // Shortest time between two applies
+  int64_t lastApplyUs = -1;
+  bool finalInputApplied = false;
+};
+
+// Feeds a mouse reporting every inputPeriodUs for durationUs, then silence,
+// applying whenever the pacer allows: at once from OnInput(), or from the
+// one-shot wakeup armed with DelayUntilNextFrameUs().
+PacedRun Simulate(FramePacer* pacer, int64_t inputPeriodUs,
+                  int64_t durationUs) {
+  PacedRun run;
+  int64_t wakeUs = -1;  // Pending one-shot timer
+  auto apply = [&](int64_t nowUs) {
+    pacer->OnApplied(nowUs);
+    if (run.lastApplyUs >= 0 && nowUs - run.lastApplyUs < run.minGapUs) {
+      run.minGapUs = nowUs - run.lastApplyUs;
+    }
+    run.lastApplyUs = nowUs;
+    run.applies++;
+  };
+
+  int64_t nextInputUs = 0;
+  while (nextInputUs < durationUs || wakeUs >= 0) {
+    if (wakeUs >= 0 && (wakeUs <= nextInputUs || nextInputUs >= durationUs)) {
+      const int64_t nowUs = wakeUs;
+      wakeUs = -1;
+      if (pacer->DelayUntilNextFrameUs(nowUs) == 0) apply(nowUs);
+      continue;
+    }
+
+    const int64_t nowUs = nextInputUs;
+    nextInputUs += inputPeriodUs;
+    if (pacer->OnInput(nowUs)) {
+      apply(nowUs);
+    } else if (wakeUs < 0) {
+      wakeUs = nowUs + pacer->DelayUntilNextFrameUs(nowUs);
+    }
+  }
+  run.finalInputApplied = !pacer->pending;
+  return run;
+}
+
+}  // namespace
+
+// Two seconds of a 1000 Hz mouse at several refresh rates: one update per
+// frame at most, the last position always lands, and no input waits longer
+// than a frame.
+TEST(FramePacer, OneUpdatePerFrameFromThousandHertzInput) {
+  for (const int hz : {30, 60, 144, 240}) {
+    FramePacer pacer;
+    pacer.SetRefreshRate(hz);
+    const int64_t durationUs = 2000000;
+    const PacedRun run = Simulate(&pacer, 1000, durationUs);
+
+    std::printf("  %3d Hz: %llu moves received, %llu applied, lag avg %lld "
+                "us, max %lld us\n",
+                hz, static_cast<unsigned long long>(pacer.received),
+                static_cast<unsigned long long>(pacer.applied),
+                static_cast<long long>(pacer.AverageLagUs()),
+                static_cast<long long>(pacer.maxLagUs));
+    CHECK_EQ(pacer.received, 2000u);
+    CHECK_EQ(pacer.applied, static_cast<uint64_t>(run.applies));
+    CHECK(run.finalInputApplied);
+    CHECK(run.minGapUs >= pacer.frameIntervalUs);
+    CHECK(pacer.maxLagUs <= pacer.frameIntervalUs);
+    const int64_t frames = durationUs / pacer.frameIntervalUs;
+    CHECK(static_cast<int64_t>(pacer.applied) <= frames + 2);
+    CHECK(static_cast<int64_t>(pacer.applied) >= frames - 2);
+    CHECK_EQ(pacer.Coalesced(), pacer.received - pacer.applied);
+  }
+}
+
+// Input slower than the display is applied as it arrives, without delay.
+TEST(FramePacer, SlowInputIsNotDelayed) {
+  FramePacer pacer;
+  pacer.SetRefreshRate(60);
+  const PacedRun run = Simulate(&pacer, 50000, 1000000);
+  CHECK_EQ(pacer.received, 20u);
+  CHECK_EQ(pacer.applied, 20u);
+  CHECK_EQ(pacer.maxLagUs, 0);
+  CHECK(run.finalInputApplied);
+}
+
+TEST(FramePacer, DefaultRefreshRateFallback) {
+  FramePacer pacer;
+  pacer.SetRefreshRate(1);
+  CHECK_EQ(pacer.frameIntervalUs, 1000000 / FramePacer::kDefaultRefreshRate);
+  CHECK_EQ(pacer.DelayUntilNextFrameUs(0), -1);
+}
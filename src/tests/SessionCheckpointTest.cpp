@@ -0,0 +1,154 @@
+// SessionCheckpointTest.cpp - Recovery from a crash at every byte of a save
+
+#include <fstream>
+#include <initializer_list>
+#include <iterator>
+#include <string>
+
+#include "SessionCheckpoint.h"
+#include "SettingsStore.h"
+#include "TestHarness.h"
+
+namespace {
+
+// The checkpoint a session saves as its sequence-th write
+SessionCheckpoint MakeCheckpoint(uint32_t sequence) {
+  SessionCheckpoint checkpoint;
+  checkpoint.sequence = sequence;
+  checkpoint.active = true;
+  checkpoint.paused = sequence % 3 == 0;
+  checkpoint.timePerBlock = 60;
+  checkpoint.numBlocks = 4;
+  checkpoint.numQuestions = 40;
+  checkpoint.transparency = 90;
+  checkpoint.savedAtMs = 1700000000000 + int64_t{sequence} * 60000;
+  checkpoint.heldMs = int64_t{sequence} * 60000;
+  checkpoint.wallOriginMs = checkpoint.savedAtMs - checkpoint.heldMs;
+  return checkpoint;
+}
+
+bool SaveSlot(const std::filesystem::path& dir, uint32_t sequence) {
+  return WriteFileAtomically(GetSessionCheckpointPath(dir, sequence % 2),
+                             EncodeSessionCheckpoint(MakeCheckpoint(sequence)));
+}
+
+void WriteRaw(const std::filesystem::path& file, const std::string& bytes) {
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+bool SameCheckpoint(const SessionCheckpoint& a, const SessionCheckpoint& b) {
+  return a.sequence == b.sequence && a.active == b.active &&
+         a.paused == b.paused && a.stopped == b.stopped &&
+         a.timePerBlock == b.timePerBlock && a.numBlocks == b.numBlocks &&
+         a.numQuestions == b.numQuestions &&
+         a.transparency == b.transparency &&
+         a.wallOriginMs == b.wallOriginMs && a.heldMs == b.heldMs &&
+         a.savedAtMs == b.savedAtMs;
+}
+
+// Loads from dir and checks the result is the checkpoint of write expected
+// (0 meaning none at all). Returns false on a mismatch.
+bool RecoversWrite(const std::filesystem::path& dir, uint32_t expected) {
+  SessionCheckpoint loaded;
+  const bool found = LoadSessionCheckpoint(dir, &loaded);
+  if (expected == 0) return !found;
+  return found && SameCheckpoint(loaded, MakeCheckpoint(expected));
+}
+
+}  // namespace
+
+TEST(SessionCheckpoint, EncodeDecodeRoundTrip) {
+  const SessionCheckpoint checkpoint = MakeCheckpoint(7);
+  const std::string bytes = EncodeSessionCheckpoint(checkpoint);
+  CHECK_EQ(bytes.size(), SessionCheckpoint::kEncodedSize);
+  SessionCheckpoint decoded;
+  REQUIRE(DecodeSessionCheckpoint(bytes, &decoded));
+  CHECK(SameCheckpoint(decoded, checkpoint));
+}
+
+// Saves writes 1..4 in turn and, before each one lands, crashes it at every
+// byte in every way a save can be cut short:
+//   - the temporary file is torn and never renamed over the slot;
+//   - the rename reached the disk but the data did not, leaving the slot
+//     truncated at that byte, or with that byte scrambled.
+// Every time, loading must come back with the previous write intact.
+TEST(SessionCheckpoint, RecoversFromCrashAtEveryByte) {
+  ScratchDirectory scratch("checkpoint-crash");
+  const std::filesystem::path& dir = scratch.path;
+  constexpr size_t kSize = SessionCheckpoint::kEncodedSize;
+
+  int failures = 0;
+  for (uint32_t write = 1; write <= 4; write++) {
+    const std::filesystem::path slot = GetSessionCheckpointPath(dir, write % 2);
+    std::filesystem::path temp = slot;
+    temp += ".tmp";
+    const std::string bytes = EncodeSessionCheckpoint(MakeCheckpoint(write));
+
+    // Keep whatever the slot held before this write to put it back.
+    std::string previous;
+    {
+      std::ifstream in(slot, std::ios::binary);
+      previous.assign(std::istreambuf_iterator<char>(in),
+                      std::istreambuf_iterator<char>());
+    }
+    const bool hadPrevious = std::filesystem::exists(slot);
+
+    for (size_t at = 0; at < kSize; at++) {
+      WriteRaw(temp, bytes.substr(0, at));
+      if (!RecoversWrite(dir, write - 1)) failures++;
+      std::filesystem::remove(temp);
+
+      WriteRaw(slot, bytes.substr(0, at));
+      if (!RecoversWrite(dir, write - 1)) failures++;
+
+      for (const unsigned char flip : {0x01, 0x80, 0xFF}) {
+        std::string damaged = bytes;
+        damaged[at] = static_cast<char>(damaged[at] ^ flip);
+        WriteRaw(slot, damaged);
+        if (!RecoversWrite(dir, write - 1)) failures++;
+      }
+
+      if (hadPrevious) {
+        WriteRaw(slot, previous);
+      } else {
+        std::filesystem::remove(slot);
+      }
+    }
+
+    // A record with trailing garbage is torn too.
+    WriteRaw(slot, bytes + '\0');
+    CHECK(RecoversWrite(dir, write - 1));
+
+    // The write that completes is the one recovered from then on.
+    REQUIRE(SaveSlot(dir, write));
+    CHECK(!std::filesystem::exists(temp));
+    CHECK(RecoversWrite(dir, write));
+  }
+  CHECK_EQ(failures, 0);
+}
+
+TEST(SessionCheckpoint, BothSlotsDamagedRecoversNothing) {
+  ScratchDirectory scratch("checkpoint-damaged");
+  const std::filesystem::path& dir = scratch.path;
+  CHECK(RecoversWrite(dir, 0));
+  REQUIRE(SaveSlot(dir, 1));
+  REQUIRE(SaveSlot(dir, 2));
+  CHECK(RecoversWrite(dir, 2));
+
+  WriteRaw(GetSessionCheckpointPath(dir, 0), "");
+  WriteRaw(GetSessionCheckpointPath(dir, 1), std::string(64, 'x'));
+  CHECK(RecoversWrite(dir, 0));
+}
+
+TEST(SessionCheckpoint, NewestWinsAcrossSequenceWrap) {
+  ScratchDirectory scratch("checkpoint-wrap");
+  const std::filesystem::path& dir = scratch.path;
+  REQUIRE(SaveSlot(dir, 0xFFFFFFFFu));
+  CHECK(RecoversWrite(dir, 0xFFFFFFFFu));
+  REQUIRE(WriteFileAtomically(GetSessionCheckpointPath(dir, 0),
+                              EncodeSessionCheckpoint(MakeCheckpoint(0))));
+  SessionCheckpoint loaded;
+  REQUIRE(LoadSessionCheckpoint(dir, &loaded));
+  CHECK_EQ(loaded.sequence, 0u);
+}
@@ -0,0 +1,464 @@
+// SessionFleetTest.cpp - Fleet transitions against TimerState, commands, reuse
+
+#include <initializer_list>
+#include <vector>
+
+#include "SessionFleet.h"
+#include "TestHarness.h"
+#include "TimerClock.h"
+#include "TimerState.h"
+
+namespace {
+
+// Every kind of boundary: weighted and zero-length questions, breaks (one of
+// them zero-length), a zero-length block and section changes.
+SessionPlan MakeMixedPlan() {
+  SessionPlan plan;
+  const int weights[] = {1, 0, 3};
+  plan.AddBlock(0, 100, 3, weights);
+  plan.AddBreak(0, 0);
+  plan.AddBreak(0, 50);
+  plan.AddBlock(1, 7, 10);
+  plan.AddBlock(1, 0, 2);
+  plan.AddBreak(1, 30);
+  plan.AddBlock(2, 45, 4);
+  return plan;
+}
+
+// One block of seconds, split into questions of equal length
+SessionPlan MakeSimplePlan(int64_t seconds, int questions) {
+  SessionPlan plan;
+  plan.AddBlock(0, seconds, questions);
+  return plan;
+}
+
+bool SameEvent(const TimerEvent& a, const TimerEvent& b) {
+  return a.type == b.type && a.atSecond == b.atSecond && a.block == b.block &&
+         a.question == b.question;
+}
+
+// A fleet and, for each of its sessions, a TimerState on the same manual
+// clock, given the same commands. The events each reports are collected per
+// session id.
+struct MirroredFleet {
+  ManualTimerClock clock;
+  SessionFleet fleet;
+  std::vector<SessionPlan> plans;
+  std::vector<TimerState> states;
+  std::vector<bool> live;
+  std::vector<std::vector<FleetEvent>> fleetEvents;
+  std::vector<std::vector<TimerEvent>> stateEvents;
+  int fullBatches = 0;
+  int splitBoundaries = 0;  // Batches ending between a boundary's events
+
+  explicit MirroredFleet(int64_t startMs) {
+    clock.nowMs = startMs;
+    fleet.Reset(startMs);
+  }
+
+  int AddPlan(const SessionPlan& plan) {
+    plans.push_back(plan);
+    return fleet.AddPlan(plan);
+  }
+
+  uint32_t AddSession(int plan, int group) {
+    const uint32_t id = fleet.AddSession(plan, group, clock.nowMs);
+    if (id >= states.size()) {
+      states.resize(id + 1);
+      live.resize(id + 1);
+      fleetEvents.resize(id + 1);
+      stateEvents.resize(id + 1);
+    }
+    states[id].InitializeWithPlan(TimerConfig(), plans[plan], &clock);
+    states[id].Stop();
+    live[id] = true;
+    fleetEvents[id].clear();
+    stateEvents[id].clear();
+    return id;
+  }
+
+  void RemoveSession(uint32_t id) {
+    fleet.RemoveSession(id);
+    live[id] = false;
+  }
+
+  void Start(uint32_t id) {
+    states[id].Start();
+    fleet.Start(id, clock.nowMs);
+  }
+
+  void Stop(uint32_t id) {
+    states[id].Stop();
+    fleet.Stop(id, clock.nowMs);
+  }
+
+  void SetPaused(uint32_t id, bool pause) {
+    states[id].SetPaused(pause);
+    fleet.SetPaused(id, pause, clock.nowMs);
+  }
+
+  void SeekTo(uint32_t id, int64_t elapsedMs) {
+    states[id].SeekTo(elapsedMs);
+    fleet.SeekTo(id, elapsedMs, clock.nowMs);
+  }
+
+  void StartGroup(int group) {
+    for (const uint32_t id : fleet.GroupMembers(group)) states[id].Start();
+    fleet.StartGroup(group, clock.nowMs);
+  }
+
+  void SetGroupPaused(int group, bool pause) {
+    for (const uint32_t id : fleet.GroupMembers(group)) {
+      states[id].SetPaused(pause);
+    }
+    fleet.SetGroupPaused(group, pause, clock.nowMs);
+  }
+
+  // One Advance() of the fleet at nowMs. Returns true if the batch filled up.
+  bool AdvanceFleetOnce(int64_t nowMs) {
+    clock.nowMs = nowMs;
+    FleetEventBatch batch;
+    const bool full = fleet.Advance(nowMs, &batch);
+    if (full) fullBatches++;
+    if (batch.count > 0 && batch.events[batch.count - 1].event.type ==
+                               TimerEventType::BlockAdvanced) {
+      splitBoundaries++;
+    }
+    for (int i = 0; i < batch.count; i++) {
+      fleetEvents[batch.events[i].session].push_back(batch.events[i]);
+    }
+    return full;
+  }
+
+  // Moves the clock to nowMs and drains the fleet and every TimerState.
+  void AdvanceTo(int64_t nowMs) {
+    while (AdvanceFleetOnce(nowMs)) {
+    }
+    for (uint32_t id = 0; id < states.size(); id++) {
+      if (!live[id]) continue;
+      TimerEventBatch batch;
+      bool more = true;
+      while (more) {
+        more = states[id].Advance(&batch);
+        for (int i = 0; i < batch.count; i++) {
+          stateEvents[id].push_back(batch.events[i]);
+        }
+      }
+    }
+  }
+
+  // Sessions whose events, elapsed time or position differ from their
+  // TimerState's.
+  int Mismatches() const {
+    int mismatches = 0;
+    for (uint32_t id = 0; id < states.size(); id++) {
+      if (!live[id]) continue;
+      bool same = fleetEvents[id].size() == stateEvents[id].size();
+      for (size_t i = 0; same && i < fleetEvents[id].size(); i++) {
+        same = SameEvent(fleetEvents[id][i].event, stateEvents[id][i]);
+      }
+      const TimerPosition pos = fleet.PositionAt(id, clock.nowMs);
+      same = same &&
+             fleet.GetElapsedMilliseconds(id, clock.nowMs) ==
+                 states[id].GetElapsedMilliseconds() &&
+             pos.currentTime == states[id].currentTime &&
+             pos.segmentIndex == states[id].segmentIndex &&
+             fleet.IsRunning(id) == states[id].IsRunning() &&
+             fleet.IsPaused(id) == states[id].paused;
+      if (!same) mismatches++;
+    }
+    return mismatches;
+  }
+
+  size_t FleetEventCount() const {
+    size_t count = 0;
+    for (const std::vector<FleetEvent>& events : fleetEvents) {
+      count += events.size();
+    }
+    return count;
+  }
+
+  std::vector<int64_t> DueTimes(uint32_t id) const {
+    std::vector<int64_t> times;
+    for (const FleetEvent& event : fleetEvents[id]) {
+      times.push_back(event.dueMs);
+    }
+    return times;
+  }
+};
+
+}  // namespace
+
+// Sessions started at staggered times on two plans, followed to the end in
+// uneven steps: each reports exactly what its TimerState does, stamped with
+// the fleet time its boundary fell at, and leaves the wheel once completed.
+TEST(SessionFleet, EventsMatchTimerStateOverFullPlan) {
+  TimerConfig config = {};
+  config.timePerBlock = 3;
+  config.numBlocks = 3;
+  config.numQuestions = 7;
+  config.ComputeDerivedValues();
+
+  const int64_t startMs = 1234567;
+  MirroredFleet mirror(startMs);
+  const int plans[] = {mirror.AddPlan(MakeMixedPlan()),
+                       mirror.AddPlan(BuildSessionPlan(config))};
+  std::vector<int64_t> sessionStartMs;
+  for (int i = 0; i < 40; i++) {
+    const uint32_t id = mirror.AddSession(plans[i % 2], -1);
+    mirror.clock.nowMs = startMs + i * 137;
+    mirror.Start(id);
+    sessionStartMs.push_back(mirror.clock.nowMs);
+  }
+
+  TestRandom random;
+  int lateWakes = 0;
+  int64_t nowMs = mirror.clock.nowMs;
+  const int64_t endMs = startMs + 40 * 137 + 600 * 1000;
+  while (nowMs < endMs) {
+    // Nothing falls due before the fleet's wake time.
+    const int64_t wakeMs = mirror.fleet.NextWakeMs();
+    if (wakeMs > nowMs + 1) {
+      const size_t reported = mirror.FleetEventCount();
+      nowMs = wakeMs - 1;
+      mirror.AdvanceTo(nowMs);
+      if (mirror.FleetEventCount() != reported) lateWakes++;
+    }
+    nowMs += random.Between(0, 4) == 0 ? random.Between(1, 20000)
+                                       : random.Between(1, 1500);
+    mirror.AdvanceTo(nowMs);
+  }
+  CHECK_EQ(lateWakes, 0);
+  CHECK_EQ(mirror.Mismatches(), 0);
+
+  int wrongDue = 0;
+  for (uint32_t id = 0; id < mirror.states.size(); id++) {
+    const std::vector<FleetEvent>& events = mirror.fleetEvents[id];
+    REQUIRE(!events.empty());
+    CHECK(events.back().event.type == TimerEventType::Completed);
+    for (const FleetEvent& event : events) {
+      if (event.session != id ||
+          event.dueMs != sessionStartMs[id] + event.event.atSecond * 1000) {
+        wrongDue++;
+      }
+    }
+  }
+  CHECK_EQ(wrongDue, 0);
+  CHECK_EQ(mirror.fleet.ScheduledCount(), 0u);
+  CHECK_EQ(mirror.fleet.NextWakeMs(), -1);
+}
+
+// Pausing a session, or its whole group, delays its remaining boundaries by
+// the time spent paused; sessions outside the group keep their times.
+TEST(SessionFleet, PauseAndResumeShiftBoundaries) {
+  MirroredFleet mirror(0);
+  const int plan = mirror.AddPlan(MakeSimplePlan(100, 4));
+  const int paused = mirror.fleet.AddGroup();
+  const int other = mirror.fleet.AddGroup();
+  const uint32_t a = mirror.AddSession(plan, paused);
+  const uint32_t b = mirror.AddSession(plan, paused);
+  const uint32_t c = mirror.AddSession(plan, other);
+  mirror.StartGroup(paused);
+  mirror.StartGroup(other);
+
+  for (int64_t nowMs = 0; nowMs <= 130000; nowMs += 500) {
+    mirror.AdvanceTo(nowMs);
+    if (nowMs == 10000) mirror.SetPaused(a, true);
+    if (nowMs == 20000) mirror.SetPaused(a, false);
+    if (nowMs == 30000) {
+      mirror.SetGroupPaused(paused, true);
+      CHECK_EQ(mirror.fleet.ScheduledCount(), 1u);
+      CHECK(mirror.fleet.IsPaused(b));
+      CHECK(mirror.fleet.IsRunning(c));
+    }
+    if (nowMs == 45000) mirror.SetGroupPaused(paused, false);
+  }
+  CHECK_EQ(mirror.Mismatches(), 0);
+
+  // a: paused 10 s, then 15 s with its group; b: 15 s; c: never
+  CHECK(mirror.DueTimes(a) ==
+        std::vector<int64_t>({50000, 75000, 100000, 125000}));
+  CHECK(mirror.DueTimes(b) ==
+        std::vector<int64_t>({25000, 65000, 90000, 115000}));
+  CHECK(mirror.DueTimes(c) ==
+        std::vector<int64_t>({25000, 50000, 75000, 100000}));
+}
+
+// Thousands of sessions crossing boundaries at the same instant overflow a
+// batch many times over. Draining resumes where the last batch stopped, even
+// when the clock has moved on meanwhile, and never splits a boundary.
+TEST(SessionFleet, FullBatchResumesWithoutLoss) {
+  TimerConfig config = {};
+  config.timePerBlock = 1;
+  config.numBlocks = 3;
+  config.numQuestions = 2;
+  config.ComputeDerivedValues();
+
+  MirroredFleet mirror(0);
+  const int plan = mirror.AddPlan(BuildSessionPlan(config));
+  const int group = mirror.fleet.AddGroup();
+  for (int i = 0; i < 2000; i++) mirror.AddSession(plan, group);
+  mirror.StartGroup(group);
+
+  // The first two blocks at once, then the rest from a later clock reading
+  // before the first pass has been drained.
+  CHECK(mirror.AdvanceFleetOnce(120000));
+  mirror.AdvanceTo(150000);
+  CHECK(mirror.fullBatches > 2000 * 4 / FleetEventBatch::kCapacity);
+  mirror.AdvanceTo(180000);
+  CHECK_EQ(mirror.Mismatches(), 0);
+
+  CHECK_EQ(mirror.splitBoundaries, 0);
+  // Per session: question 2, block 2 (two events), question 2, block 3 (two
+  // events), question 2, completion
+  CHECK_EQ(mirror.FleetEventCount(), 2000u * 8);
+}
+
+TEST(SessionFleet, RemoveSessionReusesId) {
+  MirroredFleet mirror(0);
+  const int plan = mirror.AddPlan(MakeSimplePlan(60, 3));
+  const int first = mirror.fleet.AddGroup();
+  const int second = mirror.fleet.AddGroup();
+  const uint32_t a = mirror.AddSession(plan, first);
+  const uint32_t b = mirror.AddSession(plan, first);
+  const uint32_t c = mirror.AddSession(plan, first);
+  mirror.StartGroup(first);
+  CHECK_EQ(mirror.fleet.SessionCount(), 3u);
+
+  mirror.RemoveSession(b);
+  mirror.RemoveSession(b);
+  CHECK_EQ(mirror.fleet.SessionCount(), 2u);
+  CHECK_EQ(mirror.fleet.ScheduledCount(), 2u);
+  CHECK(mirror.fleet.GroupMembers(first) == std::vector<uint32_t>({a, c}));
+
+  // The id comes back clean, in its new group, and does not inherit the
+  // removed session's schedule.
+  mirror.AdvanceTo(10000);
+  const uint32_t d = mirror.AddSession(plan, second);
+  CHECK_EQ(d, b);
+  CHECK(mirror.fleet.IsStopped(d));
+  CHECK_EQ(mirror.fleet.GetElapsedMilliseconds(d, 10000), 0);
+  CHECK(mirror.fleet.GroupMembers(second) == std::vector<uint32_t>({d}));
+  mirror.AdvanceTo(30000);
+  CHECK(mirror.fleetEvents[d].empty());
+  mirror.Start(d);
+
+  // Removing the member whose slot the last removal refilled
+  mirror.RemoveSession(a);
+  CHECK(mirror.fleet.GroupMembers(first) == std::vector<uint32_t>({c}));
+  mirror.AdvanceTo(100000);
+  CHECK_EQ(mirror.Mismatches(), 0);
+  CHECK(mirror.DueTimes(c) == std::vector<int64_t>({20000, 40000, 60000}));
+  CHECK(mirror.DueTimes(d) == std::vector<int64_t>({50000, 70000, 90000}));
+
+  // A session removed while left over from a full batch reports nothing.
+  MirroredFleet crowd(0);
+  const int crowdPlan = crowd.AddPlan(MakeSimplePlan(10, 2));
+  for (int i = 0; i < 600; i++) crowd.Start(crowd.AddSession(crowdPlan, -1));
+  CHECK(crowd.AdvanceFleetOnce(5000));
+  uint32_t pending = 0;
+  while (!crowd.fleetEvents[pending].empty()) pending++;
+  crowd.RemoveSession(pending);
+  crowd.AdvanceTo(5000);
+  CHECK(crowd.fleetEvents[pending].empty());
+  CHECK_EQ(crowd.Mismatches(), 0);
+}
+
+// Seeking reports none of the boundaries skipped, forward or back, and the
+// next boundary falls due from the new position, running or halted.
+TEST(SessionFleet, SeekToSkipsTransitions) {
+  MirroredFleet mirror(0);
+  const int plan = mirror.AddPlan(MakeSimplePlan(100, 10));
+  const uint32_t id = mirror.AddSession(plan, -1);
+  mirror.Start(id);
+
+  mirror.AdvanceTo(5000);
+  mirror.SeekTo(id, 55500);
+  CHECK_EQ(mirror.fleet.PositionAt(id, 5000).currentQuestion, 6);
+  mirror.AdvanceTo(9000);
+  CHECK(mirror.fleetEvents[id].empty());
+  mirror.AdvanceTo(9500);
+  REQUIRE(mirror.fleetEvents[id].size() == 1);
+  CHECK_EQ(mirror.fleetEvents[id][0].dueMs, 9500);
+  CHECK_EQ(mirror.fleetEvents[id][0].event.question, 7);
+
+  // Back to the start: the boundaries are crossed, and reported, again.
+  mirror.SeekTo(id, 0);
+  mirror.AdvanceTo(19500);
+  CHECK_EQ(mirror.fleetEvents[id].size(), 2u);
+  CHECK_EQ(mirror.fleetEvents[id].back().event.question, 2);
+
+  // Halted sessions hold the position they were moved to.
+  mirror.SetPaused(id, true);
+  mirror.SeekTo(id, 89000);
+  mirror.AdvanceTo(60000);
+  CHECK_EQ(mirror.fleet.GetElapsedMilliseconds(id, 60000), 89000);
+  CHECK_EQ(mirror.fleetEvents[id].size(), 2u);
+  mirror.SetPaused(id, false);
+  mirror.AdvanceTo(61000);
+  CHECK_EQ(mirror.fleetEvents[id].back().dueMs, 61000);
+  CHECK_EQ(mirror.fleetEvents[id].back().event.question, 10);
+
+  // Past the end completes without a Completed event; negative is the start.
+  mirror.SeekTo(id, 500000);
+  CHECK(mirror.fleet.PositionAt(id, 61000).completed);
+  CHECK_EQ(mirror.fleet.ScheduledCount(), 0u);
+  mirror.AdvanceTo(70000);
+  CHECK_EQ(mirror.fleetEvents[id].size(), 3u);
+  mirror.SeekTo(id, -5000);
+  CHECK_EQ(mirror.fleet.GetElapsedMilliseconds(id, 70000), 0);
+  mirror.AdvanceTo(80000);
+  CHECK_EQ(mirror.fleetEvents[id].size(), 4u);
+  CHECK_EQ(mirror.Mismatches(), 0);
+}
+
+// Random per-session and per-group commands and clock jumps over a few
+// hundred sessions, compared with their TimerStates after every step.
+TEST(SessionFleet, RandomCommandsMatchTimerState) {
+  constexpr int kSessions = 200;
+  constexpr int kGroups = 5;
+  TimerConfig config = {};
+  config.timePerBlock = 20;
+  config.numBlocks = 2;
+  config.numQuestions = 7;
+  config.ComputeDerivedValues();
+
+  MirroredFleet mirror(5);
+  const int plans[] = {mirror.AddPlan(MakeMixedPlan()),
+                       mirror.AddPlan(BuildSessionPlan(config))};
+  for (int group = 0; group < kGroups; group++) mirror.fleet.AddGroup();
+  for (int i = 0; i < kSessions; i++) {
+    mirror.AddSession(plans[i % 2], i % kGroups);
+  }
+
+  TestRandom random;
+  int64_t nowMs = 5;
+  int failedSteps = 0;
+  for (int step = 0; step < 5000; step++) {
+    nowMs += random.Between(0, 4) == 0 ? random.Between(0, 600000)
+                                       : random.Between(0, 1500);
+    mirror.clock.nowMs = nowMs;
+    if (random.Between(0, 9) == 0) {
+      const uint32_t id =
+          static_cast<uint32_t>(random.Between(0, kSessions - 1));
+      const int64_t totalMs = mirror.plans[id % 2].TotalSeconds() * 1000;
+      switch (random.Between(0, 3)) {
+        case 0: mirror.Start(id); break;
+        case 1: mirror.Stop(id); break;
+        case 2: mirror.SetPaused(id, random.Between(0, 1) == 1); break;
+        default: mirror.SeekTo(id, random.Between(-1000, totalMs + 2000));
+      }
+    }
+    if (random.Between(0, 199) == 0) {
+      const int group = static_cast<int>(random.Between(0, kGroups - 1));
+      if (random.Between(0, 1) == 0) {
+        mirror.SetGroupPaused(group, true);
+      } else {
+        mirror.StartGroup(group);
+      }
+    }
+    mirror.AdvanceTo(nowMs);
+    if (mirror.Mismatches() != 0) failedSteps++;
+  }
+  CHECK_EQ(failedSteps, 0);
+}
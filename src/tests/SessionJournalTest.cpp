@@ -0,0 +1,183 @@
+// SessionJournalTest.cpp - Journal round trips and resync past damage
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SessionJournal.h"
+#include "TestHarness.h"
+
+namespace {
+
+// A session's worth of records: every type, with config records between
+// runs of position records, wall and elapsed time moving both ways.
+std::vector<JournalRecord> MakeRecords(int count) {
+  TestRandom random;
+  std::vector<JournalRecord> records;
+  int64_t wallMs = 1700000000000;
+  int64_t elapsedMs = 0;
+  for (int i = 0; i < count; i++) {
+    JournalRecord record;
+    record.type = static_cast<JournalRecordType>(
+        i % static_cast<int>(JournalRecordType::kCount));
+    wallMs += random.Between(-5000, 120000);
+    elapsedMs += random.Between(-1000, 90000);
+    record.wallMs = wallMs;
+    record.elapsedMs = elapsedMs;
+    if (JournalRecordHasConfig(record.type)) {
+      record.timePerBlock = static_cast<int>(random.Between(1, 600));
+      record.numBlocks = static_cast<int>(random.Between(1, 40));
+      record.numQuestions = static_cast<int>(random.Between(1, 200));
+      record.transparency = static_cast<int>(random.Between(0, 100));
+    } else {
+      record.block = static_cast<int>(random.Between(0, 40));
+      record.question = static_cast<int>(random.Between(0, 200));
+    }
+    records.push_back(record);
+  }
+  return records;
+}
+
+bool SameRecord(const JournalRecord& a, const JournalRecord& b) {
+  return a.type == b.type && a.wallMs == b.wallMs &&
+         a.elapsedMs == b.elapsedMs && a.block == b.block &&
+         a.question == b.question && a.timePerBlock == b.timePerBlock &&
+         a.numBlocks == b.numBlocks && a.numQuestions == b.numQuestions &&
+         a.transparency == b.transparency;
+}
+
+// Encodes records as frames of recordsPerFrame each, noting where every
+// frame starts in the returned file.
+std::string WriteJournal(const std::vector<JournalRecord>& records,
+                         size_t recordsPerFrame,
+                         std::vector<size_t>* frameStarts) {
+  SessionJournal journal;
+  std::string file;
+  for (size_t i = 0; i < records.size(); i++) {
+    journal.Append(records[i]);
+    if ((i + 1) % recordsPerFrame == 0 || i + 1 == records.size()) {
+      if (frameStarts) frameStarts->push_back(file.size());
+      file += journal.TakeFrame();
+    }
+  }
+  return file;
+}
+
+std::vector<JournalRecord> ReadJournal(const std::string& file,
+                                       uint64_t* damagedFrames) {
+  std::istringstream in(file);
+  JournalReader reader(&in);
+  std::vector<JournalRecord> records;
+  JournalRecord record;
+  while (reader.Next(&record)) records.push_back(record);
+  *damagedFrames = reader.damagedFrames;
+  return records;
+}
+
+// True if read is exactly written with frames [skipFirst, skipLast) left out.
+bool MatchesWithoutFrames(const std::vector<JournalRecord>& read,
+                          const std::vector<JournalRecord>& written,
+                          size_t recordsPerFrame, size_t skipFirst,
+                          size_t skipLast) {
+  size_t next = 0;
+  for (size_t i = 0; i < written.size(); i++) {
+    const size_t frame = i / recordsPerFrame;
+    if (frame >= skipFirst && frame < skipLast) continue;
+    if (next >= read.size() || !SameRecord(read[next], written[i])) {
+      return false;
+    }
+    next++;
+  }
+  return next == read.size();
+}
+
+}  // namespace
+
+TEST(SessionJournal, RoundTripsEveryRecordType) {
+  const std::vector<JournalRecord> written = MakeRecords(1000);
+  for (const size_t perFrame : {size_t{1}, size_t{7}, size_t{1000}}) {
+    uint64_t damaged = 0;
+    const std::vector<JournalRecord> read =
+        ReadJournal(WriteJournal(written, perFrame, nullptr), &damaged);
+    CHECK_EQ(damaged, 0u);
+    CHECK(MatchesWithoutFrames(read, written, perFrame, 0, 0));
+  }
+}
+
+TEST(SessionJournal, FlushesOnSizeAgeAndHalt) {
+  SessionJournal journal;
+  CHECK(!journal.NeedsFlush(0));
+  JournalRecord record;
+  record.type = JournalRecordType::QuestionAdvanced;
+  record.wallMs = 1000;
+  journal.Append(record);
+  CHECK(!journal.NeedsFlush(1000));
+  CHECK(journal.NeedsFlush(1000 + SessionJournal::kFlushIntervalMs));
+
+  record.type = JournalRecordType::Paused;
+  journal.Append(record);
+  CHECK(journal.NeedsFlush(1000));
+  journal.TakeFrame();
+  CHECK(!journal.NeedsFlush(1000 + SessionJournal::kFlushIntervalMs));
+
+  record.type = JournalRecordType::QuestionAdvanced;
+  while (journal.pending.size() < SessionJournal::kFlushBytes) {
+    CHECK(!journal.NeedsFlush(1000));
+    journal.Append(record);
+  }
+  CHECK(journal.NeedsFlush(1000));
+  CHECK_EQ(journal.frames, 1u);
+}
+
+// Scrambles each byte of one frame in the middle of the journal in turn.
+// Only that frame may be lost; every record before and after it must come
+// back, and the damage must be counted.
+TEST(SessionJournal, ResyncsPastCorruptionAtEveryByte) {
+  constexpr size_t kPerFrame = 5;
+  const std::vector<JournalRecord> written = MakeRecords(15);
+  std::vector<size_t> starts;
+  const std::string file = WriteJournal(written, kPerFrame, &starts);
+  REQUIRE(starts.size() == 3);
+
+  int failures = 0;
+  for (size_t at = starts[1]; at < starts[2]; at++) {
+    std::string damaged = file;
+    damaged[at] = static_cast<char>(damaged[at] ^ 0x5A);
+    uint64_t damagedFrames = 0;
+    const std::vector<JournalRecord> read =
+        ReadJournal(damaged, &damagedFrames);
+    // A scrambled magic hides the frame instead of damaging it.
+    const bool magic = at < starts[1] + 4;
+    if (!MatchesWithoutFrames(read, written, kPerFrame, 1, 2) ||
+        damagedFrames != (magic ? 0u : 1u)) {
+      failures++;
+    }
+  }
+  CHECK_EQ(failures, 0);
+}
+
+// A crash tears the last frame at some byte, then the next run appends a
+// fresh frame right after the torn one. Everything but the torn frame must
+// be read back.
+TEST(SessionJournal, ResyncsPastTornFrameAtEveryByte) {
+  constexpr size_t kPerFrame = 4;
+  const std::vector<JournalRecord> written = MakeRecords(12);
+  std::vector<size_t> starts;
+  const std::string file = WriteJournal(written, kPerFrame, &starts);
+  REQUIRE(starts.size() == 3);
+  const std::string lastFrame = file.substr(starts[2]);
+
+  int failures = 0;
+  for (size_t cut = starts[1] + 1; cut < starts[2]; cut++) {
+    const std::string torn = file.substr(0, cut) + lastFrame;
+    uint64_t damagedFrames = 0;
+    const std::vector<JournalRecord> read = ReadJournal(torn, &damagedFrames);
+    if (!MatchesWithoutFrames(read, written, kPerFrame, 1, 2)) failures++;
+
+    // Without anything appended, the torn tail just ends the journal.
+    const std::vector<JournalRecord> tail =
+        ReadJournal(file.substr(0, cut), &damagedFrames);
+    if (!MatchesWithoutFrames(tail, written, kPerFrame, 1, 3)) failures++;
+  }
+  CHECK_EQ(failures, 0);
+}
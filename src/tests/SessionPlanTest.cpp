@@ -0,0 +1,281 @@
+// SessionPlanTest.cpp - Remainder distribution, weights, breaks and lookups
+
+#include <algorithm>
+#include <cstdlib>
+#include <initializer_list>
+#include <vector>
+
+#include "SessionPlan.h"
+#include "TestHarness.h"
+
+namespace {
+
+int64_t SegmentLength(const SessionPlan& plan, int index) {
+  return plan.segmentEnds[index] -
+         (index > 0 ? plan.segmentEnds[index - 1] : 0);
+}
+
+// Segment containing elapsedSeconds by walking the timeline from the start
+int LinearFindSegment(const SessionPlan& plan, int64_t elapsedSeconds) {
+  if (elapsedSeconds < 0) elapsedSeconds = 0;
+  int index = 0;
+  while (index < plan.SegmentCount() &&
+         plan.segmentEnds[index] <= elapsedSeconds) {
+    index++;
+  }
+  return index;
+}
+
+// Random sections of blocks (some weighted, some with zero weights) with
+// breaks between some of them, until the plan has at least segmentCount
+// segments. Zero-length blocks, questions and breaks are included.
+SessionPlan MakeMixedPlan(int segmentCount, TestRandom* random) {
+  SessionPlan plan;
+  int section = 0;
+  std::vector<int> weights;
+  while (plan.SegmentCount() < segmentCount) {
+    if (random->Between(0, 9) == 0) section++;
+    const int questions = static_cast<int>(random->Between(1, 60));
+    const int64_t length = random->Between(0, 10) == 0
+                               ? random->Between(0, questions)
+                               : random->Between(questions, 7200);
+    if (random->Between(0, 1) == 0) {
+      weights.assign(questions, 0);
+      for (int& weight : weights) {
+        weight = static_cast<int>(random->Between(0, 4) == 0
+                                      ? 0
+                                      : random->Between(1, 50));
+      }
+      plan.AddBlock(section, length, questions, weights.data());
+    } else {
+      plan.AddBlock(section, length, questions);
+    }
+    if (random->Between(0, 3) == 0) {
+      plan.AddBreak(section, random->Between(0, 900));
+    }
+  }
+  return plan;
+}
+
+// Compares PositionAt(t) with what the segment found by a linear scan says
+// the position should be. Returns false on any difference.
+bool PositionMatchesLinearScan(const SessionPlan& plan, int64_t t) {
+  if (t < 0) t = 0;
+  const TimerPosition pos = plan.PositionAt(t);
+  const int index = LinearFindSegment(plan, t);
+  if (index >= plan.SegmentCount()) {
+    return pos.completed && pos.segmentIndex == plan.SegmentCount() &&
+           pos.currentTime == 0;
+  }
+
+  const PlanSegment& segment = plan.segments[index];
+  const int64_t start = index > 0 ? plan.segmentEnds[index - 1] : 0;
+  const bool isBreak = segment.kind == PlanSegmentKind::Break;
+  bool same = !pos.completed && pos.segmentIndex == index &&
+              pos.inBreak == isBreak &&
+              pos.currentTime == plan.TotalSeconds() - t &&
+              pos.questionTimeElapsed == t - start &&
+              pos.questionLength == SegmentLength(plan, index) &&
+              pos.questionTimeElapsed < pos.questionLength &&
+              pos.questionProgress >= 0 && pos.questionProgress < 100;
+  if (isBreak) {
+    same = same && pos.currentQuestion == 0 &&
+           pos.blockLength == pos.questionLength;
+  } else {
+    const PlanBlock& block = plan.blocks[segment.block];
+    same = same && pos.currentQuestion == segment.question &&
+           pos.currentBlock == segment.block + 1 &&
+           pos.questionsInBlock == block.numQuestions &&
+           pos.blockTimeElapsed == t - block.startSecond &&
+           pos.blockLength == block.endSecond - block.startSecond;
+  }
+  return same;
+}
+
+}  // namespace
+
+// Every block length against every question count up to 17: the question
+// lengths must sum exactly to the block, differ by at most one second, and
+// the blocks must tile the timeline with no gaps.
+TEST(SessionPlan, RemaindersSumToBlockLength) {
+  SessionPlan plan;
+  int failures = 0;
+  for (int64_t length = 0; length <= 250; length++) {
+    for (int questions = 1; questions <= 17; questions++) {
+      const int first = plan.SegmentCount();
+      const int64_t start = plan.TotalSeconds();
+      const int block = plan.AddBlock(0, length, questions);
+      int64_t sum = 0;
+      int64_t shortest = length;
+      int64_t longest = 0;
+      for (int i = first; i < plan.SegmentCount(); i++) {
+        const int64_t segment = SegmentLength(plan, i);
+        sum += segment;
+        if (segment < shortest) shortest = segment;
+        if (segment > longest) longest = segment;
+      }
+      if (sum != length || longest - shortest > 1 ||
+          plan.SegmentCount() - first != questions ||
+          plan.blocks[block].startSecond != start ||
+          plan.blocks[block].endSecond != start + length) {
+        failures++;
+      }
+    }
+  }
+  CHECK_EQ(failures, 0);
+}
+
+TEST(SessionPlan, WeightedSplits) {
+  SessionPlan plan;
+  const int rising[] = {1, 2, 3, 4};
+  plan.AddBlock(0, 100, 4, rising);
+  CHECK_EQ(SegmentLength(plan, 0), 10);
+  CHECK_EQ(SegmentLength(plan, 1), 20);
+  CHECK_EQ(SegmentLength(plan, 2), 30);
+  CHECK_EQ(SegmentLength(plan, 3), 40);
+
+  // Zero weights give zero-length questions that lookups step over.
+  const int gaps[] = {0, 5, 0, 5};
+  plan.Clear();
+  plan.AddBlock(0, 9, 4, gaps);
+  CHECK_EQ(SegmentLength(plan, 0), 0);
+  CHECK_EQ(SegmentLength(plan, 1), 4);
+  CHECK_EQ(SegmentLength(plan, 2), 0);
+  CHECK_EQ(SegmentLength(plan, 3), 5);
+  CHECK_EQ(plan.PositionAt(0).currentQuestion, 2);
+  CHECK_EQ(plan.PositionAt(4).currentQuestion, 4);
+
+  // All-zero (or negative) weights fall back to an equal split.
+  const int none[] = {0, -3, 0};
+  plan.Clear();
+  plan.AddBlock(0, 10, 3, none);
+  CHECK_EQ(SegmentLength(plan, 0), 3);
+  CHECK_EQ(SegmentLength(plan, 1), 3);
+  CHECK_EQ(SegmentLength(plan, 2), 4);
+
+  // Random weights: every question is within a second of its exact share
+  // and the block still sums exactly.
+  TestRandom random;
+  int failures = 0;
+  for (int trial = 0; trial < 2000; trial++) {
+    const int questions = static_cast<int>(random.Between(1, 40));
+    const int64_t length = random.Between(0, 20000);
+    std::vector<int> weights(questions);
+    int64_t totalWeight = 0;
+    for (int& weight : weights) {
+      weight = static_cast<int>(random.Between(1, 1000));
+      totalWeight += weight;
+    }
+    plan.Clear();
+    plan.AddBlock(0, length, questions, weights.data());
+    int64_t sum = 0;
+    for (int i = 0; i < questions; i++) {
+      const int64_t segment = SegmentLength(plan, i);
+      sum += segment;
+      const int64_t scaled = segment * totalWeight;
+      const int64_t exact = length * weights[i];
+      if (std::llabs(scaled - exact) >= totalWeight) failures++;
+    }
+    if (sum != length) failures++;
+  }
+  CHECK_EQ(failures, 0);
+}
+
+TEST(SessionPlan, BreaksReportQuestionZero) {
+  SessionPlan plan;
+  plan.AddBlock(0, 600, 5);
+  plan.AddBreak(0, 300);
+  plan.AddBlock(1, 900, 10);
+  CHECK_EQ(plan.TotalSeconds(), 1800);
+  CHECK_EQ(plan.SegmentCount(), 16);
+  CHECK(plan.segments[5].kind == PlanSegmentKind::Break);
+  CHECK_EQ(plan.segments[5].block, 1);
+  CHECK_EQ(plan.segments[6].section, 1);
+
+  for (const int64_t t : {600, 750, 899}) {
+    const TimerPosition pos = plan.PositionAt(t);
+    CHECK(pos.inBreak);
+    CHECK_EQ(pos.currentQuestion, 0);
+    CHECK_EQ(pos.currentBlock, 2);  // The block it leads into
+    CHECK_EQ(pos.questionsInBlock, 10);
+    CHECK_EQ(pos.blockTimeElapsed, t - 600);
+    CHECK_EQ(pos.blockLength, 300);
+    CHECK_EQ(pos.currentTime, 1800 - t);
+  }
+
+  const TimerPosition before = plan.PositionAt(599);
+  CHECK(!before.inBreak);
+  CHECK_EQ(before.currentQuestion, 5);
+  CHECK_EQ(before.currentBlock, 1);
+  const TimerPosition after = plan.PositionAt(900);
+  CHECK(!after.inBreak);
+  CHECK_EQ(after.currentQuestion, 1);
+  CHECK_EQ(after.currentBlock, 2);
+  CHECK_EQ(after.blockTimeElapsed, 0);
+
+  // A trailing break still belongs to the last block.
+  plan.AddBreak(1, 60);
+  CHECK_EQ(plan.PositionAt(1830).currentBlock, 2);
+  CHECK(plan.PositionAt(1860).completed);
+}
+
+// A 50k-segment plan, queried at every boundary and a second either side
+// of it, plus random times: binary search, the ticking hints and hints that
+// are wrong all agree with a linear scan.
+TEST(SessionPlan, FindSegmentMatchesLinearScanOnLargePlan) {
+  TestRandom random;
+  const SessionPlan plan = MakeMixedPlan(50000, &random);
+  REQUIRE(plan.SegmentCount() >= 50000);
+
+  std::vector<int64_t> times;
+  times.push_back(-1);
+  times.push_back(0);
+  for (const int64_t end : plan.segmentEnds) {
+    times.push_back(end - 1);
+    times.push_back(end);
+    times.push_back(end + 1);
+  }
+
+  // Sweep the times in order with a linear-scan cursor.
+  std::sort(times.begin(), times.end());
+  int failures = 0;
+  int cursor = 0;
+  for (const int64_t t : times) {
+    // Negative times count as 0, as in FindSegment().
+    while (cursor < plan.SegmentCount() &&
+           plan.segmentEnds[cursor] <= (t < 0 ? 0 : t)) {
+      cursor++;
+    }
+    const int hint = static_cast<int>(random.Between(-1, plan.SegmentCount()));
+    if (plan.FindSegment(t) != cursor ||
+        plan.FindSegment(t, cursor) != cursor ||
+        plan.FindSegment(t, cursor - 1) != cursor ||
+        plan.FindSegment(t, hint) != cursor) {
+      failures++;
+    }
+  }
+
+  for (int i = 0; i < 2000; i++) {
+    const int64_t t = random.Between(0, plan.TotalSeconds() + 10);
+    const int expected = LinearFindSegment(plan, t);
+    if (plan.FindSegment(t) != expected ||
+        plan.FindSegment(t, expected - 1) != expected) {
+      failures++;
+    }
+  }
+  CHECK_EQ(failures, 0);
+}
+
+TEST(SessionPlan, PositionAtEveryBoundary) {
+  TestRandom random;
+  const SessionPlan plan = MakeMixedPlan(2000, &random);
+  int failures = 0;
+  for (const int64_t end : plan.segmentEnds) {
+    for (int64_t t = end - 1; t <= end + 1; t++) {
+      if (!PositionMatchesLinearScan(plan, t)) failures++;
+    }
+  }
+  CHECK_EQ(failures, 0);
+  CHECK(plan.PositionAt(plan.TotalSeconds()).completed);
+  CHECK(!plan.PositionAt(plan.TotalSeconds() - 1).completed);
+}
@@ -0,0 +1,237 @@
+// SessionProgressTest.cpp - Batch progress kernels against TimerState
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "SessionProgress.h"
+#include "TestHarness.h"
+#include "TimerClock.h"
+#include "TimerState.h"
+
+namespace {
+
+// Compute() falls back to the best kernel the CPU has when asked for AVX2 it
+// cannot run, so every kernel can be asked for on any machine.
+constexpr ProgressKernel kKernels[] = {
+    ProgressKernel::Scalar, ProgressKernel::Sse2, ProgressKernel::Avx2};
+
+constexpr int64_t kEpochMs = 5000000;
+
+// Weighted and zero-length questions, a break and an hour-long block
+SessionPlan MakeMixedPlan() {
+  SessionPlan plan;
+  const int weights[] = {1, 0, 3};
+  plan.AddBlock(0, 100, 3, weights);
+  plan.AddBreak(0, 50);
+  plan.AddBlock(1, 7, 10);
+  plan.AddBlock(1, 3600, 40);
+  return plan;
+}
+
+// One TimerState per row on a shared manual clock, and the batch rows set
+// from them.
+struct ProgressSessions {
+  ManualTimerClock clock;
+  std::vector<TimerState> states;
+  SessionProgressBatch batch;
+
+  // count sessions of plan, at random points of it (some past the end), a
+  // fifth of them stopped and a seventh paused.
+  ProgressSessions(const SessionPlan& plan, size_t count,
+                   TestRandom* random) {
+    clock.nowMs = kEpochMs;
+    batch.Reset(kEpochMs);
+    states.resize(count);
+    const int64_t totalMs = plan.TotalSeconds() * 1000;
+    for (size_t row = 0; row < count; row++) {
+      TimerState& state = states[row];
+      state.InitializeWithPlan(TimerConfig(), plan, &clock);
+      if (random->Between(0, 4) == 0) state.Stop();
+      if (random->Between(0, 6) == 0) state.SetPaused(true);
+      state.SeekTo(random->Between(0, totalMs + 100000));
+      batch.Add();
+      SetRow(row);
+    }
+  }
+
+  void SetRow(size_t row) {
+    const TimerState& state = states[row];
+    const int64_t elapsedMs = state.GetElapsedMilliseconds();
+    batch.Set(row, state.plan.PositionAt(elapsedMs / 1000), elapsedMs,
+              state.IsRunning(), clock.nowMs);
+  }
+};
+
+bool SameOutputs(const SessionProgressBatch& a, const SessionProgressBatch& b) {
+  return a.questionProgress == b.questionProgress &&
+         a.blockProgress == b.blockProgress && a.remainingMs == b.remainingMs &&
+         a.staleRows == b.staleRows;
+}
+
+// Rows of batch whose outputs differ from what state, ticked to the same
+// time, shows. Progress is compared as exact fractions of the windows.
+int CountDifferences(const ProgressSessions& sessions) {
+  const SessionProgressBatch& batch = sessions.batch;
+  int differences = 0;
+  for (size_t row = 0; row < sessions.states.size(); row++) {
+    const TimerState& state = sessions.states[row];
+    const int64_t elapsedMs = state.GetElapsedMilliseconds();
+    const int64_t remainingMs =
+        std::max<int64_t>(0, int64_t{state.config.totalTime} * 1000 -
+                                 elapsedMs);
+    bool same = batch.remainingMs[row] == remainingMs &&
+                batch.question[row] == state.currentQuestion &&
+                batch.block[row] == state.currentBlock;
+    if (state.plan.PositionAt(elapsedMs / 1000).completed) {
+      same = same && batch.questionProgress[row] == 0.0f &&
+             batch.blockProgress[row] == 0.0f;
+    } else {
+      const double question =
+          static_cast<double>(state.GetQuestionElapsedMilliseconds()) /
+          (state.questionLength * 1000.0);
+      const double block =
+          static_cast<double>(state.GetBlockElapsedMilliseconds()) /
+          (state.blockLength * 1000.0);
+      same = same && std::fabs(batch.questionProgress[row] - question) < 1e-5 &&
+             std::fabs(batch.blockProgress[row] - block) < 1e-5;
+    }
+    if (!same) differences++;
+  }
+  return differences;
+}
+
+}  // namespace
+
+// A thousand sessions over an hour and more of frames, with pauses, resumes
+// and seeks: after each kernel's pass and the stale rows being set again,
+// every row shows what its TimerState does.
+TEST(SessionProgress, KernelsMatchTimerState) {
+  TestRandom random;
+  ProgressSessions sessions(MakeMixedPlan(), 1003, &random);
+
+  int differences = 0;
+  int stillStale = 0;
+  int64_t nowMs = kEpochMs;
+  for (int step = 0; step < 400; step++) {
+    nowMs += random.Between(0, 20000);
+    sessions.clock.nowMs = nowMs;
+    for (int command = 0; command < 5; command++) {
+      const size_t row = static_cast<size_t>(
+          random.Between(0, static_cast<int64_t>(sessions.states.size()) - 1));
+      TimerState& state = sessions.states[row];
+      if (random.Between(0, 3) == 0) {
+        state.SeekTo(random.Between(0, 4000000));
+      } else {
+        state.SetPaused(!state.paused);
+      }
+      sessions.SetRow(row);
+    }
+    // Advance() rather than Tick() so halted sessions' displays catch up too
+    for (TimerState& state : sessions.states) {
+      TimerEventBatch events;
+      while (state.Advance(&events)) {
+      }
+    }
+
+    const ProgressKernel kernel = kKernels[step % 3];
+    sessions.batch.Compute(nowMs, kernel);
+    for (const uint32_t row : sessions.batch.staleRows) sessions.SetRow(row);
+    if (sessions.batch.Compute(nowMs, kernel) != 0) stillStale++;
+    differences += CountDifferences(sessions);
+  }
+  CHECK_EQ(stillStale, 0);
+  CHECK_EQ(differences, 0);
+}
+
+// Every batch size up to a few 8-row groups, so stale rows land in the SSE2
+// and AVX2 kernels' scalar tails as well as in their vector steps: all
+// kernels agree bit for bit, stale row list included.
+TEST(SessionProgress, KernelsAgreeOnEveryTail) {
+  TestRandom random;
+  const SessionPlan plan = MakeMixedPlan();
+  int disagreements = 0;
+  size_t staleSeen = 0;
+  for (size_t count = 0; count <= 27; count++) {
+    ProgressSessions sessions(plan, count, &random);
+    for (int frame = 0; frame < 50; frame++) {
+      const int64_t nowMs = kEpochMs + random.Between(-2000, 400000);
+      SessionProgressBatch reference = sessions.batch;
+      reference.Compute(nowMs, ProgressKernel::Scalar);
+      staleSeen += reference.staleRows.size();
+      for (const ProgressKernel kernel : kKernels) {
+        SessionProgressBatch batch = sessions.batch;
+        const size_t stale = batch.Compute(nowMs, kernel);
+        if (stale != reference.staleRows.size() ||
+            !SameOutputs(reference, batch)) {
+          disagreements++;
+        }
+      }
+    }
+  }
+  CHECK_EQ(disagreements, 0);
+  CHECK(staleSeen > 0);
+}
+
+// Completed rows never go stale and show empty bars and no time left;
+// halted rows hold still however long the dashboard runs. The special rows
+// sit in the last, partial group of both vector kernels.
+TEST(SessionProgress, CompletedAndHaltedRows) {
+  SessionPlan plan;
+  plan.AddBlock(0, 60, 3);
+  ManualTimerClock clock;
+  clock.nowMs = kEpochMs;
+  std::vector<TimerState> states(11);
+  for (TimerState& state : states) {
+    state.InitializeWithPlan(TimerConfig(), plan, &clock);
+  }
+  states[8].SeekTo(60000);  // Completed, still running
+  states[9].SeekTo(30500);
+  states[9].SetPaused(true);
+  states[10].SeekTo(45250);
+  states[10].Stop();
+
+  SessionProgressBatch batch;
+  batch.Reset(kEpochMs);
+  for (size_t row = 0; row < states.size(); row++) {
+    batch.Add();
+    const int64_t elapsedMs = states[row].GetElapsedMilliseconds();
+    batch.Set(row, plan.PositionAt(elapsedMs / 1000), elapsedMs,
+              states[row].IsRunning(), kEpochMs);
+  }
+
+  for (const ProgressKernel kernel : kKernels) {
+    for (const int64_t laterMs : {0, 1, 19999, 20000, 3600000}) {
+      SessionProgressBatch frame = batch;
+      frame.Compute(kEpochMs + laterMs, kernel);
+      const std::vector<uint32_t>& stale = frame.staleRows;
+      CHECK(std::find(stale.begin(), stale.end(), 8u) == stale.end());
+      CHECK(std::find(stale.begin(), stale.end(), 9u) == stale.end());
+      CHECK(std::find(stale.begin(), stale.end(), 10u) == stale.end());
+      CHECK(stale.size() == (laterMs >= 20000 ? 8u : 0u));
+
+      CHECK(frame.questionProgress[8] == 0.0f);
+      CHECK(frame.blockProgress[8] == 0.0f);
+      CHECK_EQ(frame.remainingMs[8], 0);
+      CHECK(std::fabs(frame.questionProgress[9] - 0.525f) < 1e-5f);
+      CHECK(std::fabs(frame.blockProgress[9] - 30.5f / 60) < 1e-5f);
+      CHECK_EQ(frame.remainingMs[9], 29500);
+      CHECK(std::fabs(frame.questionProgress[10] - 0.2625f) < 1e-5f);
+      CHECK_EQ(frame.remainingMs[10], 14750);
+      CHECK_EQ(frame.question[10], 3);
+    }
+  }
+
+  // Running past the end goes stale once; set again, it stays completed.
+  SessionProgressBatch frame = batch;
+  frame.Compute(kEpochMs + 60000);
+  CHECK_EQ(frame.remainingMs[0], 0);
+  clock.nowMs = kEpochMs + 60000;
+  for (const uint32_t row : frame.staleRows) {
+    const int64_t elapsedMs = states[row].GetElapsedMilliseconds();
+    frame.Set(row, plan.PositionAt(elapsedMs / 1000), elapsedMs,
+              states[row].IsRunning(), clock.nowMs);
+  }
+  CHECK_EQ(frame.Compute(kEpochMs + 90000), 0u);
+  CHECK(frame.questionProgress[0] == 0.0f);
+}
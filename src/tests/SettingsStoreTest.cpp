@@ -0,0 +1,129 @@
+// SettingsStoreTest.cpp - INI round trips, change tracking and coalesced saves
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "BackgroundWriter.h"
+#include "SettingsStore.h"
+#include "TestHarness.h"
+
+namespace {
+
+std::string ReadFile(const std::filesystem::path& file) {
+  std::ifstream in(file, std::ios::binary);
+  std::ostringstream text;
+  text << in.rdbuf();
+  return text.str();
+}
+
+}  // namespace
+
+TEST(SettingsStore, ParseSerializeRoundTrip) {
+  SettingsStore store;
+  store.Parse(
+      "\xEF\xBB\xBF; comment\r\n"
+      "orphan=ignored\n"
+      "[Cover]\r\n"
+      "  x = 120 \n"
+      "# another comment\n"
+      "y=-40\n"
+      "name=a = b\n"
+      "\n"
+      "[Timer]\n"
+      "empty=\n"
+      "broken line\n"
+      "transparency=85");
+  REQUIRE(store.sections.size() == 2);
+  CHECK(*store.Find("Cover", "x") == "120");
+  CHECK(*store.Find("Cover", "name") == "a = b");
+  CHECK(*store.Find("Timer", "empty") == "");
+  CHECK(store.Find("Cover", "orphan") == nullptr);
+  int y = 0;
+  CHECK(store.GetInt("Cover", "y", &y));
+  CHECK_EQ(y, -40);
+  int empty = 7;
+  CHECK(!store.GetInt("Timer", "empty", &empty));
+  CHECK_EQ(empty, 7);
+
+  const std::string text = store.Serialize();
+  CHECK(text ==
+        "[Cover]\nx=120\ny=-40\nname=a = b\n\n"
+        "[Timer]\nempty=\ntransparency=85\n");
+  SettingsStore reparsed;
+  reparsed.Parse(text);
+  CHECK(reparsed.Serialize() == text);
+  CHECK(!store.dirty);
+}
+
+TEST(SettingsStore, UnchangedValueLeavesStoreClean) {
+  ScratchDirectory scratch("settings-unchanged");
+  SettingsStore store;
+  CHECK(store.Load(scratch.path / "settings.ini"));  // Missing: empty
+  store.SetInt("Cover", "x", 10);
+  CHECK(store.dirty);
+  REQUIRE(store.Flush());
+  CHECK(!store.dirty);
+
+  store.SetInt("Cover", "x", 10);
+  store.SetString("Cover", "x", "10");
+  CHECK(!store.dirty);
+  CHECK_EQ(store.setCalls, 3u);
+  CHECK_EQ(store.changedValues, 1u);
+  CHECK(store.Flush());
+  CHECK_EQ(store.flushes, 1u);  // Nothing to write
+}
+
+// A drag's worth of Set calls, flushed once, costs one file replacement
+// holding only the final values, both directly and through the writer.
+TEST(SettingsStore, BurstOfSetsCoalescesIntoOneWrite) {
+  ScratchDirectory scratch("settings-burst");
+  SettingsStore store;
+  REQUIRE(store.Load(scratch.path / "settings.ini"));
+  for (int i = 0; i <= 500; i++) {
+    store.SetInt("Cover", "x", i);
+    store.SetInt("Cover", "y", 2 * i);
+  }
+  CHECK_EQ(store.changedValues, 1002u);
+  REQUIRE(store.Flush());
+  CHECK_EQ(store.flushes, 1u);
+  const std::string expected = "[Cover]\nx=500\ny=1000\n";
+  CHECK(ReadFile(store.path) == expected);
+  CHECK_EQ(store.bytesWritten, uint64_t{expected.size()});
+
+  BackgroundWriter writer;
+  for (int i = 0; i <= 500; i++) store.SetInt("Cover", "x", 1000 + i);
+  store.FlushTo(&writer);
+  store.FlushTo(&writer);  // Clean: nothing enqueued
+  writer.Shutdown();
+  CHECK_EQ(store.flushes, 2u);
+  CHECK_EQ(writer.enqueued.load(), 1u);
+  CHECK_EQ(writer.written.load(), 1u);
+  CHECK(ReadFile(store.path) == "[Cover]\nx=1500\ny=1000\n");
+
+  SettingsStore reloaded;
+  REQUIRE(reloaded.Load(store.path));
+  int x = 0;
+  CHECK(reloaded.GetInt("Cover", "x", &x));
+  CHECK_EQ(x, 1500);
+}
+
+TEST(SettingsStore, FailedWriteKeepsStoreDirty) {
+  ScratchDirectory scratch("settings-failed");
+  SettingsStore store;
+  REQUIRE(store.Load(scratch.path / "missing" / "settings.ini"));
+  store.SetInt("Cover", "x", 1);
+  CHECK(!store.Flush());
+  CHECK_EQ(store.failedFlushes, 1u);
+  CHECK_EQ(store.flushes, 0u);
+  CHECK_EQ(store.bytesWritten, 0u);
+  CHECK(store.dirty);
+  CHECK(!std::filesystem::exists(scratch.path / "missing"));
+
+  // The retry writes what was kept.
+  std::filesystem::create_directories(scratch.path / "missing");
+  CHECK(store.Flush());
+  CHECK(!store.dirty);
+  CHECK(ReadFile(store.path) == "[Cover]\nx=1\n");
+  CHECK_EQ(store.failedFlushes, 1u);
+}
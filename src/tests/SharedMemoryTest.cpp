@@ -0,0 +1,89 @@
+// SharedMemoryTest.cpp - Who may create, replace and remove a named region
+
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "SharedMemory.h"
+#include "TestHarness.h"
+
+namespace {
+
+constexpr size_t kRegionBytes = 4096;
+
+// A name no other test run uses at the same time
+std::string RegionName(const char* test) {
+#ifdef _WIN32
+  return std::string("Local\\WolfTimerTest-") + test;
+#else
+  return "/wolftimer-test-" + std::to_string(getpid()) + "-" + test;
+#endif
+}
+
+}  // namespace
+
+TEST(SharedMemory, SecondCreatorFailsWhileOwnerLives) {
+  const std::string name = RegionName("live");
+  SharedMemoryMapping owner;
+  REQUIRE(owner.Create(name, kRegionBytes));
+  static_cast<unsigned char*>(owner.address)[0] = 42;
+
+  SharedMemoryMapping rival;
+  CHECK(!rival.Create(name, kRegionBytes));
+  CHECK(!rival.IsOpen());
+
+  // The owner's region is untouched and still readable.
+  SharedMemoryMapping reader;
+  REQUIRE(reader.Open(name, kRegionBytes));
+  CHECK_EQ(static_cast<const unsigned char*>(reader.address)[0], 42);
+  reader.Close();
+
+  owner.Close();
+  CHECK(!reader.Open(name, kRegionBytes));
+  CHECK(rival.Create(name, kRegionBytes));
+}
+
+#ifndef _WIN32
+
+// An object nobody holds locked is what a crashed owner leaves behind.
+TEST(SharedMemory, ReplacesObjectLeftByCrashedOwner) {
+  const std::string name = RegionName("stale");
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  REQUIRE(fd >= 0);
+  CHECK(ftruncate(fd, 16) == 0);
+  CHECK(write(fd, "stale", 5) == 5);
+  close(fd);
+
+  SharedMemoryMapping owner;
+  REQUIRE(owner.Create(name, kRegionBytes));
+  CHECK_EQ(static_cast<const unsigned char*>(owner.address)[0], 0);
+  CHECK_EQ(static_cast<const unsigned char*>(owner.address)[kRegionBytes - 1],
+           0);
+  owner.Close();
+  CHECK(shm_open(name.c_str(), O_RDONLY, 0) < 0);
+}
+
+// If the name has come to refer to another object, closing must not remove
+// it from under its new owner.
+TEST(SharedMemory, CloseLeavesSuccessorsObjectAlone) {
+  const std::string name = RegionName("successor");
+  SharedMemoryMapping owner;
+  REQUIRE(owner.Create(name, kRegionBytes));
+
+  shm_unlink(name.c_str());
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  REQUIRE(fd >= 0);
+  close(fd);
+
+  owner.Close();
+  const int survivor = shm_open(name.c_str(), O_RDONLY, 0);
+  CHECK(survivor >= 0);
+  if (survivor >= 0) close(survivor);
+  shm_unlink(name.c_str());
+}
+
+#endif
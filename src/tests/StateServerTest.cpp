@@ -0,0 +1,105 @@
+// StateServerTest.cpp - Which pages may subscribe to and read the state
+
+#include <initializer_list>
+#include <string>
+
+#include "Sockets.h"
+#include "StateServer.h"
+#include "TestHarness.h"
+
+namespace {
+
+// Sends request to the server on 127.0.0.1:port and returns the head of its
+// response (empty if none arrived within a few seconds).
+std::string Exchange(uint16_t port, const std::string& request) {
+  const SocketHandle connection = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (connection == kInvalidSocket) return std::string();
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  std::string response;
+  if (connect(connection, reinterpret_cast<sockaddr*>(&address),
+              sizeof(address)) == 0 &&
+      send(connection, request.data(), static_cast<int>(request.size()),
+           kSendFlags) == static_cast<int>(request.size())) {
+    char chunk[1024];
+    while (response.find("\r\n\r\n") == std::string::npos) {
+      PollDescriptor descriptor = {};
+      descriptor.fd = connection;
+      descriptor.events = POLLIN;
+      if (PollSockets(&descriptor, 1, 5000) <= 0) break;
+      const int received = recv(connection, chunk, sizeof(chunk), 0);
+      if (received <= 0) break;
+      response.append(chunk, static_cast<size_t>(received));
+    }
+  }
+  CloseSocket(connection);
+  return response.substr(0, response.find("\r\n\r\n"));
+}
+
+std::string WebSocketRequest(uint16_t port, const std::string& origin) {
+  std::string request = "GET /ws HTTP/1.1\r\nHost: 127.0.0.1:" +
+                        std::to_string(port) +
+                        "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                        "Sec-WebSocket-Version: 13\r\n";
+  if (!origin.empty()) request += "Origin: " + origin + "\r\n";
+  return request + "\r\n";
+}
+
+bool HasStatus(const std::string& head, int status) {
+  return head.compare(0, 13, "HTTP/1.1 " + std::to_string(status) + " ") == 0;
+}
+
+}  // namespace
+
+TEST(StateServer, WebSocketOnlyFromLoopbackPages) {
+  REQUIRE(InitializeSockets());
+  StateServer server;
+  REQUIRE(server.Start(0, nullptr));
+  const uint16_t port = server.Port();
+
+  CHECK(HasStatus(Exchange(port, WebSocketRequest(port, "")), 101));
+  CHECK(HasStatus(
+      Exchange(port, WebSocketRequest(port, "http://localhost:8080")), 101));
+  CHECK(HasStatus(
+      Exchange(port, WebSocketRequest(port, "http://127.0.0.1")), 101));
+
+  CHECK(HasStatus(
+      Exchange(port, WebSocketRequest(port, "https://example.com")), 403));
+  CHECK(HasStatus(
+      Exchange(port, WebSocketRequest(port, "http://localhost.evil.test")),
+      403));
+  CHECK(HasStatus(Exchange(port, WebSocketRequest(port, "null")), 403));
+
+  server.Stop();
+  ShutdownSockets();
+}
+
+TEST(StateServer, StateIsSharedOnlyWithLoopbackPages) {
+  REQUIRE(InitializeSockets());
+  StateServer server;
+  REQUIRE(server.Start(0, nullptr));
+  const uint16_t port = server.Port();
+  const std::string request =
+      "GET /state HTTP/1.1\r\nHost: 127.0.0.1:" + std::to_string(port) +
+      "\r\nOrigin: ";
+
+  const std::string loopback =
+      Exchange(port, request + "http://localhost:3000\r\n\r\n");
+  CHECK(HasStatus(loopback, 200));
+  CHECK(loopback.find("Access-Control-Allow-Origin: http://localhost:3000") !=
+        std::string::npos);
+
+  // Sandboxed frames of any site send "null"; they get no CORS grant.
+  for (const char* origin : {"null", "https://example.com"}) {
+    const std::string other =
+        Exchange(port, request + origin + "\r\n\r\n");
+    CHECK(HasStatus(other, 200));
+    CHECK(other.find("Access-Control-Allow-Origin") == std::string::npos);
+  }
+
+  server.Stop();
+  ShutdownSockets();
+}
@@ -0,0 +1,85 @@
+// TestHarness.h - Minimal test registry and checks for wolftimer-tests
+
+#ifndef TESTHARNESS_H
+#define TESTHARNESS_H
+
+#include <cstdint>
+#include <filesystem>
+
+// Tests are functions registered under a suite name with TEST(). CHECK and
+// CHECK_EQ record a failure and let the test go on; REQUIRE also returns
+// from it. wolftimer-tests runs every suite, or only those named on its
+// command line; CMake registers each suite with ctest on its own.
+
+using TestFunction = void (*)();
+
+bool RegisterTest(const char* suite, const char* name, TestFunction function);
+
+void ReportCheckFailure(const char* file, int line, const char* expression);
+void ReportCheckFailure(const char* file, int line, const char* expression,
+                        long long actual, long long expected);
+
+#define TEST(suite, name)                                             \
+  static void suite##_##name();                                       \
+  [[maybe_unused]] static const bool suite##_##name##_registered =    \
+      RegisterTest(#suite, #name, suite##_##name);                    \
+  static void suite##_##name()
+
+#define CHECK(condition)                                         \
+  do {                                                           \
+    if (!(condition)) {                                          \
+      ReportCheckFailure(__FILE__, __LINE__, #condition);        \
+    }                                                            \
+  } while (0)
+
+// Integral (or enum) values only; both are printed on failure.
+#define CHECK_EQ(actual, expected)                                          \
+  do {                                                                      \
+    const auto checkActual = (actual);                                      \
+    const auto checkExpected = (expected);                                  \
+    if (!(checkActual == checkExpected)) {                                  \
+      ReportCheckFailure(__FILE__, __LINE__, #actual " == " #expected,      \
+                         static_cast<long long>(checkActual),               \
+                         static_cast<long long>(checkExpected));            \
+    }                                                                       \
+  } while (0)
+
+#define REQUIRE(condition)                                       \
+  do {                                                           \
+    if (!(condition)) {                                          \
+      ReportCheckFailure(__FILE__, __LINE__, #condition);        \
+      return;                                                    \
+    }                                                            \
+  } while (0)
+
+// Deterministic xorshift64 generator, so a failing run reproduces.
+struct TestRandom {
+  uint64_t state = 0x9E3779B97F4A7C15ull;
+
+  uint64_t Next() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+  }
+
+  // Uniform in [low, high]
+  int64_t Between(int64_t low, int64_t high) {
+    return low + static_cast<int64_t>(Next() % static_cast<uint64_t>(
+                                                   high - low + 1));
+  }
+};
+
+// Empty directory under the system temp directory for a test's files,
+// removed with everything in it when the test ends.
+struct ScratchDirectory {
+  std::filesystem::path path;
+
+  explicit ScratchDirectory(const char* name);
+  ~ScratchDirectory();
+
+  ScratchDirectory(const ScratchDirectory&) = delete;
+  ScratchDirectory& operator=(const ScratchDirectory&) = delete;
+};
+
+#endif  // TESTHARNESS_H
@@ -0,0 +1,98 @@
+// TestMain.cpp - wolftimer-tests: runs the registered test suites
+//
+//   wolftimer-tests [suite ...]
+//
+// Runs every test of the named suites (all suites if none are named) and
+// exits non-zero if any check failed or a named suite does not exist.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "TestHarness.h"
+
+namespace {
+
+struct TestCase {
+  const char* suite;
+  const char* name;
+  TestFunction function;
+};
+
+std::vector<TestCase>& Registry() {
+  static std::vector<TestCase> tests;
+  return tests;
+}
+
+int failedChecks = 0;
+
+bool IsSelected(const char* suite, int argc, char** argv) {
+  if (argc < 2) return true;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], suite) == 0) return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+bool RegisterTest(const char* suite, const char* name, TestFunction function) {
+  Registry().push_back({suite, name, function});
+  return true;
+}
+
+void ReportCheckFailure(const char* file, int line, const char* expression) {
+  std::printf("%s:%d: check failed: %s\n", file, line, expression);
+  failedChecks++;
+}
+
+void ReportCheckFailure(const char* file, int line, const char* expression,
+                        long long actual, long long expected) {
+  std::printf("%s:%d: check failed: %s (%lld vs %lld)\n", file, line,
+              expression, actual, expected);
+  failedChecks++;
+}
+
+ScratchDirectory::ScratchDirectory(const char* name) {
+  path = std::filesystem::temp_directory_path() /
+         (std::string("wolftimer-tests-") + name);
+  std::error_code error;
+  std::filesystem::remove_all(path, error);
+  std::filesystem::create_directories(path, error);
+}
+
+ScratchDirectory::~ScratchDirectory() {
+  std::error_code error;
+  std::filesystem::remove_all(path, error);
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    bool known = false;
+    for (const TestCase& test : Registry()) {
+      known = known || std::strcmp(test.suite, argv[i]) == 0;
+    }
+    if (!known) {
+      std::fprintf(stderr, "wolftimer-tests: no suite named %s\n", argv[i]);
+      return 2;
+    }
+  }
+
+  int run = 0;
+  int failed = 0;
+  for (const TestCase& test : Registry()) {
+    if (!IsSelected(test.suite, argc, argv)) continue;
+    const int before = failedChecks;
+    test.function();
+    const bool passed = failedChecks == before;
+    std::printf("[%s] %s.%s\n", passed ? "  OK  " : " FAIL ", test.suite,
+                test.name);
+    std::fflush(stdout);
+    run++;
+    if (!passed) failed++;
+  }
+  std::printf("%d tests, %d failed\n", run, failed);
+  return failed == 0 ? 0 : 1;
+}
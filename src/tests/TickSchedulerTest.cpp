@@ -0,0 +1,94 @@
+// TickSchedulerTest.cpp - Wakeups per hour of the tickless scheduler
+
+#include <cstdio>
+
+#include "TestHarness.h"
+#include "TickScheduler.h"
+
+namespace {
+
+// One hour-long block of 40 questions (90 s each)
+TimerState MakeHourState(const TimerClock* clock) {
+  TimerConfig config = {};
+  config.timePerBlock = 60;
+  config.numBlocks = 1;
+  config.numQuestions = 40;
+  config.transparency = 100;
+  TimerState state = {};
+  state.Initialize(config, clock);
+  return state;
+}
+
+struct WakeupCount {
+  int wakeups = 0;
+  int secondsSkipped = 0;  // Whole seconds passed with no wakeup in them
+};
+
+// Sleeps exactly as long as the scheduler asks until the session ends or
+// limitMs passes, ticking on every wakeup.
+WakeupCount RunHeadless(TimerState* state, ManualTimerClock* clock,
+                        bool visible, int questionBarWidth, int blockBarWidth,
+                        int64_t limitMs) {
+  WakeupCount count;
+  int64_t lastSecond = 0;
+  for (;;) {
+    const int64_t delay = TickScheduler::NextWakeDelay(
+        *state, visible, questionBarWidth, blockBarWidth);
+    if (delay < 0 || clock->nowMs + delay > limitMs) break;
+    clock->nowMs += delay;
+    state->Tick();
+    count.wakeups++;
+    const int64_t second = state->GetElapsedMilliseconds() / 1000;
+    if (second > lastSecond + 1) count.secondsSkipped++;
+    lastSecond = second;
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST(TickScheduler, VisibleTextOnlyWakesOncePerSecond) {
+  ManualTimerClock clock;
+  TimerState state = MakeHourState(&clock);
+  const WakeupCount count =
+      RunHeadless(&state, &clock, true, 0, 0, 3600 * 1000);
+  std::printf("  visible, no bars: %d wakeups/hour\n", count.wakeups);
+  CHECK_EQ(count.wakeups, 3600);
+  CHECK_EQ(count.secondsSkipped, 0);
+  CHECK_EQ(state.currentTime, 0);
+}
+
+TEST(TickScheduler, VisibleBarsAddOnlyPixelCrossings) {
+  ManualTimerClock clock;
+  TimerState state = MakeHourState(&clock);
+  const int questionWidth = 200;  // A pixel every 450 ms
+  const int blockWidth = 300;     // A pixel every 12 s
+  const WakeupCount count = RunHeadless(&state, &clock, true, questionWidth,
+                                        blockWidth, 3600 * 1000);
+  std::printf("  visible, %d/%d px bars: %d wakeups/hour\n", questionWidth,
+              blockWidth, count.wakeups);
+  CHECK_EQ(count.secondsSkipped, 0);
+  // Every second plus at most one wakeup per pixel of either bar
+  CHECK(count.wakeups >= 3600);
+  CHECK(count.wakeups <= 3600 + 40 * questionWidth + blockWidth);
+}
+
+TEST(TickScheduler, HiddenWakesOnlyForCompletion) {
+  ManualTimerClock clock;
+  TimerState state = MakeHourState(&clock);
+  const WakeupCount count =
+      RunHeadless(&state, &clock, false, 0, 0, 3600 * 1000);
+  std::printf("  hidden: %d wakeups/hour\n", count.wakeups);
+  CHECK_EQ(count.wakeups, 1);
+  CHECK_EQ(state.currentTime, 0);
+}
+
+TEST(TickScheduler, HaltedTimerNeverWakes) {
+  ManualTimerClock clock;
+  TimerState state = MakeHourState(&clock);
+  state.SetPaused(true);
+  CHECK_EQ(TickScheduler::NextWakeDelay(state, true, 200, 300), -1);
+  state.SetPaused(false);
+  state.Stop();
+  CHECK_EQ(TickScheduler::NextWakeDelay(state, false), -1);
+}
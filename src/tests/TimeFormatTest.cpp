@@ -0,0 +1,50 @@
+// TimeFormatTest.cpp - Table-driven formatting against swprintf
+
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+
+#include "TestHarness.h"
+#include "TimeFormat.h"
+
+TEST(TimeFormat, MatchesSwprintf) {
+  for (int seconds = 0; seconds < 200000; seconds += 7) {
+    wchar_t expected[32];
+    wchar_t actual[32];
+
+    std::swprintf(expected, 32, L"%02d:%02d", seconds / 60, seconds % 60);
+    CHECK_EQ(FormatMinutesSeconds(seconds, actual, 32), std::wcslen(expected));
+    CHECK(std::wcscmp(actual, expected) == 0);
+
+    std::swprintf(expected, 32, L"%d:%02d:%02d", seconds / 3600,
+                  seconds / 60 % 60, seconds % 60);
+    CHECK_EQ(FormatHoursMinutesSeconds(seconds, actual, 32),
+             std::wcslen(expected));
+    CHECK(std::wcscmp(actual, expected) == 0);
+
+    std::swprintf(expected, 32, L"Q: %d/%d", seconds % 97, seconds);
+    CHECK_EQ(FormatCountLabel("Q: ", seconds % 97, seconds, actual, 32),
+             std::wcslen(expected));
+    CHECK(std::wcscmp(actual, expected) == 0);
+  }
+}
+
+TEST(TimeFormat, NegativeAndHugeValues) {
+  char text[timeformat::kMaxChars];
+  CHECK_EQ(FormatMinutesSeconds(-75, text, sizeof(text)), 6u);
+  CHECK(std::strcmp(text, "-01:15") == 0);
+  CHECK_EQ(FormatHoursMinutesSeconds(INT64_MIN, text, sizeof(text)), 23u);
+  CHECK(std::strcmp(text, "-2562047788015215:30:08") == 0);
+  CHECK_EQ(FormatCountLabel("Block ", -1, 4, text, sizeof(text)), 10u);
+  CHECK(std::strcmp(text, "Block -1/4") == 0);
+}
+
+TEST(TimeFormat, TooSmallBufferGivesEmptyString) {
+  wchar_t text[8] = L"xxxx";
+  CHECK_EQ(FormatMinutesSeconds(3599, text, 5), 0u);  // "59:59" needs 6
+  CHECK(text[0] == L'\0');
+  CHECK_EQ(FormatMinutesSeconds(3599, text, 6), 5u);
+  CHECK(std::wcscmp(text, L"59:59") == 0);
+  CHECK_EQ(FormatMinutesSeconds(3599, text, 0), 0u);
+  CHECK(text[0] == L'5');  // A zero-size buffer is left alone
+}
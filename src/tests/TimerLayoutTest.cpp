@@ -0,0 +1,75 @@
+// TimerLayoutTest.cpp - Timer bar geometry across DPIs and widths
+
+#include <initializer_list>
+
+#include "TestHarness.h"
+#include "TimerLayout.h"
+
+namespace {
+
+bool Overlap(const BarRect& a, const BarRect& b) {
+  return a.left < b.right && b.left < a.right && a.top < b.bottom &&
+         b.top < a.bottom;
+}
+
+}  // namespace
+
+TEST(TimerLayout, BaseLayoutAt96Dpi) {
+  const TimerLayout layout = ComputeTimerLayout(96);
+  CHECK_EQ(layout.windowWidth, BASE_WINDOW_WIDTH);
+  CHECK_EQ(layout.windowHeight, BASE_WINDOW_HEIGHT);
+  const BarRect& label = layout.rects[kElementQuestionLabel];
+  CHECK_EQ(label.left, BASE_MARGIN);
+  CHECK_EQ(label.top, BASE_MARGIN + BASE_LABEL_INSET);
+  CHECK_EQ(label.Width(), BASE_LABEL_WIDTH);
+  CHECK_EQ(label.Height(), BASE_ROW_HEIGHT - BASE_LABEL_SHRINK);
+  CHECK_EQ(layout.rects[kElementPauseButton].right,
+           BASE_WINDOW_WIDTH - 3 * BASE_MARGIN);
+  CHECK_EQ(layout.rects[kElementBlockLabel].top,
+           BASE_MARGIN + BASE_ROW_HEIGHT + BASE_LABEL_INSET);
+}
+
+// Every DPI from 96 to 384 at the default, minimum, maximum and assorted
+// widths: elements stay inside the window, never overlap, keep their
+// scaled fixed widths, and the progress bars absorb the rest.
+TEST(TimerLayout, ScalesAcrossDpisAndWidths) {
+  for (int dpi = 96; dpi <= 384; dpi += 8) {
+    for (const int base : {0, 100, BASE_MIN_WINDOW_WIDTH, 500, 900,
+                           BASE_MAX_WINDOW_WIDTH, 5000}) {
+      const int requested = base == 0 ? 0 : ScaleForDpi(base, dpi);
+      const TimerLayout layout = ComputeTimerLayout(dpi, requested);
+      CHECK_EQ(layout.windowWidth, ClampTimerWindowWidth(dpi, requested));
+      CHECK(layout.windowWidth >= ScaleForDpi(BASE_MIN_WINDOW_WIDTH, dpi));
+      CHECK(layout.windowWidth <= ScaleForDpi(BASE_MAX_WINDOW_WIDTH, dpi));
+      CHECK_EQ(layout.windowHeight, ScaleForDpi(BASE_WINDOW_HEIGHT, dpi));
+
+      for (int element = 0; element < kTimerElementCount; element++) {
+        const BarRect& rect = layout.rects[element];
+        CHECK(rect.Width() > 0 && rect.Height() > 0);
+        CHECK(rect.left >= 0 && rect.top >= 0);
+        CHECK(rect.right <= layout.windowWidth);
+        CHECK(rect.bottom <= layout.windowHeight);
+        for (int other = element + 1; other < kTimerElementCount; other++) {
+          CHECK(!Overlap(rect, layout.rects[other]));
+        }
+        const int x = (rect.left + rect.right) / 2;
+        const int y = (rect.top + rect.bottom) / 2;
+        CHECK_EQ(HitTestTimerLayout(layout, x, y), element);
+      }
+
+      CHECK_EQ(layout.rects[kElementQuestionLabel].Width(),
+               ScaleForDpi(BASE_LABEL_WIDTH, dpi));
+      CHECK_EQ(layout.rects[kElementStartStopButton].Width(),
+               ScaleForDpi(BASE_BTN_WIDTH, dpi));
+      CHECK_EQ(layout.rects[kElementQuestionProgress].right +
+                   ScaleForDpi(BASE_MARGIN, dpi),
+               layout.rects[kElementSettingsButton].left);
+      const int margin = ScaleForDpi(BASE_MARGIN, dpi);
+      CHECK_EQ(layout.rects[kElementCloseButton].right,
+               layout.windowWidth - 3 * margin);
+      CHECK_EQ(layout.rects[kElementPauseButton].right,
+               layout.windowWidth - 3 * margin);
+    }
+  }
+  CHECK_EQ(HitTestTimerLayout(ComputeTimerLayout(96), 0, 0), -1);
+}
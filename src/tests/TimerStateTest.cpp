@@ -0,0 +1,187 @@
+// TimerStateTest.cpp - TimerState driven by a virtual clock
+
+#include <cstdio>
+#include <vector>
+
+#include "TestHarness.h"
+#include "TimerState.h"
+
+namespace {
+
+TimerConfig MakeConfig(int minutesPerBlock, int blocks, int questions) {
+  TimerConfig config = {};
+  config.timePerBlock = minutesPerBlock;
+  config.numBlocks = blocks;
+  config.numQuestions = questions;
+  config.transparency = 100;
+  config.ComputeDerivedValues();
+  return config;
+}
+
+}  // namespace
+
+TEST(TimerState, RunsToCompletion) {
+  ManualTimerClock clock;
+  TimerState state = {};
+  state.Initialize(MakeConfig(2, 3, 4), &clock);
+  CHECK_EQ(state.currentTime, 360);
+  CHECK_EQ(state.currentBlock, 1);
+  CHECK_EQ(state.currentQuestion, 1);
+
+  clock.nowMs = 30000;
+  CHECK_EQ(state.Tick(), TickStatus::QuestionAdvanced);
+  CHECK_EQ(state.currentQuestion, 2);
+
+  clock.nowMs = 120000;
+  CHECK_EQ(state.Tick(), TickStatus::BlockAdvanced);
+  CHECK_EQ(state.currentBlock, 2);
+  CHECK_EQ(state.currentQuestion, 1);
+
+  clock.nowMs = 360000;
+  CHECK_EQ(state.Tick(), TickStatus::Completed);
+  CHECK_EQ(state.currentTime, 0);
+}
+
+TEST(TimerState, PauseFreezesElapsedTime) {
+  ManualTimerClock clock;
+  TimerState state = {};
+  state.Initialize(MakeConfig(10, 1, 5), &clock);
+
+  clock.nowMs = 1500;
+  state.SetPaused(true);
+  clock.nowMs = 61500;
+  CHECK_EQ(state.GetElapsedMilliseconds(), 1500);
+
+  state.SetPaused(false);
+  clock.nowMs = 62000;
+  CHECK_EQ(state.GetElapsedMilliseconds(), 2000);
+  state.Tick();
+  CHECK_EQ(state.currentTime, 598);
+}
+
+// Ten hours of ticks that each arrive 0-250 ms late, with an occasional
+// multi-second stall and pause, the way a busy message loop delivers them.
+// Elapsed time must follow the clock to the millisecond, and the displayed
+// second must never lag it, however the ticks are spread.
+TEST(TimerState, NoDriftOverTenHoursOfJitteredTicks) {
+  ManualTimerClock clock;
+  clock.nowMs = 123456;
+  TimerState state = {};
+  state.Initialize(MakeConfig(120, 5, 40), &clock);
+  CHECK_EQ(state.config.totalTime, 10 * 3600);
+
+  TestRandom random;
+  int64_t runningMs = 0;  // Elapsed time by the test's own reckoning
+  int64_t worstErrorMs = 0;
+  int ticks = 0;
+  while (state.currentTime > 0) {
+    int64_t delay = state.GetMillisecondsUntilNextSecond() +
+                    random.Between(0, 250);
+    if (random.Next() % 500 == 0) delay += random.Between(1000, 8000);
+    clock.nowMs += delay;
+    runningMs += delay;
+
+    if (random.Next() % 2000 == 0) {
+      state.SetPaused(true);
+      clock.nowMs += random.Between(1000, 600000);
+      state.SetPaused(false);
+    }
+
+    state.Tick();
+    ticks++;
+    const int64_t errorMs = state.GetElapsedMilliseconds() - runningMs;
+    const int64_t magnitude = errorMs < 0 ? -errorMs : errorMs;
+    if (magnitude > worstErrorMs) worstErrorMs = magnitude;
+
+    const int64_t expectedRemaining =
+        runningMs / 1000 >= state.config.totalTime
+            ? 0
+            : state.config.totalTime - runningMs / 1000;
+    CHECK_EQ(state.currentTime, expectedRemaining);
+    REQUIRE(ticks < 100000);
+  }
+  CHECK(worstErrorMs < 1);
+  CHECK_EQ(state.currentBlock, 5);
+}
+
+// StateAt() must agree with the plan lookup and with ticking second by
+// second, including blocks whose length does not divide evenly.
+TEST(TimerState, StateAtMatchesPlanAndTickReplay) {
+  const TimerConfig config = MakeConfig(7, 3, 11);
+  const SessionPlan plan = BuildSessionPlan(config);
+  ManualTimerClock clock;
+  TimerState state = {};
+  state.Initialize(config, &clock);
+
+  for (int64_t second = 0; second <= config.totalTime; second++) {
+    clock.nowMs = second * 1000;
+    state.Tick();
+    const TimerPosition closed = StateAt(config, second);
+    const TimerPosition looked = plan.PositionAt(second);
+    CHECK_EQ(closed.currentTime, looked.currentTime);
+    CHECK_EQ(closed.currentQuestion, looked.currentQuestion);
+    CHECK_EQ(closed.currentBlock, looked.currentBlock);
+    CHECK_EQ(closed.questionTimeElapsed, looked.questionTimeElapsed);
+    CHECK_EQ(closed.questionLength, looked.questionLength);
+    CHECK_EQ(closed.blockTimeElapsed, looked.blockTimeElapsed);
+    CHECK_EQ(closed.currentTime, state.currentTime);
+    CHECK_EQ(closed.currentQuestion, state.currentQuestion);
+    CHECK_EQ(closed.currentBlock, state.currentBlock);
+    CHECK_EQ(closed.questionTimeElapsed, state.questionTimeElapsed);
+  }
+}
+
+namespace {
+
+// Records every event delivered by DrainTimerEvents().
+struct EventLog {
+  std::vector<TimerEvent> events;
+  void OnTimerEvent(const TimerEvent& event) { events.push_back(event); }
+};
+
+}  // namespace
+
+// A 30-day session of 12000 questions, advanced in jumps of up to six hours
+// (hundreds of boundaries at a time, far past TimerEventBatch's capacity)
+// with pauses in between. Every boundary must come out exactly once, in
+// order, with its own timestamp.
+TEST(TimerState, MonthOfVirtualTimeDropsNoEvents) {
+  const TimerConfig config = MakeConfig(720, 60, 200);
+  CHECK_EQ(config.totalTime, 30 * 24 * 3600);
+
+  ManualTimerClock clock;
+  TimerState state = {};
+  state.Initialize(config, &clock);
+
+  std::vector<TimerEvent> expected;
+  for (int segment = 0; segment < state.plan.SegmentCount(); segment++) {
+    TimerEvent boundary[kMaxBoundaryEvents];
+    const int count = GetBoundaryEvents(state.plan, segment, boundary);
+    expected.insert(expected.end(), boundary, boundary + count);
+  }
+
+  TestRandom random;
+  EventLog log;
+  int drains = 0;
+  while (state.currentTime > 0) {
+    clock.nowMs += random.Between(1, 6 * 3600 * 1000);
+    if (random.Next() % 4 == 0) {
+      state.SetPaused(true);
+      clock.nowMs += random.Between(1, 3600 * 1000);
+      state.SetPaused(false);
+    }
+    DrainTimerEvents(state, log);
+    drains++;
+  }
+
+  std::printf("  %zu events in %d drains\n", log.events.size(), drains);
+  REQUIRE(log.events.size() == expected.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    CHECK_EQ(log.events[i].type, expected[i].type);
+    CHECK_EQ(log.events[i].atSecond, expected[i].atSecond);
+    CHECK_EQ(log.events[i].block, expected[i].block);
+    CHECK_EQ(log.events[i].question, expected[i].question);
+  }
+  CHECK_EQ(log.events.back().type, TimerEventType::Completed);
+  CHECK_EQ(expected.size(), size_t{60 * 200 - 1 + 59 + 1});
+}
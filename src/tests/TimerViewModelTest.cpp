@@ -0,0 +1,118 @@
+// TimerViewModelTest.cpp - Which controls a view model diff touches
+
+#include <cstdio>
+#include <initializer_list>
+
+#include "TestHarness.h"
+#include "TickScheduler.h"
+#include "TimerViewModel.h"
+
+namespace {
+
+TimerState MakeState(const TimerClock* clock) {
+  TimerConfig config = {};
+  config.timePerBlock = 10;
+  config.numBlocks = 2;
+  config.numQuestions = 5;
+  config.transparency = 100;
+  TimerState state = {};
+  state.Initialize(config, clock);
+  return state;
+}
+
+unsigned CommitState(const TimerState& state, TimerViewDiffer* differ) {
+  TimerViewModel view = {};
+  BuildTimerViewModel(state, 0, 0, &view);
+  return differ->Commit(view);
+}
+
+}  // namespace
+
+TEST(TimerViewModel, FirstFramePushesEverythingThenNothing) {
+  ManualTimerClock clock;
+  const TimerState state = MakeState(&clock);
+  TimerViewDiffer differ;
+  CHECK_EQ(CommitState(state, &differ), kViewAllFields);
+  CHECK_EQ(CommitState(state, &differ), 0u);
+  CHECK_EQ(differ.issuedUpdates, uint64_t{kViewFieldCount});
+  CHECK_EQ(differ.suppressedUpdates, uint64_t{kViewFieldCount});
+
+  differ.Invalidate();
+  CHECK_EQ(CommitState(state, &differ), kViewAllFields);
+}
+
+TEST(TimerViewModel, SecondTickTouchesOnlyTheClocks) {
+  ManualTimerClock clock;
+  TimerState state = MakeState(&clock);
+  TimerViewDiffer differ;
+  CommitState(state, &differ);
+
+  clock.nowMs = 1000;
+  state.Tick();
+  CHECK_EQ(CommitState(state, &differ),
+           unsigned{kViewQuestionTime | kViewBlockTime});
+
+  state.SetPaused(true);
+  CHECK_EQ(CommitState(state, &differ), unsigned{kViewPauseText});
+
+  // Question 1 -> 2 after 120 s; the block clock changes too
+  state.SetPaused(false);
+  clock.nowMs = 120000;
+  state.Tick();
+  CHECK_EQ(CommitState(state, &differ),
+           unsigned{kViewQuestionLabel | kViewQuestionTime | kViewBlockTime |
+                    kViewPauseText});
+}
+
+// Ten 60 s questions at several question bar widths, waking whenever the
+// scheduler asks. The question bar must be redrawn exactly as often as its
+// fill edge moves (checked against the fill at every millisecond), and
+// nothing else may be redrawn between whole seconds.
+TEST(TimerViewModel, BarRedrawsFollowPixelCrossings) {
+  for (const int width : {40, 150, 300, 600, 1200}) {
+    TimerConfig config = {};
+    config.timePerBlock = 10;
+    config.numBlocks = 1;
+    config.numQuestions = 10;
+    config.transparency = 100;
+    ManualTimerClock clock;
+    TimerState state = {};
+    state.Initialize(config, &clock);
+    const int64_t totalMs = int64_t{state.config.totalTime} * 1000;
+
+    int expected = 0;
+    int previousFill = 0;
+    for (int64_t ms = 1; ms < totalMs; ms++) {
+      const int fill = ProgressPixels(ms % 60000, 60, width);
+      if (fill != previousFill) expected++;
+      previousFill = fill;
+    }
+
+    TimerViewDiffer differ;
+    TimerViewModel view;
+    BuildTimerViewModel(state, width, 0, &view);
+    differ.Commit(view);
+    int redraws = 0;
+    int offSecondRedraws = 0;
+    int frames = 0;
+    for (;;) {
+      const int64_t delay = TickScheduler::NextWakeDelay(state, true, width, 0);
+      if (delay < 0) break;
+      clock.nowMs += delay;
+      if (clock.nowMs >= totalMs) break;
+      state.Tick();
+      BuildTimerViewModel(state, width, 0, &view);
+      const unsigned changed = differ.Commit(view);
+      if (changed & kViewQuestionProgress) redraws++;
+      if (clock.nowMs % 1000 != 0 && (changed & ~kViewQuestionProgress)) {
+        offSecondRedraws++;
+      }
+      frames++;
+    }
+    std::printf("  %4d px: %5d frames, %5d question bar redraws\n", width,
+                frames, redraws);
+    CHECK_EQ(redraws, expected);
+    CHECK_EQ(offSecondRedraws, 0);
+    CHECK(frames <= state.config.totalTime + expected);
+  }
+}
@@ -0,0 +1,210 @@
+// TimingWheelTest.cpp - Deadlines on every level, cancelling and wake times
+
+#include <algorithm>
+#include <initializer_list>
+#include <vector>
+
+#include "TestHarness.h"
+#include "TimingWheel.h"
+
+namespace {
+
+constexpr int64_t kSlots = TimingWheel::kSlots;
+
+// Farthest distance the top level files a deadline at (kMaxDelta in
+// TimingWheel.cpp)
+constexpr int64_t kMaxDelta =
+    (int64_t{1} << (TimingWheel::kLevelBits * TimingWheel::kLevels)) - 1;
+
+// Advances wheel to tick and returns what expired.
+std::vector<uint32_t> ExpireTo(TimingWheel* wheel, int64_t tick) {
+  std::vector<uint32_t> expired;
+  wheel->AdvanceTo(tick, &expired);
+  return expired;
+}
+
+// Nothing may expire before NextWakeTick(), and it is never later than the
+// earliest deadline still scheduled.
+bool WakeTickIsSafe(const TimingWheel& wheel,
+                    const std::vector<int64_t>& deadlines) {
+  int64_t earliest = -1;
+  for (uint32_t id = 0; id < deadlines.size(); id++) {
+    if (!wheel.IsScheduled(id)) continue;
+    const int64_t due = std::max(deadlines[id], wheel.CurrentTick());
+    if (earliest < 0 || due < earliest) earliest = due;
+  }
+  const int64_t wake = wheel.NextWakeTick();
+  if (earliest < 0) return wake == -1;
+  return wake >= wheel.CurrentTick() && wake <= earliest;
+}
+
+}  // namespace
+
+// One entry at and either side of each level's reach: each must expire at
+// its own deadline, no earlier and no later, however far the wheel jumps.
+TEST(TimingWheel, DeadlinesOnEveryLevel) {
+  const int64_t start = 1000;
+  std::vector<int64_t> deadlines;
+  for (int level = 0; level < TimingWheel::kLevels; level++) {
+    const int64_t reach = int64_t{1} << (TimingWheel::kLevelBits * level);
+    for (const int64_t delta : {reach - 1, reach, reach + 1, reach * 3 + 7}) {
+      deadlines.push_back(start + delta);
+    }
+  }
+  deadlines.push_back(start + kSlots - 1);
+  deadlines.push_back(start + kSlots);
+
+  TimingWheel wheel;
+  wheel.Reset(start);
+  for (uint32_t id = 0; id < deadlines.size(); id++) {
+    wheel.Schedule(id, deadlines[id]);
+  }
+  CHECK_EQ(wheel.Size(), deadlines.size());
+  CHECK(WakeTickIsSafe(wheel, deadlines));
+
+  std::vector<int64_t> order = deadlines;
+  std::sort(order.begin(), order.end());
+  order.erase(std::unique(order.begin(), order.end()), order.end());
+  int failures = 0;
+  for (const int64_t deadline : order) {
+    if (!ExpireTo(&wheel, deadline - 1).empty()) failures++;
+    if (!WakeTickIsSafe(wheel, deadlines)) failures++;
+    const std::vector<uint32_t> expired = ExpireTo(&wheel, deadline);
+    if (expired.empty()) failures++;
+    for (const uint32_t id : expired) {
+      if (deadlines[id] != deadline || wheel.IsScheduled(id)) failures++;
+    }
+  }
+  CHECK_EQ(failures, 0);
+  CHECK_EQ(wheel.Size(), 0u);
+  CHECK_EQ(wheel.NextWakeTick(), -1);
+  CHECK(wheel.cascaded > 0);
+}
+
+// Deadlines past the top level's span wait in its farthest slot and are
+// re-filed when it cascades, until they come within reach.
+TEST(TimingWheel, DeadlinesBeyondTopLevel) {
+  TimingWheel wheel;
+  wheel.Reset(5);
+  const int64_t far = 5 + kMaxDelta + 12345;
+  const int64_t farther = 5 + 2 * kMaxDelta + 3;
+  wheel.Schedule(0, far);
+  wheel.Schedule(1, farther);
+  wheel.Schedule(2, 5 + kMaxDelta);
+  CHECK_EQ(wheel.Deadline(0), far);
+  CHECK(wheel.NextWakeTick() <= 5 + kMaxDelta);
+
+  CHECK(ExpireTo(&wheel, 5 + kMaxDelta - 1).empty());
+  std::vector<uint32_t> expired = ExpireTo(&wheel, 5 + kMaxDelta);
+  REQUIRE(expired.size() == 1);
+  CHECK_EQ(expired[0], 2u);
+
+  CHECK(ExpireTo(&wheel, far - 1).empty());
+  CHECK(wheel.NextWakeTick() <= far);
+  expired = ExpireTo(&wheel, far);
+  REQUIRE(expired.size() == 1);
+  CHECK_EQ(expired[0], 0u);
+
+  CHECK(ExpireTo(&wheel, farther - 1).empty());
+  expired = ExpireTo(&wheel, farther + 100);
+  REQUIRE(expired.size() == 1);
+  CHECK_EQ(expired[0], 1u);
+  CHECK_EQ(wheel.Size(), 0u);
+}
+
+TEST(TimingWheel, CancelAndReschedule) {
+  TimingWheel wheel;
+  wheel.Reset(1);  // Off a span boundary, so the wake tick is exact
+  wheel.Schedule(7, 100);
+  wheel.Schedule(3, 70000);  // Level 2
+  wheel.Schedule(9, 300);
+  CHECK_EQ(wheel.Size(), 3u);
+
+  // Moving an entry between levels, either way, keeps one copy of it.
+  wheel.Schedule(3, 50);
+  wheel.Schedule(7, 1 << 20);
+  CHECK_EQ(wheel.Size(), 3u);
+  CHECK_EQ(wheel.NextWakeTick(), 50);
+
+  wheel.Cancel(9);
+  wheel.Cancel(9);
+  wheel.Cancel(1000);  // Never seen
+  CHECK(!wheel.IsScheduled(9));
+  CHECK(!wheel.IsScheduled(1000));
+  CHECK_EQ(wheel.Size(), 2u);
+
+  std::vector<uint32_t> expired = ExpireTo(&wheel, 1000);
+  REQUIRE(expired.size() == 1);
+  CHECK_EQ(expired[0], 3u);
+  expired = ExpireTo(&wheel, (1 << 20) - 1);
+  CHECK(expired.empty());
+  expired = ExpireTo(&wheel, 1 << 20);
+  REQUIRE(expired.size() == 1);
+  CHECK_EQ(expired[0], 7u);
+
+  // Rescheduling after expiry, and into the past, which expires next time.
+  wheel.Schedule(3, 10);
+  CHECK_EQ(wheel.NextWakeTick(), wheel.CurrentTick());
+  expired = ExpireTo(&wheel, wheel.CurrentTick());
+  REQUIRE(expired.size() == 1);
+  CHECK_EQ(expired[0], 3u);
+  CHECK_EQ(wheel.Size(), 0u);
+}
+
+// Random scheduling, rescheduling and cancelling over deadlines up to a few
+// million ticks away, checked against a plain list of deadlines after every
+// step: the right entries expire, in deadline order, and the wake tick is
+// never past the earliest deadline.
+TEST(TimingWheel, MatchesReferenceUnderRandomOperations) {
+  constexpr uint32_t kIds = 2000;
+  TestRandom random;
+  TimingWheel wheel;
+  wheel.Reset(random.Between(0, 1 << 20));
+  std::vector<int64_t> deadlines(kIds, -1);  // -1 if not scheduled
+
+  int failures = 0;
+  for (int step = 0; step < 4000; step++) {
+    for (int op = 0; op < 20; op++) {
+      const uint32_t id = static_cast<uint32_t>(random.Between(0, kIds - 1));
+      if (random.Between(0, 4) == 0) {
+        wheel.Cancel(id);
+        deadlines[id] = -1;
+        continue;
+      }
+      const int64_t span = int64_t{1} << random.Between(0, 22);
+      deadlines[id] = wheel.CurrentTick() + random.Between(0, span);
+      wheel.Schedule(id, deadlines[id]);
+    }
+
+    for (uint32_t id = 0; id < kIds; id++) {
+      if (wheel.IsScheduled(id) != (deadlines[id] >= 0)) failures++;
+    }
+    if (!WakeTickIsSafe(wheel, deadlines)) failures++;
+
+    const int64_t wake = wheel.NextWakeTick();
+    if (wake > wheel.CurrentTick() &&
+        !ExpireTo(&wheel, wake - 1).empty()) {
+      failures++;
+    }
+
+    const int64_t jump = random.Between(0, 3) == 0 ? 1 << 16 : 300;
+    const int64_t tick = wheel.CurrentTick() + random.Between(0, jump);
+    const std::vector<uint32_t> expired = ExpireTo(&wheel, tick);
+    size_t expected = 0;
+    for (uint32_t id = 0; id < kIds; id++) {
+      if (deadlines[id] >= 0 && deadlines[id] <= tick) expected++;
+    }
+    if (expired.size() != expected) failures++;
+    int64_t previous = -1;
+    for (const uint32_t id : expired) {
+      if (deadlines[id] < 0 || deadlines[id] > tick ||
+          deadlines[id] < previous) {
+        failures++;
+      }
+      previous = deadlines[id];
+      deadlines[id] = -1;
+    }
+    if (wheel.CurrentTick() != tick + 1) failures++;
+  }
+  CHECK_EQ(failures, 0);
+}